@@ -33,12 +33,15 @@ int
 main(int argc,
      char *argv[])
 {
-    CLArgs::printBackGroundWelcomeMessage();
-    
     CLArgs args(argc,argv,false);
     if (args.getError() > 0) {
         return 1;
     }
+    
+    ///Nothing must be printed before the frames streamed to the standard output
+    if (args.getFrameStreamDestination() != "-") {
+        CLArgs::printBackGroundWelcomeMessage();
+    }
 
     setShutDownSignal(SIGINT);   // shut down on ctrl-c
     setShutDownSignal(SIGTERM);   // shut down on killall
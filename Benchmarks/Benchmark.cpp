@@ -0,0 +1,568 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QDateTime>
+#include <QtCore/QRegExp>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+
+///Iterations are never increased beyond this count, whatever the time taken by the benchmark
+#define NATRON_BENCHMARK_MAX_ITERATIONS 1000000000LL
+
+using namespace Natron::Benchmark;
+
+namespace Natron {
+namespace Benchmark {
+
+///Releases the threads of a run once they have all reached the timed loop, so that they really contend
+class StartBarrier
+{
+    QMutex _mutex;
+    QWaitCondition _cond;
+    int _waiting;
+
+public:
+
+    StartBarrier(int threadsCount)
+    : _mutex()
+    , _cond()
+    , _waiting(threadsCount)
+    {
+    }
+
+    void wait()
+    {
+        QMutexLocker k(&_mutex);
+        --_waiting;
+        if (_waiting <= 0) {
+            _cond.wakeAll();
+        } else {
+            while (_waiting > 0) {
+                _cond.wait(&_mutex);
+            }
+        }
+    }
+};
+
+} // namespace Benchmark
+} // namespace Natron
+
+State::State(long long iterations,
+             const std::vector<int>& args,
+             int threadIndex,
+             int threadsCount,
+             StartBarrier* barrier)
+: _iterations(iterations)
+, _remaining(iterations)
+, _args(args)
+, _threadIndex(threadIndex)
+, _threadsCount(threadsCount)
+, _barrier(barrier)
+, _started(false)
+, _running(false)
+, _timer()
+, _elapsedNs(0.)
+, _itemsProcessed(0)
+, _bytesProcessed(0)
+, _error()
+{
+    assert(iterations > 0);
+}
+
+void
+State::waitForOtherThreads()
+{
+    if (_barrier) {
+        _barrier->wait();
+    }
+}
+
+void
+State::pauseTiming()
+{
+    assert(_running);
+    _elapsedNs += (double)_timer.nsecsElapsed();
+    _running = false;
+}
+
+void
+State::resumeTiming()
+{
+    assert(!_running);
+    _running = true;
+    _timer.start();
+}
+
+void
+State::skipWithError(const std::string& message)
+{
+    _error = message;
+    _remaining = 0;
+}
+
+int
+State::range(int index) const
+{
+    assert( index >= 0 && index < (int)_args.size() );
+    return _args[index];
+}
+
+Definition::Definition(const std::string& name,
+                       BenchmarkFunction func)
+: _name(name)
+, _func(func)
+, _args()
+, _threads()
+{
+}
+
+Definition*
+Definition::arg(int a)
+{
+    std::vector<int> v(1,a);
+    _args.push_back(v);
+    return this;
+}
+
+Definition*
+Definition::args(int a,
+                 int b)
+{
+    std::vector<int> v(2);
+    v[0] = a;
+    v[1] = b;
+    _args.push_back(v);
+    return this;
+}
+
+Definition*
+Definition::threads(int n)
+{
+    assert(n > 0);
+    _threads.push_back(n);
+    return this;
+}
+
+///Not a global so that it is constructed before the static definitions of the benchmarks register themselves
+static std::vector<Definition*>&
+getRegisteredBenchmarks()
+{
+    static std::vector<Definition*> benchmarks;
+    return benchmarks;
+}
+
+Definition*
+Natron::Benchmark::registerBenchmark(const char* name,
+                                     BenchmarkFunction func)
+{
+    Definition* ret = new Definition(name,func);
+    getRegisteredBenchmarks().push_back(ret);
+    return ret;
+}
+
+namespace {
+
+struct RunResult
+{
+    std::string name;
+    long long iterations;
+    ///Per iteration of one thread
+    double realTimeNs;
+    ///Per iteration, summed over all threads of the process
+    double cpuTimeNs;
+    double itemsPerSecond;
+    double bytesPerSecond;
+    std::string error;
+
+    RunResult()
+    : name()
+    , iterations(0)
+    , realTimeNs(0.)
+    , cpuTimeNs(0.)
+    , itemsPerSecond(0.)
+    , bytesPerSecond(0.)
+    , error()
+    {
+    }
+};
+
+class BenchmarkThread
+    : public QThread
+{
+    BenchmarkFunction _func;
+    State* _state;
+
+public:
+
+    BenchmarkThread(BenchmarkFunction func,
+                    State* state)
+    : QThread()
+    , _func(func)
+    , _state(state)
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        _func(*_state);
+    }
+};
+
+struct Options
+{
+    QRegExp filter;
+    double minTime;
+    bool jsonOnStdout;
+    std::string outFile;
+
+    Options()
+    : filter( QString(".") )
+    , minTime(0.5)
+    , jsonOnStdout(false)
+    , outFile()
+    {
+    }
+};
+
+} // anon namespace
+
+/**
+ * @brief Runs the function iterations times on each thread and returns the time taken by the slowest thread
+ * as well as the CPU time of the whole process.
+ **/
+static void
+runOnce(BenchmarkFunction func,
+        const std::vector<int>& args,
+        int threadsCount,
+        long long iterations,
+        double* realNs,
+        double* cpuNs,
+        long long* items,
+        long long* bytes,
+        std::string* error)
+{
+    StartBarrier barrier(threadsCount);
+    std::vector<State*> states;
+    for (int i = 0; i < threadsCount; ++i) {
+        states.push_back( new State(iterations,args,i,threadsCount,threadsCount > 1 ? &barrier : 0) );
+    }
+
+    std::clock_t cpuStart = std::clock();
+    if (threadsCount == 1) {
+        ///Run in the main thread: some benchmarks create nodes, which must be done in the main thread
+        func(*states[0]);
+    } else {
+        std::vector<BenchmarkThread*> threads;
+        for (int i = 0; i < threadsCount; ++i) {
+            threads.push_back( new BenchmarkThread(func,states[i]) );
+            threads.back()->start();
+        }
+        for (int i = 0; i < threadsCount; ++i) {
+            threads[i]->wait();
+            delete threads[i];
+        }
+    }
+    std::clock_t cpuEnd = std::clock();
+
+    *realNs = 0.;
+    *items = 0;
+    *bytes = 0;
+    error->clear();
+    for (int i = 0; i < threadsCount; ++i) {
+        *realNs = std::max( *realNs, states[i]->getElapsedNanoSeconds() );
+        *items += states[i]->getItemsProcessed();
+        *bytes += states[i]->getBytesProcessed();
+        if ( error->empty() ) {
+            *error = states[i]->getError();
+        }
+        delete states[i];
+    }
+    *cpuNs = (double)(cpuEnd - cpuStart) * 1e9 / CLOCKS_PER_SEC;
+}
+
+static RunResult
+runBenchmark(const std::string& name,
+             BenchmarkFunction func,
+             const std::vector<int>& args,
+             int threadsCount,
+             double minTime)
+{
+    RunResult ret;
+
+    ret.name = name;
+
+    ///Same heuristic as google-benchmark: grow the number of iterations until the run lasts at least minTime
+    long long iterations = 1;
+    double realNs,cpuNs;
+    long long items,bytes;
+    for (;;) {
+        runOnce(func, args, threadsCount, iterations, &realNs, &cpuNs, &items, &bytes, &ret.error);
+        if ( !ret.error.empty() ) {
+            return ret;
+        }
+        double seconds = realNs * 1e-9;
+        if ( (seconds >= minTime) || (iterations >= NATRON_BENCHMARK_MAX_ITERATIONS) ) {
+            break;
+        }
+        double multiplier = minTime * 1.4 / std::max(seconds,1e-9);
+        if (seconds / minTime <= 0.1) {
+            multiplier = std::min(multiplier,10.);
+        }
+        long long next = (long long)(iterations * multiplier);
+        iterations = std::min( std::max(next,iterations + 1), NATRON_BENCHMARK_MAX_ITERATIONS );
+    }
+
+    ret.iterations = iterations * threadsCount;
+    ret.realTimeNs = realNs / iterations;
+    ret.cpuTimeNs = cpuNs / ret.iterations;
+    if (realNs > 0.) {
+        ret.itemsPerSecond = (double)items * 1e9 / realNs;
+        ret.bytesPerSecond = (double)bytes * 1e9 / realNs;
+    }
+
+    return ret;
+} // runBenchmark
+
+static std::string
+escapeJSON(const std::string& str)
+{
+    std::string ret;
+
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        char c = str[i];
+        switch (c) {
+        case '"':
+            ret += "\\\"";
+            break;
+        case '\\':
+            ret += "\\\\";
+            break;
+        case '\n':
+            ret += "\\n";
+            break;
+        case '\t':
+            ret += "\\t";
+            break;
+        default:
+            if ( (unsigned char)c < 0x20 ) {
+                char buf[8];
+                std::sprintf(buf, "\\u%04x", (unsigned int)c);
+                ret += buf;
+            } else {
+                ret += c;
+            }
+            break;
+        }
+    }
+
+    return ret;
+}
+
+static void
+writeJSON(std::ostream& os,
+          const std::string& executable,
+          const std::vector<RunResult>& results)
+{
+    os.precision(6);
+    os << std::fixed;
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << "    \"date\": \"" << escapeJSON( QDateTime::currentDateTime().toString(Qt::ISODate).toStdString() ) << "\",\n";
+    os << "    \"executable\": \"" << escapeJSON(executable) << "\",\n";
+    os << "    \"num_cpus\": " << QThread::idealThreadCount() << ",\n";
+#ifdef DEBUG
+    os << "    \"library_build_type\": \"debug\",\n";
+#else
+    os << "    \"library_build_type\": \"release\",\n";
+#endif
+    os << "    \"natron_version\": \"" << NATRON_VERSION_STRING << "\"\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const RunResult& r = results[i];
+        os << (i == 0 ? "\n" : ",\n");
+        os << "    {\n";
+        os << "      \"name\": \"" << escapeJSON(r.name) << "\",\n";
+        if ( !r.error.empty() ) {
+            os << "      \"error_occurred\": true,\n";
+            os << "      \"error_message\": \"" << escapeJSON(r.error) << "\"\n";
+        } else {
+            os << "      \"iterations\": " << r.iterations << ",\n";
+            os << "      \"real_time\": " << r.realTimeNs << ",\n";
+            os << "      \"cpu_time\": " << r.cpuTimeNs << ",\n";
+            if (r.bytesPerSecond > 0.) {
+                os << "      \"bytes_per_second\": " << r.bytesPerSecond << ",\n";
+            }
+            if (r.itemsPerSecond > 0.) {
+                os << "      \"items_per_second\": " << r.itemsPerSecond << ",\n";
+            }
+            os << "      \"time_unit\": \"ns\"\n";
+        }
+        os << "    }";
+    }
+    os << "\n  ]\n";
+    os << "}\n";
+}
+
+static void
+printConsoleHeader()
+{
+    std::printf("%-60s %15s %15s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    std::printf("%s\n", std::string(105,'-').c_str());
+}
+
+static void
+printConsoleResult(const RunResult& r)
+{
+    if ( !r.error.empty() ) {
+        std::printf( "%-60s ERROR: %s\n", r.name.c_str(), r.error.c_str() );
+    } else {
+        std::printf("%-60s %12.0f ns %12.0f ns %12lld", r.name.c_str(), r.realTimeNs, r.cpuTimeNs, r.iterations);
+        if (r.bytesPerSecond > 0.) {
+            std::printf( " %10.1fMB/s", r.bytesPerSecond / (1024. * 1024.) );
+        }
+        if (r.itemsPerSecond > 0.) {
+            std::printf( " %10.1fk items/s", r.itemsPerSecond / 1000. );
+        }
+        std::printf("\n");
+    }
+    std::fflush(stdout);
+}
+
+static bool
+parseOptions(int argc,
+             char* argv[],
+             Options* options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string opt(argv[i]);
+        std::size_t eq = opt.find('=');
+        std::string key = opt.substr(0,eq);
+        std::string value = eq == std::string::npos ? std::string() : opt.substr(eq + 1);
+        if (key == "--benchmark_filter") {
+            options->filter = QRegExp( QString::fromUtf8( value.c_str() ) );
+            if ( !options->filter.isValid() ) {
+                std::cerr << "Invalid filter: " << value << std::endl;
+
+                return false;
+            }
+        } else if (key == "--benchmark_min_time") {
+            std::stringstream ss(value);
+            ss >> options->minTime;
+            if (ss.fail() || options->minTime <= 0.) {
+                std::cerr << "Invalid minimum time: " << value << std::endl;
+
+                return false;
+            }
+        } else if (key == "--benchmark_format") {
+            if (value == "json") {
+                options->jsonOnStdout = true;
+            } else if (value == "console") {
+                options->jsonOnStdout = false;
+            } else {
+                std::cerr << "Unknown format: " << value << std::endl;
+
+                return false;
+            }
+        } else if (key == "--benchmark_out") {
+            options->outFile = value;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark_filter=<regexp>] [--benchmark_min_time=<seconds>]"
+                " [--benchmark_format=<console|json>] [--benchmark_out=<file>]" << std::endl;
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int
+Natron::Benchmark::runBenchmarks(int argc,
+                                 char* argv[])
+{
+    Options options;
+
+    if ( !parseOptions(argc, argv, &options) ) {
+        return 1;
+    }
+
+    if (!options.jsonOnStdout) {
+        printConsoleHeader();
+    }
+
+    std::vector<RunResult> results;
+    const std::vector<Definition*>& benchmarks = getRegisteredBenchmarks();
+    for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+        const Definition* def = benchmarks[i];
+        std::vector<std::vector<int> > argsList = def->getArgs();
+        if ( argsList.empty() ) {
+            argsList.push_back( std::vector<int>() );
+        }
+        std::vector<int> threadsList = def->getThreads();
+        bool explicitThreads = !threadsList.empty();
+        if (!explicitThreads) {
+            threadsList.push_back(1);
+        }
+
+        for (std::size_t a = 0; a < argsList.size(); ++a) {
+            for (std::size_t t = 0; t < threadsList.size(); ++t) {
+                std::stringstream name;
+                name << def->getName();
+                for (std::size_t k = 0; k < argsList[a].size(); ++k) {
+                    name << '/' << argsList[a][k];
+                }
+                if (explicitThreads) {
+                    name << "/threads:" << threadsList[t];
+                }
+                if ( options.filter.indexIn( QString::fromUtf8( name.str().c_str() ) ) == -1 ) {
+                    continue;
+                }
+                RunResult r = runBenchmark(name.str(), def->getFunction(), argsList[a], threadsList[t], options.minTime);
+                if (!options.jsonOnStdout) {
+                    printConsoleResult(r);
+                }
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (options.jsonOnStdout) {
+        writeJSON(std::cout, argv[0], results);
+    }
+    if ( !options.outFile.empty() ) {
+        std::ofstream ofile( options.outFile.c_str() );
+        if (!ofile) {
+            std::cerr << "Could not open " << options.outFile << " for writing" << std::endl;
+
+            return 1;
+        }
+        writeJSON(ofile, argv[0], results);
+    }
+
+    return 0;
+} // runBenchmarks
@@ -0,0 +1,244 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_BENCHMARKS_BENCHMARK_H_
+#define NATRON_BENCHMARKS_BENCHMARK_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QElapsedTimer>
+CLANG_DIAG_ON(deprecated)
+
+/**
+ * @brief A small micro-benchmark harness modeled after google-benchmark: a benchmark is a function taking a State
+ * and looping while State::keepRunning() returns true. The harness picks the number of iterations so that each
+ * benchmark runs for at least --benchmark_min_time seconds, and writes the results either as a console table or
+ * in the JSON format of google-benchmark (--benchmark_format=json or --benchmark_out=<file>), so that the results
+ * of 2 commits can be compared with the tools written for google-benchmark.
+ *
+ * Usage:
+ *   static void BM_Foo(Natron::Benchmark::State& state)
+ *   {
+ *       /// setup, not timed
+ *       while ( state.keepRunning() ) {
+ *           /// timed code
+ *       }
+ *   }
+ *   NATRON_BENCHMARK(BM_Foo)->arg(64)->arg(1024)->threads(4);
+ **/
+namespace Natron {
+namespace Benchmark {
+
+class StartBarrier;
+class State
+{
+public:
+
+    State(long long iterations,
+          const std::vector<int>& args,
+          int threadIndex,
+          int threadsCount,
+          StartBarrier* barrier);
+
+    /**
+     * @brief Returns true while the timed loop must go on. The timer is started on the first call and
+     * stopped when it returns false.
+     * When the benchmark runs on several threads, the first call waits for all the threads to reach it: the set-up
+     * done before the loop by the thread 0 is complete when the other threads enter the loop.
+     **/
+    bool keepRunning()
+    {
+        if (!_started) {
+            _started = true;
+            waitForOtherThreads();
+            if ( !_error.empty() ) {
+                return false;
+            }
+            resumeTiming();
+        }
+        if (_remaining > 0) {
+            --_remaining;
+            return true;
+        }
+        if (_running) {
+            pauseTiming();
+        }
+        return false;
+    }
+
+    /**
+     * @brief Excludes the code between pauseTiming() and resumeTiming() from the measured time. This has a cost,
+     * do not call it on every iteration of a very short benchmark.
+     **/
+    void pauseTiming();
+
+    void resumeTiming();
+
+    /**
+     * @brief Marks the benchmark as failed: the timed loop is not entered (or left on the next call to keepRunning())
+     * and the message is reported instead of the timings.
+     **/
+    void skipWithError(const std::string& message);
+
+    ///The index-th argument given to Definition::arg()
+    int range(int index = 0) const;
+
+    int threadIndex() const
+    {
+        return _threadIndex;
+    }
+
+    int threads() const
+    {
+        return _threadsCount;
+    }
+
+    long long iterations() const
+    {
+        return _iterations;
+    }
+
+    ///Used to report items_per_second and bytes_per_second
+    void setItemsProcessed(long long items)
+    {
+        _itemsProcessed = items;
+    }
+
+    void setBytesProcessed(long long bytes)
+    {
+        _bytesProcessed = bytes;
+    }
+
+    long long getItemsProcessed() const
+    {
+        return _itemsProcessed;
+    }
+
+    long long getBytesProcessed() const
+    {
+        return _bytesProcessed;
+    }
+
+    const std::string& getError() const
+    {
+        return _error;
+    }
+
+    ///The time spent in the timed loop, in nanoseconds
+    double getElapsedNanoSeconds() const
+    {
+        return _elapsedNs;
+    }
+
+private:
+
+    void waitForOtherThreads();
+
+    long long _iterations;
+    long long _remaining;
+    std::vector<int> _args;
+    int _threadIndex;
+    int _threadsCount;
+    StartBarrier* _barrier;
+    bool _started;
+    bool _running;
+    QElapsedTimer _timer;
+    double _elapsedNs;
+    long long _itemsProcessed;
+    long long _bytesProcessed;
+    std::string _error;
+};
+
+/**
+ * @brief Prevents the compiler from optimizing away a computation whose result is otherwise unused.
+ **/
+template <typename T>
+inline void
+doNotOptimize(const T& value)
+{
+    static volatile char sink;
+
+    sink = *reinterpret_cast<const volatile char*>(&value);
+}
+
+typedef void (*BenchmarkFunction)(State& state);
+
+/**
+ * @brief A registered benchmark. Each argument set and each thread count is run as a separate benchmark named
+ * name/arg0/arg1/threads:n
+ **/
+class Definition
+{
+public:
+
+    Definition(const std::string& name,
+               BenchmarkFunction func);
+
+    ///Runs the benchmark once more with a single argument
+    Definition* arg(int a);
+
+    ///Runs the benchmark once more with 2 arguments
+    Definition* args(int a,int b);
+
+    ///Runs the benchmark once more on n threads running the function concurrently, for contention measurements
+    Definition* threads(int n);
+
+    const std::string& getName() const
+    {
+        return _name;
+    }
+
+    BenchmarkFunction getFunction() const
+    {
+        return _func;
+    }
+
+    const std::vector<std::vector<int> >& getArgs() const
+    {
+        return _args;
+    }
+
+    const std::vector<int>& getThreads() const
+    {
+        return _threads;
+    }
+
+private:
+
+    std::string _name;
+    BenchmarkFunction _func;
+    std::vector<std::vector<int> > _args;
+    std::vector<int> _threads;
+};
+
+Definition* registerBenchmark(const char* name,BenchmarkFunction func);
+
+/**
+ * @brief Runs all the registered benchmarks matching --benchmark_filter=<regexp> and reports them.
+ * The other recognized options are --benchmark_min_time=<seconds>, --benchmark_format=<console|json> and
+ * --benchmark_out=<file> (always JSON). Returns the exit code of the program.
+ **/
+int runBenchmarks(int argc,char* argv[]);
+
+} // namespace Benchmark
+} // namespace Natron
+
+#define NATRON_BENCHMARK_CONCAT_(a,b) a ## b
+#define NATRON_BENCHMARK_CONCAT(a,b) NATRON_BENCHMARK_CONCAT_(a,b)
+
+#define NATRON_BENCHMARK(func) \
+    static Natron::Benchmark::Definition* NATRON_BENCHMARK_CONCAT(natronBenchmark_,__LINE__) = \
+    Natron::Benchmark::registerBenchmark(# func,func)
+
+#endif // NATRON_BENCHMARKS_BENCHMARK_H_
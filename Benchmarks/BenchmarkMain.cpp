@@ -0,0 +1,37 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "Benchmarks/Benchmark.h"
+
+#include "Engine/AppManager.h"
+#include "Engine/AppInstance.h"
+
+int
+main(int argc,
+     char *argv[])
+{
+    ///Same set-up as the unit tests: a background application, with the plug-ins loaded and the caches created.
+    ///The command line is kept for the benchmark options.
+    AppManager* manager = new AppManager;
+    int appArgc = 0;
+    CLArgs cl;
+    manager->load(appArgc, 0, cl);
+
+    int ret = Natron::Benchmark::runBenchmarks(argc, argv);
+
+    AppInstance* app = manager->getTopLevelInstance();
+    if (app) {
+        app->quit();
+    }
+    appPTR->setNumberOfThreads(0);
+    delete appPTR;
+
+    return ret;
+}
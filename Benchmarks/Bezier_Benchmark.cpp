@@ -0,0 +1,116 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cmath>
+#include <climits>
+#include <list>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/AppManager.h"
+#include "Engine/AppInstance.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/RotoContext.h"
+
+using namespace Natron::Benchmark;
+
+///Number of control points of the benchmarked shape
+#define kBezierBenchmarkControlPoints 16
+
+/**
+ * @brief Returns a closed shape of kBezierBenchmarkControlPoints points placed on a circle, in a Roto node
+ * created the first time. Must be called on the main thread.
+ **/
+static boost::shared_ptr<Bezier>
+getBenchmarkBezier()
+{
+    static boost::shared_ptr<Natron::Node> rotoNode;
+    static boost::shared_ptr<Bezier> bezier;
+
+    if (bezier) {
+        return bezier;
+    }
+
+    AppInstance* app = appPTR->getTopLevelInstance();
+    if (!app) {
+        return bezier;
+    }
+    rotoNode = app->createNode( CreateNodeArgs(PLUGINID_OFX_ROTO,
+                                               "",
+                                               -1,-1,false,INT_MIN,INT_MIN,false,true,false,
+                                               QString(),CreateNodeArgs::DefaultValuesList(),
+                                               app->getProject()) );
+    if (!rotoNode) {
+        return bezier;
+    }
+    boost::shared_ptr<RotoContext> context = rotoNode->getRotoContext();
+    if (!context) {
+        return bezier;
+    }
+
+    const double radius = 500.;
+    for (int i = 0; i < kBezierBenchmarkControlPoints; ++i) {
+        double angle = 2. * M_PI * i / kBezierBenchmarkControlPoints;
+        double x = 1000. + radius * std::cos(angle);
+        double y = 1000. + radius * std::sin(angle);
+        if (i == 0) {
+            bezier = context->makeBezier(x, y, "Bezier", 0);
+        } else {
+            bezier->addControlPoint(x, y, 0);
+        }
+    }
+    bezier->setCurveFinished(true);
+
+    return bezier;
+}
+
+///Evaluates the shape with range(0) points per segment, as done for the overlay and for the render of the Roto node
+static void
+BM_BezierEvaluateDeCasteljau(State& state)
+{
+    boost::shared_ptr<Bezier> bezier = getBenchmarkBezier();
+
+    if (!bezier) {
+        state.skipWithError("Could not create a Roto node, the " PLUGINID_OFX_ROTO " plug-in must be installed");
+    }
+
+    const int pointsPerSegment = state.range(0);
+    while ( state.keepRunning() ) {
+        std::list<Natron::Point> points;
+        RectD bbox;
+        bezier->evaluateAtTime_DeCasteljau(0, 0, pointsPerSegment, &points, &bbox);
+        doNotOptimize( points.size() );
+    }
+    state.setItemsProcessed(state.iterations() * kBezierBenchmarkControlPoints * pointsPerSegment);
+}
+
+NATRON_BENCHMARK(BM_BezierEvaluateDeCasteljau)->arg(10)->arg(50)->arg(200);
+
+static void
+BM_BezierEvaluateFeatherDeCasteljau(State& state)
+{
+    boost::shared_ptr<Bezier> bezier = getBenchmarkBezier();
+
+    if (!bezier) {
+        state.skipWithError("Could not create a Roto node, the " PLUGINID_OFX_ROTO " plug-in must be installed");
+    }
+
+    const int pointsPerSegment = state.range(0);
+    while ( state.keepRunning() ) {
+        std::list<Natron::Point> points;
+        RectD bbox;
+        bezier->evaluateFeatherPointsAtTime_DeCasteljau(0, 0, pointsPerSegment, true, &points, &bbox);
+        doNotOptimize( points.size() );
+    }
+    state.setItemsProcessed(state.iterations() * kBezierBenchmarkControlPoints * pointsPerSegment);
+}
+
+NATRON_BENCHMARK(BM_BezierEvaluateFeatherDeCasteljau)->arg(50);
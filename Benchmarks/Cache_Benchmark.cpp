@@ -0,0 +1,97 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/AppManager.h"
+#include "Engine/Image.h"
+
+using namespace Natron::Benchmark;
+
+///Small tiles so that the cache bookkeeping and its locking dominate, not the allocation of the pixels
+#define kCacheBenchmarkTileSize 64
+
+static boost::shared_ptr<Natron::ImageParams>
+makeTileParams()
+{
+    RectD rod(0,0,kCacheBenchmarkTileSize,kCacheBenchmarkTileSize);
+    std::map<int, std::map<int,std::vector<RangeD> > > framesNeeded;
+
+    return Natron::Image::makeParams(0, rod, 1., 0, false, Natron::ImageComponents::getRGBAComponents(),
+                                     Natron::eImageBitDepthFloat, framesNeeded);
+}
+
+static Natron::ImageKey
+makeTileKey(int index)
+{
+    return Natron::ImageKey( (U64)index + 1, false, 0, 0 );
+}
+
+///All threads request the same sequence of new tiles: the first thread to reach a tile creates it and the others
+///find it in the cache, as do the render threads of several viewers reading the same inputs. The cache evicts
+///the oldest tiles as the sequence goes on.
+static void
+BM_CacheGetOrCreate(State& state)
+{
+    boost::shared_ptr<Natron::ImageParams> params = makeTileParams();
+
+    if (state.threadIndex() == 0) {
+        appPTR->clearNodeCache();
+    }
+
+    int index = 0;
+    while ( state.keepRunning() ) {
+        boost::shared_ptr<Natron::Image> image;
+        Natron::getImageFromCacheOrCreate(makeTileKey(index), params, &image);
+        if (!image) {
+            state.skipWithError("Failed to allocate an image");
+            continue;
+        }
+        image->allocateMemory();
+        ++index;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+
+NATRON_BENCHMARK(BM_CacheGetOrCreate)->threads(1)->threads(2)->threads(4)->threads(8);
+
+///All threads look-up tiles that are all in the cache
+static void
+BM_CacheGet(State& state)
+{
+    const int keys = state.range(0);
+
+    ///The other threads enter the loop once the first one has filled the cache
+    if (state.threadIndex() == 0) {
+        appPTR->clearNodeCache();
+        boost::shared_ptr<Natron::ImageParams> params = makeTileParams();
+        for (int i = 0; i < keys; ++i) {
+            boost::shared_ptr<Natron::Image> image;
+            Natron::getImageFromCacheOrCreate(makeTileKey(i), params, &image);
+            if (image) {
+                image->allocateMemory();
+            }
+        }
+    }
+
+    int index = state.threadIndex() * keys / state.threads();
+    while ( state.keepRunning() ) {
+        std::list<boost::shared_ptr<Natron::Image> > images;
+        Natron::getImageFromCache(makeTileKey(index), &images);
+        doNotOptimize( images.size() );
+        index = (index + 1) % keys;
+    }
+    state.setItemsProcessed( state.iterations() );
+}
+
+NATRON_BENCHMARK(BM_CacheGet)->arg(256)->threads(1)->threads(2)->threads(4)->threads(8);
@@ -0,0 +1,43 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstdlib>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/Curve.h"
+
+using namespace Natron::Benchmark;
+
+///Evaluates a curve with range(0) keyframes at 1000 times spread over the whole curve
+static void
+BM_CurveGetValueAt(State& state)
+{
+    const int keyframes = state.range(0);
+    const int evaluations = 1000;
+
+    srand(2000);
+    Curve c;
+    for (int i = 0; i < keyframes; ++i) {
+        // coverity[dont_call]
+        c.addKeyFrame( KeyFrame( (double)i * 10., (double)(rand() % 100) ) );
+    }
+    const double step = (double)(keyframes * 10) / evaluations;
+
+    while ( state.keepRunning() ) {
+        double sum = 0.;
+        for (int i = 0; i < evaluations; ++i) {
+            sum += c.getValueAt(i * step);
+        }
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.iterations() * evaluations);
+}
+
+NATRON_BENCHMARK(BM_CurveGetValueAt)->arg(2)->arg(100)->arg(10000);
@@ -0,0 +1,43 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/Hash64.h"
+
+using namespace Natron::Benchmark;
+
+///Appends range(0) values to a hash and computes it, as done for every node when the graph changes
+static void
+BM_Hash64AppendAndCompute(State& state)
+{
+    const int count = state.range(0);
+
+    srand(2000);
+    std::vector<U64> values(count);
+    for (int i = 0; i < count; ++i) {
+        // coverity[dont_call]
+        values[i] = (U64)rand();
+    }
+
+    while ( state.keepRunning() ) {
+        Hash64 hash;
+        for (int i = 0; i < count; ++i) {
+            hash.append<U64>(values[i]);
+        }
+        hash.computeHash();
+        doNotOptimize( hash.value() );
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+
+NATRON_BENCHMARK(BM_Hash64AppendAndCompute)->arg(16)->arg(256)->arg(4096);
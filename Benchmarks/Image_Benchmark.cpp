@@ -0,0 +1,106 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/Image.h"
+
+using namespace Natron::Benchmark;
+
+///Bytes of a RGBA float pixel
+#define kRGBAFloatPixelSize (4 * (long long)sizeof(float))
+
+///A size x size RGBA float image, filled with a constant color
+static Natron::Image*
+makeImage(int size,
+          Natron::ImageBitDepthEnum depth = Natron::eImageBitDepthFloat,
+          unsigned int mipMapLevel = 0,
+          bool useBitmap = false)
+{
+    RectI bounds(0,0,size,size);
+    RectD rod(0,0,size << mipMapLevel,size << mipMapLevel);
+    Natron::Image* ret = new Natron::Image(Natron::ImageComponents::getRGBAComponents(), rod, bounds, mipMapLevel, 1., depth, useBitmap);
+
+    ret->fill(bounds, 0.5, 0.25, 0.125, 1.);
+
+    return ret;
+}
+
+///A bitmap with a rendered rectangle in the middle and a rendered band at the bottom, as left by a partial render
+static void
+BM_BitmapMinimalNonMarkedRects(State& state)
+{
+    const int size = state.range(0);
+    const RectI rod(0,0,size,size);
+    Natron::Bitmap bm(rod);
+
+    bm.markForRendered( RectI(size / 4,size / 4,size * 3 / 4,size * 3 / 4) );
+    bm.markForRendered( RectI(0,0,size,size / 8) );
+
+    while ( state.keepRunning() ) {
+        std::list<RectI> rects;
+        bm.minimalNonMarkedRects(rod, rects);
+        doNotOptimize( rects.size() );
+    }
+    state.setItemsProcessed( state.iterations() * rod.area() );
+}
+
+NATRON_BENCHMARK(BM_BitmapMinimalNonMarkedRects)->arg(512)->arg(2048);
+
+///Builds the next mipmap level of a RGBA float image
+static void
+BM_ImageHalve(State& state)
+{
+    const int size = state.range(0);
+    boost::shared_ptr<Natron::Image> src( makeImage(size) );
+    const RectI bounds = src->getBounds();
+    boost::shared_ptr<Natron::Image> dst( makeImage(size / 2, Natron::eImageBitDepthFloat, 1) );
+
+    while ( state.keepRunning() ) {
+        src->downscaleMipMap(src->getRoD(), bounds, 0, 1, false, dst.get());
+    }
+    state.setBytesProcessed( state.iterations() * bounds.area() * kRGBAFloatPixelSize );
+}
+
+NATRON_BENCHMARK(BM_ImageHalve)->arg(512)->arg(2048);
+
+static void
+BM_ImagePasteFrom(State& state)
+{
+    const int size = state.range(0);
+    boost::shared_ptr<Natron::Image> src( makeImage(size) );
+    boost::shared_ptr<Natron::Image> dst( makeImage(size) );
+    const RectI bounds = src->getBounds();
+
+    while ( state.keepRunning() ) {
+        dst->pasteFrom(*src, bounds, false);
+    }
+    state.setBytesProcessed( state.iterations() * bounds.area() * kRGBAFloatPixelSize );
+}
+
+NATRON_BENCHMARK(BM_ImagePasteFrom)->arg(512)->arg(2048);
+
+///Linear RGBA float to sRGB RGBA byte, as done when a plug-in does not support floating point images
+static void
+BM_ImageConvertToFormat(State& state)
+{
+    const int size = state.range(0);
+    boost::shared_ptr<Natron::Image> src( makeImage(size) );
+    boost::shared_ptr<Natron::Image> dst( makeImage(size, Natron::eImageBitDepthByte) );
+    const RectI bounds = src->getBounds();
+
+    while ( state.keepRunning() ) {
+        src->convertToFormat(bounds, Natron::eViewerColorSpaceLinear, Natron::eViewerColorSpaceSRGB, 3, false, false, false, dst.get());
+    }
+    state.setBytesProcessed( state.iterations() * bounds.area() * kRGBAFloatPixelSize );
+}
+
+NATRON_BENCHMARK(BM_ImageConvertToFormat)->arg(512)->arg(2048);
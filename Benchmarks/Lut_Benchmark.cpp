@@ -0,0 +1,119 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <vector>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/Lut.h"
+#include "Engine/Rect.h"
+
+using namespace Natron::Benchmark;
+using namespace Natron::Color;
+
+///range(0) linear values in [0,1]
+static std::vector<float>
+makeLinearRamp(int count)
+{
+    std::vector<float> ret(count);
+
+    for (int i = 0; i < count; ++i) {
+        ret[i] = (float)i / (count - 1);
+    }
+
+    return ret;
+}
+
+static void
+BM_LutToColorSpaceUint8FromLinearFloatFast(State& state)
+{
+    const Lut* lut = LutManager::sRGBLut();
+
+    lut->validate();
+    const int count = state.range(0);
+    std::vector<float> src = makeLinearRamp(count);
+    std::vector<unsigned char> dst(count);
+
+    while ( state.keepRunning() ) {
+        for (int i = 0; i < count; ++i) {
+            dst[i] = lut->toColorSpaceUint8FromLinearFloatFast(src[i]);
+        }
+        doNotOptimize(dst[0]);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+
+NATRON_BENCHMARK(BM_LutToColorSpaceUint8FromLinearFloatFast)->arg(1 << 16);
+
+static void
+BM_LutFromColorSpaceUint8ToLinearFloatFast(State& state)
+{
+    const Lut* lut = LutManager::sRGBLut();
+
+    lut->validate();
+    const int count = state.range(0);
+    std::vector<unsigned char> src(count);
+    for (int i = 0; i < count; ++i) {
+        src[i] = (unsigned char)(i & 0xff);
+    }
+    std::vector<float> dst(count);
+
+    while ( state.keepRunning() ) {
+        for (int i = 0; i < count; ++i) {
+            dst[i] = lut->fromColorSpaceUint8ToLinearFloatFast(src[i]);
+        }
+        doNotOptimize(dst[0]);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+
+NATRON_BENCHMARK(BM_LutFromColorSpaceUint8ToLinearFloatFast)->arg(1 << 16);
+
+///The buffer version, used by the readers and writers
+static void
+BM_LutToColorSpaceFloatFromLinearFloatFast(State& state)
+{
+    const Lut* lut = LutManager::sRGBLut();
+
+    lut->validate();
+    const int count = state.range(0);
+    const std::vector<float> src = makeLinearRamp(count);
+    std::vector<float> buf(count);
+
+    while ( state.keepRunning() ) {
+        buf = src;
+        lut->toColorSpaceFloatFromLinearFloatFast(&buf[0], count);
+        doNotOptimize(buf[0]);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+
+NATRON_BENCHMARK(BM_LutToColorSpaceFloatFromLinearFloatFast)->arg(1 << 16);
+
+///Conversion of a packed RGBA float image to 8-bit BGRA, with the error diffusion
+static void
+BM_LutToBytePacked(State& state)
+{
+    const Lut* lut = LutManager::sRGBLut();
+
+    lut->validate();
+    const int size = state.range(0);
+    const RectI rod(0,0,size,size);
+    std::vector<float> src = makeLinearRamp(size * size * 4);
+    std::vector<unsigned char> dst(size * size * 4);
+
+    while ( state.keepRunning() ) {
+        lut->to_byte_packed(&dst[0], &src[0], rod, rod, rod, ePixelPackingRGBA, ePixelPackingBGRA, false, false);
+        doNotOptimize(dst[0]);
+    }
+    state.setItemsProcessed(state.iterations() * size * size);
+    state.setBytesProcessed( state.iterations() * size * size * 4 * (long long)sizeof(float) );
+}
+
+NATRON_BENCHMARK(BM_LutToBytePacked)->arg(512)->arg(2048);
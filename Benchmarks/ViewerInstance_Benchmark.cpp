@@ -0,0 +1,89 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <vector>
+
+#include "Benchmarks/Benchmark.h"
+#include "Engine/Image.h"
+#include "Engine/Lut.h"
+#include "Engine/ViewerInstancePrivate.h"
+
+using namespace Natron::Benchmark;
+
+/**
+ * @brief Converts a size x size linear RGBA float image to the viewer texture with the given bit depth,
+ * the way the viewer does for each rendered frame (scaleToTexture8bits or scaleToTexture32bits).
+ **/
+static void
+benchmarkViewerConversion(State& state,
+                          int bitDepth,
+                          bool computeVminVmax)
+{
+    const int size = state.range(0);
+    const RectI bounds(0,0,size,size);
+    const RectD rod(0,0,size,size);
+    boost::shared_ptr<Natron::Image> image( new Natron::Image(Natron::ImageComponents::getRGBAComponents(), rod, bounds, 0, 1.,
+                                                              Natron::eImageBitDepthFloat) );
+
+    ///A ramp so that the error diffusion and the colour-space conversion do not always hit the same values
+    {
+        Natron::Image::WriteAccess acc = image->getWriteRights();
+        for (int y = 0; y < size; ++y) {
+            float* pix = (float*)acc.pixelAt(0, y);
+            for (int x = 0; x < size; ++x, pix += 4) {
+                pix[0] = (float)x / size;
+                pix[1] = (float)y / size;
+                pix[2] = 0.5f;
+                pix[3] = 1.f;
+            }
+        }
+    }
+
+    const Natron::Color::Lut* lut = Natron::Color::LutManager::sRGBLut();
+    lut->validate();
+
+    TextureRect texRect(0, 0, size, size, size, size, 1, 1.);
+    RenderViewerArgs args(image, texRect, Natron::eDisplayChannelsRGB, Natron::eImagePremultiplicationPremultiplied, bitDepth,
+                          1., 0., lut, lut, 3, false, computeVminVmax, boost::shared_ptr<HistogramBins>());
+    std::size_t bytesPerPixel = bitDepth == OpenGLViewerI::eBitDepthByte ? sizeof(U32) : 4 * sizeof(float);
+    std::vector<unsigned char> buffer(bytesPerPixel * size * size);
+
+    while ( state.keepRunning() ) {
+        std::pair<double,double> vMinMax = renderFunctor(std::make_pair(0,size), args, NULL, &buffer[0]);
+        doNotOptimize(vMinMax.first);
+    }
+    state.setItemsProcessed( state.iterations() * bounds.area() );
+    state.setBytesProcessed( state.iterations() * bounds.area() * 4 * (long long)sizeof(float) );
+}
+
+static void
+BM_ViewerScaleToTexture8bits(State& state)
+{
+    benchmarkViewerConversion(state, OpenGLViewerI::eBitDepthByte, false);
+}
+
+NATRON_BENCHMARK(BM_ViewerScaleToTexture8bits)->arg(512)->arg(2048)->arg(4096);
+
+static void
+BM_ViewerScaleToTexture32bits(State& state)
+{
+    benchmarkViewerConversion(state, OpenGLViewerI::eBitDepthFloat, false);
+}
+
+NATRON_BENCHMARK(BM_ViewerScaleToTexture32bits)->arg(512)->arg(2048);
+
+///With the computation of the displayed range used by the auto-contrast
+static void
+BM_ViewerScaleToTexture32bitsAutoContrast(State& state)
+{
+    benchmarkViewerConversion(state, OpenGLViewerI::eBitDepthFloat, true);
+}
+
+NATRON_BENCHMARK(BM_ViewerScaleToTexture32bitsAutoContrast)->arg(2048);
@@ -14,8 +14,11 @@
 
 #include "AppInstance.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <list>
+#include <set>
 #include <stdexcept>
 
 #include <QDir>
@@ -25,10 +28,13 @@
 #include <QFileInfo>
 #include <QEventLoop>
 #include <QSettings>
+#include <QFile>
 
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
 #include <boost/bind.hpp>
 #endif
+#include <SequenceParsing.h>
+#include <ofxNatron.h>
 
 #include "Global/QtCompat.h"
 
@@ -38,12 +44,18 @@
 #include "Engine/Node.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/BlockingBackgroundRender.h"
+#include "Engine/WritersRenderGroup.h"
 #include "Engine/NodeSerialization.h"
 #include "Engine/FileDownloader.h"
+#include "Engine/FrameStreamer.h"
+#include "Engine/Hash64.h"
 #include "Engine/Settings.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/NoOp.h"
 #include "Engine/OfxHost.h"
+#include "Engine/ProcessMessage.h"
+#include "Engine/RenderCheckpoint.h"
+#include "Engine/TrackScheduler.h"
 
 using namespace Natron;
 
@@ -93,6 +105,13 @@ struct AppInstancePrivate
     bool _creatingGroup;
     bool _creatingNode;
     
+    bool resumeRenders; //< the --resume option was given
+    bool verifyResumedFrames; //< the --resume-verify option was given
+    U64 projectContentHash; //< identifies the render jobs of the project file loaded, for their checkpoints
+    
+    std::string trackerName; //< the Tracker node being tracked by trackForCL
+    std::vector<std::string> trackNames; //< the script names of its tracks, in the order passed to the scheduler
+    
     AppInstancePrivate(int appID,
                        AppInstance* app)
     : _currentProject( new Natron::Project(app) )
@@ -101,11 +120,22 @@ struct AppInstancePrivate
     , creatingGroupMutex()
     , _creatingGroup(false)
     , _creatingNode(false)
+    , resumeRenders(false)
+    , verifyResumedFrames(false)
+    , projectContentHash(0)
+    , trackerName()
+    , trackNames()
     {
     }
     
     void declareCurrentAppVariable_Python();
     
+    /**
+     * @brief Returns the checkpoint recording the frames of the writer already rendered between first and last,
+     * or NULL if the render of this writer cannot be resumed.
+     **/
+    boost::shared_ptr<RenderCheckpoint> createRenderCheckpoint(Natron::OutputEffectInstance* writer,int first,int last);
+    
 };
 
 AppInstance::AppInstance(int appID)
@@ -145,6 +175,21 @@ AppInstance::isCreatingNode() const
     return _imp->_creatingNode;
 }
 
+bool
+AppInstance::progressUpdate(KnobHolder* effect,
+                            double t,
+                            int time)
+{
+    if ( effect && appPTR->isBackground() ) {
+        Natron::ProcessMessage progress(Natron::eProcessMessageTypeFrameProgress);
+        progress.time = time;
+        progress.value = t;
+        appPTR->writeToOutputPipe(QString(),progress);
+    }
+
+    return true;
+}
+
 void
 AppInstance::checkForNewVersion() const
 {
@@ -365,6 +410,79 @@ AppInstance::getWritersWorkForCL(const CLArgs& cl,std::list<AppInstance::RenderR
     }
 }
 
+void
+AppInstance::trackForCL(const CLArgs& cl)
+{
+    const std::list<QString>& trackers = cl.getTrackerArgs();
+    for (std::list<QString>::const_iterator it = trackers.begin(); it != trackers.end(); ++it) {
+        
+        std::string trackerName = it->toStdString();
+        NodePtr tracker = getNodeByFullySpecifiedName(trackerName);
+        if ( !tracker || !tracker->isMultiInstance() || !tracker->isPointTrackerNode() ) {
+            throw std::invalid_argument(trackerName + tr(" is not the name of a Tracker node of the project").toStdString());
+        }
+        
+        ///Each track is a child instance of the Tracker node, tracked with its "track next" button
+        std::list<NodePtr> tracks;
+        tracker->getChildrenMultiInstance(&tracks);
+        
+        std::list<Button_Knob*> trackButtons;
+        _imp->trackerName = trackerName;
+        _imp->trackNames.clear();
+        for (std::list<NodePtr>::iterator it2 = tracks.begin(); it2 != tracks.end(); ++it2) {
+            if ( !*it2 || !(*it2)->getLiveInstance() || (*it2)->isNodeDisabled() ) {
+                continue;
+            }
+            Button_Knob* button = dynamic_cast<Button_Knob*>( (*it2)->getKnobByName(kNatronParamTrackingNext).get() );
+            if (!button) {
+                continue;
+            }
+            trackButtons.push_back(button);
+            _imp->trackNames.push_back( (*it2)->getScriptName() );
+        }
+        
+        if ( trackButtons.empty() ) {
+            std::cout << tr("%1 has no enabled track, nothing to track.").arg( trackerName.c_str() ).toStdString() << std::endl;
+            continue;
+        }
+        
+        int first,last;
+        if ( cl.hasFrameRange() ) {
+            first = cl.getFrameRange().first;
+            last = cl.getFrameRange().second;
+        } else {
+            getFrameRange(&first, &last);
+        }
+        
+        ///The signals of the scheduler are queued to this thread and processed by the loop until tracking is finished
+        TrackScheduler scheduler;
+        scheduler.setUpdateViewerOnTracking(false);
+        QObject::connect( &scheduler, SIGNAL( trackProgressUpdate(int,double) ), this, SLOT( onTrackProgressUpdate(int,double) ) );
+        
+        QEventLoop loop;
+        QObject::connect( &scheduler, SIGNAL( trackingFinished() ), &loop, SLOT( quit() ), Qt::QueuedConnection );
+        scheduler.track(first, last + 1, true, trackButtons);
+        loop.exec();
+        
+        scheduler.quitThread();
+        std::cout << tr("%1: tracking finished.").arg( trackerName.c_str() ).toStdString() << std::endl;
+    }
+    
+    _imp->trackerName.clear();
+    _imp->trackNames.clear();
+}
+
+void
+AppInstance::onTrackProgressUpdate(int track,
+                                   double progress)
+{
+    if ( (track < 0) || ( track >= (int)_imp->trackNames.size() ) ) {
+        return;
+    }
+    std::cout << tr("%1: %2 tracked at %3%").arg( _imp->trackerName.c_str() ).arg( _imp->trackNames[track].c_str() )
+    .arg( (int)(progress * 100) ).toStdString() << std::endl;
+}
+
 NodePtr
 AppInstance::createWriter(const std::string& filename,
                           const boost::shared_ptr<NodeCollection>& collection,
@@ -430,6 +548,26 @@ AppInstance::load(const CLArgs& cl)
         
         std::list<AppInstance::RenderRequest> writersWork;
 
+        if ( cl.isResumeEnabled() ) {
+            _imp->resumeRenders = true;
+            _imp->verifyResumedFrames = cl.isResumeVerifyEnabled();
+
+            ///The checkpoints of the renders are only valid for this exact content of the file
+            QFile projectFile( info.absoluteFilePath() );
+            if ( !projectFile.open(QIODevice::ReadOnly) ) {
+                throw std::invalid_argument(tr("Cannot read the project file.").toStdString());
+            }
+            QByteArray content = projectFile.readAll();
+            Hash64 hash;
+            for (int i = 0; i < content.size(); i += sizeof(U64)) {
+                U64 word = 0;
+                memcpy( &word, content.constData() + i, std::min( (int)sizeof(U64), content.size() - i ) );
+                hash.append(word);
+            }
+            hash.computeHash();
+            _imp->projectContentHash = hash.value();
+        }
+
         if (info.suffix() == NATRON_PROJECT_FILE_EXT) {
             
             if ( !_imp->_currentProject->loadProject(info.path(),info.fileName()) ) {
@@ -437,7 +575,6 @@ AppInstance::load(const CLArgs& cl)
             }
             
             getWritersWorkForCL(cl, writersWork);
-            startWritersRendering(writersWork);
 
         } else if (info.suffix() == "py") {
             
@@ -448,6 +585,23 @@ AppInstance::load(const CLArgs& cl)
             throw std::invalid_argument(tr(NATRON_APPLICATION_NAME " only accepts python scripts or .ntp project files").toStdString());
         }
         
+        if ( !cl.getTrackerArgs().empty() ) {
+            trackForCL(cl);
+            
+            ///Keep the tracks in the project file. A script cannot be saved back, its tracks are only used by the renders below.
+            if (info.suffix() == NATRON_PROJECT_FILE_EXT) {
+                if ( _imp->_currentProject->saveProject(_imp->_currentProject->getProjectPath(),
+                                                        _imp->_currentProject->getProjectName(), false).isEmpty() ) {
+                    throw std::invalid_argument(tr("Could not save the project once tracking was done.").toStdString());
+                }
+            }
+            
+            ///Only render the writers that were explicitly requested
+            if ( cl.getWriterArgs().empty() ) {
+                return;
+            }
+        }
+        
         startWritersRendering(writersWork);
         
     } else if (appPTR->getAppType() == AppManager::eAppTypeInterpreter) {
@@ -1051,8 +1205,72 @@ AppInstance::startWritersRendering(const std::list<RenderWork>& writers)
     
     if ( appPTR->isBackground() ) {
         
+        std::list<RenderWork> works;
+        for (std::list<RenderWork>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+            RenderWork w = *it;
+            int first,last;
+            getWriterFrameRange(*it, &first, &last);
+            w.firstFrame = first;
+            w.lastFrame = last;
+            works.push_back(w);
+        }
+        
+        boost::shared_ptr<FrameStreamer> streamer = appPTR->getFrameStreamer();
+        if (streamer) {
+            if (works.size() != 1) {
+                throw std::invalid_argument(tr("The frames of a single Write node can be streamed, use the -w option to select it.").toStdString());
+            }
+            works.front().writer->setFrameStreamer(streamer);
+        }
+        
+        ///Writers that were already rendered partially only render the frames missing
+        std::list<RenderWork> groupWorks;
+        for (std::list<RenderWork>::const_iterator it = works.begin(); it != works.end(); ++it) {
+            boost::shared_ptr<RenderCheckpoint> checkpoint;
+            if (_imp->resumeRenders) {
+                checkpoint = _imp->createRenderCheckpoint(it->writer, it->firstFrame, it->lastFrame);
+                it->writer->setRenderCheckpoint(checkpoint);
+            }
+            std::list<std::pair<int,int> > framesToRender;
+            if (checkpoint) {
+                checkpoint->getFrameRangesToRender(it->firstFrame, it->lastFrame, &framesToRender);
+            }
+            ///The group expects its writers to render their whole frame range
+            if ( !checkpoint || ( (framesToRender.size() == 1) && (framesToRender.front().first == it->firstFrame) &&
+                                  (framesToRender.front().second == it->lastFrame) ) ) {
+                groupWorks.push_back(*it);
+            }
+        }
+        
+        ///Several writers advance frame by frame together so that the nodes they share are rendered once per frame
+        boost::shared_ptr<WritersRenderGroup> group;
+        if (groupWorks.size() > 1) {
+            std::list<WritersRenderGroup::WriterRange> ranges;
+            for (std::list<RenderWork>::const_iterator it = groupWorks.begin(); it != groupWorks.end(); ++it) {
+                WritersRenderGroup::WriterRange r;
+                r.writer = it->writer;
+                r.firstFrame = it->firstFrame;
+                r.lastFrame = it->lastFrame;
+                ranges.push_back(r);
+            }
+            group.reset( new WritersRenderGroup(ranges) );
+            for (std::list<RenderWork>::const_iterator it = groupWorks.begin(); it != groupWorks.end(); ++it) {
+                it->writer->setRenderGroup(group);
+            }
+        }
+        
         //blocking call, we don't want this function to return pre-maturely, in which case it would kill the app
-        QtConcurrent::blockingMap( writers,boost::bind(&AppInstance::startRenderingFullSequence,this,_1,false,QString()) );
+        QtConcurrent::blockingMap( works,boost::bind(&AppInstance::startRenderingFullSequence,this,_1,false,QString()) );
+        
+        if (group) {
+            ///Writers which did not start rendering still hold the group
+            for (std::list<RenderWork>::const_iterator it = groupWorks.begin(); it != groupWorks.end(); ++it) {
+                it->writer->setRenderGroup( boost::shared_ptr<WritersRenderGroup>() );
+            }
+        }
+        for (std::list<RenderWork>::const_iterator it = works.begin(); it != works.end(); ++it) {
+            it->writer->setRenderCheckpoint( boost::shared_ptr<RenderCheckpoint>() );
+        }
     } else {
         
         //Take a snapshot of the graph at this time, this will be the version loaded by the process
@@ -1066,22 +1284,115 @@ AppInstance::startWritersRendering(const std::list<RenderWork>& writers)
     }
 }
 
+void
+AppInstance::getWriterFrameRange(const RenderWork& writerWork,int* first,int* last) const
+{
+    if (writerWork.firstFrame == INT_MIN || writerWork.lastFrame == INT_MAX) {
+        writerWork.writer->getFrameRange_public(writerWork.writer->getHash(), first, last);
+        if (*first == INT_MIN || *last == INT_MAX) {
+            getFrameRange(first, last);
+        }
+    } else {
+        *first = writerWork.firstFrame;
+        *last = writerWork.lastFrame;
+    }
+}
+
 void
 AppInstance::startRenderingFullSequence(const RenderWork& writerWork,bool /*renderInSeparateProcess*/,const QString& /*savePath*/)
 {
     BlockingBackgroundRender backgroundRender(writerWork.writer);
     int first,last;
-    if (writerWork.firstFrame == INT_MIN || writerWork.lastFrame == INT_MAX) {
-        writerWork.writer->getFrameRange_public(writerWork.writer->getHash(), &first, &last);
-        if (first == INT_MIN || last == INT_MAX) {
-            getFrameRange(&first, &last);
+    getWriterFrameRange(writerWork, &first, &last);
+    
+    boost::shared_ptr<RenderCheckpoint> checkpoint = writerWork.writer->getRenderCheckpoint();
+    if (!checkpoint) {
+        backgroundRender.blockingRender(first,last); //< doesn't return before rendering is finished
+        return;
+    }
+    
+    /*
+     * Render all the frames that were not completed by a previous render at once, from the first one to the last one:
+     * the scheduler skips the frames completed in between, so that the render threads are not left idle at the end
+     * of each gap as they would be if each gap was rendered in turn.
+     */
+    std::list<std::pair<int,int> > ranges;
+    checkpoint->getFrameRangesToRender(first, last, &ranges);
+    if ( !ranges.empty() ) {
+        backgroundRender.blockingRender(ranges.front().first,ranges.back().second);
+    }
+    
+    ///If the render failed or was aborted, the next run will resume from there
+    std::list<std::pair<int,int> > missing;
+    checkpoint->getFrameRangesToRender(first, last, &missing);
+    if ( missing.empty() ) {
+        ///The job is done
+        checkpoint->remove();
+    }
+}
+
+boost::shared_ptr<RenderCheckpoint>
+AppInstancePrivate::createRenderCheckpoint(Natron::OutputEffectInstance* writer,
+                                           int first,
+                                           int last)
+{
+    std::string writerName = writer->getScriptName_mt_safe();
+    
+    ///A writer producing a single file, e.g a movie, rewrites it from the start, and streamed frames are gone
+    if ( (writer->getSequentialPreference() != Natron::eSequentialPreferenceNotSequential) || writer->getFrameStreamer() ) {
+        std::cout << QObject::tr("The render of %1 cannot be resumed: it does not write a file per frame.").arg( writerName.c_str() ).toStdString() << std::endl;
+        return boost::shared_ptr<RenderCheckpoint>();
+    }
+    
+    std::string pattern;
+    boost::shared_ptr<KnobI> fileParam = writer->getKnobByName(kOfxImageEffectFileParamName);
+    Knob<std::string>* isString = dynamic_cast<Knob<std::string>*>( fileParam.get() );
+    if (isString) {
+        pattern = isString->getValue();
+        _currentProject->canonicalizePath(pattern);
+    }
+    
+    Hash64 key;
+    key.append(projectContentHash);
+    Hash64_appendQString( &key, QString( writerName.c_str() ) );
+    Hash64_appendQString( &key, QString( pattern.c_str() ) );
+    key.computeHash();
+    
+    boost::shared_ptr<RenderCheckpoint> checkpoint( new RenderCheckpoint( RenderCheckpoint::getCheckpointFilePath(writerName.c_str(), key.value()) ) );
+    QString error;
+    if ( !checkpoint->open(&error) ) {
+        std::cout << error.toStdString() << std::endl;
+        return boost::shared_ptr<RenderCheckpoint>();
+    }
+    
+    std::set<int> completed;
+    checkpoint->getCompletedFrames(&completed);
+    
+    if (verifyResumedFrames && !pattern.empty()) {
+        int viewsCount = _currentProject->getProjectViewsCount();
+        for (std::set<int>::iterator it = completed.lower_bound(first); it != completed.end() && *it <= last; ++it) {
+            for (int view = 0; view < viewsCount; ++view) {
+                QFileInfo output( SequenceParsing::generateFileNameFromPattern(pattern, *it, view).c_str() );
+                if ( !output.exists() || (output.size() == 0) ) {
+                    checkpoint->markFrameIncomplete(*it);
+                    break;
+                }
+            }
         }
-    } else {
-        first = writerWork.firstFrame;
-        last = writerWork.lastFrame;
     }
     
-    backgroundRender.blockingRender(first,last); //< doesn't return before rendering is finished
+    int nCompleted = 0;
+    for (int i = first; i <= last; ++i) {
+        if ( checkpoint->isFrameCompleted(i) ) {
+            ++nCompleted;
+        }
+    }
+    if (nCompleted > 0) {
+        std::cout << QObject::tr("%1: %2 frames of %3 were already rendered, resuming.").arg( writerName.c_str() ).arg(nCompleted)
+        .arg(last - first + 1).toStdString() << std::endl;
+    }
+    
+    return checkpoint;
 }
 
 void
@@ -274,11 +274,13 @@ public:
     {
     }
 
-    virtual bool progressUpdate(KnobHolder* /*effect*/,
-                                double /*t*/)
-    {
-        return true;
-    }
+    /**
+     * @brief In a background process, the progress is reported to the main process if there is one.
+     * @param time The frame being rendered by the effect reporting the progress
+     **/
+    virtual bool progressUpdate(KnobHolder* effect,
+                                double t,
+                                int time);
 
     /**
      * @brief Checks for a new version of Natron
@@ -307,6 +309,12 @@ public:
 
     virtual void startRenderingFullSequence(const RenderWork& writerWork,bool renderInSeparateProcess,const QString& savePath);
 
+    /**
+     * @brief Returns the frame range to render for the writer: the one requested, or else the one of the writer
+     * or else the one of the project.
+     **/
+    void getWriterFrameRange(const RenderWork& writerWork,int* first,int* last) const;
+
     virtual void clearViewersLastRenderedTexture() {}
 
     virtual void toggleAutoHideGraphInputs() {}
@@ -372,6 +380,8 @@ public Q_SLOTS:
 
     void newVersionCheckError();
 
+    void onTrackProgressUpdate(int track,double progress);
+
 Q_SIGNALS:
 
     void pluginsPopulated();
@@ -395,6 +405,12 @@ private:
     
     void getWritersWorkForCL(const CLArgs& cl,std::list<AppInstance::RenderRequest>& requests);
 
+    /**
+     * @brief Tracks forward all the enabled tracks of the Tracker nodes given with the --track option and
+     * returns once they are done. Throws an exception if a name is not the one of a Tracker node.
+     **/
+    void trackForCL(const CLArgs& cl);
+
 
     boost::shared_ptr<Natron::Node> createNodeInternal(const QString & pluginID,const std::string & multiInstanceParentName,
                                                        int majorVersion,int minorVersion,
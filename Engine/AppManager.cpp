@@ -30,6 +30,7 @@
 #include <QLocalSocket>
 #include <QThread>
 #include <QTemporaryFile>
+#include <QDir>
 #include <QThreadPool>
 #include <QtCore/QAtomicInt>
 
@@ -60,7 +61,9 @@
 #include "Engine/FrameEntry.h"
 #include "Engine/StandardPaths.h"
 #include "Engine/Format.h"
+#include "Engine/FrameStreamer.h"
 #include "Engine/Log.h"
+#include "Engine/Trace.h"
 #include "Engine/Cache.h"
 #include "Engine/Variant.h"
 #include "Engine/Knob.h"
@@ -71,10 +74,28 @@
 #include "Engine/BackDrop.h"
 
 
+#ifdef NATRON_USE_BREAKPAD
+///Called by breakpad in the crashed process, before the minidump is written
+#if defined(Q_OS_WIN32)
+static bool
+breakpadFilterCallback(void* /*context*/,
+                       EXCEPTION_POINTERS* /*exinfo*/,
+                       MDRawAssertionInfo* /*assertion*/)
+#else
+static bool
+breakpadFilterCallback(void* /*context*/)
+#endif
+{
+    Natron::Trace::writeOnCrash();
+
+    return true;
+}
+#endif
+
 BOOST_CLASS_EXPORT(Natron::FrameParams)
 BOOST_CLASS_EXPORT(Natron::ImageParams)
 
-#define NATRON_CACHE_VERSION 2
+#define NATRON_CACHE_VERSION 3
 
 
 using namespace Natron;
@@ -103,6 +124,8 @@ struct AppManagerPrivate
     
     ProcessInputChannel* _backgroundIPC; //< object used to communicate with the main app
     //if this app is background, see the ProcessInputChannel def
+    boost::shared_ptr<FrameStreamer> frameStreamer; //< where the frames are streamed, if the --stream option was given
+    bool flushLogOnExit; //< true if the --trace option was given
     bool _loaded; //< true when the first instance is completly loaded.
     QString _binaryPath; //< the path to the application's binary
     mutable QMutex _wasAbortCalledMutex;
@@ -221,6 +244,8 @@ AppManagerPrivate::AppManagerPrivate()
 , diskCachesLocationMutex()
 , diskCachesLocation()
 ,_backgroundIPC(0)
+,frameStreamer()
+,flushLogOnExit(false)
 ,_loaded(false)
 ,_binaryPath()
 ,_wasAbortAnyProcessingCalled(false)
@@ -330,10 +355,18 @@ struct CLArgsPrivate
     
     std::list<CLArgs::WriterArg> writers;
     
+    std::list<QString> trackers;
+    
     bool isBackground;
     
     QString ipcPipe;
     
+    QString frameStreamDestination;
+    
+    QString traceFileName;
+    
+    bool resume,resumeVerify;
+    
     int error;
     
     bool isInterpreterMode;
@@ -348,8 +381,13 @@ struct CLArgsPrivate
     , filename()
     , isPythonScript(false)
     , writers()
+    , trackers()
     , isBackground(false)
     , ipcPipe()
+    , frameStreamDestination()
+    , traceFileName()
+    , resume(false)
+    , resumeVerify(false)
     , error(0)
     , isInterpreterMode(false)
     , range()
@@ -434,6 +472,13 @@ CLArgs::printUsage(const std::string& programName)
               "start it."
               "NatronRenderer and " NATRON_APPLICATION_NAME "will do the same thing in this mode, only the init.py script will be loaded.");
     W_LINE("\n");
+    W_TR_LINE("[--trace] <filename> writes the trace of what the threads did to this file when the application exits. "
+              "On Unix it is also written each time the process receives the SIGUSR1 signal, e.g. to see what a render that seems stuck is doing. "
+              "The file is decoded with NatronTraceDecoder.");
+    W_TR_LINE("Some examples of usage of the tool:\n");
+    W_LINE("./NatronRenderer --trace /tmp/render.ntrace -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp");
+    W_LINE("kill -USR1 <pid>");
+    W_LINE("\n");
     
     W_TR_LINE("- Options for the execution of " NATRON_APPLICATION_NAME " projects:\n");
     W_LINE(programName + " <project file path>");
@@ -452,6 +497,31 @@ CLArgs::printUsage(const std::string& programName)
     W_LINE("./NatronRenderer -w MyWriter /FastDisk/Pictures/sequence###.exr 1-100 /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("./NatronRenderer -w MyWriter -w MySecondWriter 1-10 /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("\n");
+    W_TR_LINE("[--stream] <destination> streams the frames of the single Write node to render as raw pixels instead of writing files.\n"
+              "The destination is either - for the standard output, in which case everything else is printed on the standard error, "
+              "or the path of a file, typically a FIFO read by another program. Each frame is preceded by a header giving its time, view, "
+              "bounds, bit depth and components, and the frames are streamed in the order of the sequence.");
+    W_TR_LINE("Some examples of usage of the tool:\n");
+    W_LINE("./NatronRenderer -w MyWriter 1-100 --stream - /Users/Me/MyNatronProjects/MyProject.ntp | myEncoder");
+    W_LINE("./NatronRenderer -w MyWriter 1-100 --stream /tmp/natronFrames /Users/Me/MyNatronProjects/MyProject.ntp");
+    W_LINE("\n");
+    W_TR_LINE("[--resume] records the frames rendered by each Write node in a checkpoint file of the cache directory. If a previous render "
+              "of the same project and Write node with this option was interrupted, only the frames it did not complete are rendered.\n"
+              "The checkpoint is identified by the content of the project file and the output filename of the Write node, and it "
+              "is deleted once all frames are rendered. It only applies to Write nodes writing one file per frame, such as image sequences.");
+    W_TR_LINE("[--resume-verify] same as --resume, but the frames already rendered are rendered again if their output file is missing or empty.");
+    W_TR_LINE("Some examples of usage of the tool:\n");
+    W_LINE("./NatronRenderer -w MyWriter 1-2000 --resume /Users/Me/MyNatronProjects/MyProject.ntp");
+    W_LINE("\n");
+    W_TR_LINE("[--track] <Tracker node script name> tracks forward all the enabled tracks of the Tracker node over the frame range, "
+              "or the project frame range if none is given, before rendering anything.\n"
+              "The progress of each track is printed as it goes. When a project file is given it is saved once tracking is done, "
+              "so that it keeps the tracks. Unless Write nodes are specified with the -w option, nothing is rendered afterwards.\n"
+              "Note that several --track options can be set to specify multiple Tracker nodes.");
+    W_TR_LINE("Some examples of usage of the tool:\n");
+    W_LINE("./NatronRenderer --track Tracker1 1-100 /Users/Me/MyNatronProjects/MyProject.ntp");
+    W_LINE("./NatronRenderer --track Tracker1 -w MyWriter 1-100 /Users/Me/MyNatronProjects/MyProject.ntp");
+    W_LINE("\n");
     W_TR_LINE("- Options for the execution of Python scripts:\n");
     W_LINE(programName + " <Python script path>");
     W_TR_LINE("Note that the following does not apply if the -t option was given.");
@@ -507,6 +577,12 @@ CLArgs::getWriterArgs() const
     return _imp->writers;
 }
 
+const std::list<QString>&
+CLArgs::getTrackerArgs() const
+{
+    return _imp->trackers;
+}
+
 bool
 CLArgs::hasFrameRange() const
 {
@@ -543,6 +619,30 @@ CLArgs::getIPCPipeName() const
     return _imp->ipcPipe;
 }
 
+const QString&
+CLArgs::getFrameStreamDestination() const
+{
+    return _imp->frameStreamDestination;
+}
+
+const QString&
+CLArgs::getTraceFileName() const
+{
+    return _imp->traceFileName;
+}
+
+bool
+CLArgs::isResumeEnabled() const
+{
+    return _imp->resume;
+}
+
+bool
+CLArgs::isResumeVerifyEnabled() const
+{
+    return _imp->resumeVerify;
+}
+
 bool
 CLArgs::isPythonScript() const
 {
@@ -661,6 +761,68 @@ CLArgsPrivate::parse()
         }
     }
     
+    {
+        QStringList::iterator it = hasToken("stream", "");
+        if (it != args.end()) {
+            if (!isBackground || isInterpreterMode) {
+                std::cout << QObject::tr("You cannot use the --stream option in interactive or interpreter mode").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            QStringList::iterator next = it;
+            ++next;
+            if (next == args.end()) {
+                std::cout << QObject::tr("You must specify - or a file path when using the --stream option").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            frameStreamDestination = *next;
+#if defined(Q_OS_UNIX)
+            frameStreamDestination = AppManager::qt_tildeExpansion(frameStreamDestination);
+#endif
+            ++next;
+            args.erase(it,next);
+        }
+    }
+    
+    {
+        QStringList::iterator it = hasToken("trace", "");
+        if (it != args.end()) {
+            QStringList::iterator next = it;
+            ++next;
+            if ( (next == args.end()) || next->startsWith("-") ) {
+                std::cout << QObject::tr("You must specify a file path when using the --trace option").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            traceFileName = *next;
+#if defined(Q_OS_UNIX)
+            traceFileName = AppManager::qt_tildeExpansion(traceFileName);
+#endif
+            ++next;
+            args.erase(it,next);
+        }
+    }
+    
+    {
+        QStringList::iterator it = hasToken("resume-verify", "");
+        if (it != args.end()) {
+            resume = true;
+            resumeVerify = true;
+            args.erase(it);
+        }
+        it = hasToken("resume", "");
+        if (it != args.end()) {
+            resume = true;
+            args.erase(it);
+        }
+        if ( resume && (!isBackground || isInterpreterMode) ) {
+            std::cout << QObject::tr("You cannot use the --resume option in interactive or interpreter mode").toStdString() << std::endl;
+            error = 1;
+            return;
+        }
+    }
+    
     {
         QStringList::iterator it = hasFileNameWithExtension(NATRON_PROJECT_FILE_EXT);
         if (it == args.end()) {
@@ -695,6 +857,46 @@ CLArgsPrivate::parse()
         }
     }
     
+    //Parse trackers
+    for (;;) {
+        QStringList::iterator it = hasToken("track", "");
+        if (it == args.end()) {
+            break;
+        }
+        
+        if (!isBackground || isInterpreterMode) {
+            std::cout << QObject::tr("You cannot use the --track option in interactive or interpreter mode").toStdString() << std::endl;
+            error = 1;
+            return;
+        }
+        if (resume) {
+            ///Saving the tracks changes the project file which identifies the checkpoints of the renders
+            std::cout << QObject::tr("You cannot use the --track option with the --resume option").toStdString() << std::endl;
+            error = 1;
+            return;
+        }
+        
+        QStringList::iterator next = it;
+        ++next;
+        if (next == args.end()) {
+            std::cout << QObject::tr("You must specify the name of a Tracker node when using the --track option").toStdString() << std::endl;
+            error = 1;
+            return;
+        }
+        
+        std::string pythonConform = Natron::makeNameScriptFriendly(next->toStdString());
+        if (next->toStdString() != pythonConform) {
+            std::cout << QObject::tr("The name of the Tracker node specified is not valid: it cannot contain non alpha-numerical "
+                                     "characters and must not start with a digit.").toStdString() << std::endl;
+            error = 1;
+            return;
+        }
+        
+        trackers.push_back(*next);
+        ++next;
+        args.erase(it,next);
+    }
+    
     //Parse writers
     for (;;) {
         QStringList::iterator it = hasToken("writer", "w");
@@ -807,6 +1009,23 @@ AppManager::load(int &argc,
                  char *argv[],
                  const CLArgs& cl)
 {
+    ///Open the stream first: when it is the standard output nothing else must be printed there
+    if ( !cl.getFrameStreamDestination().isEmpty() ) {
+        boost::shared_ptr<FrameStreamer> streamer(new FrameStreamer);
+        QString error;
+        if ( !streamer->open(cl.getFrameStreamDestination(), &error) ) {
+            std::cerr << error.toStdString() << std::endl;
+            return false;
+        }
+        _imp->frameStreamer = streamer;
+    }
+
+    if ( !cl.getTraceFileName().isEmpty() ) {
+        Natron::Log::open( cl.getTraceFileName().toStdString() );
+        Natron::Log::installFlushSignalHandler();
+        _imp->flushLogOnExit = true;
+    }
+
     ///if the user didn't specify launch arguments (e.g unit testing)
     ///find out the binary path
     bool hadArgs = true;
@@ -892,6 +1111,13 @@ AppManager::~AppManager()
     }
 #endif
     
+    if (_imp->flushLogOnExit) {
+        Natron::Log::removeFlushSignalHandler();
+        if ( !Natron::Log::flush() ) {
+            std::cerr << QObject::tr("Could not write the trace file").toStdString() << std::endl;
+        }
+    }
+
     if (qApp) {
         delete qApp;
     }
@@ -1029,7 +1255,9 @@ AppManager::loadInternal(const CLArgs& cl)
     }
     std::setlocale(LC_NUMERIC,"C"); // set the locale for LC_NUMERIC only
 
-    Natron::Log::instance(); //< enable logging
+    ///The trace of the threads is always on, it is written to the temporary directory if we crash
+    QString crashTraceFileName = QString(NATRON_APPLICATION_NAME "_crash_trace") + QString::number( qApp->applicationPid() ) + ".ntrace";
+    Natron::Trace::initialize( QDir::temp().absoluteFilePath(crashTraceFileName).toStdString() );
     
 #ifdef NATRON_USE_BREAKPAD
     _imp->initBreakpad();
@@ -1285,16 +1513,18 @@ AppManager::abortAnyProcessing()
 
 bool
 AppManager::writeToOutputPipe(const QString & longMessage,
-                              const QString & shortMessage)
+                              const Natron::ProcessMessage & message)
 {
     if (!_imp->_backgroundIPC) {
-        
+        if ( longMessage.isEmpty() ) {
+            return false;
+        }
         QMutexLocker k(&_imp->_ofxLogMutex);
         ///Don't use qdebug here which is disabled if QT_NO_DEBUG_OUTPUT is defined.
         std::cout << longMessage.toStdString() << std::endl;
         return false;
     }
-    _imp->_backgroundIPC->writeToOutputChannel(shortMessage);
+    _imp->_backgroundIPC->writeToOutputChannel(message);
 
     return true;
 }
@@ -2115,6 +2345,23 @@ AppManager::getImageOrCreate_diskCache(const Natron::ImageKey & key,const boost:
 }
 
 
+void
+AppManager::getImageCachesLookupStats(U64* nodeCacheLookups,
+                                      U64* nodeCacheHits,
+                                      U64* diskCacheLookups,
+                                      U64* diskCacheHits) const
+{
+    _imp->_nodeCache->getLookupStats(nodeCacheLookups, nodeCacheHits);
+    _imp->_diskCache->getLookupStats(diskCacheLookups, diskCacheHits);
+}
+
+void
+AppManager::resetImageCachesLookupStats()
+{
+    _imp->_nodeCache->resetLookupStats();
+    _imp->_diskCache->resetLookupStats();
+}
+
 bool
 AppManager::getTexture(const Natron::FrameKey & key,
                        boost::shared_ptr<Natron::FrameEntry>* returnValue) const
@@ -2162,6 +2409,12 @@ AppManager::getOrActivateViewerCacheSignalEmitter() const
     return _imp->_viewerCache->activateSignalEmitter();
 }
 
+boost::shared_ptr<FrameStreamer>
+AppManager::getFrameStreamer() const
+{
+    return _imp->frameStreamer;
+}
+
 boost::shared_ptr<Settings> AppManager::getCurrentSettings() const
 {
     return _imp->_settings;
@@ -2195,6 +2448,7 @@ AppManager::registerEngineMetaTypes() const
     qRegisterMetaType<Natron::StandardButtons>();
     qRegisterMetaType<RectI>();
     qRegisterMetaType<RectD>();
+    qRegisterMetaType<Natron::ProcessMessageList>("Natron::ProcessMessageList");
 #if QT_VERSION < 0x050000
     qRegisterMetaType<QAbstractSocket::SocketState>("SocketState");
 #endif
@@ -3205,13 +3459,13 @@ AppManager::onCrashReporterOutputWritten()
         //because we know the pipe is opened on the other side.
         
 #if defined(Q_OS_MAC)
-        _imp->breakpadHandler.reset(new google_breakpad::ExceptionHandler( std::string(), 0, 0/*dmpcb*/,  0, true,
+        _imp->breakpadHandler.reset(new google_breakpad::ExceptionHandler( std::string(), breakpadFilterCallback, 0/*dmpcb*/,  0, true,
                                                                           _imp->crashReporterBreakpadPipe.toStdString().c_str()));
 #elif defined(Q_OS_LINUX)
-        _imp->breakpadHandler.reset(new google_breakpad::ExceptionHandler( google_breakpad::MinidumpDescriptor(std::string()), 0, 0/*dmpCb*/,
+        _imp->breakpadHandler.reset(new google_breakpad::ExceptionHandler( google_breakpad::MinidumpDescriptor(std::string()), breakpadFilterCallback, 0/*dmpCb*/,
                                                                           0, true, handle));
 #elif defined(Q_OS_WIN32)
-        _imp->breakpadHandler.reset(new google_breakpad::ExceptionHandler( std::wstring(), 0, 0/*dmpcb*/,
+        _imp->breakpadHandler.reset(new google_breakpad::ExceptionHandler( std::wstring(), breakpadFilterCallback, 0/*dmpcb*/,
                                                                           google_breakpad::ExceptionHandler::HANDLER_ALL,
                                                                           MiniDumpNormal,
                                                                           filename.toStdWString(),
@@ -47,6 +47,7 @@ class Settings;
 class KnobHolder;
 class NodeSerialization;
 class KnobSerialization;
+class FrameStreamer;
 
 namespace Natron {
 class Node;
@@ -60,6 +61,7 @@ class FrameParams;
 class FrameEntry;
 class Plugin;
 class CacheSignalEmitter;
+struct ProcessMessage;
 
 enum AppInstanceStatusEnum
 {
@@ -109,6 +111,11 @@ public:
     
     const std::list<CLArgs::WriterArg>& getWriterArgs() const;
     
+    /**
+     * @brief The script names of the Tracker nodes to track before rendering, @see AppInstance::trackForCL
+     **/
+    const std::list<QString>& getTrackerArgs() const;
+    
     bool hasFrameRange() const;
     
     const std::pair<int,int>& getFrameRange() const;
@@ -121,6 +128,28 @@ public:
     
     const QString& getIPCPipeName() const;
     
+    /**
+     * @brief The destination of the frames when they are streamed instead of being written by the writer,
+     * "-" for the standard output. Empty if frames are not streamed. @see FrameStreamer
+     **/
+    const QString& getFrameStreamDestination() const;
+    
+    /**
+     * @brief The file the trace of the threads is written to when the application exits or receives SIGUSR1,
+     * empty if the --trace option was not given. @see Natron::Log::flush
+     **/
+    const QString& getTraceFileName() const;
+    
+    /**
+     * @brief True if the frames already rendered by a previous render of the same writers must be skipped, @see RenderCheckpoint
+     **/
+    bool isResumeEnabled() const;
+    
+    /**
+     * @brief True if the output files of the frames already rendered must be checked before skipping them.
+     **/
+    bool isResumeVerifyEnabled() const;
+    
     bool isPythonScript() const;
     
 private:
@@ -231,6 +260,14 @@ public:
     bool getImageOrCreate_diskCache(const Natron::ImageKey & key,const boost::shared_ptr<Natron::ImageParams>& params,
                           boost::shared_ptr<Natron::Image>* returnValue) const;
     
+    /**
+     * @brief The number of look-ups of the node cache and of the disk cache (used by the DiskCache nodes), and how many
+     * found the image, since the application started or resetImageCachesLookupStats() was called.
+     **/
+    void getImageCachesLookupStats(U64* nodeCacheLookups,U64* nodeCacheHits,U64* diskCacheLookups,U64* diskCacheHits) const;
+
+    void resetImageCachesLookupStats();
+
 
     bool getTexture(const Natron::FrameKey & key,
                     boost::shared_ptr<Natron::FrameEntry>* returnValue) const;
@@ -242,6 +279,11 @@ public:
 
     Natron::CacheSignalEmitter* getOrActivateViewerCacheSignalEmitter() const;
 
+    /**
+     * @brief The destination of the frames given by the --stream option, if any.
+     **/
+    boost::shared_ptr<FrameStreamer> getFrameStreamer() const;
+
     void setApplicationsCachesMaximumMemoryPercent(double p);
 
     void setApplicationsCachesMaximumViewerDiskSpace(unsigned long long size);
@@ -267,10 +309,10 @@ public:
     const KnobFactory & getKnobFactory() const WARN_UNUSED_RETURN;
 
     /**
-     * @brief If the current process is a background process, then it will right the output pipe the
-     * short message. Otherwise the longMessage is printed to stdout
+     * @brief If the current process is a background process managed by a GUI process, then the message is written
+     * to the output pipe. Otherwise the longMessage is printed to stdout, unless it is empty.
      **/
-    bool writeToOutputPipe(const QString & longMessage,const QString & shortMessage);
+    bool writeToOutputPipe(const QString & longMessage,const Natron::ProcessMessage & message);
 
     void abortAnyProcessing();
 
@@ -20,6 +20,7 @@ CLANG_DIAG_OFF(deprecated-register) //'register' storage class specifier is depr
 CLANG_DIAG_ON(deprecated-register)
 #include "Engine/EffectInstance.h"
 #include "Engine/AppManager.h"
+#include "Engine/ProcessMessage.h"
 #include "Engine/Settings.h"
 
 BlockingBackgroundRender::BlockingBackgroundRender(Natron::OutputEffectInstance* writer)
@@ -31,10 +32,15 @@ BlockingBackgroundRender::BlockingBackgroundRender(Natron::OutputEffectInstance*
 void
 BlockingBackgroundRender::blockingRender(int first,int last)
 {
-    _writer->renderFullSequence(this,first,last);
-    if (appPTR->getCurrentSettings()->getNumberOfThreads() != -1) {
+    bool wait = appPTR->getCurrentSettings()->getNumberOfThreads() != -1;
+    if (wait) {
+        ///Flag it before starting: a short render may be finished before renderFullSequence returns
         QMutexLocker locker(&_runningMutex);
         _running = true;
+    }
+    _writer->renderFullSequence(this,first,last);
+    if (wait) {
+        QMutexLocker locker(&_runningMutex);
         while (_running) {
             _runningCond.wait(&_runningMutex);
         }
@@ -45,7 +51,7 @@ void
 BlockingBackgroundRender::notifyFinished()
 {
     qDebug() << "Blocking render finished.";
-    appPTR->writeToOutputPipe(kRenderingFinishedStringLong,kRenderingFinishedStringShort);
+    appPTR->writeToOutputPipe( kRenderingFinishedStringLong,Natron::ProcessMessage(Natron::eProcessMessageTypeRenderingFinished) );
     QMutexLocker locker(&_runningMutex);
     _running = false;
     _runningCond.wakeOne();
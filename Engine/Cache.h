@@ -386,6 +386,10 @@ private:
 
     mutable QMutex _getLock;  //prevents get() and getOrCreate() to be called simultaneously
 
+    ///Protected by _getLock: the look-ups made by get() and getOrCreate() and how many found an entry
+    mutable U64 _lookups;
+    mutable U64 _hits;
+
     /*These 2 are mutable because we need to modify the LRU list even
          when we call get() and we want this function to be const.*/
     mutable CacheContainer _memoryCache;
@@ -423,6 +427,8 @@ public:
           ,_sizeLock()
           ,_lock()
           , _getLock()
+          , _lookups(0)
+          , _hits(0)
           ,_memoryCache()
           ,_diskCache()
           ,_cacheName(cacheName)
@@ -468,9 +474,17 @@ public:
         ///Be atomic, so it cannot be created by another thread in the meantime
         QMutexLocker getlocker(&_getLock);
 
-        ///lock the cache before reading it.
-        QMutexLocker locker(&_lock);
-        return getInternal(key,returnValue);
+        bool found;
+        {
+            ///lock the cache before reading it.
+            QMutexLocker locker(&_lock);
+            found = getInternal(key,returnValue);
+        }
+        ++_lookups;
+        if (found) {
+            ++_hits;
+        }
+        return found;
         
     } // get
     
@@ -664,10 +678,12 @@ public:
                 QMutexLocker locker(&_lock);
                 didGetSucceed = getInternal(key,&entries);
             }
+            ++_lookups;
             if (didGetSucceed) {
                 for (typename std::list<EntryTypePtr>::iterator it = entries.begin(); it != entries.end(); ++it) {
                     if (*(*it)->getParams() == *params) {
                         *returnValue = *it;
+                        ++_hits;
                         return true;
                     }
                 }
@@ -1089,6 +1105,24 @@ public:
         QMutexLocker k(&_sizeLock); return _diskCacheSize;
     }
 
+    /**
+     * @brief Returns how many look-ups were made by get() and getOrCreate() since the cache was created or
+     * resetLookupStats() was called, and how many of them found the entry in the cache.
+     **/
+    void getLookupStats(U64* lookups,U64* hits) const
+    {
+        QMutexLocker k(&_getLock);
+        *lookups = _lookups;
+        *hits = _hits;
+    }
+
+    void resetLookupStats()
+    {
+        QMutexLocker k(&_getLock);
+        _lookups = 0;
+        _hits = 0;
+    }
+
     CacheSignalEmitter* activateSignalEmitter() const
     {
         return _signalEmitter;
@@ -32,6 +32,7 @@
 #include "Engine/Node.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/Log.h"
+#include "Engine/Trace.h"
 #include "Engine/Image.h"
 #include "Engine/ImageParams.h"
 #include "Engine/KnobFile.h"
@@ -41,6 +42,7 @@
 #include "Engine/PluginMemory.h"
 #include "Engine/Project.h"
 #include "Engine/BlockingBackgroundRender.h"
+#include "Engine/WritersRenderGroup.h"
 #include "Engine/AppInstance.h"
 #include "Engine/ThreadStorage.h"
 #include "Engine/Settings.h"
@@ -662,6 +664,56 @@ public:
     }
 };
 
+#if NATRON_ENABLE_TRIMAP
+/**
+ * @brief Holds the claim of a thread on a portion of a cached image it renders directly in,
+ * see Image::claimForRendering(). The portion is marked as not rendered unless setRendered() was called.
+ **/
+class RenderClaim_RAII
+{
+    boost::shared_ptr<Natron::Image> image;
+    RectI roi;
+    bool rendered;
+    
+public:
+    
+    RenderClaim_RAII()
+    : image()
+    , roi()
+    , rendered(false)
+    {
+    }
+    
+    bool claim(const boost::shared_ptr<Natron::Image>& img,const RectI& rect)
+    {
+        assert(!image);
+        if (!img->claimForRendering(rect)) {
+            return false;
+        }
+        image = img;
+        roi = rect;
+        return true;
+    }
+    
+    bool isClaimed() const
+    {
+        return image.get() != 0;
+    }
+    
+    void setRendered()
+    {
+        rendered = true;
+    }
+    
+    ~RenderClaim_RAII()
+    {
+        if (image) {
+            image->releaseRenderClaim(roi, rendered);
+        }
+    }
+};
+#endif
+
 void
 EffectInstance::addThreadLocalInputImageTempPointer(const boost::shared_ptr<Natron::Image> & img)
 {
@@ -734,7 +786,8 @@ EffectInstance::setParallelRenderArgsTLS(int time,
                                          U64 renderAge,
                                          ViewerInstance* viewer,
                                          int textureIndex,
-                                         const TimeLine* timeline)
+                                         const TimeLine* timeline,
+                                         Natron::Node* previewRequester)
 {
     ParallelRenderArgs& args = _imp->frameRenderArgs.localData();
     args.time = time;
@@ -749,6 +802,7 @@ EffectInstance::setParallelRenderArgsTLS(int time,
     args.renderAge = renderAge;
     args.renderRequester = viewer;
     args.textureIndex = textureIndex;
+    args.previewRequester = previewRequester;
     
     ++args.validArgs;
     
@@ -840,6 +894,9 @@ EffectInstance::aborted() const
             ///No valid args, probably not rendering
             return false;
         } else {
+            if ( args.previewRequester && args.previewRequester->isPreviewAbortRequested() ) {
+                return true;
+            }
             if (args.isRenderResponseToUserInteraction) {
                 
                 if (args.canAbort) {
@@ -3177,6 +3234,10 @@ EffectInstance::renderRoIInternal(SequenceTime time,
             ( (nbThreads == 0) && (appPTR->getHardwareIdealThreadCount() == 1) ) ||
             ( QThreadPool::globalInstance()->activeThreadCount() >= QThreadPool::globalInstance()->maxThreadCount() ) ) {
             safety = eRenderSafetyFullySafe;
+        } else if ( _imp->frameRenderArgs.hasLocalData() && _imp->frameRenderArgs.localData().previewRequester ) {
+            ///Previews are rendered entirely by the thread that requested them, which has a low priority,
+            ///instead of competing with the viewer for the threads of the global pool.
+            safety = eRenderSafetyFullySafe;
         } else {
             if ( !getApp()->getProject()->tryLock() ) {
                 safety = eRenderSafetyFullySafe;
@@ -3563,6 +3624,21 @@ EffectInstance::tiledRenderingFunctor(RenderArgs & args,
     
     ImageList tmpPlanes;
     
+    /*
+     * A plug-in that supports tiles only writes in its render window: when it renders a single plane which is not
+     * downscaled afterwards in this function, let it render directly in the cached image once this thread owns the
+     * render window, instead of rendering in a temporary image copied afterwards.
+     * Multi-planar plug-ins may allocate planes on the fly during the render, these keep rendering in temporary images.
+     * A claim marks the window as being rendered, which only renders reading the bitmap as a trimap understand: other
+     * renders would take the window for rendered and read it before it is.
+     */
+#if NATRON_ENABLE_TRIMAP
+    const bool canRenderInCachedImage = !frameArgs.canAbort && frameArgs.isRenderResponseToUserInteraction &&
+    planes.planes.size() == 1 && supportsTiles() && !isMultiPlanar() &&
+    !(renderFullScaleThenDownscale && mipMapLevel != 0 && !renderUseScaleOneInputs);
+    RenderClaim_RAII renderClaim;
+#endif
+    
     bool isBeingRenderedElseWhere = false;
     if (frameTLS.empty()) {
         renderRectToRender = args._renderWindowPixel;
@@ -3572,6 +3648,12 @@ EffectInstance::tiledRenderingFunctor(RenderArgs & args,
              * When using the cache, allocate a local temporary buffer onto which the plug-in will render, and then safely
              * copy this buffer to the shared (among threads) image.
              */
+#if NATRON_ENABLE_TRIMAP
+            if (canRenderInCachedImage && it->second.renderMappedImage->usesBitMap() &&
+                renderClaim.claim(it->second.renderMappedImage, renderRectToRender)) {
+                it->second.tmpImage = it->second.renderMappedImage;
+            } else
+#endif
             if (it->second.renderMappedImage->usesBitMap()) {
                 it->second.tmpImage.reset(new Image(it->second.renderMappedImage->getComponents(),
                                                     it->second.renderMappedImage->getRoD(),
@@ -3686,6 +3768,12 @@ EffectInstance::tiledRenderingFunctor(RenderArgs & args,
              * When using the cache, allocate a local temporary buffer onto which the plug-in will render, and then safely
              * copy this buffer to the shared (among threads) image.
              */
+#if NATRON_ENABLE_TRIMAP
+            if (canRenderInCachedImage && it->second.renderMappedImage->usesBitMap() &&
+                renderClaim.claim(it->second.renderMappedImage, renderRectToRender)) {
+                it->second.tmpImage = it->second.renderMappedImage;
+            } else
+#endif
             if (it->second.renderMappedImage->usesBitMap()) {
                 it->second.tmpImage.reset(new Image(it->second.renderMappedImage->getComponents(),
                                                     it->second.renderMappedImage->getRoD(),
@@ -3709,7 +3797,8 @@ EffectInstance::tiledRenderingFunctor(RenderArgs & args,
     
     
 #if NATRON_ENABLE_TRIMAP
-    if (!frameArgs.canAbort && frameArgs.isRenderResponseToUserInteraction) {
+    ///A claimed render window is already marked as being rendered
+    if (!frameArgs.canAbort && frameArgs.isRenderResponseToUserInteraction && !renderClaim.isClaimed()) {
         if (renderFullScaleThenDownscale && renderUseScaleOneInputs) {
             firstPlane.fullscaleImage->markForRendering(renderRectToRender);
         } else {
@@ -3718,7 +3807,7 @@ EffectInstance::tiledRenderingFunctor(RenderArgs & args,
     }
 #endif
     
-    /// Render in the temporary image
+    /// Render in the temporary image, or directly in the cached image if this thread claimed the render window
     
     RenderScale originalScale;
     originalScale.x = firstPlane.downscaleImage->getScale();
@@ -3812,6 +3901,9 @@ EffectInstance::tiledRenderingFunctor(RenderArgs & args,
             }
         }
         
+#if NATRON_ENABLE_TRIMAP
+        renderClaim.setRendered();
+#endif
     }
   
     
@@ -4399,7 +4491,10 @@ EffectInstance::render_public(SequenceTime time,
                               const std::list<boost::shared_ptr<Natron::Image> >& outputPlanes)
 {
     NON_RECURSIVE_ACTION();
-    return render(time, originalScale, mappedScale, roi, view, isSequentialRender, isRenderResponseToUserInteraction, outputPlanes);
+    Natron::Trace::RenderScope trace(getNode()->getScriptName_mt_safe(), time, view, roi.x1, roi.y1, roi.x2, roi.y2);
+    Natron::StatusEnum stat = render(time, originalScale, mappedScale, roi, view, isSequentialRender, isRenderResponseToUserInteraction, outputPlanes);
+    trace.setStatus(stat);
+    return stat;
 
 }
 
@@ -5423,6 +5518,9 @@ OutputEffectInstance::OutputEffectInstance(boost::shared_ptr<Node> node)
       , _writerLastFrame(0)
       , _outputEffectDataLock(new QMutex)
       , _renderController(0)
+      , _renderGroup()
+      , _frameStreamer()
+      , _renderCheckpoint()
       , _engine(0)
 {
 }
@@ -5502,12 +5600,68 @@ OutputEffectInstance::renderFullSequence(BlockingBackgroundRender* renderControl
 void
 OutputEffectInstance::notifyRenderFinished()
 {
+    boost::shared_ptr<WritersRenderGroup> group;
+    {
+        QMutexLocker l(_outputEffectDataLock);
+        group.swap(_renderGroup);
+    }
+    if (group) {
+        group->removeWriter(this);
+    }
     if (_renderController) {
         _renderController->notifyFinished();
         _renderController = 0;
     }
 }
 
+void
+OutputEffectInstance::setRenderGroup(const boost::shared_ptr<WritersRenderGroup>& group)
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    _renderGroup = group;
+}
+
+boost::shared_ptr<WritersRenderGroup>
+OutputEffectInstance::getRenderGroup() const
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    return _renderGroup;
+}
+
+void
+OutputEffectInstance::setFrameStreamer(const boost::shared_ptr<FrameStreamer>& streamer)
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    _frameStreamer = streamer;
+}
+
+boost::shared_ptr<FrameStreamer>
+OutputEffectInstance::getFrameStreamer() const
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    return _frameStreamer;
+}
+
+void
+OutputEffectInstance::setRenderCheckpoint(const boost::shared_ptr<RenderCheckpoint>& checkpoint)
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    _renderCheckpoint = checkpoint;
+}
+
+boost::shared_ptr<RenderCheckpoint>
+OutputEffectInstance::getRenderCheckpoint() const
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    return _renderCheckpoint;
+}
+
 int
 OutputEffectInstance::getCurrentFrame() const
 {
@@ -58,6 +58,9 @@ class TimeLine;
 class OverlaySupport;
 class PluginMemory;
 class BlockingBackgroundRender;
+class WritersRenderGroup;
+class FrameStreamer;
+class RenderCheckpoint;
 class NodeSerialization;
 class ViewerInstance;
 class RenderEngine;
@@ -65,6 +68,9 @@ class BufferableObject;
 namespace Transform {
 struct Matrix3x3;
 }
+namespace Natron {
+class Node;
+}
 
 /**
  * @brief Thread-local arguments given to render a frame by the tree.
@@ -117,6 +123,10 @@ struct ParallelRenderArgs
     ///The texture index of the viewer being rendered, only useful for abortable renders
     int textureIndex;
     
+    ///The node whose preview is being rendered, or NULL if this is not a preview render.
+    ///Preview renders are not split across the threads of the global pool and are aborted by Node::abortPreviewRendering.
+    Natron::Node* previewRequester;
+    
     ParallelRenderArgs()
     : time(0)
     , timeline(0)
@@ -130,6 +140,7 @@ struct ParallelRenderArgs
     , renderAge(0)
     , renderRequester(0)
     , textureIndex(0)
+    , previewRequester(0)
     {
         
     }
@@ -576,7 +587,8 @@ public:
                                   U64 renderAge,
                                   ViewerInstance* viewer,
                                   int textureIndex,
-                                  const TimeLine* timeline);
+                                  const TimeLine* timeline,
+                                  Natron::Node* previewRequester = 0);
 
     void setParallelRenderArgsTLS(const ParallelRenderArgs& args); 
 
@@ -1603,6 +1615,9 @@ class OutputEffectInstance
     SequenceTime _writerLastFrame;
     mutable QMutex* _outputEffectDataLock;
     BlockingBackgroundRender* _renderController; //< pointer to a blocking renderer
+    boost::shared_ptr<WritersRenderGroup> _renderGroup; //< the writers rendering along with this one, if any
+    boost::shared_ptr<FrameStreamer> _frameStreamer; //< if set, the frames are streamed instead of being written
+    boost::shared_ptr<RenderCheckpoint> _renderCheckpoint; //< if set, the frames rendered are recorded there
     
     RenderEngine* _engine;
 public:
@@ -1628,6 +1643,28 @@ public:
     void renderFullSequence(BlockingBackgroundRender* renderController,int first,int last);
 
     void notifyRenderFinished();
+    
+    /**
+     * @brief Set the group of writers this writer renders with until it finishes rendering, see WritersRenderGroup.
+     **/
+    void setRenderGroup(const boost::shared_ptr<WritersRenderGroup>& group);
+    
+    boost::shared_ptr<WritersRenderGroup> getRenderGroup() const;
+
+    /**
+     * @brief When set, the images of the input of this writer are streamed in frame order, see FrameStreamer,
+     * and the writer itself does not render anything.
+     **/
+    void setFrameStreamer(const boost::shared_ptr<FrameStreamer>& streamer);
+
+    boost::shared_ptr<FrameStreamer> getFrameStreamer() const;
+
+    /**
+     * @brief When set, the frames completely rendered by this writer are recorded in the checkpoint, see RenderCheckpoint.
+     **/
+    void setRenderCheckpoint(const boost::shared_ptr<RenderCheckpoint>& checkpoint);
+
+    boost::shared_ptr<RenderCheckpoint> getRenderCheckpoint() const;
 
     void renderCurrentFrame(bool canAbort);
 
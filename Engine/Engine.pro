@@ -68,6 +68,7 @@ SOURCES += \
     FileDownloader.cpp \
     FileSystemModel.cpp \
     FrameEntry.cpp \
+    FrameStreamer.cpp \
     FrameKey.cpp \
     FrameParamsSerialization.cpp \
     Hash64.cpp \
@@ -107,11 +108,13 @@ SOURCES += \
     Plugin.cpp \
     PluginMemory.cpp \
     ProcessHandler.cpp \
+    ProcessMessage.cpp \
     Project.cpp \
     ProjectPrivate.cpp \
     ProjectSerialization.cpp \
     PySideCompat.cpp \
     Rect.cpp \
+    RenderCheckpoint.cpp \
     RotoContext.cpp \
     RotoSerialization.cpp  \
     RotoWrapper.cpp \
@@ -121,8 +124,11 @@ SOURCES += \
     StringAnimationManager.cpp \
     TimeLine.cpp \
     Timer.cpp \
+    Trace.cpp \
+    TrackScheduler.cpp \
     Transform.cpp \
     ViewerInstance.cpp \
+    WritersRenderGroup.cpp \
     ../libs/SequenceParsing/SequenceParsing.cpp \
     NatronEngine/natronengine_module_wrapper.cpp \
     NatronEngine/natron_wrapper.cpp \
@@ -186,6 +192,7 @@ HEADERS += \
     FrameEntrySerialization.h \
     FrameParams.h \
     FrameParamsSerialization.h \
+    FrameStreamer.h \
     GlobalFunctionsWrapper.h \
     Hash64.h \
     HistogramCPU.h \
@@ -236,11 +243,13 @@ HEADERS += \
     Plugin.h \
     PluginMemory.h \
     ProcessHandler.h \
+    ProcessMessage.h \
     Project.h \
     ProjectPrivate.h \
     ProjectSerialization.h \
     Pyside_Engine_Python.h \
     Rect.h \
+    RenderCheckpoint.h \
     RotoContext.h \
     RotoContextPrivate.h \
     RotoSerialization.h \
@@ -255,10 +264,13 @@ HEADERS += \
     ThreadStorage.h \
     TimeLine.h \
     Timer.h \
+    Trace.h \
+    TrackScheduler.h \
     Transform.h \
     Variant.h \
     ViewerInstance.h \
     ViewerInstancePrivate.h \
+    WritersRenderGroup.h \
     ../Global/Enums.h \
     ../Global/GitVersion.h \
     ../Global/GLIncludes.h \
@@ -267,6 +279,7 @@ HEADERS += \
     ../Global/Macros.h \
     ../Global/MemoryInfo.h \
     ../Global/QtCompat.h \
+    ../Global/TraceFormat.h \
     ../libs/SequenceParsing/SequenceParsing.h \
     ../libs/OpenFX/include/ofxCore.h \
     ../libs/OpenFX/include/ofxDialog.h \
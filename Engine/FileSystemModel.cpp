@@ -13,6 +13,8 @@
 #include "FileSystemModel.h"
 
 #include <vector>
+#include <set>
+#include <map>
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
@@ -25,6 +27,7 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QDebug>
 #include <QtCore/QUrl>
 #include <QtCore/QMimeData>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
@@ -32,6 +35,12 @@ CLANG_DIAG_ON(uninitialized)
 
 
 
+///Maximum number of files of the current directory watched for modifications
+#define NATRON_FILESYSTEM_MODEL_MAX_WATCHED_FILES 1000
+
+///Number of directory listings kept by the gatherer
+#define NATRON_FILESYSTEM_MODEL_CACHED_DIRECTORIES 16
+
 static QStringList getSplitPath(const QString& path)
 {
 	if (path.isEmpty()) {
@@ -86,6 +95,7 @@ struct FileSystemItemPrivate
     
     FileSystemItem* parent;
     std::vector< boost::shared_ptr<FileSystemItem> > children; ///vector for random access
+    std::set<QString> childrenNames; ///< names of all children, to check for duplicates without scanning the children
     QMutex childrenMutex;
 
     bool isDir;
@@ -103,6 +113,7 @@ struct FileSystemItemPrivate
                           const QDateTime& dateModified,quint64 size,FileSystemItem* parent)
     : parent(parent)
     , children()
+    , childrenNames()
     , childrenMutex()
     , isDir(isDir)
     , filename(filename)
@@ -231,7 +242,7 @@ FileSystemItem::addChild(const boost::shared_ptr<FileSystemItem>& child)
 {
     QMutexLocker l(&_imp->childrenMutex);
     _imp->children.push_back(child);
-    
+    _imp->childrenNames.insert(child->fileName());
 }
 
 void
@@ -242,15 +253,7 @@ FileSystemItem::addChild(const boost::shared_ptr<SequenceParsing::SequenceFromFi
     ///Does the child exist already ?
     QString filename = sequence ? sequence->generateUserFriendlySequencePattern().c_str() : info.fileName();
     
-    bool found = false;
-    for (int j = 0; j < (int)_imp->children.size(); ++j) {
-        if (_imp->children[j]->fileName() == filename) {
-            found = true;
-            break;
-        }
-    }
-    
-    if (!found) {
+    if ( _imp->childrenNames.insert(filename).second ) {
         
         bool isDir = sequence ? false : info.isDir();
         qint64 size;
@@ -278,6 +281,7 @@ FileSystemItem::clearChildren()
 {
     QMutexLocker l(&_imp->childrenMutex);
     _imp->children.clear();
+    _imp->childrenNames.clear();
 }
 
 // This is a recursive method which tries to match a path to a specifiq
@@ -360,7 +364,7 @@ struct FileSystemModelPrivate
     
     boost::shared_ptr<FileSystemItem> getItemFromPath(const QString &path) const;
     
-    void populateItem(const boost::shared_ptr<FileSystemItem>& item);
+    void populateItem(const boost::shared_ptr<FileSystemItem>& item,bool forceRescan);
     
     FileSystemItem *getItem(const QModelIndex &index) const;
     
@@ -744,6 +748,13 @@ FileSystemModel::generateRegexpFilterFromFileExtensions(const QStringList& exten
     return ret;
 }
 
+QString
+FileSystemModel::getRegexpFilters() const
+{
+    QMutexLocker l(&_imp->filtersMutex);
+    return _imp->encodedRegexps;
+}
+
 bool
 FileSystemModel::isAcceptedByRegexps(const QString & path) const
 {
@@ -923,14 +934,14 @@ FileSystemModel::setRootPath(const QString& path)
     
     if (item && item != _imp->rootItem) {
         
-        delete _imp->watcher;
-        _imp->watcher = new QFileSystemWatcher;
-        QObject::connect(_imp->watcher, SIGNAL(directoryChanged(QString)), this, SLOT(onWatchedDirectoryChanged(QString)));
-        QObject::connect(_imp->watcher, SIGNAL(fileChanged(QString)), this, SLOT(onWatchedFileChanged(QString)));
-        _imp->watcher->removePath(_imp->currentRootPath);
+        ///Stop watching the previous directory rather than re-creating the watcher (and its inotify instance) each time
+        QStringList watchedPaths = _imp->watcher->directories() + _imp->watcher->files();
+        if ( !watchedPaths.isEmpty() ) {
+            _imp->watcher->removePaths(watchedPaths);
+        }
         _imp->watcher->addPath(item->absoluteFilePath());
         
-        _imp->populateItem(item);
+        _imp->populateItem(item,false);
     } else {
         Q_EMIT directoryLoaded(path);
     }
@@ -940,11 +951,11 @@ FileSystemModel::setRootPath(const QString& path)
 
 
 void
-FileSystemModelPrivate::populateItem(const boost::shared_ptr<FileSystemItem> &item)
+FileSystemModelPrivate::populateItem(const boost::shared_ptr<FileSystemItem> &item,bool forceRescan)
 {
     ///We do it in a separate thread because it might be expensive,
     ///the directoryLoaded signal will be emitted when it is finished
-    gatherer.fetchDirectory(item);
+    gatherer.fetchDirectory(item,forceRescan);
 }
 
 void
@@ -965,29 +976,26 @@ FileSystemModel::onDirectoryLoadedByGatherer(const QString& directory)
     if (!_imp->rootPathWatched) {
         assert(_imp->watcher);
         
-        ///Watch all files in the directory and track changes
-        for (int i = 0; i < item->childCount(); ++i) {
+        ///Watch the files in the directory and track changes. Files added or removed are already reported by the
+        ///watch on the directory itself, so frames of sequences are not watched individually: a directory with
+        ///100k frames would otherwise create as many inotify watches.
+        QStringList paths;
+        for (int i = 0; i < item->childCount() && paths.size() < NATRON_FILESYSTEM_MODEL_MAX_WATCHED_FILES; ++i) {
             boost::shared_ptr<FileSystemItem> child = item->childAt(i);
             boost::shared_ptr<SequenceParsing::SequenceFromFiles> sequence = child->getSequence();
             
             if (sequence) {
-                ///Add all items in the sequence
                 if (sequence->isSingleFile()) {
-                    _imp->watcher->addPath(sequence->generateValidSequencePattern().c_str());
-                } else {
-                    const std::map<int,SequenceParsing::FileNameContent>& indexes = sequence->getFrameIndexes();
-                    for (std::map<int,SequenceParsing::FileNameContent>::const_iterator it = indexes.begin();
-                         it != indexes.end(); ++it) {
-                        _imp->watcher->addPath(it->second.absoluteFileName().c_str());
-                    }
+                    paths.push_back(sequence->generateValidSequencePattern().c_str());
                 }
-    
             } else {
-                const QString& absolutePath = child->absoluteFilePath();
-                _imp->watcher->addPath(absolutePath);
+                paths.push_back(child->absoluteFilePath());
             }
             
         }
+        if ( !paths.isEmpty() ) {
+            _imp->watcher->addPaths(paths);
+        }
         
         ///Set it to true to prevent it from being re-watched
         _imp->rootPathWatched = true;
@@ -1053,7 +1061,8 @@ FileSystemModel::cleanAndRefreshItem(const boost::shared_ptr<FileSystemItem>& it
             endRemoveRows();
         }
         
-        _imp->populateItem(item);
+        ///The directory content might have changed within the resolution of its modification date, do not trust the cache
+        _imp->populateItem(item,true);
     }
 }
 
@@ -1074,6 +1083,20 @@ FileSystemModelPrivate::getItem(const QModelIndex &index) const
 
 ///////////////////////// FileGathererThread
 
+typedef std::list< std::pair< boost::shared_ptr<SequenceParsing::SequenceFromFiles> ,QFileInfo > > FileSequences;
+
+///A directory listing as it was last gathered
+struct GatheredDirectory
+{
+    QString path;
+    QDateTime lastModified;
+    
+    ///The settings of the model (filters, sorting, sequence mode) when the directory was gathered
+    QString settings;
+    
+    FileSequences sequences;
+};
+
 struct FileGathererThreadPrivate
 {
     FileSystemModel* model;
@@ -1094,8 +1117,12 @@ struct FileGathererThreadPrivate
     QWaitCondition startCountCond;
     
     boost::shared_ptr<FileSystemItem> requestedItem,itemBeingFetched;
+    bool requestedRescan;
     QMutex requestedDirMutex;
     
+    ///The most recently gathered directories, most recent first. Only accessed by the gatherer thread
+    std::list<GatheredDirectory> cache;
+    
     FileGathererThreadPrivate(FileSystemModel* model)
     : model(model)
     , mustQuit(false)
@@ -1111,11 +1138,48 @@ struct FileGathererThreadPrivate
     , startCountCond()
     , requestedItem()
     , itemBeingFetched()
+    , requestedRescan(false)
     , requestedDirMutex()
+    , cache()
     {
         
     }
     
+    bool getCachedDirectory(const QString& path,const QDateTime& lastModified,const QString& settings,FileSequences* sequences)
+    {
+        for (std::list<GatheredDirectory>::iterator it = cache.begin(); it != cache.end(); ++it) {
+            if (it->path == path) {
+                if (it->lastModified != lastModified || it->settings != settings) {
+                    cache.erase(it);
+                    return false;
+                }
+                *sequences = it->sequences;
+                cache.splice(cache.begin(), cache, it);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void cacheDirectory(const QString& path,const QDateTime& lastModified,const QString& settings,const FileSequences& sequences)
+    {
+        for (std::list<GatheredDirectory>::iterator it = cache.begin(); it != cache.end(); ++it) {
+            if (it->path == path) {
+                cache.erase(it);
+                break;
+            }
+        }
+        GatheredDirectory dir;
+        dir.path = path;
+        dir.lastModified = lastModified;
+        dir.settings = settings;
+        dir.sequences = sequences;
+        cache.push_front(dir);
+        if ((int)cache.size() > NATRON_FILESYSTEM_MODEL_CACHED_DIRECTORIES) {
+            cache.pop_back();
+        }
+    }
+    
     bool checkForExit()
     {
         QMutexLocker l(&mustQuitMutex);
@@ -1229,13 +1293,15 @@ FileGathererThread::run()
                 return;
             }
             
+            bool forceRescan;
             {
                 QMutexLocker k(&_imp->requestedDirMutex);
                 _imp->itemBeingFetched = _imp->requestedItem;
+                forceRescan = _imp->requestedRescan;
             }
             
             ///Doesn't need to be protected under requestedDirMutex since it is written to only by this thread
-            gatheringKernel(_imp->itemBeingFetched);
+            gatheringKernel(_imp->itemBeingFetched,forceRescan);
             _imp->itemBeingFetched.reset();
             
         } //WorkingSetter
@@ -1253,8 +1319,40 @@ FileGathererThread::run()
     }
 }
 
+///Files can only belong to the same sequence if their names differ by their numbers only: this returns the file name
+///with every number (and its sign) replaced by a '#' so that the candidate sequences of a file are found directly.
+static QString
+getSequenceSignature(const QString& filename)
+{
+    QString ret;
+    ret.reserve( filename.size() );
+    int i = 0;
+    const int size = filename.size();
+    while (i < size) {
+        const QChar c = filename.at(i);
+        if ( c.isDigit() || ( c == QChar('-') && (i + 1 < size) && filename.at(i + 1).isDigit() ) ) {
+            ret.append( QChar('#') );
+            ++i;
+            while ( i < size && filename.at(i).isDigit() ) {
+                ++i;
+            }
+        } else {
+            ret.append(c);
+            ++i;
+        }
+    }
+    return ret;
+}
 
-typedef std::list< std::pair< boost::shared_ptr<SequenceParsing::SequenceFromFiles> ,QFileInfo > > FileSequences;
+///Fetches the properties of the file needed by FileSystemItem::addChild so that they are cached by the QFileInfo
+static void
+statFileInfo(QFileInfo& info)
+{
+    if ( !info.isDir() ) {
+        (void)info.size();
+    }
+    (void)info.lastModified();
+}
 
 #define KERNEL_INCR() \
     switch (viewOrder) \
@@ -1268,10 +1366,10 @@ typedef std::list< std::pair< boost::shared_ptr<SequenceParsing::SequenceFromFil
     }
 
 void
-FileGathererThread::gatheringKernel(const boost::shared_ptr<FileSystemItem>& item)
+FileGathererThread::gatheringKernel(const boost::shared_ptr<FileSystemItem>& item,bool forceRescan)
 {
-
-    QDir dir( item->absoluteFilePath() );
+    const QString& dirPath = item->absoluteFilePath();
+    QDir dir(dirPath);
     
     Qt::SortOrder viewOrder = _imp->model->sortIndicatorOrder();
     FileSystemModel::Sections sortSection = (FileSystemModel::Sections)_imp->model->sortIndicatorSection();
@@ -1294,82 +1392,114 @@ FileGathererThread::gatheringKernel(const boost::shared_ptr<FileSystemItem>& ite
     }
     sort |= QDir::IgnoreCase;
     
-    ///All entries in the directory
-    QFileInfoList all = dir.entryInfoList(_imp->model->filter(), sort);
+    const QDir::Filters filters = _imp->model->filter();
+    const bool sequenceMode = _imp->model->isSequenceModeEnabled();
+    
+    ///The listing of the directory only depends on its content and on the settings of the model
+    const QString settings = QString("%1 %2 %3 %4 %5").arg( (int)filters ).arg( (int)sortSection ).arg( (int)viewOrder )
+    .arg( (int)sequenceMode ).arg( _imp->model->getRegexpFilters() );
+    const QDateTime lastModified = QFileInfo(dirPath).lastModified();
     
     ///List of all possible file sequences in the directory or directories
     FileSequences sequences;
     
-    int start = 0;
-    int end = 0;
-    switch (viewOrder) {
-        case Qt::AscendingOrder:
-            start = 0;
-            end = all.size();
-            break;
-        case Qt::DescendingOrder:
-            start = all.size() - 1;
-            end = -1;
-            break;
-    }
-    
-    int i = start;
-    while (i != end) {
+    if ( forceRescan || !_imp->getCachedDirectory(dirPath, lastModified, settings, &sequences) ) {
         
-        ///If we must abort we do it now
-        if ( _imp->checkForAbort() ) {
-            return;
+        ///All entries in the directory
+        QFileInfoList all = dir.entryInfoList(filters, sort);
+        
+        ///The sequences which a file may belong to, see getSequenceSignature
+        std::map<QString, std::vector<boost::shared_ptr<SequenceParsing::SequenceFromFiles> > > sequencesBySignature;
+        
+        int start = 0;
+        int end = 0;
+        switch (viewOrder) {
+            case Qt::AscendingOrder:
+                start = 0;
+                end = all.size();
+                break;
+            case Qt::DescendingOrder:
+                start = all.size() - 1;
+                end = -1;
+                break;
         }
-                
-        if ( all[i].isDir() ) {
-            ///This is a directory
-            sequences.push_back(std::make_pair(boost::shared_ptr<SequenceParsing::SequenceFromFiles>(), all[i]));
-        } else {
+        
+        int i = start;
+        while (i != end) {
             
-
-            QString filename = all[i].fileName();
-
-            /// If the item does not match the filter regexp set by the user, discard it
-            if ( !_imp->model->isAcceptedByRegexps(filename) ) {
-                KERNEL_INCR();
-                continue;
+            ///If we must abort we do it now
+            if ( _imp->checkForAbort() ) {
+                return;
             }
             
-            /// If file sequence fetching is disabled, accept it
-            if ( !_imp->model->isSequenceModeEnabled() ) {
+            if ( all[i].isDir() ) {
+                ///This is a directory
                 sequences.push_back(std::make_pair(boost::shared_ptr<SequenceParsing::SequenceFromFiles>(), all[i]));
-                KERNEL_INCR();
-                continue;
-            }
-
-            std::string absoluteFilePath = generateChildAbsoluteName(item.get(), filename).toStdString();
-            
-            
-            bool foundMatchingSequence = false;
-            
-            /// If we reach here, this is a valid file and we need to determine if it belongs to another sequence or we need
-            /// to create a new one
-            SequenceParsing::FileNameContent fileContent(absoluteFilePath);
-            
-            ///Note that we use a reverse iterator because we have more chance to find a match in the last recently added entries
-            for (FileSequences::reverse_iterator it = sequences.rbegin(); it != sequences.rend(); ++it) {
+            } else {
                 
-                if ( it->first && it->first->tryInsertFile(fileContent,false) ) {
+                
+                QString filename = all[i].fileName();
+                
+                /// If the item does not match the filter regexp set by the user, discard it
+                if ( !_imp->model->isAcceptedByRegexps(filename) ) {
+                    KERNEL_INCR();
+                    continue;
+                }
+                
+                /// If file sequence fetching is disabled, accept it
+                if (!sequenceMode) {
+                    sequences.push_back(std::make_pair(boost::shared_ptr<SequenceParsing::SequenceFromFiles>(), all[i]));
+                    KERNEL_INCR();
+                    continue;
+                }
+                
+                std::string absoluteFilePath = generateChildAbsoluteName(item.get(), filename).toStdString();
+                
+                
+                bool foundMatchingSequence = false;
+                
+                /// If we reach here, this is a valid file and we need to determine if it belongs to another sequence or we need
+                /// to create a new one
+                SequenceParsing::FileNameContent fileContent(absoluteFilePath);
+                
+                ///Only the sequences with the same signature may contain this file
+                std::vector<boost::shared_ptr<SequenceParsing::SequenceFromFiles> >& candidates = sequencesBySignature[getSequenceSignature(filename)];
+                
+                ///Note that we use a reverse iterator because we have more chance to find a match in the last recently added entries
+                for (std::vector<boost::shared_ptr<SequenceParsing::SequenceFromFiles> >::reverse_iterator it = candidates.rbegin();
+                     it != candidates.rend(); ++it) {
+                    
+                    if ( (*it)->tryInsertFile(fileContent,false) ) {
+                        
+                        foundMatchingSequence = true;
+                        break;
+                    }
                     
-                    foundMatchingSequence = true;
-                    break;
+                }
+                
+                if (!foundMatchingSequence) {
+                    boost::shared_ptr<SequenceParsing::SequenceFromFiles> newSequence( new SequenceParsing::SequenceFromFiles(fileContent,true) );
+                    sequences.push_back(std::make_pair(newSequence, all[i]));
+                    candidates.push_back(newSequence);
                 }
                 
             }
-            
-            if (!foundMatchingSequence) {
-                boost::shared_ptr<SequenceParsing::SequenceFromFiles> newSequence( new SequenceParsing::SequenceFromFiles(fileContent,true) );
-                sequences.push_back(std::make_pair(newSequence, all[i]));
-
-            }
-            
+            KERNEL_INCR();
         }
-        KERNEL_INCR();
+        
+        ///Only the entries which end-up in the view need their properties. This is where most of the time goes
+        ///on network shares so they are fetched in parallel rather than one after another by addChild.
+        QFileInfoList toStat;
+        for (FileSequences::iterator it = sequences.begin(); it != sequences.end(); ++it) {
+            toStat.push_back(it->second);
+        }
+        QtConcurrent::blockingMap(toStat, statFileInfo);
+        
+        if ( _imp->checkForAbort() ) {
+            return;
+        }
+        
+        _imp->cacheDirectory(dirPath, lastModified, settings, sequences);
     }
     
     ///Now iterate through the sequences and create the children as necessary
@@ -1377,16 +1507,17 @@ FileGathererThread::gatheringKernel(const boost::shared_ptr<FileSystemItem>& ite
         item->addChild(it->first, it->second);
     }
     
-    Q_EMIT directoryLoaded( item->absoluteFilePath() );
+    Q_EMIT directoryLoaded(dirPath);
 }
 
 void
-FileGathererThread::fetchDirectory(const boost::shared_ptr<FileSystemItem>& item)
+FileGathererThread::fetchDirectory(const boost::shared_ptr<FileSystemItem>& item,bool forceRescan)
 {
     abortGathering();
     {
         QMutexLocker l(&_imp->requestedDirMutex);
         _imp->requestedItem = item;
+        _imp->requestedRescan = forceRescan;
     }
     
     if ( isRunning() ) {
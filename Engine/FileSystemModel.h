@@ -122,7 +122,11 @@ public:
     
     void quitGatherer();
     
-    void fetchDirectory(const boost::shared_ptr<FileSystemItem>& item);
+    /**
+     * @brief Requests the content of the given directory. The listing of the directory is cached and is
+     * re-used as long as the directory was not modified, unless forceRescan is true.
+     **/
+    void fetchDirectory(const boost::shared_ptr<FileSystemItem>& item,bool forceRescan = false);
     
     bool isWorking() const;
 Q_SIGNALS:
@@ -134,7 +138,7 @@ private:
     
     virtual void run() OVERRIDE FINAL;
     
-    void gatheringKernel(const boost::shared_ptr<FileSystemItem>& item);
+    void gatheringKernel(const boost::shared_ptr<FileSystemItem>& item,bool forceRescan);
     
     boost::scoped_ptr<FileGathererThreadPrivate> _imp;
     
@@ -250,6 +254,11 @@ public:
      **/
     void setRegexpFilters(const QString& filters);
     
+    /**
+     * @brief Returns the regexp filters as they were passed to setRegexpFilters
+     **/
+    QString getRegexpFilters() const WARN_UNUSED_RETURN;
+    
     /**
      * @brief Generates an encoded regexp filter that can be passed to setRegexpFilters from a list of file extensions
      * @extensions A list of file extensions in the form "jpg", "png", "exr" etc...
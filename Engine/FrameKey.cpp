@@ -62,6 +62,24 @@ FrameKey::FrameKey(SequenceTime time,
 {
 }
 
+FrameKey::FrameKey(const FrameKey & other,
+                   const TextureRect & textureRect)
+: KeyHelper<U64>()
+, _time(other._time)
+, _treeVersion(other._treeVersion)
+, _gain(other._gain)
+, _lut(other._lut)
+, _bitDepth(other._bitDepth)
+, _channels(other._channels)
+, _view(other._view)
+, _textureRect(textureRect)
+, _scale(other._scale)
+, _inputName(other._inputName)
+, _layer(other._layer)
+, _alphaChannelFullName(other._alphaChannelFullName)
+{
+}
+
 void
 FrameKey::fillHash(Hash64* hash) const
 {
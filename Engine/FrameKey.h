@@ -43,6 +43,10 @@ public:
              const ImageComponents& layer,
              const std::string& alphaChannelFullName);
 
+    /// the key of the portion textureRect of the texture identified by other, e.g. one of its tiles
+    FrameKey(const FrameKey & other,
+             const TextureRect & textureRect);
+
     void fillHash(Hash64* hash) const;
 
     bool operator==(const FrameKey & other) const;
@@ -92,6 +96,11 @@ public:
         return _inputName;
     }
 
+    const TextureRect & getTextureRect() const WARN_UNUSED_RETURN
+    {
+        return _textureRect;
+    }
+
 private:
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version);
@@ -0,0 +1,144 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "FrameStreamer.h"
+
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QObject>
+CLANG_DIAG_ON(deprecated)
+
+#include "Engine/Image.h"
+#include "Engine/Rect.h"
+
+struct FrameStreamerPrivate
+{
+    QFile file;
+
+    FrameStreamerPrivate()
+    : file()
+    {
+    }
+
+    bool openStandardOutput();
+};
+
+bool
+FrameStreamerPrivate::openStandardOutput()
+{
+    std::cout.flush();
+    std::fflush(stdout);
+
+    ///Keep the standard output for the frames and send what is printed to std::cout to the standard error
+#if defined(Q_OS_WIN)
+    int fd = _dup( _fileno(stdout) );
+    if (fd == -1) {
+        return false;
+    }
+    _setmode(fd, _O_BINARY);
+    _dup2( _fileno(stderr), _fileno(stdout) );
+#else
+    int fd = dup( fileno(stdout) );
+    if (fd == -1) {
+        return false;
+    }
+    dup2( fileno(stderr), fileno(stdout) );
+#endif
+
+    return file.open(fd, QIODevice::WriteOnly | QIODevice::Unbuffered, QFile::AutoCloseHandle);
+}
+
+FrameStreamer::FrameStreamer()
+: _imp( new FrameStreamerPrivate() )
+{
+}
+
+FrameStreamer::~FrameStreamer()
+{
+    _imp->file.close();
+}
+
+bool
+FrameStreamer::open(const QString & destination,
+                    QString* error)
+{
+#if defined(Q_OS_UNIX)
+    ///When the reader goes away, make the writes fail instead of killing the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    bool ok;
+    if (destination == "-") {
+        ok = _imp->openStandardOutput();
+    } else {
+        _imp->file.setFileName(destination);
+        ok = _imp->file.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+    if (!ok) {
+        *error = QObject::tr("Cannot open %1 to stream the frames: %2").arg(destination).arg( _imp->file.errorString() );
+    }
+
+    return ok;
+}
+
+bool
+FrameStreamer::writeFrame(int time,
+                          int view,
+                          const Natron::Image & image,
+                          const RectI & roi)
+{
+    const Natron::ImageComponents& comps = image.getComponents();
+    int nComps = comps.getNumComponents();
+    Natron::ImageBitDepthEnum depth = image.getBitDepth();
+    int rowSize = roi.width() * nComps * Natron::getSizeOfForBitDepth(depth);
+
+    QByteArray header;
+    {
+        QDataStream stream(&header,QIODevice::WriteOnly);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream.writeRawData(NATRON_FRAME_STREAM_MAGIC, 4);
+        stream << (quint32)0; //< the header size, written below
+        stream << (quint32)NATRON_FRAME_STREAM_VERSION;
+        stream << (qint32)time << (qint32)view;
+        stream << (qint32)roi.x1 << (qint32)roi.y1 << (qint32)roi.x2 << (qint32)roi.y2;
+        stream << (quint32)depth << (quint32)nComps;
+        stream << QByteArray( (comps.getLayerName() + '.' + comps.getComponentsGlobalName()).c_str() );
+        stream << (quint64)rowSize * roi.height();
+        stream.device()->seek(4);
+        stream << (quint32)header.size();
+    }
+    if (_imp->file.write(header) != header.size()) {
+        return false;
+    }
+
+    Natron::Image::ReadAccess acc = image.getReadRights();
+    for (int y = roi.y2 - 1; y >= roi.y1; --y) {
+        const char* row = (const char*)acc.pixelAt(roi.x1, y);
+        assert(row);
+        if (_imp->file.write(row, rowSize) != rowSize) {
+            return false;
+        }
+    }
+
+    return true;
+}
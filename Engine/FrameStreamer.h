@@ -0,0 +1,80 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_FRAMESTREAMER_H_
+#define NATRON_ENGINE_FRAMESTREAMER_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+class RectI;
+namespace Natron {
+class Image;
+}
+
+///Identifies the start of each frame in the stream
+#define NATRON_FRAME_STREAM_MAGIC "NTRF"
+#define NATRON_FRAME_STREAM_VERSION 1
+
+/**
+ * @brief Writes the frames rendered by an output node as raw pixels to the standard output or to a file
+ * (typically a FIFO read by an encoder) instead of letting the writer encode them to files.
+ *
+ * Each frame is made of a header, in little endian:
+ * - char[4]: NATRON_FRAME_STREAM_MAGIC
+ * - quint32: the size of the header in bytes, magic included: fields may be appended in later versions
+ * - quint32: NATRON_FRAME_STREAM_VERSION
+ * - qint32: time, qint32: view
+ * - qint32 x1, y1, x2, y2: the bounds of the frame in pixel coordinates, x2 and y2 excluded
+ * - quint32: the bit depth, 1: 8-bit unsigned, 2: 16-bit unsigned, 3: 32-bit float
+ * - quint32: the number of components
+ * - quint32 size + chars: the layer and components names, e.g "Color.RGBA"
+ * - quint64: the size in bytes of the pixels that follow
+ *
+ * followed by the pixels, with the components of each pixel packed together, in native byte order, and the rows from
+ * the top (y2 - 1) to the bottom (y1) of the frame.
+ *
+ * The frames are written in the order of the sequence: the scheduler of the writer orders them.
+ **/
+struct FrameStreamerPrivate;
+class FrameStreamer
+{
+public:
+
+    FrameStreamer();
+
+    ~FrameStreamer();
+
+    /**
+     * @brief Opens the destination of the frames: "-" is the standard output, anything else is a file path.
+     * Opening a FIFO blocks until its reader opens it.
+     * When streaming to the standard output, everything else this process prints there goes to the standard error instead.
+     * Returns false and sets error if the destination cannot be opened.
+     **/
+    bool open(const QString & destination,QString* error);
+
+    /**
+     * @brief Writes the given region of the image at the given time and view.
+     * Returns false if the frame could not be written, e.g because the reader closed the FIFO.
+     * Must not be called concurrently: the scheduler of the writer calls it from a single thread, in frame order.
+     **/
+    bool writeFrame(int time,int view,const Natron::Image & image,const RectI & roi);
+
+private:
+
+    boost::scoped_ptr<FrameStreamerPrivate> _imp;
+};
+
+#endif // NATRON_ENGINE_FRAMESTREAMER_H_
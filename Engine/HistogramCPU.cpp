@@ -12,9 +12,14 @@
 #include <algorithm>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+#include <boost/bind.hpp>
 
 #include "Engine/Image.h"
 
+///Number of pixels processed at once when accumulating the bins
+#define kHistogramChunkSize 256
+
 
 struct HistogramRequest
 {
@@ -25,6 +30,9 @@ struct HistogramRequest
     double vmin;
     double vmax;
     int smoothingKernelSize;
+    ///If set, the bins were already accumulated and image is not used
+    boost::shared_ptr<HistogramBins> bins;
+    unsigned int mipMapLevel;
 
     HistogramRequest()
         : binsCount(0)
@@ -34,6 +42,8 @@ struct HistogramRequest
           , vmin(0)
           , vmax(0)
           , smoothingKernelSize(0)
+          , bins()
+          , mipMapLevel(0)
     {
     }
 
@@ -51,6 +61,23 @@ struct HistogramRequest
           , vmin(vmin)
           , vmax(vmax)
           , smoothingKernelSize(smoothingKernelSize)
+          , bins()
+          , mipMapLevel(image ? image->getMipMapLevel() : 0)
+    {
+    }
+
+    HistogramRequest(const boost::shared_ptr<HistogramBins> & bins,
+                     unsigned int mipMapLevel,
+                     int smoothingKernelSize)
+        : binsCount(bins->binsCount)
+          , mode(bins->mode)
+          , image()
+          , rect(bins->rect)
+          , vmin(bins->vmin)
+          , vmax(bins->vmax)
+          , smoothingKernelSize(smoothingKernelSize)
+          , bins(bins)
+          , mipMapLevel(mipMapLevel)
     {
     }
 };
@@ -104,6 +131,127 @@ struct HistogramCPUPrivate
     }
 };
 
+HistogramBins::HistogramBins(int mode,
+                             int binsCount,
+                             double vmin,
+                             double vmax,
+                             const RectI & rect)
+    : mode(mode)
+      , binsCount(binsCount)
+      , vmin(vmin)
+      , vmax(vmax)
+      , rect(rect)
+      , _mergeMutex()
+{
+    for (int i = 0; i < getHistogramsCount(); ++i) {
+        histograms[i].resize(binsCount * kHistogramUpscale, 0.f);
+    }
+}
+
+/**
+ * @brief Adds the n values of p to the bins of histo. The bin indices are computed first in a loop without
+ * dependencies between values, so only the increments themselves are serialized.
+ **/
+static void
+accumulateValues(const float* p,
+                 int n,
+                 double vmin,
+                 double vmax,
+                 std::vector<float>* histo)
+{
+    if ( histo->empty() || !(vmax > vmin) ) {
+        return;
+    }
+    const float size = (float)histo->size();
+    const float offset = (float)vmin;
+    const float scale = (float)( histo->size() / (vmax - vmin) );
+    float* bins = &(*histo)[0];
+    int indices[kHistogramChunkSize];
+
+    for (int x0 = 0; x0 < n; x0 += kHistogramChunkSize) {
+        const int m = std::min(kHistogramChunkSize, n - x0);
+        const float* values = p + x0;
+        for (int i = 0; i < m; ++i) {
+            float v = (values[i] - offset) * scale;
+            ///values out of [vmin, vmax[ as well as NaNs are discarded
+            indices[i] = (v >= 0.f && v < size) ? (int)v : -1;
+        }
+        for (int i = 0; i < m; ++i) {
+            if (indices[i] >= 0) {
+                bins[indices[i]] += 1.f;
+            }
+        }
+    }
+}
+
+void
+HistogramBins::accumulate(const float* r,
+                          const float* g,
+                          const float* b,
+                          const float* a,
+                          int n)
+{
+    /// keep the mode in sync with Histogram::DisplayModeEnum
+    switch (mode) {
+    case 0:     //< RGB
+        accumulateValues(r, n, vmin, vmax, &histograms[0]);
+        accumulateValues(g, n, vmin, vmax, &histograms[1]);
+        accumulateValues(b, n, vmin, vmax, &histograms[2]);
+        break;
+    case 1:     //< A
+        accumulateValues(a, n, vmin, vmax, &histograms[0]);
+        break;
+    case 2: {     //< Y
+        float lum[kHistogramChunkSize];
+        for (int x0 = 0; x0 < n; x0 += kHistogramChunkSize) {
+            const int m = std::min(kHistogramChunkSize, n - x0);
+            for (int i = 0; i < m; ++i) {
+                lum[i] = 0.299f * r[x0 + i] + 0.587f * g[x0 + i] + 0.114f * b[x0 + i];
+            }
+            accumulateValues(lum, m, vmin, vmax, &histograms[0]);
+        }
+        break;
+    }
+    case 3:     //< R
+        accumulateValues(r, n, vmin, vmax, &histograms[0]);
+        break;
+    case 4:     //< G
+        accumulateValues(g, n, vmin, vmax, &histograms[0]);
+        break;
+    case 5:     //< B
+        accumulateValues(b, n, vmin, vmax, &histograms[0]);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+void
+HistogramBins::merge(const HistogramBins & other)
+{
+    assert(other.mode == mode && other.binsCount == binsCount);
+    QMutexLocker l(&_mergeMutex);
+    for (int i = 0; i < getHistogramsCount(); ++i) {
+        std::vector<float> & dst = histograms[i];
+        const std::vector<float> & src = other.histograms[i];
+        assert( dst.size() == src.size() );
+        for (std::size_t j = 0; j < dst.size(); ++j) {
+            dst[j] += src[j];
+        }
+    }
+}
+
+bool
+HistogramBins::isValidFor(int mode,
+                          int binsCount,
+                          double vmin,
+                          double vmax,
+                          const RectI & rect) const
+{
+    return this->mode == mode && this->binsCount == binsCount && this->vmin == vmin && this->vmax == vmax && this->rect == rect;
+}
+
 HistogramCPU::HistogramCPU()
     : QThread()
       , _imp( new HistogramCPUPrivate() )
@@ -138,6 +286,25 @@ HistogramCPU::computeHistogram(int mode,      //< corresponds to the enum Histog
     }
 }
 
+void
+HistogramCPU::computeHistogram(const boost::shared_ptr<HistogramBins> & bins,
+                               unsigned int mipMapLevel,
+                               int smoothingKernelSize)
+{
+    assert(bins);
+    QMutexLocker quitLocker(&_imp->mustQuitMutex);
+    QMutexLocker locker(&_imp->requestMutex);
+
+    _imp->requests.push_back( HistogramRequest(bins, mipMapLevel, smoothingKernelSize) );
+    if (!isRunning() && !_imp->mustQuit) {
+        quitLocker.unlock();
+        start(HighestPriority);
+    } else {
+        quitLocker.unlock();
+        _imp->requestCond.wakeOne();
+    }
+}
+
 void
 HistogramCPU::quitAnyComputation()
 {
@@ -197,75 +364,68 @@ HistogramCPU::getMostRecentlyProducedHistogram(std::vector<float>* histogram1,
     return true;
 }
 
-///putting these in an anonymous namespace will yield this error on gcc 4.2:
-///"function has not external linkage"
-struct pix_red
-{
-    static float val(const float *pix)
-    {
-        return pix[0];
-    }
-};
-
-struct pix_green
-{
-    static float val(const float *pix)
-    {
-        return pix[1];
-    }
-};
-
-struct pix_blue
+///Accumulates the bins of the rows [rows.first, rows.second[ of the image
+static void
+accumulateImageRows(std::pair<int,int> rows,
+                    const boost::shared_ptr<Natron::Image> & image,
+                    HistogramBins* bins)
 {
-    static float val(const float *pix)
-    {
-        return pix[2];
+    ///Images come from the viewer which is in float.
+    assert(image->getBitDepth() == Natron::eImageBitDepthFloat);
+
+    HistogramBins local(bins->mode, bins->binsCount, bins->vmin, bins->vmax, bins->rect);
+    const int nComps = (int)image->getComponentsCount();
+    const RectI & rect = bins->rect;
+    float r[kHistogramChunkSize];
+    float g[kHistogramChunkSize];
+    float b[kHistogramChunkSize];
+    float a[kHistogramChunkSize];
+
+    Natron::Image::ReadAccess acc = image->getReadRights();
+
+    for (int y = rows.first; y < rows.second; ++y) {
+        for (int x0 = rect.left(); x0 < rect.right(); x0 += kHistogramChunkSize) {
+            const int n = std::min(kHistogramChunkSize, rect.right() - x0);
+            const float *pix = (const float*)acc.pixelAt(x0, y);
+            if (!pix) {
+                continue;
+            }
+            ///de-interleave the pixels so that the bins can be computed on contiguous values
+            for (int i = 0; i < n; ++i, pix += nComps) {
+                if (nComps == 1) {
+                    r[i] = g[i] = b[i] = a[i] = pix[0];
+                } else {
+                    r[i] = pix[0];
+                    g[i] = pix[1];
+                    b[i] = nComps >= 3 ? pix[2] : 0.f;
+                    a[i] = nComps >= 4 ? pix[3] : 1.f;
+                }
+            }
+            local.accumulate(r, g, b, a, n);
+        }
     }
-};
+    bins->merge(local);
+}
 
-struct pix_alpha
+///Accumulates the bins of the whole rect of the image in one pass, splitting the rows across threads
+static void
+accumulateImage(const boost::shared_ptr<Natron::Image> & image,
+                HistogramBins* bins)
 {
-    static float val(const float *pix)
-    {
-        return pix[3];
+    const RectI & rect = bins->rect;
+    if ( rect.isNull() ) {
+        return;
     }
-};
-
-struct pix_lum
-{
-    static float val(const float *pix)
-    {
-        return 0.299 * pix[0] + 0.587 * pix[1] + 0.114 * pix[2];
+    QList<std::pair<int,int> > splitRows;
+    int nThreads = std::max(1, QThread::idealThreadCount());
+    int rowsPerThread = std::max( 1, (rect.height() + nThreads - 1) / nThreads );
+    for (int y = rect.bottom(); y < rect.top(); y += rowsPerThread) {
+        splitRows.push_back( std::make_pair( y, std::min(y + rowsPerThread, rect.top()) ) );
     }
-};
-
-
-template <float pix_func(const float*)>
-void
-computeHisto(const HistogramRequest & request,
-             int upscale,
-             std::vector<float> *histo)
-{
-    assert(histo);
-    histo->resize(request.binsCount * upscale);
-    std::fill(histo->begin(), histo->end(), 0.f);
-    double binSize = (request.vmax - request.vmin) / histo->size();
-
-    ///Images come from the viewer which is in float.
-    assert(request.image->getBitDepth() == Natron::eImageBitDepthFloat);
-
-    Natron::Image::ReadAccess acc = request.image->getReadRights();
-    
-    for (int y = request.rect.bottom(); y < request.rect.top(); ++y) {
-        for (int x = request.rect.left(); x < request.rect.right(); ++x) {
-            const float *pix = (const float*)acc.pixelAt(x, y);
-            float v = pix_func(pix);
-            if ( (request.vmin <= v) && (v < request.vmax) ) {
-                int index = (int)( (v - request.vmin) / binSize );
-                assert( 0 <= index && index < (int)histo->size() );
-                (*histo)[index] += 1.f;
-            }
-        }
+    if (splitRows.size() == 1) {
+        accumulateImageRows(splitRows.front(), image, bins);
+    } else {
+        QtConcurrent::map( splitRows, boost::bind(&accumulateImageRows, _1, image, bins) ).waitForFinished();
     }
 }
 
@@ -405,65 +565,24 @@ iir_1d_filter(SrcIterator src,
     }
 } // iir_1d_filter
 
+///Smoothes the upscaled bins and downsamples them to obtain the final histogram
 static void
-computeHistogramStatic(const HistogramRequest & request,
-                       boost::shared_ptr<FinishedHistogram> ret,
-                       int histogramIndex)
+smoothHistogram(const std::vector<float> & bins,
+                int binsCount,
+                int smoothingKernelSize,
+                std::vector<float>* histo)
 {
-    const int upscale = 5;
-    std::vector<float> *histo = 0;
-
-    switch (histogramIndex) {
-    case 1:
-        histo = &ret->histogram1;
-        break;
-    case 2:
-        histo = &ret->histogram2;
-        break;
-    case 3:
-        histo = &ret->histogram3;
-        break;
-    default:
-        break;
-    }
-    assert(histo);
-
-    /// keep the mode parameter in sync with Histogram::DisplayModeEnum
+    const int upscale = kHistogramUpscale;
+    std::vector<float> histo_upscaled(bins);
 
-    int mode = request.mode;
-
-    ///if the mode is RGB, adjust the mode to either R,G or B depending on the histogram index
-    if (mode == 0) {
-        mode = histogramIndex + 2;
+    histo->resize(binsCount);
+    if ( histo_upscaled.empty() ) {
+        return;
     }
 
-    ret->pixelsCount = request.rect.area();
-    // a histogram with upscale more bins
-    std::vector<float> histo_upscaled;
-    switch (mode) {
-    case 1:     //< A
-        computeHisto<&pix_alpha::val>(request, upscale, &histo_upscaled);
-        break;
-    case 2:     //<Y
-        computeHisto<&pix_lum::val>(request, upscale, &histo_upscaled);
-        break;
-    case 3:     //< R
-        computeHisto<&pix_red::val>(request, upscale, &histo_upscaled);
-        break;
-    case 4:     //< G
-        computeHisto<&pix_green::val>(request, upscale, &histo_upscaled);
-        break;
-    case 5:     //< B
-        computeHisto<&pix_blue::val>(request, upscale, &histo_upscaled);
-        break;
-
-    default:
-        assert(false);
-        break;
-    }
     double sigma = upscale;
-    if (request.smoothingKernelSize > 1) {
-        sigma *= request.smoothingKernelSize;
+    if (smoothingKernelSize > 1) {
+        sigma *= smoothingKernelSize;
     }
     // smooth the upscaled histogram
     double filter[7];
@@ -473,7 +592,6 @@ computeHistogramStatic(const HistogramRequest & request,
     iir_1d_filter(histo_upscaled.begin(), histo_upscaled.begin(), histo_upscaled.size(), filter);
 
     // downsample to obtain the final histogram
-    histo->resize(request.binsCount);
     assert(histo_upscaled.size() == histo->size() * upscale);
     std::vector<float>::const_iterator it_in = histo_upscaled.begin();
     std::advance(it_in, (upscale - 1) / 2);
@@ -485,7 +603,7 @@ computeHistogramStatic(const HistogramRequest & request,
             std::advance (it_in,upscale);
         }
     }
-} // computeHistogramStatic
+} // smoothHistogram
 
 void
 HistogramCPU::run()
@@ -515,30 +633,24 @@ HistogramCPU::run()
                 return;
             }
         }
+        boost::shared_ptr<HistogramBins> bins = request.bins;
+        if (!bins) {
+            ///all the histograms of the mode are accumulated in a single pass over the image
+            bins.reset( new HistogramBins(request.mode, request.binsCount, request.vmin, request.vmax, request.rect) );
+            accumulateImage(request.image, bins.get());
+        }
+
         boost::shared_ptr<FinishedHistogram> ret(new FinishedHistogram);
-        ret->binsCount = request.binsCount;
-        ret->mode = request.mode;
-        ret->vmin = request.vmin;
-        ret->vmax = request.vmax;
-        ret->mipMapLevel = request.image->getMipMapLevel();
-
-
-        switch (request.mode) {
-        case 0:     //< RGB
-            computeHistogramStatic(request, ret, 1);
-            computeHistogramStatic(request, ret, 2);
-            computeHistogramStatic(request, ret, 3);
-            break;
-        case 1:
-        case 2:
-        case 3:
-        case 4:
-        case 5:
-            computeHistogramStatic(request, ret, 1);
-            break;
-        default:
-            assert(false);     //< unknown case.
-            break;
+        ret->binsCount = bins->binsCount;
+        ret->mode = bins->mode;
+        ret->vmin = bins->vmin;
+        ret->vmax = bins->vmax;
+        ret->mipMapLevel = request.mipMapLevel;
+        ret->pixelsCount = bins->rect.area();
+
+        std::vector<float>* histograms[3] = { &ret->histogram1, &ret->histogram2, &ret->histogram3 };
+        for (int i = 0; i < bins->getHistogramsCount(); ++i) {
+            smoothHistogram(bins->histograms[i], bins->binsCount, request.smoothingKernelSize, histograms[i]);
         }
 
 
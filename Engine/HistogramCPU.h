@@ -13,16 +13,73 @@
 
 #include <vector>
 #include <QThread>
+#include <QMutex>
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/noncopyable.hpp>
 #endif
 #include "Global/Macros.h"
+#include "Engine/Rect.h"
+
+///Number of bins accumulated per displayed bin: the histogram is smoothed at this resolution and then downsampled
+#define kHistogramUpscale 5
 
 namespace Natron {
 class Image;
 }
-class RectI;
+
+/**
+ * @brief The raw (upscaled, not yet smoothed) bins of the histogram(s) of a portion of an image.
+ * They are accumulated in a single pass over the pixels for all the histograms of a mode, either by
+ * HistogramCPU itself or by the viewer while it converts the image to a texture.
+ **/
+class HistogramBins
+    : boost::noncopyable
+{
+public:
+
+    HistogramBins(int mode, //< corresponds to the enum Histogram::DisplayModeEnum
+                  int binsCount, //< the number of bins displayed, kHistogramUpscale times more are accumulated
+                  double vmin,
+                  double vmax,
+                  const RectI & rect);
+
+    ///Adds the n pixels of the planar scan-line r,g,b,a to the histograms
+    void accumulate(const float* r,
+                    const float* g,
+                    const float* b,
+                    const float* a,
+                    int n);
+
+    ///Adds the bins of other (which must have the same parameters) to this one. Thread-safe.
+    void merge(const HistogramBins & other);
+
+    ///Returns true if these bins were computed with the given parameters
+    bool isValidFor(int mode,
+                    int binsCount,
+                    double vmin,
+                    double vmax,
+                    const RectI & rect) const;
+
+    ///The number of histograms of the mode, i.e. 3 for RGB and 1 otherwise
+    int getHistogramsCount() const
+    {
+        return mode == 0 ? 3 : 1;
+    }
+
+    int mode;
+    int binsCount;
+    double vmin,vmax;
+    RectI rect;
+    ///The upscaled bins, only the first getHistogramsCount() are used
+    std::vector<float> histograms[3];
+
+private:
+
+    QMutex _mergeMutex;
+};
+
 struct HistogramCPUPrivate;
 class HistogramCPU
     : public QThread
@@ -43,6 +100,11 @@ public:
                           double vmax,
                           int smoothingKernelSize);
 
+    ///Same as above, except that the bins were already accumulated (by the viewer): only the smoothing is left to compute
+    void computeHistogram(const boost::shared_ptr<HistogramBins> & bins,
+                          unsigned int mipMapLevel,
+                          int smoothingKernelSize);
+
     ////Returns true if a new histogram fully computed is available
     bool hasProducedHistogram() const;
 
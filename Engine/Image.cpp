@@ -15,6 +15,9 @@
 
 #include "Image.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <QDebug>
 #ifndef Q_MOC_RUN
 #include <boost/math/special_functions/fpclassify.hpp>
@@ -444,6 +447,20 @@ Natron::Bitmap::clear(const RectI& roi)
     }
 }
 
+bool
+Natron::Bitmap::isClear(const RectI& roi) const
+{
+    const char* buf = BM_GET(roi.bottom(), roi.left());
+    for (int i = roi.bottom(); i < roi.top(); ++i, buf += _bounds.width()) {
+        for (int j = 0; j < roi.width(); ++j) {
+            if (buf[j] != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 void
 Natron::Bitmap::swap(Bitmap& other)
 {
@@ -480,6 +497,10 @@ Image::Image(const ImageKey & key,
              const std::string & path)
     : CacheEntryHelper<unsigned char, ImageKey,ImageParams>(key, params, cache,storage,path)
     , _useBitmap(true)
+    , _renderClaimsMutex()
+    , _renderClaimsCond()
+    , _renderClaimsCount(0)
+    , _pendingResizesCount(0)
 {
     _bitDepth = params->getBitDepth();
     _rod = params->getRoD();
@@ -495,6 +516,10 @@ Image::Image(const ImageKey & key,
              const boost::shared_ptr<Natron::ImageParams>& params)
 : CacheEntryHelper<unsigned char, ImageKey,ImageParams>(key, params, NULL,Natron::eStorageModeRAM,std::string())
 , _useBitmap(false)
+, _renderClaimsMutex()
+, _renderClaimsCond()
+, _renderClaimsCount(0)
+, _pendingResizesCount(0)
 {
     _bitDepth = params->getBitDepth();
     _rod = params->getRoD();
@@ -521,6 +546,10 @@ Image::Image(const ImageComponents& components,
              bool useBitmap)
     : CacheEntryHelper<unsigned char,ImageKey,ImageParams>()
     , _useBitmap(useBitmap)
+    , _renderClaimsMutex()
+    , _renderClaimsCond()
+    , _renderClaimsCount(0)
+    , _pendingResizesCount(0)
 {
     
     setCacheEntry(makeKey(0,false,0,0),
@@ -720,8 +749,25 @@ Image::ensureBounds(const RectI& newBounds)
         return;
     }
     
+    /*
+     * Wait for the threads rendering directly in the buffer to be done with it. The wait releases _renderClaimsMutex:
+     * _pendingResizesCount makes claimForRendering() fail meanwhile so that new claims do not delay the resize forever.
+     * Once no claim is left, _renderClaimsMutex is held until the buffer is reallocated.
+     */
+    QMutexLocker claimsLocker(&_renderClaimsMutex);
+    ++_pendingResizesCount;
+    while (_renderClaimsCount > 0) {
+        _renderClaimsCond.wait(&_renderClaimsMutex);
+    }
+    --_pendingResizesCount;
+    
     QWriteLocker k(&_entryLock);
     
+    ///Another thread might have resized the image in the meantime
+    if (_bounds.contains(newBounds)) {
+        return;
+    }
+    
     RectI merge = newBounds;
     merge.merge(_bounds);
     
@@ -765,6 +811,50 @@ Image::ensureBounds(const RectI& newBounds)
 }
     
 
+#if NATRON_ENABLE_TRIMAP
+bool
+Image::claimForRendering(const RectI & roi)
+{
+    if (!_useBitmap) {
+        return false;
+    }
+    
+    QMutexLocker claimsLocker(&_renderClaimsMutex);
+    if (_pendingResizesCount > 0) {
+        return false;
+    }
+    QWriteLocker k(&_entryLock);
+    
+    if ( !_bounds.contains(roi) || !_bitmap.isClear(roi) ) {
+        return false;
+    }
+    _bitmap.markForRendering(roi);
+    ++_renderClaimsCount;
+    
+    return true;
+}
+
+void
+Image::releaseRenderClaim(const RectI & roi,
+                          bool rendered)
+{
+    {
+        QWriteLocker k(&_entryLock);
+        if (rendered) {
+            _bitmap.markForRendered(roi);
+        } else {
+            _bitmap.clear(roi);
+        }
+    }
+    
+    QMutexLocker claimsLocker(&_renderClaimsMutex);
+    assert(_renderClaimsCount > 0);
+    if (--_renderClaimsCount == 0) {
+        _renderClaimsCond.wakeAll();
+    }
+}
+#endif
+
 // code proofread and fixed by @devernay on 8/8/2014
 void
 Image::pasteFrom(const Natron::Image & src,
@@ -1938,7 +2028,22 @@ Image::convertToFormatInternal_sameComps(const RectI & renderWindow,
     if (intersection.isNull()) {
         return;
     }
+
+    ///The float colour-space conversions are applied to whole rows, where the Lut vectorizes them
+    const int width = intersection.width();
+    const int nLutComps = std::min(nComp, 3);
+    const bool srcFloatLut = srcLut && srcDepth == eImageBitDepthFloat;
+    const bool dstFloatLut = dstLut && dstDepth == eImageBitDepthFloat;
+    std::vector<float> linearRow(srcFloatLut ? width * nComp : 0);
+
     for (int y = 0; y < intersection.height(); ++y) {
+        if (srcFloatLut) {
+            const float* srcRow = (const float*)srcImg.pixelAt(intersection.x1, intersection.y1 + y);
+            for (int k = 0; k < nLutComps; ++k) {
+                srcLut->fromColorSpaceFloatToLinearFloatFast(srcRow + k, nComp, width, &linearRow[k], nComp);
+            }
+        }
+
         // coverity[dont_call]
         int start = rand() % intersection.width();
         const SRCPIX* srcPixels = (const SRCPIX*)srcImg.pixelAt(intersection.x1 + start, intersection.y1 + y);
@@ -1968,7 +2073,8 @@ Image::convertToFormatInternal_sameComps(const RectI & renderWindow,
                             } else if (srcDepth == eImageBitDepthShort) {
                                 pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(srcPixels[k]);
                             } else {
-                                pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(srcPixels[k]);
+                                ///converted with the whole row above
+                                pixFloat = linearRow[x * nComp + k];
                             }
                         } else {
                             pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
@@ -1985,12 +2091,10 @@ Image::convertToFormatInternal_sameComps(const RectI & renderWindow,
                             pix = dstLut ? dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
                                   convertPixelDepth<float, DSTPIX>(pixFloat);
                         } else {
-                            if (dstLut) {
-                                pixFloat = dstLut->toColorSpaceFloatFromLinearFloat(pixFloat);
-                            }
+                            ///if there is a dstLut, converted with the whole row below
                             pix = convertPixelDepth<float, DSTPIX>(pixFloat);
                         }
-                        dstPixels[k] = invert ? dstMaxValue - pix : pix;
+                        dstPixels[k] = (invert && !dstFloatLut) ? dstMaxValue - pix : pix;
                     }
                 }
 
@@ -2008,6 +2112,18 @@ Image::convertToFormatInternal_sameComps(const RectI & renderWindow,
             dstPixels = dstStart - nComp;
         }
 
+        if (dstFloatLut) {
+            float* dstRow = (float*)dstImg.pixelAt(intersection.x1, intersection.y1 + y);
+            for (int k = 0; k < nLutComps; ++k) {
+                dstLut->toColorSpaceFloatFromLinearFloatFast(dstRow + k, nComp, width, dstRow + k, nComp);
+                if (invert) {
+                    for (int x = 0; x < width; ++x) {
+                        dstRow[x * nComp + k] = dstMaxValue - dstRow[x * nComp + k];
+                    }
+                }
+            }
+        }
+
         if (copyBitmap) {
             dstImg.copyBitmapRowPortion(intersection.x1, intersection.x2, intersection.y1 + y, srcImg);
         }
@@ -2078,8 +2194,34 @@ Image::convertToFormatInternal(const RectI & renderWindow,
 
     const Natron::Color::Lut* srcLut = lutFromColorspace(srcColorSpace);
     const Natron::Color::Lut* dstLut = lutFromColorspace(dstColorSpace);
+
+    ///The float colour-space conversions of the RGB channels are applied to whole rows, where the Lut vectorizes them
+    const int width = intersection.width();
+    const bool rgbToRgb = srcNComps > 1 && dstNComps > 1;
+    const bool unpremult = srcNComps == 4 && dstNComps == 3 && requiresUnpremult;
+    const bool srcFloatLut = rgbToRgb && srcLut && (unpremult || srcDepth == eImageBitDepthFloat);
+    const bool dstFloatLut = rgbToRgb && dstLut && dstDepth == eImageBitDepthFloat;
+    std::vector<float> linearRow(srcFloatLut ? width * 3 : 0);
     
     for (int y = 0; y < intersection.height(); ++y) {
+
+        if (srcFloatLut) {
+            const SRCPIX* srcRow = (const SRCPIX*)srcImg.pixelAt(intersection.x1, intersection.y1 + y);
+            for (int x = 0; x < width; ++x, srcRow += srcNComps) {
+                if (unpremult) {
+                    ///Unpremult before doing colorspace conversion from linear to X
+                    float a = convertPixelDepth<SRCPIX, float>(srcRow[srcNComps - 1]);
+                    for (int k = 0; k < 3; ++k) {
+                        linearRow[x * 3 + k] = a == 0.f ? 0.f : convertPixelDepth<SRCPIX, float>(srcRow[k]) / a;
+                    }
+                } else {
+                    for (int k = 0; k < 3; ++k) {
+                        linearRow[x * 3 + k] = (float)srcRow[k];
+                    }
+                }
+            }
+            srcLut->fromColorSpaceFloatToLinearFloatFast(&linearRow[0], width * 3);
+        }
         
         ///Start of the line for error diffusion
         // coverity[dont_call]
@@ -2174,21 +2316,19 @@ Image::convertToFormatInternal(const RectI & renderWindow,
                                 ///For RGB channels
                                 float pixFloat;
                                 
-                                ///Unpremult before doing colorspace conversion from linear to X
-                                if (unpremultChannel) {
+                                if (srcFloatLut) {
+                                    ///unpremultiplied and converted with the whole row above
+                                    pixFloat = linearRow[x * 3 + k];
+                                } else if (unpremultChannel) {
+                                    ///Unpremult before doing colorspace conversion from linear to X
                                     pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
                                     pixFloat = alphaForUnPremult == 0.f ? 0. : pixFloat / alphaForUnPremult;
-                                    if (srcLut) {
-                                        pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(pixFloat);
-                                    }
-
                                 } else if (srcLut) {
                                     if (srcDepth == eImageBitDepthByte) {
                                         pixFloat = srcLut->fromColorSpaceUint8ToLinearFloatFast(srcPixels[k]);
-                                    } else if (srcDepth == eImageBitDepthShort) {
-                                        pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(srcPixels[k]);
                                     } else {
-                                        pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(srcPixels[k]);
+                                        assert(srcDepth == eImageBitDepthShort);
+                                        pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(srcPixels[k]);
                                     }
                                 } else {
                                     pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
@@ -2206,12 +2346,10 @@ Image::convertToFormatInternal(const RectI & renderWindow,
                                     convertPixelDepth<float, DSTPIX>(pixFloat);
 
                                 } else {
-                                    if (dstLut) {
-                                        pixFloat = dstLut->toColorSpaceFloatFromLinearFloat(pixFloat);
-                                    }
+                                    ///if there is a dstLut, converted with the whole row below
                                     pix = convertPixelDepth<float, DSTPIX>(pixFloat);
                                 }
-                                dstPixels[k] = invert ? dstMaxValue - pix : pix;
+                                dstPixels[k] = (invert && !dstFloatLut) ? dstMaxValue - pix : pix;
                             }
                         }
                     }
@@ -2230,6 +2368,18 @@ Image::convertToFormatInternal(const RectI & renderWindow,
             srcPixels = srcStart - srcNComps;
             dstPixels = dstStart - dstNComps;
         }
+
+        if (dstFloatLut) {
+            float* dstRow = (float*)dstImg.pixelAt(intersection.x1, intersection.y1 + y);
+            for (int k = 0; k < 3; ++k) {
+                dstLut->toColorSpaceFloatFromLinearFloatFast(dstRow + k, dstNComps, width, dstRow + k, dstNComps);
+                if (invert) {
+                    for (int x = 0; x < width; ++x) {
+                        dstRow[x * dstNComps + k] = dstMaxValue - dstRow[x * dstNComps + k];
+                    }
+                }
+            }
+        }
     }
     
     if (copyBitmap) {
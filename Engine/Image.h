@@ -25,6 +25,8 @@ CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QHash>
 CLANG_DIAG_ON(deprecated)
 #include <QtCore/QReadWriteLock>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 
 #include "Engine/ImageKey.h"
 #include "Engine/ImageComponents.h"
@@ -110,6 +112,9 @@ namespace Natron {
         
         void clear(const RectI& roi);
         
+        ///Returns true if no pixel of the roi is rendered or being rendered
+        bool isClear(const RectI& roi) const WARN_UNUSED_RETURN;
+        
         void swap(Natron::Bitmap& other);
 
         const char* getBitmap() const
@@ -208,6 +213,25 @@ namespace Natron {
          **/
         void ensureBounds(const RectI& newBounds);
         
+#if NATRON_ENABLE_TRIMAP
+        /**
+         * @brief Claims the roi of this image for the calling thread, so that a plug-in can render directly in the
+         * buffer of the image instead of a temporary image pasted afterwards.
+         * Returns false and does nothing if a pixel of the roi is already rendered or being rendered by another thread,
+         * or if ensureBounds() is waiting to reallocate the buffer.
+         * Otherwise the roi is marked as being rendered (PIXEL_UNAVAILABLE) and ensureBounds() will not reallocate the
+         * buffer until releaseRenderClaim() is called. Only renders that read the bitmap as a trimap may claim:
+         * the other ones take pixels being rendered for rendered pixels.
+         **/
+        bool claimForRendering(const RectI & roi) WARN_UNUSED_RETURN;
+        
+        /**
+         * @brief Ends a claim obtained with claimForRendering(): the roi is marked as rendered if rendered is true,
+         * otherwise it is marked as not rendered so that another render can claim it again.
+         **/
+        void releaseRenderClaim(const RectI & roi,bool rendered);
+#endif
+        
         /**
      * @brief Returns the region of definition of the image in canonical coordinates. It doesn't have any
      * scale applied to it. In order to return the true pixel data window you must call getBounds()
@@ -708,6 +732,16 @@ namespace Natron {
         RectI _bounds;
         double _par;
         bool _useBitmap;
+        
+        ///Protects _renderClaimsCount and _pendingResizesCount, always taken before _entryLock
+        QMutex _renderClaimsMutex;
+        QWaitCondition _renderClaimsCond;
+        
+        ///Number of threads rendering directly in the buffer, see claimForRendering()
+        int _renderClaimsCount;
+        
+        ///Number of threads waiting in ensureBounds() for the claims to be released
+        int _pendingResizesCount;
     };
 
     template <typename SRCPIX,typename DSTPIX>
@@ -15,158 +15,152 @@
 
 #include "Log.h"
 
-#ifdef NATRON_LOG
-
-
-#include <cassert>
 #include <cstdio>
 #include <cstdarg>
-#include <cstdlib>
-#include <string>
 
-#include <QFile>
-#include <QTextStream>
-#include <QMutex>
+#ifdef __NATRON_WIN32__
+#define vsnprintf _vsnprintf
+#elif defined(__NATRON_UNIX__)
+#include <signal.h>
+#include <unistd.h>
+#endif
 
-#include "Global/GlobalDefines.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QThread>
 
+#include "Global/GlobalDefines.h"
+#include "Engine/Trace.h"
 
 namespace Natron {
-class LogPrivate
+namespace {
+
+///Only protects the file name, never taken when logging
+QMutex fileNameMutex;
+std::string fileName;
+
+void
+recordFunction(quint16 event,
+               const std::string & callerName,
+               const std::string & function)
 {
-public:
+    std::string text = callerName + ' ' + function;
 
-    QMutex _lock;
-    QFile* _file;
-    QTextStream* _stream;
-    int _beginsCount;
+    Trace::record( event, text.c_str(), text.size() );
+}
 
-    LogPrivate()
-        : _lock()
-          , _file(NULL)
-          , _stream(NULL)
-          , _beginsCount(0)
-    {
-    }
+#ifdef __NATRON_UNIX__
+///The signal handler only writes a byte to this pipe: writing the log is not async-signal-safe
+int flushPipe[2] = { -1, -1 };
 
-    ~LogPrivate()
-    {
-        if (_stream) {
-            delete _stream;
-        }
-        if (_file) {
-            _file->close();
-            delete _file;
-        }
-    }
+void
+flushSignalHandler(int /*sig*/)
+{
+    char c = 0;
+    ssize_t n = ::write(flushPipe[1], &c, 1);
 
-    void open(const std::string & fileName)
-    {
-        QMutexLocker locker(&_lock);
+    (void)n;
+}
 
-        if (_file) {
-            return;
-        }
-        _file = new QFile( fileName.c_str() );
-        _file->open(QIODevice::WriteOnly | QIODevice::Truncate);
-        _stream = new QTextStream(_file);
-    }
+class FlushThread
+    : public QThread
+{
+public:
 
-    void beginFunction(const std::string & callerName,
-                       const std::string & function)
+    FlushThread()
+    : QThread()
     {
-        if (!_file) {
-            QString filename(NATRON_APPLICATION_NAME + QString("_log") + QString::number( QCoreApplication::instance()->applicationPid() ) + ".txt");
-            open( filename.toStdString() );
-        }
-        QMutexLocker locker(&_lock);
-        _stream->operator <<("********************************************************************************\n");
-        for (int i = 0; i < _beginsCount; ++i) {
-            _stream->operator <<("    ");
-        }
-        _stream->operator <<("START ");
-        _stream->operator <<( callerName.c_str() );
-        _stream->operator <<("    ");
-        _stream->operator <<( function.c_str() );
-        _stream->operator <<('\n');
-        _stream->flush();
-        ++_beginsCount;
+        setObjectName("Log flush");
     }
 
-    void print(const std::string & log)
-    {
-        QMutexLocker locker(&_lock);
+private:
 
-        assert(_file);
-        for (int i = 0; i < _beginsCount; ++i) {
-            _stream->operator <<("    ");
-        }
-        QString str( log.c_str() );
-        for (int i = 0; i < str.size(); ++i) {
-            _stream->operator <<( str.at(i).toAscii() );
-            if ( (i % 80 == 0) && (i != 0) ) { // format to 80 columns
-                /*Find closest word end and insert a new line*/
-                ++i;
-                while ( i < str.size() && str.at(i) != QChar(' ') ) {
-                    _stream->operator <<( str.at(i).toAscii() );
-                    ++i;
-                }
-                _stream->operator <<('\n');
-                for (int i = 0; i < _beginsCount; ++i) {
-                    _stream->operator <<("    ");
-                }
-            }
-        }
-        _stream->operator <<( log.c_str() );
-        _stream->operator <<('\n');
-        _stream->flush();
-    }
-
-    void endFunction(const std::string & callerName,
-                     const std::string & function)
+    virtual void run() OVERRIDE FINAL
     {
-        QMutexLocker locker(&_lock);
+        char c;
 
-        --_beginsCount;
-        for (int i = 0; i < _beginsCount; ++i) {
-            _stream->operator <<("    ");
+        ///read() returns 0 once removeFlushSignalHandler() closed the pipe
+        while (::read(flushPipe[0], &c, 1) > 0) {
+            Log::flush();
         }
-        _stream->operator <<("STOP ");
-        _stream->operator <<( callerName.c_str() );
-        _stream->operator <<("    ");
-        _stream->operator <<( function.c_str() );
-        _stream->operator <<('\n');
-        _stream->flush();
     }
 };
 
-Log::Log()
-    : Singleton<Natron::Log>(),_imp( new LogPrivate() )
+FlushThread* flushThread = 0;
+#endif // __NATRON_UNIX__
+} // anon namespace
+
+void
+Log::open(const std::string & name)
 {
+    QMutexLocker k(&fileNameMutex);
+
+    fileName = name;
 }
 
-Log::~Log()
+bool
+Log::flush()
 {
-    delete _imp;
+    std::string name;
+    {
+        QMutexLocker k(&fileNameMutex);
+        name = fileName;
+    }
+    if ( name.empty() ) {
+        qint64 pid = QCoreApplication::instance() ? QCoreApplication::instance()->applicationPid() : 0;
+        name = ( NATRON_APPLICATION_NAME + QString("_log") + QString::number(pid) + ".ntrace" ).toStdString();
+    }
+
+    return Trace::writeToFile(name);
+}
+
+void
+Log::installFlushSignalHandler()
+{
+#ifdef __NATRON_UNIX__
+    if ( flushThread || (::pipe(flushPipe) != 0) ) {
+        return;
+    }
+    flushThread = new FlushThread;
+    flushThread->start();
+
+    struct sigaction action;
+    action.sa_handler = flushSignalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+#endif
 }
 
 void
-Log::open(const std::string & fileName)
+Log::removeFlushSignalHandler()
 {
-    Log::instance()->_imp->open(fileName);
+#ifdef __NATRON_UNIX__
+    if (!flushThread) {
+        return;
+    }
+    signal(SIGUSR1, SIG_DFL);
+    ::close(flushPipe[1]);
+    flushThread->wait();
+    delete flushThread;
+    flushThread = 0;
+    ::close(flushPipe[0]);
+    flushPipe[0] = flushPipe[1] = -1;
+#endif
 }
 
 void
 Log::beginFunction(const std::string & callerName,
                    const std::string & function)
 {
-    Log::instance()->_imp->beginFunction(callerName,function);
+    recordFunction(Trace::eTraceEventBeginFunction, callerName, function);
 }
 
 void
 Log::print(const std::string & log)
 {
-    Log::instance()->_imp->print(log);
+    Trace::recordMessage(log);
 }
 
 void
@@ -177,17 +171,17 @@ Log::print(const char *format,
 
     va_start(args, format);
     char buf[10000];
-    sprintf(buf, format, args);
+    ///Longer messages are truncated, _vsnprintf does not terminate them
+    vsnprintf(buf, sizeof(buf), format, args);
+    buf[sizeof(buf) - 1] = 0;
     va_end(args);
-    std::string str(buf);
-    Log::print(str);
+    Trace::recordMessage(buf);
 }
 
 void
 Log::endFunction(const std::string & callerName,
                  const std::string & function)
 {
-    Log::instance()->_imp->endFunction(callerName,function);
+    recordFunction(Trace::eTraceEventEndFunction, callerName, function);
 }
 } //namespace Natron
-#endif // ifdef NATRON_LOG
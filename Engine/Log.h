@@ -16,111 +16,73 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
-#ifdef NATRON_LOG
+#include <string>
 
 #include "Global/Macros.h"
-#include "Engine/Singleton.h"
 
 namespace Natron {
-class LogPrivate;
+
+/**
+ * @brief A text log of what the engine does, recorded in the binary trace of the calling thread (see Engine/Trace.h):
+ * logging takes no lock and is always enabled. The log is written to a file with Log::flush(), which the --trace
+ * command-line option calls on exit and on SIGUSR1, and decoded with NatronTraceDecoder.
+ **/
 class Log
-    : public Singleton<Natron::Log>
 {
-    LogPrivate* _imp;
+    Log();
 
 public:
 
-    Log();
+    /**
+     * @brief Sets the file the log is written to by the next calls to flush().
+     **/
+    static void open(const std::string & fileName);
 
-    virtual ~Log() FINAL;
+    /**
+     * @brief Writes the events recorded so far by all threads to the file given to open(), or to
+     * NATRON_APPLICATION_NAME_log<pid>.ntrace in the current directory if open() was not called.
+     * Returns false if the file could not be written.
+     **/
+    static bool flush();
 
     /**
-     * @brief Opens a new file with the name 'fileName' which
-     * will serve as a log sink for next calls.
+     * @brief On Unix, makes the SIGUSR1 signal call flush() from a thread of its own, so that the log of a process
+     * that is still running (or that hangs) can be written with "kill -USR1 <pid>". Does nothing on other systems.
      **/
-    static void open(const std::string & fileName);
+    static void installFlushSignalHandler();
+
+    /**
+     * @brief Restores the default action of SIGUSR1 and stops the thread started by installFlushSignalHandler().
+     **/
+    static void removeFlushSignalHandler();
 
     /**
-     * @brief Begins a new function in the log. It will print a new delimiter
-     * and a START tag. This is used to bracket a call to print.
+     * @brief Begins a new function in the log. This is used to bracket a call to print.
+     * Only the first NATRON_TRACE_PAYLOAD_SIZE characters of "callerName function" are kept.
      **/
     static void beginFunction(const std::string & callerName,const std::string & function);
 
     /**
-     * @brief Prints the content of 'log' into the log's file. If beginFunction was
-     * not called then it will be called with functionName. Do not insert line-breaks
-     * the log will do it for you and format the content to 80 columns.
+     * @brief Prints the content of 'log' into the log.
      **/
     static void print(const std::string & log);
 
     /**
-     * @brief Same as print but using printf-like formating. Do not insert line-breaks
-     * the log will do it for you and format the content to 80 columns.
+     * @brief Same as print but using printf-like formating.
      **/
     static void print(const char *format, ...);
 
     /**
-     * @brief Ends a function in the log. It will print a new delimiter
-     * and a STOP tag. This is used to bracket a call to print.
+     * @brief Ends a function in the log. This is used to bracket a call to print.
      **/
     static void endFunction(const std::string & callerName,const std::string & function);
-    static bool enabled()
-    {
-        return true;
-    }
-};
-}
-#else
-#include <string>
-
-namespace Natron {
-// no-op class
-class Log
-{
-    Log()
-    {
-    }
-
-    ~Log()
-    {
-    };
-
-public:
-    static void instance()
-    {
-    }
-
-    static void open(const std::string & )
-    {
-    }
-
-    static void beginFunction(const std::string &,
-                              const std::string & )
-    {
-    }
-
-    static void print(const std::string & )
-    {
-    }
-
-    static void print(const char *,
-                      ...)
-    {
-    }
-
-    static void endFunction(const std::string &,
-                            const std::string & )
-    {
-    }
 
     static bool enabled()
     {
-        return false;
+        return true;
     }
 };
 }
 
-#endif // ifdef NATRON_LOG
-
 
 #endif // NATRON_ENGINE_LOG_H_
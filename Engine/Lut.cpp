@@ -15,7 +15,10 @@
 
 #include "Lut.h"
 
+#include <algorithm>
 #include <cstring> // for memcpy
+#include <limits>
+#include <vector>
 
 #include "Engine/Rect.h"
 
@@ -101,6 +104,223 @@ index_to_float(const unsigned short i)
     return tmp.f;
 }
 
+/* the float whose 16 most significant bits are i and all the others are zero, i.e. the smallest float
+   of the interval indexed by i in the hipart tables. The special cases are the same as index_to_float(). */
+static float
+hipart_start_to_float(const unsigned short i)
+{
+    if ( ( i < 0x80) || ( ( i >= 0x8000) && ( i < 0x8080) ) ) {
+        return 0;
+    }
+    if ( ( i >= 0x7f80) && ( i < 0x8000) ) {
+        return std::numeric_limits<float>::max();
+    }
+    if (i >= 0xff80) {
+        return -std::numeric_limits<float>::max();
+    }
+    uint32_t bits = (uint32_t)i << 16;
+    float f;
+    std::memcpy( &f, &bits, sizeof(float) );
+
+    return f;
+}
+
+/// number of values converted at once by the 16-bit conversions
+#define kLutChunkSize 256
+
+/* Converts n linear floats (premultiplied by alpha if it is not NULL) to 16-bit values in the destination
+   color-space, by interpolating toFunc between the values of the table at both ends of the hipart interval.
+   The lookups are done in a separate loop, so that the bit manipulations, the interpolation and the
+   quantization are straight loops over contiguous buffers that the compiler can vectorize. */
+static void
+linearFloatToUint16(const float* toFunc_hipart_to_float,
+                    const float* from,
+                    const float* alpha,
+                    int inDelta,
+                    int n,
+                    unsigned short* to,
+                    int outDelta)
+{
+    float v[kLutChunkSize];
+    uint32_t bits[kLutChunkSize];
+    float lo[kLutChunkSize];
+    float hi[kLutChunkSize];
+
+    for (int x0 = 0; x0 < n; x0 += kLutChunkSize) {
+        const int m = std::min(kLutChunkSize, n - x0);
+        const float* src = from + x0 * inDelta;
+        if (alpha) {
+            const float* a = alpha + x0 * inDelta;
+            for (int i = 0; i < m; ++i) {
+                v[i] = src[i * inDelta] * a[i * inDelta];
+            }
+        } else {
+            for (int i = 0; i < m; ++i) {
+                v[i] = src[i * inDelta];
+            }
+        }
+        std::memcpy( bits, v, m * sizeof(float) );
+        for (int i = 0; i < m; ++i) {
+            const unsigned int index = bits[i] >> 16;
+            lo[i] = toFunc_hipart_to_float[index];
+            hi[i] = toFunc_hipart_to_float[index + 1];
+        }
+        unsigned short* dst = to + x0 * outDelta;
+        for (int i = 0; i < m; ++i) {
+            const float t = (bits[i] & 0xffff) * (1.f / 0x10000);
+            float q = (lo[i] + t * (hi[i] - lo[i])) * 65535.f + 0.5f;
+            q = q < 0.f ? 0.f : q;
+            q = q > 65535.f ? 65535.f : q;
+            dst[i * outDelta] = (unsigned short)q;
+        }
+    }
+}
+
+/* Converts n 16-bit values in the source color-space to linear floats. If alpha is not NULL, the values are
+   premultiplied by it: they are unpremultiplied before the lookup and multiplied back after. */
+static void
+uint16ToLinearFloat(const float* fromFunc_uint16_to_float,
+                    const unsigned short* from,
+                    const unsigned short* alpha,
+                    int inDelta,
+                    int n,
+                    float* to,
+                    int outDelta)
+{
+    if (!alpha) {
+        for (int x = 0; x < n; ++x) {
+            to[x * outDelta] = fromFunc_uint16_to_float[from[x * inDelta]];
+        }
+    } else {
+        for (int x = 0; x < n; ++x) {
+            const unsigned int a = alpha[x * inDelta];
+            if (a == 0) {
+                to[x * outDelta] = 0.f;
+            } else {
+                unsigned int unpremult = (from[x * inDelta] * 65535u + a / 2) / a;
+                unpremult = unpremult > 65535u ? 65535u : unpremult;
+                to[x * outDelta] = fromFunc_uint16_to_float[unpremult] * Color::intToFloat<65536>(a);
+            }
+        }
+    }
+}
+
+/// the float made of the given bits
+static float
+bits_to_float(uint32_t bits)
+{
+    float f;
+    std::memcpy( &f, &bits, sizeof(float) );
+
+    return f;
+}
+
+/// the bits of the smallest float of the [2^kLutFloatMinExponent, 2^kLutFloatMaxExponent[ range of the float tables
+#define kLutFloatMinBits ( (uint32_t)(127 + kLutFloatMinExponent) << 23 )
+
+/* the start of the interval i of the float tables: the interval 0 is [0, 2^kLutFloatMinExponent[, and the
+   following ones split each power of two of the range in 2^kLutFloatMantissaBits intervals */
+static float
+float_table_index_to_float(int i)
+{
+    if (i == 0) {
+        return 0.f;
+    }
+
+    return bits_to_float( kLutFloatMinBits + ( (uint32_t)(i - 1) << (23 - kLutFloatMantissaBits) ) );
+}
+
+/* Samples func at the start of each interval of a float table, and checks at three points inside each interval
+   that the linear interpolation is within kLutFloatMaxError. The intervals that are not (because the function is
+   not smooth enough or not continuous there, or overflows) get NaN at their start, which makes the conversion
+   evaluate func for the values of that interval and of the previous one. The check uses half of the error bound,
+   so that the points that are not checked stay within it. */
+static void
+fill_float_table(fromColorSpaceFunctionV1 func,
+                 float* table)
+{
+    for (int i = 0; i < kLutFloatTableSize; ++i) {
+        table[i] = func( float_table_index_to_float(i) );
+    }
+    std::vector<bool> inaccurate(kLutFloatTableSize, false);
+    for (int i = 0; i < kLutFloatTableSize - 1; ++i) {
+        const float start = float_table_index_to_float(i);
+        const float end = float_table_index_to_float(i + 1);
+        for (int k = 1; k < 4; ++k) {
+            const float t = k / 4.f;
+            const float exact = func( start + t * (end - start) );
+            const float approx = table[i] + t * (table[i + 1] - table[i]);
+            const float tolerance = 0.5f * kLutFloatMaxError * std::max(std::abs(exact), 1e-2f);
+            // written so that infinities and NaNs fail the test
+            if ( !(std::abs(approx - exact) <= tolerance) ) {
+                inaccurate[i] = true;
+            }
+        }
+    }
+    for (int i = 0; i < kLutFloatTableSize; ++i) {
+        if (inaccurate[i]) {
+            table[i] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+}
+
+/* Converts n floats (separated by inDelta) with the float table of func. As for linearFloatToUint16(),
+   the interpolation is a straight loop over contiguous buffers, and the values outside of the range of the
+   table or in the intervals that are not accurate enough are converted with func afterwards. */
+static void
+convert_with_float_table(const float* table,
+                         fromColorSpaceFunctionV1 func,
+                         const float* from,
+                         int inDelta,
+                         int n,
+                         float* to,
+                         int outDelta)
+{
+    const float minValue = float_table_index_to_float(1);
+    const float maxValue = bits_to_float( (uint32_t)(127 + kLutFloatMaxExponent) << 23 );
+    float v[kLutChunkSize];
+    int32_t bits[kLutChunkSize];
+    float lo[kLutChunkSize];
+    float hi[kLutChunkSize];
+    float t[kLutChunkSize];
+
+    for (int x0 = 0; x0 < n; x0 += kLutChunkSize) {
+        const int m = std::min(kLutChunkSize, n - x0);
+        const float* src = from + x0 * inDelta;
+        for (int i = 0; i < m; ++i) {
+            v[i] = src[i * inDelta];
+        }
+        std::memcpy( bits, v, m * sizeof(float) );
+        // branch-free so that the compiler can vectorize it: negative values have negative bits
+        // and end up in the first interval, as do values too large (or NaN), which are
+        // converted with func below
+        for (int i = 0; i < m; ++i) {
+            const int32_t mantissa = bits[i] & ( (1 << (23 - kLutFloatMantissaBits)) - 1 );
+            int32_t index = ( (bits[i] - (int32_t)kLutFloatMinBits) >> (23 - kLutFloatMantissaBits) ) + 1;
+            const int32_t inTable = -(int32_t)( (uint32_t)index < (uint32_t)(kLutFloatTableSize - 1) );
+            const float tSmall = v[i] * (1.f / minValue);
+            const float tMantissa = mantissa * ( 1.f / (1 << (23 - kLutFloatMantissaBits)) );
+            // a blend rather than a select, which the compiler would turn into a branch to avoid evaluating
+            // a multiplication that is not needed
+            const float small = (float)( bits[i] < (int32_t)kLutFloatMinBits );
+            t[i] = tMantissa + small * (tSmall - tMantissa);
+            bits[i] = index & inTable;
+        }
+        for (int i = 0; i < m; ++i) {
+            lo[i] = table[bits[i]];
+            hi[i] = table[bits[i] + 1];
+        }
+        for (int i = 0; i < m; ++i) {
+            lo[i] += t[i] * (hi[i] - lo[i]);
+        }
+        float* dst = to + x0 * outDelta;
+        for (int i = 0; i < m; ++i) {
+            const float r = lo[i];
+            dst[i * outDelta] = ( (v[i] >= 0.f) && (v[i] < maxValue) && (r == r) ) ? r : func(v[i]);
+        }
+    }
+}
+
 ///initialize the singleton
 LutManager LutManager::m_instance = LutManager();
 LutManager::LutManager()
@@ -202,18 +422,63 @@ Lut::fromColorSpaceUint8ToLinearFloatFast(unsigned char v) const
     return fromFunc_uint8_to_float[v];
 }
 
-#if 0
-// It is not recommended to use this function, because the output is quantized
-// If one really needs float, one has to use the full function (or OpenColorIO)
 float
 Lut::toColorSpaceFloatFromLinearFloatFast(float v) const
 {
     assert(init_);
+    float ret;
+    convert_with_float_table(toFunc_float, _toFunc, &v, 1, 1, &ret, 1);
 
-    return Color::intToFloat<0xff01>(toFunc_hipart_to_uint8xx[hipart(v)]);
+    return ret;
 }
 
-#endif
+float
+Lut::fromColorSpaceFloatToLinearFloatFast(float v) const
+{
+    assert(init_);
+    float ret;
+    convert_with_float_table(fromFunc_float, _fromFunc, &v, 1, 1, &ret, 1);
+
+    return ret;
+}
+
+void
+Lut::toColorSpaceFloatFromLinearFloatFast(float* p,
+                                          int n) const
+{
+    assert(init_);
+    convert_with_float_table(toFunc_float, _toFunc, p, 1, n, p, 1);
+}
+
+void
+Lut::fromColorSpaceFloatToLinearFloatFast(float* p,
+                                          int n) const
+{
+    assert(init_);
+    convert_with_float_table(fromFunc_float, _fromFunc, p, 1, n, p, 1);
+}
+
+void
+Lut::toColorSpaceFloatFromLinearFloatFast(const float* from,
+                                          int inDelta,
+                                          int n,
+                                          float* to,
+                                          int outDelta) const
+{
+    assert(init_);
+    convert_with_float_table(toFunc_float, _toFunc, from, inDelta, n, to, outDelta);
+}
+
+void
+Lut::fromColorSpaceFloatToLinearFloatFast(const float* from,
+                                          int inDelta,
+                                          int n,
+                                          float* to,
+                                          int outDelta) const
+{
+    assert(init_);
+    convert_with_float_table(fromFunc_float, _fromFunc, from, inDelta, n, to, outDelta);
+}
 
 unsigned char
 Lut::toColorSpaceUint8FromLinearFloatFast(float v) const
@@ -231,62 +496,22 @@ Lut::toColorSpaceUint8xxFromLinearFloatFast(float v) const
     return toFunc_hipart_to_uint8xx[hipart(v)];
 }
 
-// the following only works for increasing LUTs
 unsigned short
 Lut::toColorSpaceUint16FromLinearFloatFast(float v) const
 {
     assert(init_);
-    // algorithm:
-    // - convert to 8 bits -> val8u
-    // - convert val8u-1, val8u and val8u+1 to float
-    // - interpolate linearly in the right interval
-    unsigned char v8u = toColorSpaceUint8FromLinearFloatFast(v);
-    unsigned char v8u_next, v8u_prev;
-    float v32f_next, v32f_prev;
-    if (v8u == 0) {
-        v8u_prev = 0;
-        v8u_next = 1;
-        v32f_prev = fromColorSpaceUint8ToLinearFloatFast(0);
-        v32f_next = fromColorSpaceUint8ToLinearFloatFast(1);
-    } else if (v8u == 255) {
-        v8u_prev = 254;
-        v8u_next = 255;
-        v32f_prev = fromColorSpaceUint8ToLinearFloatFast(254);
-        v32f_next = fromColorSpaceUint8ToLinearFloatFast(255);
-    } else {
-        float v32f = fromColorSpaceUint8ToLinearFloatFast(v8u);
-        // we suppose the LUT is an increasing func
-        if (v < v32f) {
-            v8u_prev = v8u - 1;
-            v32f_prev = fromColorSpaceUint8ToLinearFloatFast(v8u_prev);
-            v8u_next = v8u;
-            v32f_next = v32f;
-        } else {
-            v8u_prev = v8u;
-            v32f_prev = v32f;
-            v8u_next = v8u + 1;
-            v32f_next = fromColorSpaceUint8ToLinearFloatFast(v8u_next);
-        }
-    }
+    unsigned short ret;
+    linearFloatToUint16(toFunc_hipart_to_float, &v, NULL, 1, 1, &ret, 1);
 
-    // interpolate linearly
-    return (v8u_prev << 8) + v8u_prev + (v - v32f_prev) * ( ( (v8u_next - v8u_prev) << 8 ) + (v8u_next + v8u_prev) ) / (v32f_next - v32f_prev) + 0.5;
+    return ret;
 }
 
 float
 Lut::fromColorSpaceUint16ToLinearFloatFast(unsigned short v) const
 {
     assert(init_);
-    // the following is from ImageMagick's quantum.h
-    unsigned char v8u_prev = ( v - (v >> 8) ) >> 8;
-    unsigned char v8u_next = v8u_prev + 1;
-    unsigned short v16u_prev = (v8u_prev << 8) + v8u_prev;
-    unsigned short v16u_next = (v8u_next << 8) + v8u_next;
-    float v32f_prev = fromColorSpaceUint8ToLinearFloatFast(v8u_prev);
-    float v32f_next = fromColorSpaceUint8ToLinearFloatFast(v8u_next);
 
-    // interpolate linearly
-    return v32f_prev + (v - v16u_prev) * (v32f_next - v32f_prev) / (v16u_next - v16u_prev);
+    return fromFunc_uint16_to_float[v];
 }
 
 void
@@ -300,7 +525,13 @@ Lut::fillTables() const
         float inp = index_to_float( (unsigned short)i );
         float f = _toFunc(inp);
         toFunc_hipart_to_uint8xx[i] = Color::floatToInt<0xff01>(f);
+        toFunc_hipart_to_float[i] = _toFunc( hipart_start_to_float( (unsigned short)i ) );
+        fromFunc_uint16_to_float[i] = _fromFunc( Color::intToFloat<65536>(i) );
     }
+    // the last interval has no upper end: make it constant
+    toFunc_hipart_to_float[0x10000] = toFunc_hipart_to_float[0xffff];
+    fill_float_table(_toFunc, toFunc_float);
+    fill_float_table(_fromFunc, fromFunc_float);
     // fill fromFunc_uint8_to_float, and make sure that
     // the entries of toFunc_hipart_to_uint8xx corresponding
     // to the transform of each byte value contain the same value,
@@ -366,14 +597,15 @@ Lut::to_byte_planar(unsigned char* to,
 }
 
 void
-Lut::to_short_planar(unsigned short* /*to*/,
-                     const float* /*from*/,
-                     int /*W*/,
-                     const float* /*alpha*/,
-                     int /*inDelta*/,
-                     int /*outDelta*/) const
+Lut::to_short_planar(unsigned short* to,
+                     const float* from,
+                     int W,
+                     const float* alpha,
+                     int inDelta,
+                     int outDelta) const
 {
-    throw std::runtime_error("Lut::to_short_planar not implemented yet.");
+    validate();
+    linearFloatToUint16(toFunc_hipart_to_float, from, alpha, inDelta, W, to, outDelta);
 }
 
 void
@@ -385,14 +617,14 @@ Lut::to_float_planar(float* to,
                      int outDelta) const
 {
     validate();
+    const int n = (W + inDelta - 1) / inDelta;
     if (!alpha) {
-        for (int f = 0,t = 0; f < W; f += inDelta, t += outDelta) {
-            to[t] = toColorSpaceFloatFromLinearFloat(from[f]);
-        }
+        convert_with_float_table(toFunc_float, _toFunc, from, inDelta, n, to, outDelta);
     } else {
         for (int f = 0,t = 0; f < W; f += inDelta, t += outDelta) {
-            to[t] = toColorSpaceFloatFromLinearFloat(from[f] * alpha[f]);
+            to[t] = from[f] * alpha[f];
         }
+        convert_with_float_table(toFunc_float, _toFunc, to, outDelta, n, to, outDelta);
     }
 }
 
@@ -479,18 +711,62 @@ Lut::to_byte_packed(unsigned char* to,
 } // to_byte_packed
 
 void
-Lut::to_short_packed(unsigned short* /*to*/,
-                     const float* /*from*/,
-                     const RectI & /*conversionRect*/,
-                     const RectI & /*srcBounds*/,
-                     const RectI & /*dstBounds*/,
-                     PixelPackingEnum /*inputPacking*/,
-                     PixelPackingEnum /*outputPacking*/,
-                     bool /*invertY*/,
-                     bool /*premult*/) const
+Lut::to_short_packed(unsigned short* to,
+                     const float* from,
+                     const RectI & conversionRect,
+                     const RectI & srcBounds,
+                     const RectI & dstBounds,
+                     PixelPackingEnum inputPacking,
+                     PixelPackingEnum outputPacking,
+                     bool invertY,
+                     bool premult) const
 {
-    throw std::runtime_error("Lut::to_short_packed not implemented yet.");
-}
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("Invalid pixel format.");
+    }
+
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect,srcBounds) || !clip(&rect,dstBounds) ) {
+        return;
+    }
+
+    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
+    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
+    int inROffset, inGOffset, inBOffset, inAOffset;
+    int outROffset, outGOffset, outBOffset, outAOffset;
+    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
+    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
+
+    int inPackingSize,outPackingSize;
+    inPackingSize = inputHasAlpha ? 4 : 3;
+    outPackingSize = outputHasAlpha ? 4 : 3;
+
+    validate();
+
+    const int width = rect.x2 - rect.x1;
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        int srcY = y;
+        if (!invertY) {
+            srcY = srcBounds.y2 - y - 1;
+        }
+
+        int dstY = dstBounds.y2 - y - 1;
+        const float *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize) + rect.x1 * inPackingSize;
+        unsigned short *dst_pixels = to + (dstY * (dstBounds.x2 - dstBounds.x1) * outPackingSize) + rect.x1 * outPackingSize;
+        const float* alpha = (inputHasAlpha && premult) ? src_pixels + inAOffset : NULL;
+        ///each channel is converted separately, the conversion is not the bottleneck of the strided accesses
+        linearFloatToUint16(toFunc_hipart_to_float, src_pixels + inROffset, alpha, inPackingSize, width, dst_pixels + outROffset, outPackingSize);
+        linearFloatToUint16(toFunc_hipart_to_float, src_pixels + inGOffset, alpha, inPackingSize, width, dst_pixels + outGOffset, outPackingSize);
+        linearFloatToUint16(toFunc_hipart_to_float, src_pixels + inBOffset, alpha, inPackingSize, width, dst_pixels + outBOffset, outPackingSize);
+        if (outputHasAlpha) {
+            for (int x = 0; x < width; ++x) {
+                float a = inputHasAlpha ? src_pixels[x * inPackingSize + inAOffset] : 1.f;
+                dst_pixels[x * outPackingSize + outAOffset] = floatToInt<65536>(a);
+            }
+        }
+    }
+} // to_short_packed
 
 void
 Lut::to_float_packed(float* to,
@@ -523,6 +799,7 @@ Lut::to_float_packed(float* to,
 
     validate();
 
+    const int width = rect.x2 - rect.x1;
     for (int y = rect.y1; y < rect.y2; ++y) {
         int srcY = y;
         if (invertY) {
@@ -532,18 +809,23 @@ Lut::to_float_packed(float* to,
         int dstY = dstBounds.y2 - y - 1;
         const float *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
         float *dst_pixels = to + (dstY * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
-        /* go fowards from starting point to end of line: */
         for (int x = rect.x1; x < rect.x2; ++x) {
             int inCol = x * inPackingSize;
             int outCol = x * outPackingSize;
             float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;;
-            dst_pixels[outCol + outROffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inROffset] * a);
-            dst_pixels[outCol + outGOffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inGOffset] * a);
-            dst_pixels[outCol + outBOffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inBOffset] * a);
+            dst_pixels[outCol + outROffset] = src_pixels[inCol + inROffset] * a;
+            dst_pixels[outCol + outGOffset] = src_pixels[inCol + inGOffset] * a;
+            dst_pixels[outCol + outBOffset] = src_pixels[inCol + inBOffset] * a;
             if (outputHasAlpha) {
                 dst_pixels[outCol + outAOffset] = a;
             }
         }
+        ///convert the whole row, one channel at a time
+        const int offsets[3] = { outROffset, outGOffset, outBOffset };
+        for (int c = 0; c < 3; ++c) {
+            float* dst = dst_pixels + rect.x1 * outPackingSize + offsets[c];
+            convert_with_float_table(toFunc_float, _toFunc, dst, outPackingSize, width, dst, outPackingSize);
+        }
     }
 }
 
@@ -568,14 +850,15 @@ Lut::from_byte_planar(float* to,
 }
 
 void
-Lut::from_short_planar(float* /*to*/,
-                       const unsigned short* /*from*/,
-                       int /*W*/,
-                       const unsigned short*/* alpha*/,
-                       int /*inDelta*/,
-                       int /* outDelta*/) const
+Lut::from_short_planar(float* to,
+                       const unsigned short* from,
+                       int W,
+                       const unsigned short* alpha,
+                       int inDelta,
+                       int outDelta) const
 {
-    throw std::runtime_error("Lut::from_short_planar not implemented yet.");
+    validate();
+    uint16ToLinearFloat(fromFunc_uint16_to_float, from, alpha, inDelta, W, to, outDelta);
 }
 
 void
@@ -587,14 +870,17 @@ Lut::from_float_planar(float* to,
                        int outDelta) const
 {
     validate();
+    const int n = (W + inDelta - 1) / inDelta;
     if (!alpha) {
-        for (int f = 0,t = 0; f < W; f += inDelta, t += outDelta) {
-            to[t] = fromColorSpaceFloatToLinearFloat(from[f]);
-        }
+        convert_with_float_table(fromFunc_float, _fromFunc, from, inDelta, n, to, outDelta);
     } else {
         for (int f = 0,t = 0; f < W; f += inDelta, t += outDelta) {
             float a = alpha[f];
-            to[t] = a <= 0. ? 0. : fromColorSpaceFloatToLinearFloat(from[f] / a) * a;
+            to[t] = a <= 0. ? 0. : from[f] / a;
+        }
+        convert_with_float_table(fromFunc_float, _fromFunc, to, outDelta, n, to, outDelta);
+        for (int f = 0,t = 0; f < W; f += inDelta, t += outDelta) {
+            to[t] *= alpha[f];
         }
     }
 }
@@ -678,18 +964,60 @@ Lut::from_byte_packed(float* to,
 } // from_byte_packed
 
 void
-Lut::from_short_packed(float* /*to*/,
-                       const unsigned short* /*from*/,
-                       const RectI & /*conversionRect*/,
-                       const RectI & /*srcBounds*/,
-                       const RectI & /*dstBounds*/,
-                       PixelPackingEnum /*inputPacking*/,
-                       PixelPackingEnum /*outputPacking*/,
-                       bool /*invertY*/,
-                       bool /*premult*/) const
+Lut::from_short_packed(float* to,
+                       const unsigned short* from,
+                       const RectI & conversionRect,
+                       const RectI & srcBounds,
+                       const RectI & dstBounds,
+                       PixelPackingEnum inputPacking,
+                       PixelPackingEnum outputPacking,
+                       bool invertY,
+                       bool premult) const
 {
-    throw std::runtime_error("Lut::from_short_packed not implemented yet.");
-}
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("Invalid pixel format.");
+    }
+
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect,srcBounds) || !clip(&rect,dstBounds) ) {
+        return;
+    }
+
+
+    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
+    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
+    int inROffset, inGOffset, inBOffset, inAOffset;
+    int outROffset, outGOffset, outBOffset, outAOffset;
+    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
+    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
+
+    int inPackingSize,outPackingSize;
+    inPackingSize = inputHasAlpha ? 4 : 3;
+    outPackingSize = outputHasAlpha ? 4 : 3;
+
+    validate();
+
+    const int width = rect.x2 - rect.x1;
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        int srcY = y;
+        if (invertY) {
+            srcY = srcBounds.y2 - y - 1;
+        }
+
+        const unsigned short *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize) + rect.x1 * inPackingSize;
+        float *dst_pixels = to + (y * (dstBounds.x2 - dstBounds.x1) * outPackingSize) + rect.x1 * outPackingSize;
+        const unsigned short* alpha = (inputHasAlpha && premult) ? src_pixels + inAOffset : NULL;
+        uint16ToLinearFloat(fromFunc_uint16_to_float, src_pixels + inROffset, alpha, inPackingSize, width, dst_pixels + outROffset, outPackingSize);
+        uint16ToLinearFloat(fromFunc_uint16_to_float, src_pixels + inGOffset, alpha, inPackingSize, width, dst_pixels + outGOffset, outPackingSize);
+        uint16ToLinearFloat(fromFunc_uint16_to_float, src_pixels + inBOffset, alpha, inPackingSize, width, dst_pixels + outBOffset, outPackingSize);
+        if (outputHasAlpha) {
+            for (int x = 0; x < width; ++x) {
+                dst_pixels[x * outPackingSize + outAOffset] = inputHasAlpha ? Color::intToFloat<65536>(src_pixels[x * inPackingSize + inAOffset]) : 1.f;
+            }
+        }
+    }
+} // from_short_packed
 
 void
 Lut::from_float_packed(float* to,
@@ -726,6 +1054,7 @@ Lut::from_float_packed(float* to,
 
     validate();
 
+    const int width = rect.x2 - rect.x1;
     for (int y = rect.y1; y < rect.y2; ++y) {
         int srcY = y;
         if (invertY) {
@@ -743,13 +1072,28 @@ Lut::from_float_packed(float* to,
                 gf = src_pixels[inCol + inGOffset] / a;
                 bf = src_pixels[inCol + inBOffset] / a;
             }
-            dst_pixels[outCol + outROffset] = fromColorSpaceFloatToLinearFloat(rf) * a;
-            dst_pixels[outCol + outGOffset] = fromColorSpaceFloatToLinearFloat(gf) * a;
-            dst_pixels[outCol + outBOffset] = fromColorSpaceFloatToLinearFloat(bf) * a;
+            dst_pixels[outCol + outROffset] = rf;
+            dst_pixels[outCol + outGOffset] = gf;
+            dst_pixels[outCol + outBOffset] = bf;
             if (outputHasAlpha) {
                 dst_pixels[outCol + outAOffset] = a;
             }
         }
+        ///convert the whole row, one channel at a time, then premultiply again
+        const int offsets[3] = { outROffset, outGOffset, outBOffset };
+        for (int c = 0; c < 3; ++c) {
+            float* dst = dst_pixels + rect.x1 * outPackingSize + offsets[c];
+            convert_with_float_table(fromFunc_float, _fromFunc, dst, outPackingSize, width, dst, outPackingSize);
+        }
+        if (inputHasAlpha && premult) {
+            for (int x = rect.x1; x < rect.x2; ++x) {
+                float a = src_pixels[x * inPackingSize + inAOffset];
+                float* dst = dst_pixels + x * outPackingSize;
+                dst[outROffset] *= a;
+                dst[outGOffset] *= a;
+                dst[outBOffset] *= a;
+            }
+        }
     }
 } // from_float_packed
 
@@ -858,16 +1202,58 @@ from_byte_packed(float *to,
 }
 
 void
-from_short_packed(float */*to*/,
-                  const unsigned short */*from*/,
-                  const RectI & /*rect*/,
-                  const RectI & /*srcRod*/,
-                  const RectI & /*rod*/,
-                  PixelPackingEnum /*inputFormat*/,
-                  PixelPackingEnum /*format*/,
-                  bool /*invertY*/)
+from_short_packed(float *to,
+                  const unsigned short *from,
+                  const RectI &conversionRect,
+                  const RectI &srcBounds,
+                  const RectI &dstBounds,
+                  PixelPackingEnum inputPacking,
+                  PixelPackingEnum outputPacking,
+                  bool invertY)
 {
-    throw std::runtime_error("Linear::from_short_packed not yet implemented.");
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("Invalid pixel format.");
+    }
+
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect,srcBounds) || !clip(&rect,dstBounds) ) {
+        return;
+    }
+
+
+    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
+    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
+    int inROffset, inGOffset, inBOffset, inAOffset;
+    int outROffset, outGOffset, outBOffset, outAOffset;
+    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
+    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
+
+
+    int inPackingSize,outPackingSize;
+    inPackingSize = inputHasAlpha ? 4 : 3;
+    outPackingSize = outputHasAlpha ? 4 : 3;
+
+
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        int srcY = y;
+        if (invertY) {
+            srcY = srcBounds.y2 - y - 1;
+        }
+        const unsigned short *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
+        float *dst_pixels = to + (y * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
+        for (int x = rect.x1; x < rect.x2; ++x) {
+            int inCol = x * inPackingSize;
+            int outCol = x * outPackingSize;
+            unsigned short a = inputHasAlpha ? src_pixels[inCol + inAOffset] : 65535;
+            dst_pixels[outCol + outROffset] = Color::intToFloat<65536>(src_pixels[inCol + inROffset]);
+            dst_pixels[outCol + outGOffset] = Color::intToFloat<65536>(src_pixels[inCol + inGOffset]);
+            dst_pixels[outCol + outBOffset] = Color::intToFloat<65536>(src_pixels[inCol + inBOffset]);
+            if (outputHasAlpha) {
+                dst_pixels[outCol + outAOffset] = Color::intToFloat<65536>(a);
+            }
+        }
+    }
 }
 
 void
@@ -1026,13 +1412,16 @@ to_short_planar(unsigned short *to,
                 int inDelta,
                 int outDelta)
 {
-    (void)to;
-    (void)from;
-    (void)W;
-    (void)alpha;
-    (void)inDelta;
-    (void)outDelta;
-    throw std::runtime_error("Linear::to_short_planar not yet implemented.");
+    ///16 bits are precise enough to round without error diffusion
+    if (!alpha) {
+        for (int x = 0; x < W; ++x) {
+            to[x * outDelta] = floatToInt<65536>(from[x * inDelta]);
+        }
+    } else {
+        for (int x = 0; x < W; ++x) {
+            to[x * outDelta] = floatToInt<65536>(from[x * inDelta] * alpha[x * inDelta]);
+        }
+    }
 }
 
 void
@@ -1150,17 +1539,50 @@ to_short_packed(unsigned short* to,
                 bool invertY,
                 bool premult)
 {
-    (void)to;
-    (void)from;
-    (void)conversionRect;
-    (void)srcBounds;
-    (void)dstBounds;
-    (void)invertY;
-    (void)premult;
-    (void)inputPacking;
-    (void)outputPacking;
-    throw std::runtime_error("Linear::to_short_packed not yet implemented.");
-}
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("This function is not meant for planar buffers.");
+    }
+
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect,srcBounds) || !clip(&rect,dstBounds) ) {
+        return;
+    }
+
+
+    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
+    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
+    int inROffset, inGOffset, inBOffset, inAOffset;
+    int outROffset, outGOffset, outBOffset, outAOffset;
+    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
+    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
+
+    int inPackingSize,outPackingSize;
+    inPackingSize = inputHasAlpha ? 4 : 3;
+    outPackingSize = outputHasAlpha ? 4 : 3;
+
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        int srcY = y;
+        if (invertY) {
+            srcY = srcBounds.y2 - y - 1;
+        }
+
+        const float *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
+        unsigned short *dst_pixels = to + (y * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
+        for (int x = rect.x1; x < rect.x2; ++x) {
+            int inCol = x * inPackingSize;
+            int outCol = x * outPackingSize;
+            float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;
+
+            dst_pixels[outCol + outROffset] = floatToInt<65536>(src_pixels[inCol + inROffset] * a);
+            dst_pixels[outCol + outGOffset] = floatToInt<65536>(src_pixels[inCol + inGOffset] * a);
+            dst_pixels[outCol + outBOffset] = floatToInt<65536>(src_pixels[inCol + inBOffset] * a);
+            if (outputHasAlpha) {
+                dst_pixels[outCol + outAOffset] = floatToInt<65536>(inputHasAlpha ? src_pixels[inCol + inAOffset] : 1.f);
+            }
+        }
+    }
+} // to_short_packed
 
 void
 to_float_packed(float* to,
@@ -71,6 +71,18 @@ enum PixelPackingEnum
 };
 
 
+/// The float-to-float tables sample the transfer function at the start of the intervals of floats sharing the same
+/// exponent and kLutFloatMantissaBits most significant bits of the mantissa, in [2^kLutFloatMinExponent, 2^kLutFloatMaxExponent[.
+/// One more interval covers [0, 2^kLutFloatMinExponent[. Values outside of this range are converted with the functions.
+#define kLutFloatMinExponent -14
+#define kLutFloatMaxExponent 8
+#define kLutFloatMantissaBits 10
+#define kLutFloatTableSize ( (kLutFloatMaxExponent - kLutFloatMinExponent) * (1 << kLutFloatMantissaBits) + 2 )
+
+/// The maximum error of the float-to-float tables, relative to the exact value (or to 1e-2 for smaller values).
+/// Each interval is checked when the tables are filled, the ones that exceed it are converted with the functions.
+#define kLutFloatMaxError 1e-5
+
 /* @brief Converts a float ranging in [0 - 1.f] in the desired color-space to linear color-space also ranging in [0 - 1.f]*/
 typedef float (*fromColorSpaceFunctionV1)(float v);
 
@@ -147,7 +159,11 @@ class Lut
     /// the fast lookup tables are mutable, because they are automatically initialized post-construction,
     /// and never change afterwards
     mutable unsigned short toFunc_hipart_to_uint8xx[0x10000];         /// contains  2^16 = 65536 values between 0-255
+    mutable float toFunc_hipart_to_float[0x10001];         /// toFunc at the start of each hipart interval, interpolated for 16-bit outputs
     mutable float fromFunc_uint8_to_float[256];         /// values between 0-1.f
+    mutable float fromFunc_uint16_to_float[0x10000];         /// values between 0-1.f
+    mutable float toFunc_float[kLutFloatTableSize];         /// toFunc sampled for the float-to-float conversions, NaN where not accurate enough
+    mutable float fromFunc_float[kLutFloatTableSize];         /// fromFunc sampled for the float-to-float conversions, NaN where not accurate enough
     mutable bool init_;         ///< false if the tables are not yet initialized
     mutable QMutex _lock;         ///< protects init_
 
@@ -207,11 +223,28 @@ public:
     }
 
     /* @brief Converts a float ranging in [0 - 1.f] in linear color-space using the look-up tables.
-     * @return A float in [0 - 1.f] in the destination color-space.
+     * @return A float in [0 - 1.f] in the destination color-space, within kLutFloatMaxError of
+     * toColorSpaceFloatFromLinearFloat(v).
+     * The interpolation is only vectorized by the buffer versions below, which should be used in loops.
+     */
+    float toColorSpaceFloatFromLinearFloatFast(float v) const;
+
+    /* @brief Converts a float ranging in [0 - 1.f] in the destination color-space using the look-up tables.
+     * @return A float in [0 - 1.f] in linear color-space, within kLutFloatMaxError of
+     * fromColorSpaceFloatToLinearFloat(v).
+     */
+    float fromColorSpaceFloatToLinearFloatFast(float v) const;
+
+    /* @brief Same as above, for the n values of the buffer p, which are converted in place.
+     */
+    void toColorSpaceFloatFromLinearFloatFast(float* p, int n) const;
+    void fromColorSpaceFloatToLinearFloatFast(float* p, int n) const;
+
+    /* @brief Same as above, for the n values from[0], from[inDelta], ... written to to[0], to[outDelta], ...
+     * e.g to convert a channel of a row of packed pixels. from and to may be the same buffer.
      */
-    // It is not recommended to use this function, because the output is quantized
-    // If one really needs float, one has to use the full function (or OpenColorIO)
-    //float toColorSpaceFloatFromLinearFloatFast(float v) const;
+    void toColorSpaceFloatFromLinearFloatFast(const float* from, int inDelta, int n, float* to, int outDelta) const;
+    void fromColorSpaceFloatToLinearFloatFast(const float* from, int inDelta, int n, float* to, int outDelta) const;
 
     /* @brief Converts a float ranging in [0 - 1.f] in linear color-space using the look-up tables.
      * @return A byte in [0 - 255] in the destination color-space.
@@ -225,7 +258,8 @@ public:
 
     /* @brief Converts a float ranging in [0 - 1.f] in linear color-space using the look-up tables.
      * @return An unsigned short in [0 - 65535] in the destination color-space.
-     * This function uses localluy linear approximations of the transfer function.
+     * The transfer function is interpolated linearly between the 65536 values sampled at the start of each
+     * interval of floats sharing the same 16 most significant bits, which is accurate to 1 unit at 16 bits.
      */
     unsigned short toColorSpaceUint16FromLinearFloatFast(float v) const;
 
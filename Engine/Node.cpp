@@ -118,6 +118,7 @@ struct Node::Implementation
     , activated(true)
     , plugin(plugin_)
     , computingPreview(false)
+    , previewAbortRequested(false)
     , computingPreviewMutex()
     , pluginInstanceMemoryUsed(0)
     , memoryUsedMutex()
@@ -191,6 +192,7 @@ struct Node::Implementation
     void setComputingPreview(bool v) {
         QMutexLocker l(&computingPreviewMutex);
         computingPreview = v;
+        previewAbortRequested = false;
     }
     
     void restoreUserKnobsRecursive(const std::list<boost::shared_ptr<KnobSerializationBase> >& knobs,
@@ -202,6 +204,10 @@ struct Node::Implementation
     
     void ifGroupForceHashChangeOfInputs();
     
+    ///Invalidates the topological order of the collections of this node and of the input, called once the input
+    ///was (dis)connected, outside of inputsMutex
+    void notifyTopologyChanged(Node* input);
+    
     void runOnNodeCreatedCB(bool userEdited);
     
     void runOnNodeDeleteCB();
@@ -252,6 +258,7 @@ struct Node::Implementation
     Natron::Plugin* plugin; //< the plugin which stores the function to instantiate the effect
     
     bool computingPreview;
+    bool previewAbortRequested; //< the preview being computed must stop as soon as possible, protected by computingPreviewMutex
     mutable QMutex computingPreviewMutex;
     
     size_t pluginInstanceMemoryUsed; //< global count on all EffectInstance's of the memory they use.
@@ -637,67 +644,77 @@ Node::getHashValue() const
 }
 
 void
-Node::computeHashInternal(std::list<Natron::Node*>& marked)
+Node::computeHashOfThisNode()
 {
-    if (std::find(marked.begin(), marked.end(), this) != marked.end()) {
-        return;
-    }
-    
     ///Always called in the main thread
     assert( QThread::currentThread() == qApp->thread() );
     if (!_imp->inputsInitialized) {
         qDebug() << "Node::computeHash(): inputs not initialized";
     }
     
+    QWriteLocker l(&_imp->knobsAgeMutex);
+    
+    ///reset the hash value
+    _imp->hash.reset();
+    
+    ///append the effect's own age
+    _imp->hash.append(_imp->knobsAge);
+    
+    ///append all inputs hash
     {
-        QWriteLocker l(&_imp->knobsAgeMutex);
+        ViewerInstance* isViewer = dynamic_cast<ViewerInstance*>(_imp->liveInstance.get());
         
-        ///reset the hash value
-        _imp->hash.reset();
-        
-        ///append the effect's own age
-        _imp->hash.append(_imp->knobsAge);
-        
-        ///append all inputs hash
-        {
-            ViewerInstance* isViewer = dynamic_cast<ViewerInstance*>(_imp->liveInstance.get());
+        if (isViewer) {
+            int activeInput[2];
+            isViewer->getActiveInputs(activeInput[0], activeInput[1]);
             
-            if (isViewer) {
-                int activeInput[2];
-                isViewer->getActiveInputs(activeInput[0], activeInput[1]);
-                
-                for (int i = 0; i < 2; ++i) {
-                    NodePtr input = getInput(activeInput[i]);
-                    if (input) {
-                        _imp->hash.append(input->getHashValue() );
-                    }
+            for (int i = 0; i < 2; ++i) {
+                NodePtr input = getInput(activeInput[i]);
+                if (input) {
+                    _imp->hash.append(input->getHashValue() );
                 }
-            } else {
-                for (U32 i = 0; i < _imp->inputs.size(); ++i) {
-                    NodePtr input = getInput(i);
-                    if (input) {
-                        ///Add the index of the input to its hash.
-                        ///Explanation: if we didn't add this, just switching inputs would produce a similar
-                        ///hash.
-                        _imp->hash.append(input->getHashValue() + i);
-                    }
+            }
+        } else {
+            for (U32 i = 0; i < _imp->inputs.size(); ++i) {
+                NodePtr input = getInput(i);
+                if (input) {
+                    ///Add the index of the input to its hash.
+                    ///Explanation: if we didn't add this, just switching inputs would produce a similar
+                    ///hash.
+                    _imp->hash.append(input->getHashValue() + i);
                 }
             }
         }
-        
-        ///Also append the effect's label to distinguish 2 instances with the same parameters
-        ::Hash64_appendQString( &_imp->hash, QString( getScriptName().c_str() ) );
-        
-        
-        ///Also append the project's creation time in the hash because 2 projects openend concurrently
-        ///could reproduce the same (especially simple graphs like Viewer-Reader)
-        qint64 creationTime =  getApp()->getProject()->getProjectCreationTime();
-        _imp->hash.append(creationTime);
-        
-        _imp->hash.computeHash();
     }
     
-    marked.push_back(this);
+    ///Also append the effect's label to distinguish 2 instances with the same parameters
+    ::Hash64_appendQString( &_imp->hash, QString( getScriptName().c_str() ) );
+    
+    
+    ///Also append the project's creation time in the hash because 2 projects openend concurrently
+    ///could reproduce the same (especially simple graphs like Viewer-Reader)
+    qint64 creationTime =  getApp()->getProject()->getProjectCreationTime();
+    _imp->hash.append(creationTime);
+    
+    _imp->hash.computeHash();
+}
+
+void
+Node::computeHashInternal(std::set<Natron::Node*>& marked)
+{
+    if ( !marked.insert(this).second ) {
+        return;
+    }
+    
+    computeHashOfThisNode();
+    
+    ///While a project is loading, nodes are connected one after another: propagating the hash downstream
+    ///at each connection is quadratic in the number of nodes. Instead the hash of the whole graph is computed
+    ///once all nodes are connected, see computeHashAfterInputs.
+    if ( getApp()->getProject()->isRestoringNodes() ) {
+        _imp->liveInstance->onNodeHashChanged(getHashValue());
+        return;
+    }
     
     ///call it on all the outputs
     std::list<Node*> outputs;
@@ -723,10 +740,29 @@ Node::computeHashInternal(std::list<Natron::Node*>& marked)
 
 }
 
+void
+Node::computeHashAfterInputs(std::set<Natron::Node*>* marked)
+{
+    if ( !marked->insert(this).second ) {
+        return;
+    }
+    
+    ///Inputs are hashed first since this node's hash depends on theirs
+    for (U32 i = 0; i < _imp->inputs.size(); ++i) {
+        NodePtr input = getInput(i);
+        if (input) {
+            input->computeHashAfterInputs(marked);
+        }
+    }
+    
+    computeHashOfThisNode();
+    _imp->liveInstance->onNodeHashChanged(getHashValue());
+}
+
 void
 Node::computeHash()
 {
-    std::list<Natron::Node*> marked;
+    std::set<Natron::Node*> marked;
     computeHashInternal(marked);
     
 } // computeHash
@@ -1121,6 +1157,23 @@ Node::isRenderingPreview() const
     return _imp->computingPreview;
 }
 
+void
+Node::abortPreviewRendering()
+{
+    QMutexLocker l(&_imp->computingPreviewMutex);
+    if (_imp->computingPreview) {
+        _imp->previewAbortRequested = true;
+    }
+}
+
+bool
+Node::isPreviewAbortRequested() const
+{
+    QMutexLocker l(&_imp->computingPreviewMutex);
+    
+    return _imp->previewAbortRequested;
+}
+
 bool
 Node::hasOverlay() const
 {
@@ -1138,6 +1191,10 @@ Node::Implementation::abortPreview()
     {
         QMutexLocker locker(&computingPreviewMutex);
         computing = computingPreview;
+        ///Abort the render of the preview rather than waiting for it to be done
+        if (computing) {
+            previewAbortRequested = true;
+        }
     }
     
     if (computing) {
@@ -2333,28 +2390,50 @@ Node::isNodeUpstream(const Natron::Node* input,
     ////Only called by the main-thread
     assert( QThread::currentThread() == qApp->thread() );
     
+    *ok = false;
     if (!input) {
-        *ok = false;
-        
         return;
     }
     
-    ///No need to lock guiInputs is only written to by the main-thread
-    
-    for (U32 i = 0; i  < _imp->inputs.size(); ++i) {
-        if (_imp->inputs[i].get() == input) {
-            *ok = true;
-            
+    ///Nodes that come before input in the topological order of the graph cannot have input upstream: they are not visited
+    boost::shared_ptr<NodeCollection> group = getGroup();
+    int inputIndex = -1;
+    if ( group && input->getGroup() == group ) {
+        inputIndex = group->getTopologicalIndex(input);
+        int thisIndex = group->getTopologicalIndex(this);
+        if (inputIndex != -1 && thisIndex != -1 && thisIndex < inputIndex) {
             return;
         }
     }
-    *ok = false;
-    for (U32 i = 0; i  < _imp->inputs.size(); ++i) {
-        if (_imp->inputs[i]) {
-            _imp->inputs[i]->isNodeUpstream(input, ok);
-            if (*ok) {
+    
+    ///No need to lock guiInputs is only written to by the main-thread
+    std::set<const Natron::Node*> marked;
+    std::list<const Natron::Node*> toVisit;
+    toVisit.push_back(this);
+    while ( !toVisit.empty() ) {
+        const Natron::Node* node = toVisit.back();
+        toVisit.pop_back();
+        
+        for (U32 i = 0; i < node->_imp->inputs.size(); ++i) {
+            const Natron::Node* nodeInput = node->_imp->inputs[i].get();
+            if (!nodeInput) {
+                continue;
+            }
+            if (nodeInput == input) {
+                *ok = true;
+                
                 return;
             }
+            if ( !marked.insert(nodeInput).second ) {
+                continue;
+            }
+            if (inputIndex != -1) {
+                int index = group->getTopologicalIndex(nodeInput);
+                if (index != -1 && index < inputIndex) {
+                    continue;
+                }
+            }
+            toVisit.push_back(nodeInput);
         }
     }
 }
@@ -2463,6 +2542,7 @@ Node::connectInput(const boost::shared_ptr<Node> & input,
         _imp->inputs[inputNumber] = input;
         input->connectOutput(this);
     }
+    _imp->notifyTopologyChanged( input.get() );
     
     ///Get notified when the input name has changed
     QObject::connect( input.get(), SIGNAL( labelChanged(QString) ), this, SLOT( onInputLabelChanged(QString) ) );
@@ -2487,6 +2567,19 @@ Node::connectInput(const boost::shared_ptr<Node> & input,
     return true;
 }
 
+void
+Node::Implementation::notifyTopologyChanged(Node* input)
+{
+    boost::shared_ptr<NodeCollection> group = _publicInterface->getGroup();
+    if (group) {
+        group->notifyTopologyChanged();
+    }
+    boost::shared_ptr<NodeCollection> inputGroup = input->getGroup();
+    if (inputGroup && inputGroup != group) {
+        inputGroup->notifyTopologyChanged();
+    }
+}
+
 void
 Node::Implementation::ifGroupForceHashChangeOfInputs()
 {
@@ -2518,6 +2611,7 @@ Node::replaceInput(const boost::shared_ptr<Node>& input,int inputNumber)
         qDebug() << "Debug: Attempt to connect " << input->getScriptName_mt_safe().c_str() << " to Roto brush";
         return false;
     }
+    NodePtr oldInput;
     {
         ///Check for invalid index
         QMutexLocker l(&_imp->inputsMutex);
@@ -2540,10 +2634,15 @@ Node::replaceInput(const boost::shared_ptr<Node>& input,int inputNumber)
         if (_imp->inputs[inputNumber]) {
             QObject::connect( _imp->inputs[inputNumber].get(), SIGNAL( labelChanged(QString) ), this, SLOT( onInputLabelChanged(QString) ) );
             _imp->inputs[inputNumber]->disconnectOutput(this);
+            oldInput = _imp->inputs[inputNumber];
         }
         _imp->inputs[inputNumber] = input;
         input->connectOutput(this);
     }
+    if (oldInput) {
+        _imp->notifyTopologyChanged( oldInput.get() );
+    }
+    _imp->notifyTopologyChanged( input.get() );
     
     ///Get notified when the input name has changed
     QObject::connect( input.get(), SIGNAL( labelChanged(QString) ), this, SLOT( onInputLabelChanged(QString) ) );
@@ -2704,6 +2803,7 @@ Node::disconnectInput(int inputNumber)
     assert( QThread::currentThread() == qApp->thread() );
     assert(_imp->inputsInitialized);
     
+    NodePtr oldInput;
     {
         QMutexLocker l(&_imp->inputsMutex);
         if ( (inputNumber < 0) || ( inputNumber > (int)_imp->inputs.size() ) || (_imp->inputs[inputNumber] == NULL) ) {
@@ -2723,9 +2823,11 @@ Node::disconnectInput(int inputNumber)
         
         QObject::disconnect( _imp->inputs[inputNumber].get(), SIGNAL( labelChanged(QString) ), this, SLOT( onInputLabelChanged(QString) ) );
         _imp->inputs[inputNumber]->disconnectOutput(this);
+        oldInput = _imp->inputs[inputNumber];
         _imp->inputs[inputNumber].reset();
         
     }
+    _imp->notifyTopologyChanged( oldInput.get() );
     Q_EMIT inputChanged(inputNumber);
     onInputChanged(inputNumber);
     computeHash();
@@ -2764,6 +2866,7 @@ Node::disconnectInput(Node* input)
                 _imp->inputs[i].reset();
                 l.unlock();
                 input->disconnectOutput(this);
+                _imp->notifyTopologyChanged(input);
                 Q_EMIT inputChanged(i);
                 onInputChanged(i);
                 computeHash();
@@ -3295,7 +3398,8 @@ Node::makePreviewImage(SequenceTime time,
                                              0, //render Age
                                              0, // viewer requester
                                              0, //texture index
-                                             getApp()->getTimeLine().get());
+                                             getApp()->getTimeLine().get(),
+                                             this); //< preview requester
     
     std::list<ImageComponents> requestedComps;
     requestedComps.push_back(ImageComponents::getRGBComponents());
@@ -3765,7 +3869,7 @@ static void refreshPreviewsRecursivelyUpstreamInternal(int time,Node* node,std::
     
     for (U32 i = 0; i < inputs.size(); ++i) {
         if (inputs[i]) {
-            inputs[i]->refreshPreviewsRecursivelyUpstream(time);
+            refreshPreviewsRecursivelyUpstreamInternal(time,inputs[i].get(),marked);
         }
     }
 
@@ -3794,7 +3898,7 @@ static void refreshPreviewsRecursivelyDownstreamInternal(int time,Node* node,std
     node->getOutputs_mt_safe(outputs);
     for (std::list<Node*>::iterator it = outputs.begin(); it != outputs.end(); ++it) {
         assert(*it);
-        (*it)->refreshPreviewsRecursivelyDownstream(time);
+        refreshPreviewsRecursivelyDownstreamInternal(time,*it,marked);
     }
 
 }
@@ -20,6 +20,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <set>
 
 #include "Global/Macros.h"
 CLANG_DIAG_OFF(deprecated)
@@ -185,6 +186,13 @@ public:
      **/
     U64 getHashValue() const;
 
+    /**
+     * @brief Recompute the hash value of this node once the hash of all its inputs is up to date, without
+     * propagating it downstream. Nodes already in marked are skipped so that each node is hashed only once.
+     * This is used once all the nodes of a project are loaded and connected.
+     **/
+    void computeHashAfterInputs(std::set<Natron::Node*>* marked);
+
 
     /**
      * @brief Forwarded to the live effect instance
@@ -586,6 +594,16 @@ public:
      * @brief Returns true if the node is currently rendering a preview image.
      **/
     bool isRenderingPreview() const;
+    
+    /**
+     * @brief Aborts the render of the preview image being computed, if any, without waiting for it to stop.
+     **/
+    void abortPreviewRendering();
+    
+    /**
+     * @brief Returns true if the render of the preview image being computed must stop, @see EffectInstance::aborted
+     **/
+    bool isPreviewAbortRequested() const;
 
 
     /**
@@ -1010,7 +1028,9 @@ protected:
 
 private:
     
-    void computeHashInternal(std::list<Natron::Node*>& marked);
+    void computeHashInternal(std::set<Natron::Node*>& marked);
+    
+    void computeHashOfThisNode();
     
     void declareRotoPythonField();
 
@@ -1024,8 +1044,8 @@ private:
 
 
     /**
-     * @brief If the node is an input of this node, set ok to true, otherwise
-     * calls this function recursively on all inputs.
+     * @brief Set ok to true if the given node is upstream of this node. The topological order of the collection
+     * is used to skip the nodes that cannot have the given node upstream.
      **/
     void isNodeUpstream(const Natron::Node* input,bool* ok) const;
     
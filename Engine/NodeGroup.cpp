@@ -16,6 +16,7 @@
 #include "NodeGroup.h"
 
 #include <set>
+#include <map>
 #include <locale>
 #include <cfloat>
 #include <QThreadPool>
@@ -48,16 +49,28 @@ struct NodeCollectionPrivate
     mutable QMutex nodesMutex;
     NodeList nodes;
     
+    ///The nodes ordered so that each node comes after its inputs, recomputed lazily when topologyDirty is true
+    mutable QMutex topologyMutex;
+    bool topologyDirty;
+    NodeList topologicalOrder;
+    std::map<const Natron::Node*,int> topologicalIndexes;
+    
     NodeCollectionPrivate(AppInstance* app)
     : app(app)
     , graph(0)
     , nodesMutex()
     , nodes()
+    , topologyMutex()
+    , topologyDirty(true)
+    , topologicalOrder()
+    , topologicalIndexes()
     {
         
     }
     
     NodePtr findNodeInternal(const std::string& name,const std::string& recurseName) const;
+    
+    void refreshTopologicalOrder();
 };
 
 NodeCollection::NodeCollection(AppInstance* app)
@@ -131,17 +144,21 @@ NodeCollection::addNode(const NodePtr& node)
         QMutexLocker k(&_imp->nodesMutex);
         _imp->nodes.push_back(node);
     }
+    notifyTopologyChanged();
 }
 
 
 void
 NodeCollection::removeNode(const NodePtr& node)
 {
-    QMutexLocker k(&_imp->nodesMutex);
-    NodeList::iterator found = std::find(_imp->nodes.begin(), _imp->nodes.end(), node);
-    if (found != _imp->nodes.end()) {
-        _imp->nodes.erase(found);
+    {
+        QMutexLocker k(&_imp->nodesMutex);
+        NodeList::iterator found = std::find(_imp->nodes.begin(), _imp->nodes.end(), node);
+        if (found != _imp->nodes.end()) {
+            _imp->nodes.erase(found);
+        }
     }
+    notifyTopologyChanged();
 }
 
 NodePtr
@@ -156,6 +173,92 @@ NodeCollection::getLastNode(const std::string& pluginID) const
     return NodePtr();
 }
 
+static void
+visitNodeTopologically(const NodePtr& node,
+                       const std::set<Natron::Node*>& collectionNodes,
+                       std::set<Natron::Node*>* visited,
+                       NodeList* order)
+{
+    if ( !visited->insert( node.get() ).second ) {
+        return;
+    }
+    
+    ///Inputs come first. Inputs outside of the collection (e.g: when a node is being moved to another group) are ignored
+    std::vector<NodePtr> inputs = node->getInputs_copy();
+    for (std::vector<NodePtr>::iterator it = inputs.begin(); it != inputs.end(); ++it) {
+        if ( *it && collectionNodes.find( it->get() ) != collectionNodes.end() ) {
+            visitNodeTopologically(*it, collectionNodes, visited, order);
+        }
+    }
+    order->push_back(node);
+}
+
+void
+NodeCollectionPrivate::refreshTopologicalOrder()
+{
+    {
+        QMutexLocker k(&topologyMutex);
+        if (!topologyDirty) {
+            return;
+        }
+        ///Reset it before computing, so that a change made meanwhile invalidates the result
+        topologyDirty = false;
+    }
+    
+    NodeList allNodes;
+    {
+        QMutexLocker k(&nodesMutex);
+        allNodes = nodes;
+    }
+    std::set<Natron::Node*> collectionNodes;
+    for (NodeList::iterator it = allNodes.begin(); it != allNodes.end(); ++it) {
+        collectionNodes.insert( it->get() );
+    }
+    
+    std::set<Natron::Node*> visited;
+    NodeList order;
+    for (NodeList::iterator it = allNodes.begin(); it != allNodes.end(); ++it) {
+        visitNodeTopologically(*it, collectionNodes, &visited, &order);
+    }
+    
+    std::map<const Natron::Node*,int> indexes;
+    int index = 0;
+    for (NodeList::iterator it = order.begin(); it != order.end(); ++it, ++index) {
+        indexes.insert( std::make_pair(it->get(), index) );
+    }
+    
+    QMutexLocker k(&topologyMutex);
+    topologicalOrder.swap(order);
+    topologicalIndexes.swap(indexes);
+}
+
+void
+NodeCollection::getNodesInTopologicalOrder(NodeList* nodes) const
+{
+    _imp->refreshTopologicalOrder();
+    QMutexLocker k(&_imp->topologyMutex);
+    nodes->insert(nodes->end(), _imp->topologicalOrder.begin(), _imp->topologicalOrder.end());
+}
+
+int
+NodeCollection::getTopologicalIndex(const Natron::Node* node) const
+{
+    _imp->refreshTopologicalOrder();
+    QMutexLocker k(&_imp->topologyMutex);
+    std::map<const Natron::Node*,int>::const_iterator found = _imp->topologicalIndexes.find(node);
+    return found != _imp->topologicalIndexes.end() ? found->second : -1;
+}
+
+void
+NodeCollection::notifyTopologyChanged()
+{
+    QMutexLocker k(&_imp->topologyMutex);
+    _imp->topologyDirty = true;
+    ///Do not hold references onto nodes that may be removed
+    _imp->topologicalOrder.clear();
+    _imp->topologicalIndexes.clear();
+}
+
 bool
 NodeCollection::hasNodes() const
 {
@@ -269,17 +372,21 @@ NodeCollection::refreshViewersAndPreviews()
         int time = _imp->app->getTimeLine()->currentFrame();
         
         NodeList nodes = getNodes();
+        
+        ///Start the viewers first: previews are rendered by the same thread pool and would otherwise
+        ///delay the first frame displayed after loading a project.
         for (NodeList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
             assert(*it);
+            ViewerInstance* n = dynamic_cast<ViewerInstance*>((*it)->getLiveInstance());
+            if (n) {
+                n->getRenderEngine()->renderCurrentFrame(true);
+            }
+        }
+        for (NodeList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
             (*it)->computePreviewImage(time);
             NodeGroup* isGrp = dynamic_cast<NodeGroup*>((*it)->getLiveInstance());
             if (isGrp) {
                 isGrp->refreshViewersAndPreviews();
-            } else {
-                ViewerInstance* n = dynamic_cast<ViewerInstance*>((*it)->getLiveInstance());
-                if (n) {
-                    n->getRenderEngine()->renderCurrentFrame(true);
-                }
             }
         }
     }
@@ -363,6 +470,7 @@ NodeCollection::clearNodes(bool emitSignal)
         QMutexLocker l(&_imp->nodesMutex);
         _imp->nodes.clear();
     }
+    notifyTopologyChanged();
     
     nodesToDelete.clear();
 }
@@ -851,7 +959,8 @@ NodeCollection::setParallelRenderArgs(int time,
                                       U64 renderAge,
                                       ViewerInstance* viewer,
                                       int textureIndex,
-                                      const TimeLine* timeline)
+                                      const TimeLine* timeline,
+                                      Natron::Node* previewRequester)
 {
     NodeList nodes = getNodes();
     for (NodeList::iterator it = nodes.begin(); it!=nodes.end(); ++it) {
@@ -865,7 +974,7 @@ NodeCollection::setParallelRenderArgs(int time,
         }
         Natron::EffectInstance* liveInstance = (*it)->getLiveInstance();
         assert(liveInstance);
-        liveInstance->setParallelRenderArgsTLS(time, view, isRenderUserInteraction, isSequential, canAbort, (*it)->getHashValue(), rotoAge, renderAge,viewer,textureIndex, timeline);
+        liveInstance->setParallelRenderArgsTLS(time, view, isRenderUserInteraction, isSequential, canAbort, (*it)->getHashValue(), rotoAge, renderAge,viewer,textureIndex, timeline, previewRequester);
         
         if ((*it)->isMultiInstance()) {
             
@@ -877,7 +986,7 @@ NodeCollection::setParallelRenderArgs(int time,
                 assert(*it2);
                 Natron::EffectInstance* childLiveInstance = (*it2)->getLiveInstance();
                 assert(childLiveInstance);
-                childLiveInstance->setParallelRenderArgsTLS(time, view, isRenderUserInteraction, isSequential, canAbort, (*it2)->getHashValue(), rotoAge, renderAge,viewer, textureIndex, timeline);
+                childLiveInstance->setParallelRenderArgsTLS(time, view, isRenderUserInteraction, isSequential, canAbort, (*it2)->getHashValue(), rotoAge, renderAge,viewer, textureIndex, timeline, previewRequester);
                 
             }
         }
@@ -885,7 +994,7 @@ NodeCollection::setParallelRenderArgs(int time,
         
         NodeGroup* isGrp = dynamic_cast<NodeGroup*>((*it)->getLiveInstance());
         if (isGrp) {
-            isGrp->setParallelRenderArgs(time, view, isRenderUserInteraction, isSequential, canAbort,  renderAge, viewer, textureIndex, timeline);
+            isGrp->setParallelRenderArgs(time, view, isRenderUserInteraction, isSequential, canAbort,  renderAge, viewer, textureIndex, timeline, previewRequester);
         }
 
     }
@@ -964,11 +1073,12 @@ ParallelRenderArgsSetter::ParallelRenderArgsSetter(NodeCollection* n,
                                                    U64 renderAge,
                                                    ViewerInstance* viewer,
                                                    int textureIndex,
-                                                   const TimeLine* timeline)
+                                                   const TimeLine* timeline,
+                                                   Natron::Node* previewRequester)
 : collection(n)
 , argsMap()
 {
-    collection->setParallelRenderArgs(time,view,isRenderUserInteraction,isSequential,canAbort,renderAge,viewer,textureIndex,timeline);
+    collection->setParallelRenderArgs(time,view,isRenderUserInteraction,isSequential,canAbort,renderAge,viewer,textureIndex,timeline,previewRequester);
 }
 
 ParallelRenderArgsSetter::ParallelRenderArgsSetter(const std::map<boost::shared_ptr<Natron::Node>,ParallelRenderArgs >& args)
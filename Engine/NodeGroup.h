@@ -81,6 +81,23 @@ public:
      **/
     NodePtr getLastNode(const std::string& pluginID) const;
     
+    /**
+     * @brief Returns the nodes of the collection ordered so that each node comes after its inputs.
+     * The order is cached and only recomputed after nodes were added, removed, connected or disconnected.
+     **/
+    void getNodesInTopologicalOrder(NodeList* nodes) const;
+    
+    /**
+     * @brief Returns the position of the node in the order returned by getNodesInTopologicalOrder, or -1 if
+     * the node does not belong to this collection.
+     **/
+    int getTopologicalIndex(const Natron::Node* node) const;
+    
+    /**
+     * @brief Invalidates the topological order of the collection. MT-safe.
+     **/
+    void notifyTopologyChanged();
+    
     /**
      * @brief Removes all nodes within the collection. MT-safe.
      **/
@@ -224,7 +241,8 @@ public:
                                U64 renderAge,
                                ViewerInstance* viewer,
                                int textureIndex,
-                               const TimeLine* timeline);
+                               const TimeLine* timeline,
+                               Natron::Node* previewRequester = 0);
     void invalidateParallelRenderArgs();
     
     void getParallelRenderArgs(std::map<boost::shared_ptr<Natron::Node>,ParallelRenderArgs >& argsMap) const;
@@ -287,7 +305,8 @@ public:
                              U64 renderAge,
                              ViewerInstance* viewer,
                              int textureIndex,
-                             const TimeLine* timeline);
+                             const TimeLine* timeline,
+                             Natron::Node* previewRequester = 0);
     
     ParallelRenderArgsSetter(const std::map<boost::shared_ptr<Natron::Node>,ParallelRenderArgs >& args);
     
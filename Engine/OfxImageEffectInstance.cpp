@@ -746,7 +746,8 @@ OfxImageEffectInstance::progressEnd()
 bool
 OfxImageEffectInstance::progressUpdate(double t)
 {
-    return _ofxEffectInstance->getApp()->progressUpdate(_ofxEffectInstance, t);
+    ///The render action of this thread gives the frame, not the timeline which may be at another frame
+    return _ofxEffectInstance->getApp()->progressUpdate( _ofxEffectInstance, t, _ofxEffectInstance->getThreadLocalRenderTime() );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
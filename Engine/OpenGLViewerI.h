@@ -96,12 +96,15 @@ public:
      * 2) memcpy to copy the ramBuffer to previously mapped buffer.
      * 3) glUnmapBuffer to unmap the GPU buffer
      * 4) glTexSubImage2D or glTexImage2D depending whether yo need to resize the texture or not.
+     * bitDepth is the BitDepthEnum of the data in ramBuffer, which is 8-bit (with the gain and color-space applied) for the
+     * frames of the compact playback cache, even if getBitDepth() is not.
      **/
     virtual void transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
                                             const boost::shared_ptr<Natron::Image>& image,
                                             int time,
                                             const RectD& rod,
                                             size_t bytesCount,
+                                            int bitDepth,
                                             const TextureRect & region,
                                             double gain, double offset, int lut,
                                             int pboIndex,
@@ -35,15 +35,19 @@
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/FrameStreamer.h"
 #include "Engine/Image.h"
 #include "Engine/Node.h"
 #include "Engine/OpenGLViewerI.h"
+#include "Engine/ProcessMessage.h"
 #include "Engine/Project.h"
+#include "Engine/RenderCheckpoint.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
 #include "Engine/TimeLine.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/ViewerInstancePrivate.h"
+#include "Engine/WritersRenderGroup.h"
 
 #define NATRON_FPS_REFRESH_RATE_SECONDS 1.5
 
@@ -623,13 +627,36 @@ OutputSchedulerThread::pushAllFrameRange()
         lastFrame = _imp->livingRunArgs.lastFrame;
     }
     
+    ///When resuming a render, the frames completed by a previous render are skipped but count as rendered
+    boost::shared_ptr<RenderCheckpoint> checkpoint = _imp->outputEffect->getRenderCheckpoint();
+    U64 nFramesSkipped = 0;
     if (direction == eRenderDirectionForward) {
         for (int i = firstFrame; i <= lastFrame; ++i) {
-            _imp->framesToRender.push_back(i);
+            if ( checkpoint && checkpoint->isFrameCompleted(i) ) {
+                ++nFramesSkipped;
+            } else {
+                _imp->framesToRender.push_back(i);
+            }
         }
     } else {
         for (int i = lastFrame; i >= firstFrame; --i) {
-            _imp->framesToRender.push_back(i);
+            if ( checkpoint && checkpoint->isFrameCompleted(i) ) {
+                ++nFramesSkipped;
+            } else {
+                _imp->framesToRender.push_back(i);
+            }
+        }
+    }
+    if (nFramesSkipped > 0) {
+        QMutexLocker k(&_imp->runArgsMutex);
+        _imp->nFramesRendered += nFramesSkipped;
+        if ( _imp->framesToRender.empty() ) {
+            ///Nothing left to render: notify the scheduler rendering is finished as notifyFrameRendered() would
+            _imp->renderFinished = true;
+            k.unlock();
+            QMutexLocker bufLocker (&_imp->bufMutex);
+            ignore_result(_imp->appendBufferedFrame(0, 0, boost::shared_ptr<BufferableObject>()));
+            _imp->bufCondition.wakeOne();
         }
     }
     ///Wake up render threads to notify them theres work to do
@@ -1188,6 +1215,11 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
 {
     if (viewIndex == viewsCount -1) {
         _imp->engine->s_frameRendered(frame);
+        
+        boost::shared_ptr<RenderCheckpoint> checkpoint = _imp->outputEffect->getRenderCheckpoint();
+        if (checkpoint) {
+            checkpoint->markFrameCompleted(frame);
+        }
     }
     double percentage;
     if (policy == eSchedulingPolicyFFA) {
@@ -1227,7 +1259,21 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
         QString frameStr = QString::number(frame);
         
         QString pStr = QString::number(percentage * 100);
-        appPTR->writeToOutputPipe(kFrameRenderedStringLong + frameStr + " (" + pStr + "%)",kFrameRenderedStringShort + frameStr);
+        Natron::ProcessMessage rendered(Natron::eProcessMessageTypeFrameRendered);
+        rendered.time = frame;
+        rendered.view = viewIndex;
+        rendered.value = percentage;
+        appPTR->writeToOutputPipe(kFrameRenderedStringLong + frameStr + " (" + pStr + "%)",rendered);
+
+        U64 cacheLookups,cacheHits,diskCacheLookups,diskCacheHits;
+        appPTR->getImageCachesLookupStats(&cacheLookups, &cacheHits, &diskCacheLookups, &diskCacheHits);
+        Natron::ProcessMessage stats(Natron::eProcessMessageTypeCacheStats);
+        stats.cacheMemory = appPTR->getCachesTotalMemorySize();
+        stats.cacheLookups = cacheLookups;
+        stats.cacheHits = cacheHits;
+        stats.diskCacheLookups = diskCacheLookups;
+        stats.diskCacheHits = diskCacheHits;
+        appPTR->writeToOutputPipe(QString(),stats);
     }
     
     if (_imp->outputEffect->isWriter()) {
@@ -1827,6 +1873,32 @@ DefaultScheduler::~DefaultScheduler()
     
 }
 
+/**
+ * @brief Releases a frame in the group of writers rendering together, whichever way the frame render ends.
+ **/
+class RenderGroupFrameReleaser
+{
+    boost::shared_ptr<WritersRenderGroup> group;
+    Natron::OutputEffectInstance* writer;
+    int time;
+    
+public:
+    
+    RenderGroupFrameReleaser(const boost::shared_ptr<WritersRenderGroup>& group,Natron::OutputEffectInstance* writer,int time)
+    : group(group)
+    , writer(writer)
+    , time(time)
+    {
+    }
+    
+    ~RenderGroupFrameReleaser()
+    {
+        if (group) {
+            group->releaseFrame(writer, time);
+        }
+    }
+};
+
 class DefaultRenderFrameRunnable : public RenderThreadTask
 {
     
@@ -1849,6 +1921,10 @@ private:
     virtual void
     renderFrame(int time) {
         
+        ///When rendering along with other writers, the images shared with them are kept until this frame is done
+        boost::shared_ptr<WritersRenderGroup> renderGroup = _imp->output->getRenderGroup();
+        RenderGroupFrameReleaser releaseFrameInGroup(renderGroup, _imp->output, time);
+        
         std::string cb = _imp->output->getNode()->getBeforeFrameRenderCallback();
         if (!cb.empty()) {
             std::vector<std::string> args;
@@ -1905,8 +1981,9 @@ private:
             
             /// If the writer dosn't need to render the frames in any sequential order (such as image sequences for instance), then
             /// we just render the frames directly in this thread, no need to use the scheduler thread for maximum efficiency.
+            /// Streamed frames always go through the scheduler which orders them.
         
-            bool renderDirectly = sequentiallity == Natron::eSequentialPreferenceNotSequential;
+            bool renderDirectly = sequentiallity == Natron::eSequentialPreferenceNotSequential && !_imp->output->getFrameStreamer();
             
             
             // Do not catch exceptions: if an exception occurs here it is probably fatal, since
@@ -1945,6 +2022,10 @@ private:
                     RectI renderWindow;
                     rod.toPixelEnclosing(scale, par, &renderWindow);
                     
+                    if (renderGroup) {
+                        renderGroup->acquireFrame(_imp->output, time, i);
+                    }
+                    
                     ParallelRenderArgsSetter frameRenderArgs(activeInputToRender->getApp()->getProject().get(),
                                                              time,
                                                              i,
@@ -1958,6 +2039,7 @@ private:
                     
                     RenderingFlagSetter flagIsRendering(activeInputToRender->getNode().get());
 
+                    TimeLapse renderTime;
                     ImageList planes;
                     EffectInstance::RenderRoIRetCode retCode = activeInputToRender->renderRoI( EffectInstance::RenderRoIArgs(time, //< the time at which to render
                                                                                   scale, //< the scale at which to render
@@ -1972,6 +2054,14 @@ private:
                          _imp->scheduler->notifyRenderFailure(std::string("Error caught while rendering"));
                         return;
                     }
+
+                    if ( appPTR->isBackground() ) {
+                        Natron::ProcessMessage timing(Natron::eProcessMessageTypeFrameTiming);
+                        timing.time = time;
+                        timing.view = i;
+                        timing.value = renderTime.getTimeSinceCreation();
+                        appPTR->writeToOutputPipe(QString(),timing);
+                    }
                     
                     ///If we need sequential rendering, pass the image to the output scheduler that will ensure the sequential ordering
                     if (!renderDirectly) {
@@ -2034,10 +2124,27 @@ DefaultScheduler::processFrame(const BufferedFrames& frames)
     Natron::SequentialPreferenceEnum sequentiallity = _effect->getSequentialPreference();
     bool canOnlyHandleOneView = sequentiallity == Natron::eSequentialPreferenceOnlySequential || sequentiallity == Natron::eSequentialPreferencePreferSequential;
     
+    boost::shared_ptr<FrameStreamer> streamer = _effect->getFrameStreamer();
+    
     for (BufferedFrames::const_iterator it = frames.begin(); it != frames.end(); ++it) {
         ignore_result(_effect->getRegionOfDefinition_public(hash,it->time, scale, it->view, &rod, &isProjectFormat));
         rod.toPixelEnclosing(0, par, &roi);
         
+        if (streamer) {
+            ///The frames come in the order of the sequence, stream the input image instead of rendering the writer
+            ImagePtr inputImage = boost::dynamic_pointer_cast<Natron::Image>(it->frame);
+            assert(inputImage);
+            RectI frameRect;
+            if ( !roi.intersect(inputImage->getBounds(), &frameRect) ) {
+                frameRect.clear();
+            }
+            if ( !streamer->writeFrame(it->time, it->view, *inputImage, frameRect) ) {
+                notifyRenderFailure("Failed to write to the frame stream, its reader may have closed it");
+                return;
+            }
+            continue;
+        }
+        
         ParallelRenderArgsSetter frameRenderArgs(_effect->getApp()->getProject().get(),
                                                  it->time,
                                                  it->view,
@@ -2114,14 +2221,17 @@ DefaultScheduler::getFrameRangeToRender(int& first,int& last) const
 void
 DefaultScheduler::handleRenderFailure(const std::string& errorMessage)
 {
-    std::cout << errorMessage << std::endl;
+    Natron::ProcessMessage error(Natron::eProcessMessageTypeError);
+    error.context = _effect->getScriptName_mt_safe().c_str();
+    error.text = errorMessage.c_str();
+    appPTR->writeToOutputPipe(errorMessage.c_str(),error);
 }
 
 Natron::SchedulingPolicyEnum
 DefaultScheduler::getSchedulingPolicy() const
 {
     Natron::SequentialPreferenceEnum sequentiallity = _effect->getSequentialPreference();
-    if (sequentiallity == Natron::eSequentialPreferenceNotSequential) {
+    if (sequentiallity == Natron::eSequentialPreferenceNotSequential && !_effect->getFrameStreamer()) {
         return Natron::eSchedulingPolicyFFA;
     } else {
         return Natron::eSchedulingPolicyOrdered;
@@ -2149,7 +2259,7 @@ DefaultScheduler::aboutToStartRender()
     if (!isBackGround) {
         _effect->setKnobsFrozen(true);
     } else {
-        appPTR->writeToOutputPipe(kRenderingStartedLong, kRenderingStartedShort);
+        appPTR->writeToOutputPipe( kRenderingStartedLong, Natron::ProcessMessage(Natron::eProcessMessageTypeRenderingStarted) );
     }
     
     std::string cb = _effect->getNode()->getBeforeRenderCallback();
@@ -24,11 +24,16 @@
 #include <QDir>
 #include <QDebug>
 
+#include <cmath>
+
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
 #include "Engine/Node.h"
 #include "Engine/EffectInstance.h"
 
+///Non urgent messages are sent to the main process when there are that many of them or every 100ms
+#define NATRON_PROCESS_MESSAGES_BATCH_SIZE 64
+
 ProcessHandler::ProcessHandler(AppInstance* app,
                                const QString & projectPath,
                                Natron::OutputEffectInstance* writer)
@@ -37,6 +42,8 @@ ProcessHandler::ProcessHandler(AppInstance* app,
       ,_writer(writer)
       ,_ipcServer(0)
       ,_bgProcessOutputSocket(0)
+      ,_readerThread(0)
+      ,_reader(0)
       ,_bgProcessInputSocket(0)
       ,_earlyCancel(false)
       ,_processLog()
@@ -78,6 +85,13 @@ ProcessHandler::~ProcessHandler()
 {
     Q_EMIT deleted();
 
+    if (_readerThread) {
+        _readerThread->quit();
+        _readerThread->wait();
+        delete _reader;
+        delete _bgProcessOutputSocket;
+        delete _readerThread;
+    }
     _ipcServer->close();
     _bgProcessInputSocket->close();
     _process->close();
@@ -108,47 +122,94 @@ ProcessHandler::onNewConnectionPending()
 
     _bgProcessOutputSocket = _ipcServer->nextPendingConnection();
 
-    QObject::connect( _bgProcessOutputSocket, SIGNAL( readyRead() ), this, SLOT( onDataWrittenToSocket() ) );
+    ///The socket is read by the reader thread, it cannot stay a child of the server which lives in the main thread
+    _bgProcessOutputSocket->setParent(0);
+    _reader = new ProcessOutputReader(_bgProcessOutputSocket);
+    _readerThread = new QThread();
+    _bgProcessOutputSocket->moveToThread(_readerThread);
+    _reader->moveToThread(_readerThread);
+    QObject::connect( _reader, SIGNAL( messagesReceived(Natron::ProcessMessageList) ), this, SLOT( onMessagesReceived(Natron::ProcessMessageList) ) );
+    QObject::connect( _reader, SIGNAL( invalidMessageReceived() ), this, SLOT( onInvalidMessageReceived() ) );
+    _readerThread->start();
+
+    ///read what may have been received before the socket was moved to the reader thread
+    QMetaObject::invokeMethod(_reader, "onReadyRead", Qt::QueuedConnection);
 }
 
 void
-ProcessHandler::onDataWrittenToSocket()
+ProcessHandler::onMessagesReceived(const Natron::ProcessMessageList& messages)
 {
     ///always running in the main thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    QString str = _bgProcessOutputSocket->readLine();
-    while ( str.endsWith('\n') ) {
-        str.chop(1);
-    }
-    _processLog.append("Message received: " + str + '\n');
-    if ( str.startsWith(kFrameRenderedStringShort) ) {
-        str = str.remove(kFrameRenderedStringShort);
-        Q_EMIT frameRendered( str.toInt() );
-    } else if ( str.startsWith(kRenderingFinishedStringShort) ) {
-        ///don't do anything
-    } else if ( str.startsWith(kProgressChangedStringShort) ) {
-        str = str.remove(kProgressChangedStringShort);
-        Q_EMIT frameProgress( str.toInt() );
-    } else if ( str.startsWith(kBgProcessServerCreatedShort) ) {
-        str = str.remove(kBgProcessServerCreatedShort);
-        ///the bg process wants us to create the pipe for its input
-        if (!_bgProcessInputSocket) {
-            _bgProcessInputSocket = new QLocalSocket();
-            QObject::connect( _bgProcessInputSocket, SIGNAL( connected() ), this, SLOT( onInputPipeConnectionMade() ) );
-            _bgProcessInputSocket->connectToServer(str,QLocalSocket::ReadWrite);
-        }
-    } else if ( str.startsWith(kRenderingStartedShort) ) {
-        ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
-        ///message right away
-        if (_earlyCancel) {
-            _bgProcessInputSocket->waitForConnected(5000);
-            _earlyCancel = false;
-            onProcessCanceled();
+    for (Natron::ProcessMessageList::const_iterator it = messages.begin(); it != messages.end(); ++it) {
+        _processLog.append("Message received: " + it->toString() + '\n');
+        switch (it->type) {
+        case Natron::eProcessMessageTypeFrameRendered:
+            Q_EMIT frameRendered(it->time);
+            break;
+        case Natron::eProcessMessageTypeFrameProgress:
+            Q_EMIT frameProgress( (int)std::floor(it->value * 100) );
+            break;
+        case Natron::eProcessMessageTypeBgServerCreated:
+            ///the bg process wants us to create the pipe for its input
+            if (!_bgProcessInputSocket) {
+                _bgProcessInputSocket = new QLocalSocket();
+                QObject::connect( _bgProcessInputSocket, SIGNAL( connected() ), this, SLOT( onInputPipeConnectionMade() ) );
+                _bgProcessInputSocket->connectToServer(it->text,QLocalSocket::ReadWrite);
+            }
+            break;
+        case Natron::eProcessMessageTypeRenderingStarted:
+            ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
+            ///message right away
+            if (_earlyCancel) {
+                _bgProcessInputSocket->waitForConnected(5000);
+                _earlyCancel = false;
+                onProcessCanceled();
+            }
+            break;
+        default:
+            ///timings, cache stats, errors: they are only logged
+            break;
         }
-    } else {
-        _processLog.append("Error: Unable to interpret message.\n");
-        throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
+    }
+}
+
+void
+ProcessHandler::onInvalidMessageReceived()
+{
+    _processLog.append("Error: Unable to interpret the messages of the background process, they will be ignored.\n");
+}
+
+ProcessOutputReader::ProcessOutputReader(QLocalSocket* socket)
+    : QObject()
+      , _socket(socket)
+      , _buffer()
+{
+    QObject::connect( _socket, SIGNAL( readyRead() ), this, SLOT( onReadyRead() ) );
+}
+
+ProcessOutputReader::~ProcessOutputReader()
+{
+}
+
+void
+ProcessOutputReader::onReadyRead()
+{
+    ///always running in the reader thread
+    assert( QThread::currentThread() == thread() );
+
+    _buffer.append( _socket->readAll() );
+
+    Natron::ProcessMessageList messages;
+    if ( !Natron::decodeProcessMessages(&_buffer, &messages) ) {
+        ///We cannot find the start of the next message anymore
+        QObject::disconnect( _socket, SIGNAL( readyRead() ), this, SLOT( onReadyRead() ) );
+        Q_EMIT invalidMessageReceived();
+    }
+    if ( !messages.empty() ) {
+        Natron::coalesceProcessMessages(&messages);
+        Q_EMIT messagesReceived(messages);
     }
 }
 
@@ -185,7 +246,9 @@ ProcessHandler::onProcessCanceled()
     if (!_bgProcessInputSocket) {
         _earlyCancel = true;
     } else {
-        _bgProcessInputSocket->write( (QString(kAbortRenderingStringShort) + '\n').toUtf8() );
+        QByteArray data;
+        Natron::encodeProcessMessage(Natron::ProcessMessage(Natron::eProcessMessageTypeAbortRendering), &data);
+        _bgProcessInputSocket->write(data);
         _bgProcessInputSocket->flush();
     }
 }
@@ -218,6 +281,8 @@ ProcessInputChannel::ProcessInputChannel(const QString & mainProcessServerName)
     : QThread()
       , _mainProcessServerName(mainProcessServerName)
       , _backgroundOutputPipeMutex(new QMutex)
+      , _pendingMessages()
+      , _inputBuffer()
       , _backgroundOutputPipe(0)
       , _backgroundIPCServer(0)
       , _backgroundInputPipe(0)
@@ -239,6 +304,10 @@ ProcessInputChannel::~ProcessInputChannel()
         }
     }
 
+    {
+        QMutexLocker l(_backgroundOutputPipeMutex);
+        flushPendingMessages_locked();
+    }
     delete _backgroundIPCServer;
     delete _backgroundOutputPipeMutex;
     delete _backgroundOutputPipe;
@@ -247,13 +316,31 @@ ProcessInputChannel::~ProcessInputChannel()
 }
 
 void
-ProcessInputChannel::writeToOutputChannel(const QString & message)
+ProcessInputChannel::writeToOutputChannel(const Natron::ProcessMessage & message)
 {
-    {
-        QMutexLocker l(_backgroundOutputPipeMutex);
-        _backgroundOutputPipe->write( (message + '\n').toUtf8() );
-        _backgroundOutputPipe->flush();
+    QMutexLocker l(_backgroundOutputPipeMutex);
+
+    _pendingMessages.push_back(message);
+    if ( message.isUrgent() || (_pendingMessages.size() >= NATRON_PROCESS_MESSAGES_BATCH_SIZE) ) {
+        flushPendingMessages_locked();
+    }
+}
+
+void
+ProcessInputChannel::flushPendingMessages_locked()
+{
+    if ( _pendingMessages.empty() ) {
+        return;
+    }
+    Natron::coalesceProcessMessages(&_pendingMessages);
+
+    QByteArray data;
+    for (Natron::ProcessMessageList::const_iterator it = _pendingMessages.begin(); it != _pendingMessages.end(); ++it) {
+        Natron::encodeProcessMessage(*it, &data);
     }
+    _pendingMessages.clear();
+    _backgroundOutputPipe->write(data);
+    _backgroundOutputPipe->flush();
 }
 
 void
@@ -270,19 +357,21 @@ ProcessInputChannel::onNewConnectionPending()
 bool
 ProcessInputChannel::onInputChannelMessageReceived()
 {
-    QString str( _backgroundInputPipe->readLine() );
+    _inputBuffer.append( _backgroundInputPipe->readAll() );
 
-    while ( str.endsWith('\n') ) {
-        str.chop(1);
-    }
-    if ( str.startsWith(kAbortRenderingStringShort) ) {
-        qDebug() << "Aborting render!";
-        appPTR->abortAnyProcessing();
+    Natron::ProcessMessageList messages;
+    if ( !Natron::decodeProcessMessages(&_inputBuffer, &messages) ) {
+        std::cerr << "Error: Unable to interpret the messages of the main process." << std::endl;
 
         return true;
-    } else {
-        std::cerr << "Error: Unable to interpret message: " << str.toStdString() << std::endl;
-        throw std::runtime_error("ProcessInputChannel::onInputChannelMessageReceived() received erroneous message");
+    }
+    for (Natron::ProcessMessageList::const_iterator it = messages.begin(); it != messages.end(); ++it) {
+        if (it->type == Natron::eProcessMessageTypeAbortRendering) {
+            qDebug() << "Aborting render!";
+            appPTR->abortAnyProcessing();
+
+            return true;
+        }
     }
 
     return false;
@@ -291,15 +380,23 @@ ProcessInputChannel::onInputChannelMessageReceived()
 void
 ProcessInputChannel::run()
 {
+    bool inputChannelClosed = false;
     for (;; ) {
-        if ( _backgroundInputPipe->waitForReadyRead(100) ) {
+        if (inputChannelClosed) {
+            msleep(100);
+        } else if ( _backgroundInputPipe->waitForReadyRead(100) ) {
             if ( onInputChannelMessageReceived() ) {
                 qDebug() << "Background process now closing the input channel...";
-
-                return;
+                ///keep running to send the pending messages
+                inputChannelClosed = true;
             }
         }
 
+        {
+            QMutexLocker l(_backgroundOutputPipeMutex);
+            flushPendingMessages_locked();
+        }
+
         QMutexLocker l(_mustQuitMutex);
         if (_mustQuit) {
             _mustQuit = false;
@@ -333,7 +430,9 @@ ProcessInputChannel::initialize()
         std::cout << "WARNING: The GUI application failed to respond, canceling this process will not be possible"
             " unless it finishes or you kill it." << std::endl;
     }
-    writeToOutputChannel( QString(kBgProcessServerCreatedShort) + _backgroundIPCServer->fullServerName() );
+    Natron::ProcessMessage serverCreated(Natron::eProcessMessageTypeBgServerCreated);
+    serverCreated.text = _backgroundIPCServer->fullServerName();
+    writeToOutputChannel(serverCreated);
 
     ///we wait for the GUI app to connect its socket to this server, we let it 5 sec to reply
     _backgroundIPCServer->waitForNewConnection(5000);
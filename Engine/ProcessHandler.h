@@ -23,6 +23,7 @@ CLANG_DIAG_OFF(deprecated)
 #include <QString>
 CLANG_DIAG_ON(deprecated)
 #include "Global/GlobalDefines.h"
+#include "Engine/ProcessMessage.h"
 
 //natron
 class AppInstance;
@@ -61,18 +62,20 @@ class QWaitCondition;
  * listen to messages coming from the main process.
  *
  * 3) The background process waits for the main process to answer the connection request of the output channel.
- * Once it has replied, it will send a message (kBgProcessServerCreatedShort) meaning the main process should
+ * Once it has replied, it will send a message (eProcessMessageTypeBgServerCreated) meaning the main process should
  * open the input channel where it will write to (and the background process will listen to).
  *
- * 4) The main process creates the input channel in ProcessHandler::onDataWrittenToSocket
+ * 4) The main process creates the input channel in ProcessHandler::onMessagesReceived
  *
  * 5) The background process catches the pending connection and accepts it.
  *
  * The IPC is setup, now both processes are listening to each-other on both sides.
  *
- * NB: Message that are exchanged via this channel consists of exactly 1 line, i.e a
- * string terminated with the \n character.
+ * NB: Messages exchanged via these channels are binary ProcessMessage's prefixed with their size, @see ProcessMessage.h.
+ * The background process sends them by batches and the main process decodes them in a ProcessOutputReader thread, so that
+ * many background renders can report their progress without stalling the GUI.
  **/
+class ProcessOutputReader;
 class ProcessHandler
     : public QObject
 {
@@ -82,11 +85,13 @@ class ProcessHandler
     QProcess* _process; //< the process executing the render
     Natron::OutputEffectInstance* _writer; //< pointer to the writer that will render in the bg process
     QLocalServer* _ipcServer; //< the server for IPC with the background process
-    QLocalSocket* _bgProcessOutputSocket; //< the socket where data is output by the process
+    QLocalSocket* _bgProcessOutputSocket; //< the socket where data is output by the process, living in _readerThread
+    QThread* _readerThread; //< the thread decoding the messages of the output socket
+    ProcessOutputReader* _reader; //< lives in _readerThread
 
     //the socket where data is read by the process
     //note that this socket is initialized only when the background process sends the message
-    //kBgProcessServerCreatedShort, meaning it created its server for the input pipe and we can actually open it.
+    //eProcessMessageTypeBgServerCreated, meaning it created its server for the input pipe and we can actually open it.
     QLocalSocket* _bgProcessInputSocket;
     bool _earlyCancel; //< true if the user pressed cancel but the _bgProcessInput socket was not created yet
     QString _processLog; //< used to record the log of the process
@@ -115,9 +120,14 @@ public Q_SLOTS:
     void onNewConnectionPending();
 
     /**
-     * @brief Slot called whenever the background process writes something to the output socket (pipe).
+     * @brief Slot called with the messages the ProcessOutputReader decoded from the output socket (pipe).
      **/
-    void onDataWrittenToSocket();
+    void onMessagesReceived(const Natron::ProcessMessageList& messages);
+
+    /**
+     * @brief Called when the output socket contains data that are not valid messages.
+     **/
+    void onInvalidMessageReceived();
 
     /**
      * @brief Called whenever the background process writes something to its standard output, its just for the sake
@@ -176,6 +186,35 @@ Q_SIGNALS:
     void processFinished(int);
 };
 
+/**
+ * @brief Reads the output socket of a background process in its own thread and forwards the decoded messages
+ * to the ProcessHandler, a batch at a time.
+ **/
+class ProcessOutputReader
+    : public QObject
+{
+    Q_OBJECT
+
+    QLocalSocket* _socket;
+    QByteArray _buffer; //< data received but not decoded yet
+
+public:
+
+    ProcessOutputReader(QLocalSocket* socket);
+
+    virtual ~ProcessOutputReader();
+
+public Q_SLOTS:
+
+    void onReadyRead();
+
+Q_SIGNALS:
+
+    void messagesReceived(Natron::ProcessMessageList);
+
+    void invalidMessageReceived();
+};
+
 /**
  * @brief This class represents the "input" pipe of the background process, this is where the background
  * app expect messages from the "main" process to come. It listen to messages from the main app to take decisions.
@@ -202,8 +241,9 @@ public:
 
     /**
      * @brief Call it if you want to write something to the background process output channel.
+     * Messages that are not urgent are kept and sent with the next batch, @see ProcessMessage::isUrgent()
      **/
-    void writeToOutputChannel(const QString & message);
+    void writeToOutputChannel(const Natron::ProcessMessage & message);
 
 public Q_SLOTS:
 
@@ -238,8 +278,15 @@ private:
      **/
     void initialize();
 
+    /**
+     * @brief Sends the pending messages. _backgroundOutputPipeMutex must be locked.
+     **/
+    void flushPendingMessages_locked();
+
     QString _mainProcessServerName;
     QMutex* _backgroundOutputPipeMutex;
+    Natron::ProcessMessageList _pendingMessages; //< protected by _backgroundOutputPipeMutex
+    QByteArray _inputBuffer; //< data of the input channel not decoded yet
     QLocalSocket* _backgroundOutputPipe; //< if the process is background but managed by a gui process then this
                                          //pipe is used to output messages
     QLocalServer* _backgroundIPCServer; //< for a background app used to manage input IPC  with the gui app
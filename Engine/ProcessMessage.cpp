@@ -0,0 +1,213 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "ProcessMessage.h"
+
+#include <QtCore/QDataStream>
+
+using namespace Natron;
+
+namespace {
+
+void
+writeFields(const ProcessMessage& message,
+            QDataStream& stream)
+{
+    switch (message.type) {
+    case eProcessMessageTypeBgServerCreated:
+        stream << message.text;
+        break;
+    case eProcessMessageTypeFrameRendered:
+    case eProcessMessageTypeFrameTiming:
+        stream << message.time << message.view << message.value;
+        break;
+    case eProcessMessageTypeFrameProgress:
+        stream << message.time << message.value;
+        break;
+    case eProcessMessageTypeCacheStats:
+        stream << message.cacheMemory << message.cacheLookups << message.cacheHits << message.diskCacheLookups << message.diskCacheHits;
+        break;
+    case eProcessMessageTypeError:
+        stream << message.context << message.text;
+        break;
+    case eProcessMessageTypeNone:
+    case eProcessMessageTypeRenderingStarted:
+    case eProcessMessageTypeRenderingFinished:
+    case eProcessMessageTypeAbortRendering:
+        break;
+    }
+}
+
+///Returns false if the type is unknown
+bool
+readFields(QDataStream& stream,
+           ProcessMessage* message)
+{
+    switch (message->type) {
+    case eProcessMessageTypeBgServerCreated:
+        stream >> message->text;
+        break;
+    case eProcessMessageTypeFrameRendered:
+    case eProcessMessageTypeFrameTiming:
+        stream >> message->time >> message->view >> message->value;
+        break;
+    case eProcessMessageTypeFrameProgress:
+        stream >> message->time >> message->value;
+        break;
+    case eProcessMessageTypeCacheStats:
+        stream >> message->cacheMemory >> message->cacheLookups >> message->cacheHits >> message->diskCacheLookups >> message->diskCacheHits;
+        break;
+    case eProcessMessageTypeError:
+        stream >> message->context >> message->text;
+        break;
+    case eProcessMessageTypeRenderingStarted:
+    case eProcessMessageTypeRenderingFinished:
+    case eProcessMessageTypeAbortRendering:
+        break;
+    case eProcessMessageTypeNone:
+    default:
+        return false;
+    }
+    return true;
+}
+} // anon namespace
+
+bool
+ProcessMessage::isUrgent() const
+{
+    switch (type) {
+    case eProcessMessageTypeFrameRendered:
+    case eProcessMessageTypeFrameProgress:
+    case eProcessMessageTypeFrameTiming:
+    case eProcessMessageTypeCacheStats:
+        return false;
+    default:
+        return true;
+    }
+}
+
+bool
+ProcessMessage::supersedes(const ProcessMessage& older) const
+{
+    switch (older.type) {
+    case eProcessMessageTypeFrameProgress:
+        ///Once the frame is rendered its progress is irrelevant
+        return (type == eProcessMessageTypeFrameProgress || type == eProcessMessageTypeFrameRendered) && time == older.time;
+    case eProcessMessageTypeCacheStats:
+        return type == eProcessMessageTypeCacheStats;
+    default:
+        return false;
+    }
+}
+
+void
+Natron::coalesceProcessMessages(ProcessMessageList* messages)
+{
+    for (ProcessMessageList::iterator it = messages->begin(); it != messages->end();) {
+        bool superseded = false;
+        ProcessMessageList::iterator next = it;
+        ++next;
+        for (ProcessMessageList::iterator it2 = next; it2 != messages->end(); ++it2) {
+            if ( it2->supersedes(*it) ) {
+                superseded = true;
+                break;
+            }
+        }
+        if (superseded) {
+            it = messages->erase(it);
+        } else {
+            it = next;
+        }
+    }
+}
+
+QString
+ProcessMessage::toString() const
+{
+    switch (type) {
+    case eProcessMessageTypeBgServerCreated:
+        return "Input channel server created: " + text;
+    case eProcessMessageTypeRenderingStarted:
+        return "Rendering started";
+    case eProcessMessageTypeFrameRendered:
+        return QString("Frame rendered: %1 view %2 (%3%)").arg(time).arg(view).arg(value * 100.);
+    case eProcessMessageTypeFrameProgress:
+        return QString("Frame %1 progress: %2%").arg(time).arg(value * 100.);
+    case eProcessMessageTypeFrameTiming:
+        return QString("Frame %1 view %2 rendered in %3 s").arg(time).arg(view).arg(value);
+    case eProcessMessageTypeCacheStats:
+        return QString("Cache: %1 bytes, %2/%3 hits in RAM, %4/%5 hits on disk").arg(cacheMemory)
+               .arg(cacheHits).arg(cacheLookups).arg(diskCacheHits).arg(diskCacheLookups);
+    case eProcessMessageTypeError:
+        return QString("Error in %1: %2").arg(context).arg(text);
+    case eProcessMessageTypeRenderingFinished:
+        return "Rendering finished";
+    case eProcessMessageTypeAbortRendering:
+        return "Abort rendering";
+    case eProcessMessageTypeNone:
+        break;
+    }
+    return QString();
+}
+
+void
+Natron::encodeProcessMessage(const ProcessMessage& message,
+                             QByteArray* buffer)
+{
+    QByteArray payload;
+    {
+        QDataStream stream(&payload,QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_4_8);
+        stream << (quint16)message.type;
+        writeFields(message, stream);
+    }
+    QDataStream stream(buffer,QIODevice::WriteOnly | QIODevice::Append);
+    stream.setVersion(QDataStream::Qt_4_8);
+    stream << (quint32)payload.size();
+    buffer->append(payload);
+}
+
+bool
+Natron::decodeProcessMessages(QByteArray* buffer,
+                              ProcessMessageList* messages)
+{
+    int pos = 0;
+    while (buffer->size() - pos >= (int)sizeof(quint32)) {
+        quint32 size;
+        {
+            QDataStream stream(buffer->mid(pos, sizeof(quint32)));
+            stream >> size;
+        }
+        if (size < sizeof(quint16) || size > NATRON_PROCESS_MESSAGE_MAX_SIZE) {
+            buffer->clear();
+            return false;
+        }
+        if ( buffer->size() - pos - (int)sizeof(quint32) < (int)size ) {
+            ///Wait for the rest of the message
+            break;
+        }
+
+        QDataStream stream(buffer->mid(pos + sizeof(quint32), size));
+        stream.setVersion(QDataStream::Qt_4_8);
+        quint16 type;
+        stream >> type;
+        ProcessMessage message( (ProcessMessageTypeEnum)type );
+        if ( readFields(stream, &message) ) {
+            if (stream.status() != QDataStream::Ok) {
+                buffer->clear();
+                return false;
+            }
+            messages->push_back(message);
+        }
+        pos += sizeof(quint32) + size;
+    }
+    buffer->remove(0, pos);
+    return true;
+}
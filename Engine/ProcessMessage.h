@@ -0,0 +1,138 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_PROCESSMESSAGE_H_
+#define NATRON_ENGINE_PROCESSMESSAGE_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QByteArray>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+
+/**
+ * The messages exchanged between the main (GUI) process and the background render processes it launched,
+ * see ProcessHandler and ProcessInputChannel.
+ *
+ * On the pipe, each message is a quint32 giving the size of the rest of the message, followed by the quint16 type
+ * of the message and its fields serialized with QDataStream (big endian). Messages of an unknown type are skipped,
+ * so that a newer background process can talk to an older main process.
+ **/
+
+///Messages larger than this are considered as a corrupted stream
+#define NATRON_PROCESS_MESSAGE_MAX_SIZE (1 << 20)
+
+namespace Natron {
+
+enum ProcessMessageTypeEnum
+{
+    eProcessMessageTypeNone = 0,
+
+    ///Background process to main process
+
+    ///text: the name of the server of the input channel of the background process
+    eProcessMessageTypeBgServerCreated,
+
+    eProcessMessageTypeRenderingStarted,
+
+    ///time, view, value: the fraction of the sequence rendered
+    eProcessMessageTypeFrameRendered,
+
+    ///time, value: the fraction of the frame rendered, as reported by the plug-in
+    eProcessMessageTypeFrameProgress,
+
+    ///time, view, value: the seconds spent rendering the frame
+    eProcessMessageTypeFrameTiming,
+
+    ///cacheMemory, cacheLookups, cacheHits, diskCacheLookups, diskCacheHits
+    eProcessMessageTypeCacheStats,
+
+    ///context: the node or writer that failed, text: the error
+    eProcessMessageTypeError,
+
+    eProcessMessageTypeRenderingFinished,
+
+    ///Main process to background process
+
+    eProcessMessageTypeAbortRendering
+};
+
+struct ProcessMessage
+{
+    ProcessMessageTypeEnum type;
+    qint32 time;
+    qint32 view;
+    double value;
+    quint64 cacheMemory;
+    quint64 cacheLookups,cacheHits;
+    quint64 diskCacheLookups,diskCacheHits;
+    QString text;
+    QString context;
+
+    ProcessMessage(ProcessMessageTypeEnum type = eProcessMessageTypeNone)
+    : type(type)
+    , time(0)
+    , view(0)
+    , value(0.)
+    , cacheMemory(0)
+    , cacheLookups(0)
+    , cacheHits(0)
+    , diskCacheLookups(0)
+    , diskCacheHits(0)
+    , text()
+    , context()
+    {
+    }
+
+    /**
+     * @brief Returns true if the main process should get the message as soon as possible rather than with the next
+     * batch of messages.
+     **/
+    bool isUrgent() const;
+
+    /**
+     * @brief Returns true if this message makes the older message obsolete, so that only this one needs to be sent:
+     * e.g the progress of a frame supersedes the previous progress of the same frame.
+     **/
+    bool supersedes(const ProcessMessage& older) const;
+
+    /**
+     * @brief Returns a one line description of the message, for the logs.
+     **/
+    QString toString() const;
+};
+
+typedef std::list<ProcessMessage> ProcessMessageList;
+
+/**
+ * @brief Removes from the list the messages superseded by a message that comes after them.
+ **/
+void coalesceProcessMessages(ProcessMessageList* messages);
+
+/**
+ * @brief Appends the message to the buffer, prefixed with its size.
+ **/
+void encodeProcessMessage(const ProcessMessage& message,QByteArray* buffer);
+
+/**
+ * @brief Decodes the messages entirely contained in the buffer and removes them from it: an incomplete message
+ * at the end stays in the buffer until the rest of it is received.
+ * Returns false if the buffer does not contain valid messages: it should be discarded.
+ **/
+bool decodeProcessMessages(QByteArray* buffer,ProcessMessageList* messages);
+
+} // namespace Natron
+
+Q_DECLARE_METATYPE(Natron::ProcessMessageList)
+
+#endif // NATRON_ENGINE_PROCESSMESSAGE_H_
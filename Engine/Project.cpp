@@ -15,10 +15,13 @@
 #include "Project.h"
 
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <map>
 #include <ios>
 #include <cstdlib> // strtoul
 #include <cerrno> // errno
+#include <cstring> // memcmp
 
 #ifdef __NATRON_WIN32__
 #include <stdio.h> //for _snprintf
@@ -38,6 +41,15 @@
 #include <QHostInfo>
 #include <QFileInfo>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+CLANG_DIAG_OFF(unused-parameter)
+// /opt/local/include/boost/serialization/smart_cast.hpp:254:25: warning: unused parameter 'u' [-Wunused-parameter]
+#include <boost/archive/binary_iarchive.hpp>
+CLANG_DIAG_ON(unused-parameter)
+#include <boost/archive/binary_oarchive.hpp>
+#endif
+
 
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
@@ -92,6 +104,102 @@ static std::string generateUserFriendlyNatronVersionName()
     return ret;
 }
 
+/*
+ * The binary project format is a small container made of a header (magic, version, sections count),
+ * an index of named sections (name, offset, size) and the sections payloads.
+ * The "Project" section holds the ProjectSerialization written with a boost binary archive, which is
+ * much faster to parse than the XML archive but is tied to the architecture that wrote it.
+ * The optional "ProjectGui" section holds the GUI layout, still written as XML since it is tiny.
+ * Sections that are not known by the reader are ignored so that new ones can be added later.
+ */
+#define NATRON_BINARY_PROJECT_MAGIC "NtrnBPrj"
+#define NATRON_BINARY_PROJECT_MAGIC_SIZE 8
+#define NATRON_BINARY_PROJECT_VERSION 1
+#define NATRON_BINARY_PROJECT_SECTION_NAME_SIZE 16
+#define NATRON_BINARY_PROJECT_SECTION_PROJECT "Project"
+#define NATRON_BINARY_PROJECT_SECTION_GUI "ProjectGui"
+
+typedef std::map<std::string,std::string> BinaryProjectSections;
+
+static bool
+isBinaryProjectFile(const QString & filePath)
+{
+    std::ifstream ifile(filePath.toStdString().c_str(), std::ifstream::in | std::ifstream::binary);
+    char magic[NATRON_BINARY_PROJECT_MAGIC_SIZE];
+
+    if ( !ifile.read(magic, NATRON_BINARY_PROJECT_MAGIC_SIZE) ) {
+        return false;
+    }
+    return std::memcmp(magic, NATRON_BINARY_PROJECT_MAGIC, NATRON_BINARY_PROJECT_MAGIC_SIZE) == 0;
+}
+
+static void
+writeBinaryProjectSections(std::ostream & os,
+                           const BinaryProjectSections & sections)
+{
+    const U32 version = NATRON_BINARY_PROJECT_VERSION;
+    const U32 sectionsCount = (U32)sections.size();
+
+    os.write(NATRON_BINARY_PROJECT_MAGIC, NATRON_BINARY_PROJECT_MAGIC_SIZE);
+    os.write(reinterpret_cast<const char*>(&version), sizeof(U32));
+    os.write(reinterpret_cast<const char*>(&sectionsCount), sizeof(U32));
+
+    ///The sections are laid out right after the index, in the index order
+    U64 offset = NATRON_BINARY_PROJECT_MAGIC_SIZE + 2 * sizeof(U32) +
+                 sectionsCount * (NATRON_BINARY_PROJECT_SECTION_NAME_SIZE + 2 * sizeof(U64));
+    for (BinaryProjectSections::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+        assert(it->first.size() < NATRON_BINARY_PROJECT_SECTION_NAME_SIZE);
+        char name[NATRON_BINARY_PROJECT_SECTION_NAME_SIZE];
+        std::memset(name, 0, NATRON_BINARY_PROJECT_SECTION_NAME_SIZE);
+        std::strncpy(name, it->first.c_str(), NATRON_BINARY_PROJECT_SECTION_NAME_SIZE - 1);
+        const U64 size = it->second.size();
+        os.write(name, NATRON_BINARY_PROJECT_SECTION_NAME_SIZE);
+        os.write(reinterpret_cast<const char*>(&offset), sizeof(U64));
+        os.write(reinterpret_cast<const char*>(&size), sizeof(U64));
+        offset += size;
+    }
+    for (BinaryProjectSections::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+        os.write(it->second.data(), it->second.size());
+    }
+}
+
+static void
+readBinaryProjectSections(std::istream & is,
+                          BinaryProjectSections* sections)
+{
+    std::ostringstream ss;
+    ss << is.rdbuf();
+    const std::string data = ss.str();
+
+    const std::size_t headerSize = NATRON_BINARY_PROJECT_MAGIC_SIZE + 2 * sizeof(U32);
+    if ( (data.size() < headerSize) ||
+         (std::memcmp(data.data(), NATRON_BINARY_PROJECT_MAGIC, NATRON_BINARY_PROJECT_MAGIC_SIZE) != 0) ) {
+        throw std::runtime_error("Not a binary project file");
+    }
+    U32 version,sectionsCount;
+    std::memcpy(&version, data.data() + NATRON_BINARY_PROJECT_MAGIC_SIZE, sizeof(U32));
+    std::memcpy(&sectionsCount, data.data() + NATRON_BINARY_PROJECT_MAGIC_SIZE + sizeof(U32), sizeof(U32));
+    if (version > NATRON_BINARY_PROJECT_VERSION) {
+        throw std::invalid_argument("The given project was produced with a more recent and incompatible version of " NATRON_APPLICATION_NAME ".");
+    }
+
+    const std::size_t entrySize = NATRON_BINARY_PROJECT_SECTION_NAME_SIZE + 2 * sizeof(U64);
+    if ( (data.size() - headerSize) / entrySize < sectionsCount ) {
+        throw std::runtime_error("The sections index of the binary project is truncated");
+    }
+    for (U32 i = 0; i < sectionsCount; ++i) {
+        const char* entry = data.data() + headerSize + i * entrySize;
+        std::string name( entry, std::find(entry, entry + NATRON_BINARY_PROJECT_SECTION_NAME_SIZE, '\0') );
+        U64 offset,size;
+        std::memcpy(&offset, entry + NATRON_BINARY_PROJECT_SECTION_NAME_SIZE, sizeof(U64));
+        std::memcpy(&size, entry + NATRON_BINARY_PROJECT_SECTION_NAME_SIZE + sizeof(U64), sizeof(U64));
+        if ( (offset > data.size()) || (size > data.size() - offset) ) {
+            throw std::runtime_error("The section " + name + " of the binary project is truncated");
+        }
+        (*sections)[name] = data.substr(offset, size);
+    }
+}
+
 namespace Natron {
 Project::Project(AppInstance* appInstance)
     : KnobHolder(appInstance)
@@ -104,9 +212,7 @@ Project::Project(AppInstance* appInstance)
 Project::~Project()
 {
     ///wait for all autosaves to finish
-    for (std::list<boost::shared_ptr<QFutureWatcher<void> > >::iterator it = _imp->autoSaveFutures.begin(); it != _imp->autoSaveFutures.end(); ++it) {
-        (*it)->waitForFinished();
-    }
+    waitForPendingAutoSaves();
     
     ///Don't clear autosaves if the program is shutting down by user request.
     ///Even if the user replied she/he didn't want to save the current work, we keep an autosave of it.
@@ -205,6 +311,7 @@ Project::loadProject(const QString & path,
     refreshViewersAndPreviews();
 
     ///We successfully loaded the project, remove auto-saves of previous projects.
+    waitForPendingAutoSaves();
     removeAutoSaves();
 
     return true;
@@ -221,10 +328,11 @@ Project::loadProjectInternal(const QString & path,
     }
     
     bool ret = false;
+    const bool isBinaryProject = isBinaryProjectFile(filePath);
     std::ifstream ifile;
     try {
         ifile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        ifile.open(filePath.toStdString().c_str(),std::ifstream::in);
+        ifile.open(filePath.toStdString().c_str(),isBinaryProject ? std::ifstream::in | std::ifstream::binary : std::ifstream::in);
     } catch (const std::ifstream::failure & e) {
         throw std::runtime_error( std::string("Exception occured when opening file ") + filePath.toStdString() + ": " + e.what() );
     }
@@ -260,11 +368,32 @@ Project::loadProjectInternal(const QString & path,
             QMutexLocker k(&_imp->isLoadingProjectMutex);
             _imp->isLoadingProjectInternal = true;
         }
-        boost::archive::xml_iarchive iArchive(ifile);
         bool bgProject;
-        iArchive >> boost::serialization::make_nvp("Background_project", bgProject);
         ProjectSerialization projectSerializationObj( getApp() );
-        iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
+        boost::scoped_ptr<boost::archive::xml_iarchive> iArchive;
+        std::string guiLayout;
+        if (isBinaryProject) {
+            BinaryProjectSections sections;
+            readBinaryProjectSections(ifile, &sections);
+            BinaryProjectSections::iterator found = sections.find(NATRON_BINARY_PROJECT_SECTION_PROJECT);
+            if ( found == sections.end() ) {
+                throw std::runtime_error("The binary project has no project section");
+            }
+            {
+                std::istringstream projectStream(found->second);
+                boost::archive::binary_iarchive binArchive(projectStream);
+                binArchive >> boost::serialization::make_nvp("Background_project", bgProject);
+                binArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
+            }
+            found = sections.find(NATRON_BINARY_PROJECT_SECTION_GUI);
+            if ( found != sections.end() ) {
+                guiLayout.swap(found->second);
+            }
+        } else {
+            iArchive.reset( new boost::archive::xml_iarchive(ifile) );
+            *iArchive >> boost::serialization::make_nvp("Background_project", bgProject);
+            *iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
+        }
         
         ret = load(projectSerializationObj,name,path,isAutoSave,realFilePath);
         
@@ -274,7 +403,13 @@ Project::loadProjectInternal(const QString & path,
         }
         
         if (!bgProject) {
-            getApp()->loadProjectGui(iArchive);
+            if (iArchive) {
+                getApp()->loadProjectGui(*iArchive);
+            } else if ( !guiLayout.empty() ) {
+                std::istringstream guiStream(guiLayout);
+                boost::archive::xml_iarchive guiArchive(guiStream);
+                getApp()->loadProjectGui(guiArchive);
+            }
         }
     } catch (const boost::archive::archive_exception & e) {
         ifile.close();
@@ -359,14 +494,11 @@ Project::saveProject(const QString & path,
             ret = saveProjectInternal(path,name);
             
             ///We just saved, any auto-save left is then worthless
+            waitForPendingAutoSaves();
             removeAutoSaves();
 
             //}
         } else {
-            
-            ///Clean auto-saves before saving a new one
-            removeAutoSaves();
-            
             ret = saveProjectInternal(path,name,true);
         }
     } catch (const std::exception & e) {
@@ -382,8 +514,10 @@ Project::saveProject(const QString & path,
         _imp->isSavingProject = false;
     }
     
-    ///Save caches ToC
-    appPTR->saveCaches();
+    ///Save caches ToC. Auto-saves do it in the thread writing the file, see writeAutoSaveFile
+    if ( !autoS || name.contains("RENDER_SAVE") ) {
+        appPTR->saveCaches();
+    }
     
     return ret;
 }
@@ -405,6 +539,119 @@ fileCopy(const QString & source,
     return success;
 }
 
+static void
+writeProjectFile(const std::string & data,
+                 const QString & tmpFilename,
+                 const QString & filePath)
+{
+    std::ofstream ofile;
+    try {
+        ofile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        ofile.open(tmpFilename.toStdString().c_str(),std::ofstream::out | std::ofstream::binary);
+    } catch (const std::ofstream::failure & e) {
+        throw std::runtime_error( std::string("Exception occured when opening file ") + tmpFilename.toStdString() + ": " + e.what() );
+    }
+
+    if ( !ofile.good() ) {
+        qDebug() << "Failed to open file " << tmpFilename.toStdString().c_str();
+        throw std::runtime_error( "Failed to open file " + tmpFilename.toStdString() );
+    }
+    
+    try {
+        ofile.write( data.data(), data.size() );
+        ofile.close();
+    } catch (const std::ofstream::failure & e) {
+        QFile::remove(tmpFilename);
+        throw std::runtime_error( std::string("Failed to write the project file: I/O failure (") + e.what() + ")" );
+    }
+
+    QFile::remove(filePath);
+    int nAttemps = 0;
+
+    while ( nAttemps < 10 && !fileCopy(tmpFilename, filePath) ) {
+        ++nAttemps;
+    }
+
+    QFile::remove(tmpFilename);
+}
+
+///Run in a separate thread: only the already serialized project is used here.
+static void
+writeAutoSaveFile(const std::string & data,
+                  const QString & tmpFilename,
+                  const QString & filePath)
+{
+    try {
+        writeProjectFile(data, tmpFilename, filePath);
+    } catch (const std::exception & e) {
+        qDebug() << "Auto-save failure: " << e.what();
+    }
+    
+    ///Save caches ToC
+    appPTR->saveCaches();
+}
+
+///Hash of a serialized project, so that the last auto-save can be compared against without keeping a copy of it.
+static U64
+hashSerializedProject(const std::string & data)
+{
+    Hash64 hash;
+    std::size_t i = 0;
+
+    for (; i + sizeof(U64) <= data.size(); i += sizeof(U64)) {
+        U64 chunk;
+        memcpy(&chunk, &data[i], sizeof(U64));
+        hash.append(chunk);
+    }
+    for (; i < data.size(); ++i) {
+        hash.append<unsigned char>(data[i]);
+    }
+    hash.append<U64>( data.size() );
+    hash.computeHash();
+
+    return hash.value();
+}
+
+void
+Project::serializeProject(bool binaryFormat,
+                          std::string* data)
+{
+    std::ostringstream ss;
+    bool bgProject = appPTR->isBackground();
+    ProjectSerialization projectSerializationObj( getApp() );
+    save(&projectSerializationObj);
+    if (binaryFormat) {
+        BinaryProjectSections sections;
+        {
+            std::ostringstream projectStream;
+            {
+                boost::archive::binary_oarchive binArchive(projectStream);
+                binArchive << boost::serialization::make_nvp("Background_project",bgProject);
+                binArchive << boost::serialization::make_nvp("Project",projectSerializationObj);
+            }
+            sections[NATRON_BINARY_PROJECT_SECTION_PROJECT] = projectStream.str();
+        }
+        if (!bgProject) {
+            std::ostringstream guiStream;
+            {
+                ///The xml archive is only complete once destroyed
+                boost::archive::xml_oarchive guiArchive(guiStream);
+                getApp()->saveProjectGui(guiArchive);
+            }
+            sections[NATRON_BINARY_PROJECT_SECTION_GUI] = guiStream.str();
+        }
+        writeBinaryProjectSections(ss, sections);
+    } else {
+        boost::archive::xml_oarchive oArchive(ss);
+        oArchive << boost::serialization::make_nvp("Background_project",bgProject);
+        oArchive << boost::serialization::make_nvp("Project",projectSerializationObj);
+        if (!bgProject) {
+            getApp()->saveProjectGui(oArchive);
+        }
+    }
+    *data = ss.str();
+}
+
 QString
 Project::saveProjectInternal(const QString & path,
                              const QString & name,
@@ -412,6 +659,54 @@ Project::saveProjectInternal(const QString & path,
 {
     QDateTime time = QDateTime::currentDateTime();
     QString timeStr = time.toString();
+    
+    bool isRenderSave = name.contains("RENDER_SAVE");
+    
+    ///Fix file paths before saving.
+    QString oldProjectPath;
+    {
+        QMutexLocker l(&_imp->projectLock);
+        oldProjectPath = _imp->projectPath;
+    }
+    
+    if (!autoSave) {
+        _imp->autoSetProjectDirectory(path);
+        _imp->saveDate->setValue(timeStr.toStdString(), 0);
+        _imp->lastAuthorName->setValue(generateGUIUserName(), 0);
+        _imp->natronVersion->setValue(generateUserFriendlyNatronVersionName(),0);
+    }
+    
+    ///Serialize the project in memory on the calling thread: this snapshot of the project can then be
+    ///written to disk by another thread while the user keeps on editing the project.
+    ///The serialization itself still blocks the main thread, since the knobs and the node graph
+    ///may only be read safely from there.
+    std::string data;
+    try {
+        serializeProject(appPTR->getCurrentSettings()->isBinaryProjectFormatEnabled(), &data);
+    } catch (...) {
+        if (!autoSave) {
+            ///Reset the old project path in case of failure.
+            _imp->autoSetProjectDirectory(oldProjectPath);
+        }
+        throw;
+    }
+    
+    ///Auto-saves are written asynchronously, except the render save which is read right away
+    ///by the background render process.
+    bool asyncAutoSave = autoSave && !isRenderSave;
+    U64 snapshotHash = 0;
+    if (autoSave) {
+        snapshotHash = hashSerializedProject(data);
+        if ( asyncAutoSave && (snapshotHash == _imp->lastAutoSaveSnapshotHash) && QFile::exists(_imp->lastAutoSaveFilePath) ) {
+            ///Nothing changed since the last auto-save
+            return _imp->lastAutoSaveFilePath;
+        }
+        
+        ///Clean auto-saves before saving a new one
+        waitForPendingAutoSaves();
+        removeAutoSaves();
+    }
+    
     Hash64 timeHash;
 
     for (int i = 0; i < timeStr.size(); ++i) {
@@ -421,8 +716,6 @@ Project::saveProjectInternal(const QString & path,
     QString timeHashStr = QString::number( timeHash.value() );
     QString actualFileName = name;
     
-    bool isRenderSave = name.contains("RENDER_SAVE");
-    
     if (autoSave) {
         
         ///For render save don't encode a hash into it
@@ -473,62 +766,23 @@ Project::saveProjectInternal(const QString & path,
     tmpFilename.append( QDir::separator() );
     tmpFilename.append( QString::number( time.toMSecsSinceEpoch() ) );
 
-    std::ofstream ofile;
-    try {
-        ofile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        ofile.open(tmpFilename.toStdString().c_str(),std::ofstream::out);
-    } catch (const std::ofstream::failure & e) {
-        throw std::runtime_error( std::string("Exception occured when opening file ") + tmpFilename.toStdString() + ": " + e.what() );
-    }
-
-    if ( !ofile.good() ) {
-        qDebug() << "Failed to open file " << tmpFilename.toStdString().c_str();
-        throw std::runtime_error( "Failed to open file " + tmpFilename.toStdString() );
-    }
-
-    ///Fix file paths before saving.
-    QString oldProjectPath;
-    {
-        QMutexLocker l(&_imp->projectLock);
-        oldProjectPath = _imp->projectPath;
-    }
-    
-    if (!autoSave) {
-        _imp->autoSetProjectDirectory(path);
-        _imp->saveDate->setValue(timeStr.toStdString(), 0);
-        _imp->lastAuthorName->setValue(generateGUIUserName(), 0);
-        _imp->natronVersion->setValue(generateUserFriendlyNatronVersionName(),0);
-    }
-    
-    try {
-        boost::archive::xml_oarchive oArchive(ofile);
-        bool bgProject = appPTR->isBackground();
-        oArchive << boost::serialization::make_nvp("Background_project",bgProject);
-        ProjectSerialization projectSerializationObj( getApp() );
-        save(&projectSerializationObj);
-        oArchive << boost::serialization::make_nvp("Project",projectSerializationObj);
-        if (!bgProject) {
-            getApp()->saveProjectGui(oArchive);
-        }
-    } catch (...) {
-        ofile.close();
-        if (!autoSave) {
-            ///Reset the old project path in case of failure.
-            _imp->autoSetProjectDirectory(oldProjectPath);
+    if (asyncAutoSave) {
+        _imp->lastAutoSaveSnapshotHash = snapshotHash;
+        boost::shared_ptr<QFutureWatcher<void> > watcher(new QFutureWatcher<void>);
+        QObject::connect(watcher.get(), SIGNAL(finished()), this, SLOT(onAutoSaveFutureFinished()));
+        watcher->setFuture(QtConcurrent::run(writeAutoSaveFile, data, tmpFilename, filePath));
+        _imp->autoSaveFutures.push_back(watcher);
+    } else {
+        try {
+            writeProjectFile(data, tmpFilename, filePath);
+        } catch (...) {
+            if (!autoSave) {
+                ///Reset the old project path in case of failure.
+                _imp->autoSetProjectDirectory(oldProjectPath);
+            }
+            throw;
         }
-        throw;
-    }
-
-    ofile.close();
-
-    QFile::remove(filePath);
-    int nAttemps = 0;
-
-    while ( nAttemps < 10 && !fileCopy(tmpFilename, filePath) ) {
-        ++nAttemps;
     }
-
-    QFile::remove(tmpFilename);
     
     if (!autoSave) {
         _imp->projectName = name;
@@ -585,21 +839,25 @@ Project::onAutoSaveTimerTriggered()
         return;
     }
     
-    ///check that all schedulers are not working.
-    ///If so launch an auto-save, otherwise, restart the timer.
-    bool canAutoSave = !hasNodeRendering() && !getApp()->isShowingDialog();
-
-    if (canAutoSave) {
-        boost::shared_ptr<QFutureWatcher<void> > watcher(new QFutureWatcher<void>);
-        QObject::connect(watcher.get(), SIGNAL(finished()), this, SLOT(onAutoSaveFutureFinished()));
-        watcher->setFuture(QtConcurrent::run(this,&Project::autoSave));
-        _imp->autoSaveFutures.push_back(watcher);
+    ///The project is serialized on the main thread and written to disk in a separate thread,
+    ///hence renders in progress do not prevent the auto-save.
+    ///A modal dialog however runs its own event loop, possibly in the middle of a change of the project.
+    if ( !getApp()->isShowingDialog() ) {
+        autoSave();
     } else {
-        ///If the auto-save failed because a render is in progress, try every 2 seconds to auto-save.
+        ///If the auto-save failed because a dialog is shown, try every 2 seconds to auto-save.
         ///We don't use the user-provided timeout interval here because it could be an inapropriate value.
         _imp->autoSaveTimer->start(2000);
     }
 }
+
+void
+Project::waitForPendingAutoSaves()
+{
+    for (std::list<boost::shared_ptr<QFutureWatcher<void> > >::iterator it = _imp->autoSaveFutures.begin(); it != _imp->autoSaveFutures.end(); ++it) {
+        (*it)->waitForFinished();
+    }
+}
     
 void Project::onAutoSaveFutureFinished()
 {
@@ -1334,6 +1592,14 @@ Project::isLoadingProjectInternal() const
     return _imp->isLoadingProjectInternal;
 }
 
+bool
+Project::isRestoringNodes() const
+{
+    QMutexLocker l(&_imp->isLoadingProjectMutex);
+    
+    return _imp->isRestoringNodes;
+}
+
 bool
 Project::isGraphWorthLess() const
 {
@@ -74,6 +74,8 @@ public:
     /**
      * @brief Same as saveProject except that it will save the project in a temporary file
      * so it doesn't overwrite the project.
+     * The project is serialized in memory by the calling thread and the file is written by another thread.
+     * If nothing changed since the last auto-save, nothing is written.
      **/
     void autoSave();
 
@@ -101,6 +103,11 @@ public:
     bool isLoadingProject() const;
     
     bool isLoadingProjectInternal() const;
+    
+    /**
+     * @brief Returns true while the nodes of the project being loaded are created and connected.
+     **/
+    bool isRestoringNodes() const;
 
     QString getProjectName() const WARN_UNUSED_RETURN;
 
@@ -313,6 +320,16 @@ private:
     bool loadProjectInternal(const QString & path,const QString & name,bool isAutoSave,const QString& realFilePath);
 
     QString saveProjectInternal(const QString & path,const QString & name,bool autosave = false);
+    
+    /**
+     * @brief Serializes the project and its GUI layout in memory, in the XML or binary format.
+     **/
+    void serializeProject(bool binaryFormat,std::string* data);
+    
+    /**
+     * @brief Blocks until all auto-saves being written to disk are done.
+     **/
+    void waitForPendingAutoSaves();
 
     
     
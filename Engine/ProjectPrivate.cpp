@@ -37,6 +37,7 @@ ProjectPrivate::ProjectPrivate(Natron::Project* project)
     : _publicInterface(project)
     , projectLock()
     , projectName("Untitled." NATRON_PROJECT_FILE_EXT)
+    , lastAutoSaveSnapshotHash(0)
     , hasProjectBeenSavedByUser(false)
     , ageSinceLastSave( QDateTime::currentDateTime() )
     , lastAutoSave()
@@ -67,6 +68,7 @@ ProjectPrivate::ProjectPrivate(Natron::Project* project)
     , isLoadingProjectMutex()
     , isLoadingProject(false)
     , isLoadingProjectInternal(false)
+    , isRestoringNodes(false)
     , isSavingProjectMutex()
     , isSavingProject(false)
     , autoSaveTimer( new QTimer() )
@@ -164,8 +166,24 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
     
     bool hasProjectAWriter = false;
     
-    bool ok = NodeCollectionSerialization::restoreFromSerialization(obj.getNodesSerialization().getNodesSerialization(),
-                                                                    _publicInterface->shared_from_this(), &hasProjectAWriter);
+    ///Node hashes are not propagated downstream while the nodes are connected, see step 4)
+    {
+        QMutexLocker k(&isLoadingProjectMutex);
+        isRestoringNodes = true;
+    }
+    bool ok;
+    try {
+        ok = NodeCollectionSerialization::restoreFromSerialization(obj.getNodesSerialization().getNodesSerialization(),
+                                                                   _publicInterface->shared_from_this(), &hasProjectAWriter);
+    } catch (...) {
+        QMutexLocker k(&isLoadingProjectMutex);
+        isRestoringNodes = false;
+        throw;
+    }
+    {
+        QMutexLocker k(&isLoadingProjectMutex);
+        isRestoringNodes = false;
+    }
 
 
     if ( !hasProjectAWriter && appPTR->isBackground() ) {
@@ -174,6 +192,17 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
     }
 
     
+    /// 4) Now that all nodes are connected, compute their hash once, inputs first. From now on the hash
+    /// changes are propagated downstream again, e.g. by the clip preferences below.
+    {
+        NodeList nodes;
+        _publicInterface->getNodes_recursive(nodes);
+        std::set<Natron::Node*> marked;
+        for (NodeList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+            (*it)->computeHashAfterInputs(&marked);
+        }
+    }
+    
     _publicInterface->getApp()->updateProjectLoadStatus(QObject::tr("Restoring graph stream preferences"));
     
    
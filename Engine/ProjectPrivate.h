@@ -67,6 +67,7 @@ struct ProjectPrivate
     QString projectName; //< name of the project, e.g: "Untitled.EXT"
     QString projectPath; //< path of the project, e.g: /Users/Lala/Projects/
     QString lastAutoSaveFilePath; //< path + name of the last auto-save file
+    U64 lastAutoSaveSnapshotHash; //< hash of the serialized project written by the last auto-save
     bool hasProjectBeenSavedByUser; //< has this project ever been saved by the user?
     QDateTime ageSinceLastSave; //< the last time the user saved
     QDateTime lastAutoSave; //< the last time since autosave
@@ -108,6 +109,7 @@ struct ProjectPrivate
     mutable QMutex isLoadingProjectMutex;
     bool isLoadingProject; //< true when the project is loading
     bool isLoadingProjectInternal; //< true when loading the internal project (not gui)
+    bool isRestoringNodes; //< true while the nodes of the project are created and connected
     mutable QMutex isSavingProjectMutex;
     bool isSavingProject; //< true when the project is saving
     boost::shared_ptr<QTimer> autoSaveTimer;
@@ -0,0 +1,255 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "RenderCheckpoint.h"
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+CLANG_DIAG_ON(deprecated)
+
+#include "Engine/StandardPaths.h"
+
+#define NATRON_RENDER_CHECKPOINT_MAGIC "NTCK"
+#define NATRON_RENDER_CHECKPOINT_VERSION 1
+#define NATRON_RENDER_CHECKPOINT_HEADER_SIZE 8
+#define NATRON_RENDER_CHECKPOINT_RECORD_SIZE 8
+
+///The second word of a record is the frame xor'ed with one of these, so that a torn record is not mistaken for a valid one
+#define NATRON_RENDER_CHECKPOINT_COMPLETED 0x434f4d50u
+#define NATRON_RENDER_CHECKPOINT_INCOMPLETE 0x494e434fu
+
+struct RenderCheckpointPrivate
+{
+    QString filePath;
+    mutable QMutex lock; //< protects the members below
+    QFile file;
+    std::set<int> completedFrames;
+
+    RenderCheckpointPrivate(const QString & filePath)
+    : filePath(filePath)
+    , lock()
+    , file(filePath)
+    , completedFrames()
+    {
+    }
+
+    ///Returns false if the file exists but is not a checkpoint
+    bool readRecords();
+
+    void appendRecord(int frame,quint32 type);
+};
+
+bool
+RenderCheckpointPrivate::readRecords()
+{
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        ///It does not exist yet
+        return true;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+    if ( data.isEmpty() ) {
+        return true;
+    }
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    char magic[4];
+    quint32 version = 0;
+    if ( (stream.readRawData(magic, 4) != 4) || (qstrncmp(magic, NATRON_RENDER_CHECKPOINT_MAGIC, 4) != 0) ) {
+        return false;
+    }
+    stream >> version;
+    if (version != NATRON_RENDER_CHECKPOINT_VERSION) {
+        return false;
+    }
+
+    ///Records are applied in order: a frame may have been marked incomplete and then completed again
+    int nRecords = (data.size() - NATRON_RENDER_CHECKPOINT_HEADER_SIZE) / NATRON_RENDER_CHECKPOINT_RECORD_SIZE;
+    for (int i = 0; i < nRecords; ++i) {
+        qint32 frame;
+        quint32 check;
+        stream >> frame >> check;
+        if ( check == ( (quint32)frame ^ NATRON_RENDER_CHECKPOINT_COMPLETED ) ) {
+            completedFrames.insert(frame);
+        } else if ( check == ( (quint32)frame ^ NATRON_RENDER_CHECKPOINT_INCOMPLETE ) ) {
+            completedFrames.erase(frame);
+        } else {
+            ///The process died while writing this record, it is the last one
+            break;
+        }
+    }
+
+    return true;
+}
+
+void
+RenderCheckpointPrivate::appendRecord(int frame,
+                                      quint32 type)
+{
+    assert( !lock.tryLock() );
+    if ( !file.isOpen() ) {
+        return;
+    }
+    QByteArray record;
+    {
+        QDataStream stream(&record,QIODevice::WriteOnly);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream << (qint32)frame << ( (quint32)frame ^ type );
+    }
+    ///A single write, the file being unbuffered
+    file.write(record);
+}
+
+RenderCheckpoint::RenderCheckpoint(const QString & filePath)
+: _imp( new RenderCheckpointPrivate(filePath) )
+{
+}
+
+RenderCheckpoint::~RenderCheckpoint()
+{
+    _imp->file.close();
+}
+
+QString
+RenderCheckpoint::getCheckpointFilePath(const QString & writerName,
+                                        U64 key)
+{
+    QString path = Natron::StandardPaths::writableLocation(Natron::StandardPaths::eStandardLocationCache);
+    path.append( QDir::separator() );
+    path.append("RenderCheckpoints");
+    path.append( QDir::separator() );
+    path.append( writerName + '_' + QString::number(key, 16) + ".ckpt" );
+
+    return path;
+}
+
+bool
+RenderCheckpoint::open(QString* error)
+{
+    QMutexLocker l(&_imp->lock);
+
+    QDir().mkpath( QFileInfo(_imp->filePath).path() );
+
+    bool valid = _imp->readRecords();
+    if (!valid) {
+        _imp->completedFrames.clear();
+    }
+
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Unbuffered;
+    if (valid) {
+        mode |= QIODevice::Append;
+    } else {
+        mode |= QIODevice::Truncate;
+    }
+    if ( !_imp->file.open(mode) ) {
+        *error = QObject::tr("Cannot write the render checkpoint %1: %2").arg(_imp->filePath).arg( _imp->file.errorString() );
+
+        return false;
+    }
+    if (_imp->file.size() < NATRON_RENDER_CHECKPOINT_HEADER_SIZE) {
+        _imp->file.resize(0);
+        QByteArray header;
+        {
+            QDataStream stream(&header,QIODevice::WriteOnly);
+            stream.setByteOrder(QDataStream::LittleEndian);
+            stream.writeRawData(NATRON_RENDER_CHECKPOINT_MAGIC, 4);
+            stream << (quint32)NATRON_RENDER_CHECKPOINT_VERSION;
+        }
+        _imp->file.write(header);
+    } else {
+        ///Drop the incomplete record the previous process may have left, so that the next ones are aligned
+        qint64 size = _imp->file.size();
+        qint64 alignedSize = size - (size - NATRON_RENDER_CHECKPOINT_HEADER_SIZE) % NATRON_RENDER_CHECKPOINT_RECORD_SIZE;
+        if (alignedSize != size) {
+            _imp->file.resize(alignedSize);
+        }
+    }
+
+    return true;
+}
+
+const QString &
+RenderCheckpoint::getFilePath() const
+{
+    return _imp->filePath;
+}
+
+bool
+RenderCheckpoint::isFrameCompleted(int frame) const
+{
+    QMutexLocker l(&_imp->lock);
+
+    return _imp->completedFrames.find(frame) != _imp->completedFrames.end();
+}
+
+void
+RenderCheckpoint::getCompletedFrames(std::set<int>* frames) const
+{
+    QMutexLocker l(&_imp->lock);
+
+    *frames = _imp->completedFrames;
+}
+
+void
+RenderCheckpoint::getFrameRangesToRender(int first,
+                                         int last,
+                                         std::list<std::pair<int,int> >* ranges) const
+{
+    QMutexLocker l(&_imp->lock);
+
+    bool inRange = false;
+    for (int i = first; i <= last; ++i) {
+        if ( _imp->completedFrames.find(i) != _imp->completedFrames.end() ) {
+            inRange = false;
+        } else if (inRange) {
+            ranges->back().second = i;
+        } else {
+            ranges->push_back( std::make_pair(i, i) );
+            inRange = true;
+        }
+    }
+}
+
+void
+RenderCheckpoint::markFrameCompleted(int frame)
+{
+    QMutexLocker l(&_imp->lock);
+
+    if ( _imp->completedFrames.insert(frame).second ) {
+        _imp->appendRecord(frame, NATRON_RENDER_CHECKPOINT_COMPLETED);
+    }
+}
+
+void
+RenderCheckpoint::markFrameIncomplete(int frame)
+{
+    QMutexLocker l(&_imp->lock);
+
+    if (_imp->completedFrames.erase(frame) > 0) {
+        _imp->appendRecord(frame, NATRON_RENDER_CHECKPOINT_INCOMPLETE);
+    }
+}
+
+void
+RenderCheckpoint::remove()
+{
+    QMutexLocker l(&_imp->lock);
+
+    _imp->file.close();
+    _imp->file.remove();
+    _imp->completedFrames.clear();
+}
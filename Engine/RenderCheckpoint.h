@@ -0,0 +1,88 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_RENDERCHECKPOINT_H_
+#define NATRON_ENGINE_RENDERCHECKPOINT_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <set>
+#include <utility>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+/**
+ * @brief Records the frames of a writer's render that are completed, so that a render that was interrupted
+ * (crash, kill...) can be resumed by rendering only the frames that are missing.
+ *
+ * The checkpoint file is made of a header followed by fixed size records appended as frames complete: a record is
+ * written with a single write, and an incomplete or corrupted record at the end of the file (the process died while
+ * writing it) is ignored, so the file is always consistent.
+ **/
+struct RenderCheckpointPrivate;
+class RenderCheckpoint
+{
+public:
+
+    RenderCheckpoint(const QString & filePath);
+
+    ~RenderCheckpoint();
+
+    /**
+     * @brief Returns the path of the checkpoint of the given writer in the cache directory. The key identifies
+     * the render job, e.g it is a hash of the project content and the output filename of the writer.
+     **/
+    static QString getCheckpointFilePath(const QString & writerName,U64 key);
+
+    /**
+     * @brief Reads the frames recorded in the file, if it exists, and opens it to record new frames.
+     * Returns false and sets error if the file cannot be written.
+     **/
+    bool open(QString* error);
+
+    const QString & getFilePath() const;
+
+    bool isFrameCompleted(int frame) const;
+
+    void getCompletedFrames(std::set<int>* frames) const;
+
+    /**
+     * @brief Returns the ranges of consecutive frames between first and last (included) that are not completed.
+     **/
+    void getFrameRangesToRender(int first,int last,std::list<std::pair<int,int> >* ranges) const;
+
+    /**
+     * @brief Records that the frame is completed. Thread-safe.
+     **/
+    void markFrameCompleted(int frame);
+
+    /**
+     * @brief Records that the frame must be rendered again, e.g because its output file is missing. Thread-safe.
+     **/
+    void markFrameIncomplete(int frame);
+
+    /**
+     * @brief Deletes the file, once the render job is done.
+     **/
+    void remove();
+
+private:
+
+    boost::scoped_ptr<RenderCheckpointPrivate> _imp;
+};
+
+#endif // NATRON_ENGINE_RENDERCHECKPOINT_H_
@@ -1753,7 +1753,6 @@ bezierPoint(const Point & p0,
     return bezierFullPoint(p0, p1, p2, p3, t, &p0p1, &p1p2, &p2p3, &p0p1_p1p2, &p1p2_p2p3, dest);
 }
 
-#if 0 //UNUSED CODE
 // compute polynomial coefficients so that
 // P(t) = A*t^3 + B*t^2 + C*t + D
 static inline void
@@ -1776,8 +1775,6 @@ bezierPolyCoeffs(double p0,
     *a = p3 - 3 * p2 + 3 * p1 - p0;
 }
 
-#endif
-
 // compute polynomial coefficients so that
 // P'(t) = A*t^2 + B*t + C
 static inline void
@@ -2015,57 +2012,142 @@ bezierSegmentEval(const BezierCP & first,
     }
 }
 
-/**
- * @brief Determines if the point (x,y) lies on the bezier curve segment defined by first and last.
- * @returns True if the point is close (according to the acceptance) to the curve, false otherwise.
- * @param param[out] It is set to the parametric value at which the subdivision of the bezier segment
- * yields the closest point to (x,y) on the curve.
- **/
-static bool
-bezierSegmentMeetsPoint(const BezierCP & first,
-                        const BezierCP & last,
-                        int time,
-                        double x,
-                        double y,
-                        double distance,
-                        double *param) ///< output
+// returns the number of points needed so that the polyline joining uniformly spaced points of the
+// Bezier segment does not deviate from the segment by more than kRotoFlatteningTolerance.
+// The distance is bounded by 3/4 * max(|P0 - 2*P1 + P2|, |P1 - 2*P2 + P3|) * h^2 where h is the parametric step.
+static int
+bezierSegmentNbPoints(const Point & p0,
+                      const Point & p1,
+                      const Point & p2,
+                      const Point & p3)
 {
-    Point p0,p1,p2,p3;
-
-    first.getPositionAtTime(time, &p0.x, &p0.y);
-    first.getRightBezierPointAtTime(time, &p1.x, &p1.y);
-    last.getPositionAtTime(time, &p3.x, &p3.y);
-    last.getLeftBezierPointAtTime(time, &p2.x, &p2.y);
+    double ddx0 = p0.x - 2 * p1.x + p2.x;
+    double ddy0 = p0.y - 2 * p1.y + p2.y;
+    double ddx1 = p1.x - 2 * p2.x + p3.x;
+    double ddy1 = p1.y - 2 * p2.y + p3.y;
+    double dd = std::sqrt( std::max(ddx0 * ddx0 + ddy0 * ddy0, ddx1 * ddx1 + ddy1 * ddy1) );
+    double nbSteps = std::ceil( std::sqrt(0.75 * dd / kRotoFlatteningTolerance) );
 
-    ///Use the control polygon to approximate segment length
-    double length = ( std::sqrt( (p1.x - p0.x) * (p1.x - p0.x) + (p1.y - p0.y) * (p1.y - p0.y) ) +
-                      std::sqrt( (p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y) ) +
-                      std::sqrt( (p3.x - p2.x) * (p3.x - p2.x) + (p3.y - p2.y) * (p3.y - p2.y) ) );
-    // increment is the distance divided by the  segment length
-    double incr = length == 0. ? 1. : distance / length;
+    return (int)std::max( 1., std::min(nbSteps, (double)(kRotoFlatteningMaxPointsPerSegment - 1) ) ) + 1;
+}
 
-    ///the minimum square distance between a decasteljau point an the given (x,y) point
-    ///we save a sqrt call
-    double sqDistance = distance * distance;
-    double minSqDistance = std::numeric_limits<double>::infinity();
-    double tForMin = -1.;
-    for (double t = 0.; t <= 1.; t += incr) {
+// append nbPoints uniformly spaced points of the Bezier segment (including both end points)
+// and update the bbox bounding box
+static void
+bezierSegmentFlatten(const Point & p0,
+                     const Point & p1,
+                     const Point & p2,
+                     const Point & p3,
+                     int nbPoints,
+                     std::vector<Point>* points, ///< output
+                     RectD* bbox) ///< input/output
+{
+    double ax,bx,cx,dx,ay,by,cy,dy;
+
+    bezierPolyCoeffs(p0.x, p1.x, p2.x, p3.x, &ax, &bx, &cx, &dx);
+    bezierPolyCoeffs(p0.y, p1.y, p2.y, p3.y, &ay, &by, &cy, &dy);
+
+    double incr = 1. / (double)(nbPoints - 1);
+    for (int i = 0; i < nbPoints; ++i) {
+        double t = i * incr;
         Point p;
-        bezierPoint(p0, p1, p2, p3, t, &p);
-        double sqdist = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
-        if ( (sqdist <= sqDistance) && (sqdist < minSqDistance) ) {
-            minSqDistance = sqdist;
-            tForMin = t;
+        p.x = ( (ax * t + bx) * t + cx ) * t + dx;
+        p.y = ( (ay * t + by) * t + cy ) * t + dy;
+        points->push_back(p);
+    }
+    bezierPointBboxUpdate(p0, p1, p2, p3, bbox);
+}
+
+// get the left bezier point, position and right bezier point of each control point at the given time
+static void
+getBezierPointsAtTime(const BezierCPs & cps,
+                      int time,
+                      unsigned int mipMapLevel,
+                      std::vector<Point>* points) ///< output
+{
+    points->reserve(cps.size() * 3);
+    for (BezierCPs::const_iterator it = cps.begin(); it != cps.end(); ++it) {
+        Point p[3];
+        (*it)->getLeftBezierPointAtTime(time, &p[0].x, &p[0].y);
+        (*it)->getPositionAtTime(time, &p[1].x, &p[1].y);
+        (*it)->getRightBezierPointAtTime(time, &p[2].x, &p[2].y);
+        for (int i = 0; i < 3; ++i) {
+            if (mipMapLevel > 0) {
+                int pot = 1 << mipMapLevel;
+                p[i].x /= pot;
+                p[i].y /= pot;
+            }
+            points->push_back(p[i]);
         }
     }
+}
 
-    if (minSqDistance <= sqDistance) {
-        *param = tForMin;
+// flatten the control points and feather points given by getBezierPointsAtTime
+static void
+bezierSegmentListFlatten(const std::vector<Point> & cps,
+                         const std::vector<Point> & fps,
+                         bool finished,
+                         BezierPolylines* polylines) ///< output
+{
+    assert( cps.size() == fps.size() );
+    int nbCps = (int)cps.size() / 3;
+    if (nbCps == 0) {
+        return;
+    }
+    polylines->controlPoints.reserve(nbCps);
+    polylines->featherControlPoints.reserve(nbCps);
+    for (int i = 0; i < nbCps; ++i) {
+        polylines->controlPoints.push_back(cps[i * 3 + 1]);
+        polylines->featherControlPoints.push_back(fps[i * 3 + 1]);
+    }
+    if (nbCps == 1) {
+        // only one point
+        polylines->points.push_back(cps[1]);
+        polylines->featherPoints.push_back(fps[1]);
+        updateRange(cps[1].x, &polylines->bbox.x1, &polylines->bbox.x2);
+        updateRange(cps[1].y, &polylines->bbox.y1, &polylines->bbox.y2);
+        updateRange(fps[1].x, &polylines->featherBBox.x1, &polylines->featherBBox.x2);
+        updateRange(fps[1].y, &polylines->featherBBox.y1, &polylines->featherBBox.y2);
 
-        return true;
+        return;
     }
+    int nbSegments = finished ? nbCps : nbCps - 1;
+    for (int i = 0; i < nbSegments; ++i) {
+        int next = (i + 1) % nbCps;
+        const Point* cp = &cps[i * 3];
+        const Point* nextCp = &cps[next * 3];
+        const Point* fp = &fps[i * 3];
+        const Point* nextFp = &fps[next * 3];
 
-    return false;
+        ///Both segments use the same number of points so that they can be walked in parallel
+        int nbPoints = std::max( bezierSegmentNbPoints(cp[1], cp[2], nextCp[0], nextCp[1]),
+                                 bezierSegmentNbPoints(fp[1], fp[2], nextFp[0], nextFp[1]) );
+
+        polylines->segmentStarts.push_back( (int)polylines->points.size() );
+        bezierSegmentFlatten(cp[1], cp[2], nextCp[0], nextCp[1], nbPoints, &polylines->points, &polylines->bbox);
+        bezierSegmentFlatten(fp[1], fp[2], nextFp[0], nextFp[1], nbPoints, &polylines->featherPoints, &polylines->featherBBox);
+    }
+}
+
+// returns the squared distance between (x,y) and the [a,b] line segment
+// and the parametric position on the line segment of the closest point
+static double
+squaredDistanceToEdge(const Point & a,
+                      const Point & b,
+                      double x,
+                      double y,
+                      double *u) ///< output
+{
+    double abx = b.x - a.x;
+    double aby = b.y - a.y;
+    double sqLength = abx * abx + aby * aby;
+
+    *u = sqLength == 0. ? 0. : ( (x - a.x) * abx + (y - a.y) * aby ) / sqLength;
+    *u = std::max( 0., std::min(*u, 1.) );
+    double px = a.x + *u * abx;
+    double py = a.y + *u * aby;
+
+    return (px - x) * (px - x) + (py - y) * (py - y);
 }
 
 static bool
@@ -2405,64 +2487,66 @@ Bezier::isPointOnCurve(double x,
     assert( QThread::currentThread() == qApp->thread() );
 
     int time = getContext()->getTimelineCurrentTime();
-    QMutexLocker l(&itemMutex);
-
-    ///special case: if the curve has only 1 control point, just check if the point
-    ///is nearby that sole control point
-    if (_imp->points.size() == 1) {
-        const boost::shared_ptr<BezierCP> & cp = _imp->points.front();
-        if ( isPointCloseTo(time, *cp, x, y, distance) ) {
-            *feather = false;
+    {
+        QMutexLocker l(&itemMutex);
 
-            return 0;
-        } else {
-            ///do the same with the feather points
-            const boost::shared_ptr<BezierCP> & fp = _imp->featherPoints.front();
-            if ( isPointCloseTo(time, *fp, x, y, distance) ) {
-                *feather = true;
+        ///special case: if the curve has only 1 control point, just check if the point
+        ///is nearby that sole control point
+        if (_imp->points.size() == 1) {
+            const boost::shared_ptr<BezierCP> & cp = _imp->points.front();
+            if ( isPointCloseTo(time, *cp, x, y, distance) ) {
+                *feather = false;
 
                 return 0;
-            }
-        }
-
-        return -1;
-    }
-
-    ///For each segment find out if the point lies on the bezier
-    int index = 0;
-
-    assert( _imp->featherPoints.size() == _imp->points.size() );
-
-    BezierCPs::const_iterator fp = _imp->featherPoints.begin();
-    for (BezierCPs::const_iterator it = _imp->points.begin(); it != _imp->points.end(); ++it, ++index,++fp) {
-        BezierCPs::const_iterator next = it;
-        BezierCPs::const_iterator nextFp = fp;
-        ++nextFp;
-        ++next;
-        if ( next == _imp->points.end() ) {
-            if (!_imp->finished) {
-                return -1;
             } else {
-                next = _imp->points.begin();
-                nextFp = _imp->featherPoints.begin();
-            }
-        }
-        if ( bezierSegmentMeetsPoint(*(*it), *(*next), time, x, y, distance, t) ) {
-            *feather = false;
+                ///do the same with the feather points
+                const boost::shared_ptr<BezierCP> & fp = _imp->featherPoints.front();
+                if ( isPointCloseTo(time, *fp, x, y, distance) ) {
+                    *feather = true;
 
-            return index;
-        }
-        if ( bezierSegmentMeetsPoint(**fp, **nextFp, time, x, y, distance, t) ) {
-            *feather = true;
+                    return 0;
+                }
+            }
 
-            return index;
+            return -1;
         }
     }
 
-    ///now check the feather points segments only if they are different from the base bezier
+    ///Find the closest edge of the polygons among the ones crossing the acceptance rectangle
+    boost::shared_ptr<BezierSpatialIndex> spatialIndex = getSpatialIndex(time);
+    const BezierPolylines & polylines = *spatialIndex->polylines;
+    std::vector<int> edges;
+    spatialIndex->getEdgesInRect(RectD(x - distance, y - distance, x + distance, y + distance), &edges);
 
+    int nbPoints = (int)polylines.points.size();
+    ///we save a sqrt call
+    double minSqDistance = distance * distance;
+    int minEdge = -1;
+    double minU = 0.;
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const std::vector<Point> & polygon = edges[i] < nbPoints ? polylines.points : polylines.featherPoints;
+        int e = edges[i] < nbPoints ? edges[i] : edges[i] - nbPoints;
+        double u;
+        double sqDist = squaredDistanceToEdge(polygon[e], polygon[e + 1], x, y, &u);
+        if ( (sqDist <= minSqDistance) && ( (minEdge == -1) || (sqDist < minSqDistance) ) ) {
+            minSqDistance = sqDist;
+            minEdge = edges[i];
+            minU = u;
+        }
+    }
+    if (minEdge == -1) {
+        return -1;
+    }
 
-    return -1;
+    *feather = minEdge >= nbPoints;
+    int e = *feather ? minEdge - nbPoints : minEdge;
+    int index = (int)( std::upper_bound(polylines.segmentStarts.begin(), polylines.segmentStarts.end(), e) - polylines.segmentStarts.begin() ) - 1;
+    assert(index >= 0);
+    int start = polylines.segmentStarts[index];
+    int end = index + 1 < (int)polylines.segmentStarts.size() ? polylines.segmentStarts[index + 1] : nbPoints;
+    *t = (e - start + minU) / (double)(end - start - 1);
+
+    return index;
 } // isPointOnCurve
 
 void
@@ -3317,6 +3401,212 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau(int time,
     }
 }
 
+boost::shared_ptr<BezierPolylines>
+Bezier::getPolylinesAtTime(int time,
+                           unsigned int mipMapLevel) const
+{
+    ///Copy the points at the given time so that the flattening is done without holding the item mutex
+    std::vector<Point> cps,fps;
+    bool finished;
+    {
+        QMutexLocker l(&itemMutex);
+        finished = _imp->finished;
+        getBezierPointsAtTime(_imp->points, time, mipMapLevel, &cps);
+        getBezierPointsAtTime(_imp->featherPoints, time, mipMapLevel, &fps);
+    }
+
+    ///The polylines only depend on the points, not on the time, so a shape that does not move
+    ///shares its polylines across frames
+    Hash64 hash;
+    hash.append(finished);
+    for (std::size_t i = 0; i < cps.size(); ++i) {
+        hash.append(cps[i].x);
+        hash.append(cps[i].y);
+        hash.append(fps[i].x);
+        hash.append(fps[i].y);
+    }
+    hash.computeHash();
+
+    {
+        QMutexLocker l(&_imp->polylinesCacheMutex);
+        for (std::list<std::pair<U64, boost::shared_ptr<BezierPolylines> > >::iterator it = _imp->polylinesCache.begin();
+             it != _imp->polylinesCache.end(); ++it) {
+            if (it->first == hash.value()) {
+                boost::shared_ptr<BezierPolylines> ret = it->second;
+                _imp->polylinesCache.splice(_imp->polylinesCache.begin(), _imp->polylinesCache, it);
+
+                return ret;
+            }
+        }
+    }
+
+    boost::shared_ptr<BezierPolylines> ret(new BezierPolylines);
+    bezierSegmentListFlatten(cps, fps, finished, ret.get());
+    ret->pointsHash = hash.value();
+
+    {
+        QMutexLocker l(&_imp->polylinesCacheMutex);
+        _imp->polylinesCache.push_front( std::make_pair(hash.value(), ret) );
+        if (_imp->polylinesCache.size() > kRotoPolylinesCacheSize) {
+            _imp->polylinesCache.pop_back();
+        }
+    }
+
+    return ret;
+}
+
+boost::shared_ptr<BezierSpatialIndex>
+Bezier::getSpatialIndex(int time) const
+{
+    ///only called on the main-thread
+    assert( QThread::currentThread() == qApp->thread() );
+
+    ///The polylines are identified by a hash of the points they were computed from: only rebuild the index
+    ///of a shape whose points changed, by an interact, a tracker or a script
+    boost::shared_ptr<BezierPolylines> polylines = getPolylinesAtTime(time, 0);
+    boost::shared_ptr<BezierSpatialIndex> & spatialIndex = _imp->spatialIndex;
+    if ( !spatialIndex || (spatialIndex->polylines->pointsHash != polylines->pointsHash) ) {
+        spatialIndex.reset( new BezierSpatialIndex(polylines) );
+    }
+
+    return spatialIndex;
+}
+
+BezierSpatialIndex::BezierSpatialIndex(const boost::shared_ptr<BezierPolylines> & polylines)
+    : polylines(polylines)
+    , bounds( std::numeric_limits<double>::infinity(),
+              std::numeric_limits<double>::infinity(),
+              -std::numeric_limits<double>::infinity(),
+              -std::numeric_limits<double>::infinity() )
+    , cellSize(1.)
+    , nbCellsX(0)
+    , nbCellsY(0)
+    , pointCells()
+    , edgeCells()
+{
+    const std::vector<Point>* pointLists[2] = { &polylines->controlPoints, &polylines->featherControlPoints };
+    const std::vector<Point>* polygons[2] = { &polylines->points, &polylines->featherPoints };
+
+    for (int i = 0; i < 2; ++i) {
+        for (std::vector<Point>::const_iterator it = pointLists[i]->begin(); it != pointLists[i]->end(); ++it) {
+            updateRange(it->x, &bounds.x1, &bounds.x2);
+            updateRange(it->y, &bounds.y1, &bounds.y2);
+        }
+        for (std::vector<Point>::const_iterator it = polygons[i]->begin(); it != polygons[i]->end(); ++it) {
+            updateRange(it->x, &bounds.x1, &bounds.x2);
+            updateRange(it->y, &bounds.y1, &bounds.y2);
+        }
+    }
+    if ( polylines->controlPoints.empty() ) {
+        return;
+    }
+
+    ///Use roughly as many cells as there are items to index
+    std::size_t nbItems = polylines->controlPoints.size() * 2 + polylines->points.size() * 2;
+    int nbCells = std::min( (int)std::ceil( std::sqrt( (double)nbItems ) ), kRotoSpatialIndexMaxCells );
+    double size = std::max( bounds.x2 - bounds.x1, bounds.y2 - bounds.y1 );
+    if (size > 0) {
+        cellSize = size / nbCells;
+    }
+    nbCellsX = std::max( 1, std::min( (int)std::ceil( (bounds.x2 - bounds.x1) / cellSize ), kRotoSpatialIndexMaxCells ) );
+    nbCellsY = std::max( 1, std::min( (int)std::ceil( (bounds.y2 - bounds.y1) / cellSize ), kRotoSpatialIndexMaxCells ) );
+    pointCells.resize(nbCellsX * nbCellsY);
+    edgeCells.resize(nbCellsX * nbCellsY);
+
+    int pointOffset = 0;
+    int edgeOffset = 0;
+    for (int i = 0; i < 2; ++i) {
+        const std::vector<Point> & pts = *pointLists[i];
+        for (std::size_t p = 0; p < pts.size(); ++p) {
+            insert(RectD(pts[p].x, pts[p].y, pts[p].x, pts[p].y), pointOffset + (int)p, &pointCells);
+        }
+        pointOffset += (int)pts.size();
+
+        ///Edges only join points of the same segment: the last point of a segment is the first point of the next one
+        const std::vector<Point> & polygon = *polygons[i];
+        const std::vector<int> & starts = polylines->segmentStarts;
+        for (std::size_t s = 0; s < starts.size(); ++s) {
+            int end = s + 1 < starts.size() ? starts[s + 1] : (int)polygon.size();
+            for (int e = starts[s]; e < end - 1; ++e) {
+                const Point & a = polygon[e];
+                const Point & b = polygon[e + 1];
+                insert(RectD( std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y) ), edgeOffset + e, &edgeCells);
+            }
+        }
+        edgeOffset += (int)polygon.size();
+    }
+}
+
+bool
+BezierSpatialIndex::getCellRange(const RectD & rect,
+                                 int* x1,
+                                 int* y1,
+                                 int* x2,
+                                 int* y2) const
+{
+    if ( (nbCellsX == 0) || (rect.x2 < bounds.x1) || (rect.x1 > bounds.x2) || (rect.y2 < bounds.y1) || (rect.y1 > bounds.y2) ) {
+        return false;
+    }
+    *x1 = std::max( 0, std::min( (int)std::floor( (rect.x1 - bounds.x1) / cellSize ), nbCellsX - 1 ) );
+    *x2 = std::max( 0, std::min( (int)std::floor( (rect.x2 - bounds.x1) / cellSize ), nbCellsX - 1 ) );
+    *y1 = std::max( 0, std::min( (int)std::floor( (rect.y1 - bounds.y1) / cellSize ), nbCellsY - 1 ) );
+    *y2 = std::max( 0, std::min( (int)std::floor( (rect.y2 - bounds.y1) / cellSize ), nbCellsY - 1 ) );
+
+    return true;
+}
+
+void
+BezierSpatialIndex::insert(const RectD & rect,
+                           int item,
+                           std::vector<std::vector<int> >* cells)
+{
+    int x1,y1,x2,y2;
+
+    if ( !getCellRange(rect, &x1, &y1, &x2, &y2) ) {
+        return;
+    }
+    for (int y = y1; y <= y2; ++y) {
+        for (int x = x1; x <= x2; ++x) {
+            (*cells)[y * nbCellsX + x].push_back(item);
+        }
+    }
+}
+
+void
+BezierSpatialIndex::query(const RectD & rect,
+                          const std::vector<std::vector<int> > & cells,
+                          std::vector<int>* items) const
+{
+    int x1,y1,x2,y2;
+
+    if ( !getCellRange(rect, &x1, &y1, &x2, &y2) ) {
+        return;
+    }
+    for (int y = y1; y <= y2; ++y) {
+        for (int x = x1; x <= x2; ++x) {
+            const std::vector<int> & cell = cells[y * nbCellsX + x];
+            items->insert( items->end(), cell.begin(), cell.end() );
+        }
+    }
+    ///an item crossing several cells is listed several times
+    std::sort( items->begin(), items->end() );
+    items->erase( std::unique( items->begin(), items->end() ), items->end() );
+}
+
+void
+BezierSpatialIndex::getPointsInRect(const RectD & rect,
+                                    std::vector<int>* points) const
+{
+    query(rect, pointCells, points);
+}
+
+void
+BezierSpatialIndex::getEdgesInRect(const RectD & rect,
+                                   std::vector<int>* edges) const
+{
+    query(rect, edgeCells, edges);
+}
+
 RectD
 Bezier::getBoundingBox(int time) const
 {
@@ -3345,6 +3635,50 @@ Bezier::getBoundingBox(int time) const
     return bbox;
 }
 
+U64
+Bezier::computeRenderHash(int time,
+                          unsigned int mipmapLevel) const
+{
+    Hash64 hash;
+
+    hash.append(mipmapLevel);
+    {
+        QMutexLocker l(&itemMutex);
+        hash.append(_imp->finished);
+        assert( _imp->featherPoints.size() == _imp->points.size() );
+        BezierCPs::const_iterator itF = _imp->featherPoints.begin();
+        for (BezierCPs::const_iterator it = _imp->points.begin(); it != _imp->points.end(); ++it,++itF) {
+            const BezierCP* pts[2] = { it->get(), itF->get() };
+            for (int i = 0; i < 2; ++i) {
+                double x,y,lx,ly,rx,ry;
+                pts[i]->getPositionAtTime(time, &x, &y);
+                pts[i]->getLeftBezierPointAtTime(time, &lx, &ly);
+                pts[i]->getRightBezierPointAtTime(time, &rx, &ry);
+                hash.append(x);
+                hash.append(y);
+                hash.append(lx);
+                hash.append(ly);
+                hash.append(rx);
+                hash.append(ry);
+            }
+        }
+    }
+    hash.append( getOpacity(time) );
+    hash.append( getFeatherDistance(time) );
+    hash.append( getFeatherFallOff(time) );
+#ifdef NATRON_ROTO_INVERTIBLE
+    hash.append( getInverted(time) );
+#endif
+    double color[3];
+    getColor(time, color);
+    for (int i = 0; i < 3; ++i) {
+        hash.append(color[i]);
+    }
+    hash.computeHash();
+
+    return hash.value();
+}
+
 const std::list< boost::shared_ptr<BezierCP> > &
 Bezier::getControlPoints() const
 {
@@ -3389,12 +3723,13 @@ Bezier::isNearbyControlPoint(double x,
     ///only called on the main-thread
     assert( QThread::currentThread() == qApp->thread() );
     int time = getContext()->getTimelineCurrentTime();
+    boost::shared_ptr<BezierSpatialIndex> spatialIndex = getSpatialIndex(time);
     QMutexLocker l(&itemMutex);
     boost::shared_ptr<BezierCP> cp,fp;
 
     switch (pref) {
     case eControlPointSelectionPrefFeatherFirst: {
-        BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(x, y, acceptance, time, index);
+        BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(*spatialIndex, x, y, acceptance, index);
         if ( itF != _imp->featherPoints.end() ) {
             fp = *itF;
             BezierCPs::const_iterator it = _imp->points.begin();
@@ -3403,7 +3738,7 @@ Bezier::isNearbyControlPoint(double x,
 
             return std::make_pair(fp, cp);
         } else {
-            BezierCPs::const_iterator it = _imp->findControlPointNearby(x, y, acceptance, time, index);
+            BezierCPs::const_iterator it = _imp->findControlPointNearby(*spatialIndex, x, y, acceptance, index);
             if ( it != _imp->points.end() ) {
                 cp = *it;
                 itF = _imp->featherPoints.begin();
@@ -3418,7 +3753,7 @@ Bezier::isNearbyControlPoint(double x,
     case eControlPointSelectionPrefControlPointFirst:
     case eControlPointSelectionPrefWhateverFirst:
     default: {
-        BezierCPs::const_iterator it = _imp->findControlPointNearby(x, y, acceptance, time, index);
+        BezierCPs::const_iterator it = _imp->findControlPointNearby(*spatialIndex, x, y, acceptance, index);
         if ( it != _imp->points.end() ) {
             cp = *it;
             BezierCPs::const_iterator itF = _imp->featherPoints.begin();
@@ -3427,7 +3762,7 @@ Bezier::isNearbyControlPoint(double x,
 
             return std::make_pair(cp, fp);
         } else {
-            BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(x, y, acceptance, time, index);
+            BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(*spatialIndex, x, y, acceptance, index);
             if ( itF != _imp->featherPoints.end() ) {
                 fp = *itF;
                 it = _imp->points.begin();
@@ -3527,48 +3862,48 @@ Bezier::controlPointsWithinRect(double l,
 
     ///only called on the main-thread
     assert( QThread::currentThread() == qApp->thread() );
-    QMutexLocker locker(&itemMutex);
     int time = getContext()->getTimelineCurrentTime();
-    int i = 0;
-    if ( (mode == 0) || (mode == 1) ) {
-        for (BezierCPs::const_iterator it = _imp->points.begin(); it != _imp->points.end(); ++it,++i) {
-            double x,y;
-            (*it)->getPositionAtTime(time, &x, &y);
-            if ( ( x >= (l - acceptance) ) && ( x <= (r + acceptance) ) && ( y >= (b - acceptance) ) && ( y <= (t - acceptance) ) ) {
-                std::pair<boost::shared_ptr<BezierCP>,boost::shared_ptr<BezierCP> > p;
-                p.first = *it;
-                BezierCPs::const_iterator itF = _imp->featherPoints.begin();
-                std::advance(itF, i);
-                p.second = *itF;
-                ret.push_back(p);
-            }
+    boost::shared_ptr<BezierSpatialIndex> spatialIndex = getSpatialIndex(time);
+    std::vector<int> candidates;
+    spatialIndex->getPointsInRect(RectD(l - acceptance, b - acceptance, r + acceptance, t + acceptance), &candidates);
+
+    QMutexLocker locker(&itemMutex);
+    const BezierPolylines & polylines = *spatialIndex->polylines;
+    int nbCps = std::min( (int)polylines.controlPoints.size(), (int)_imp->points.size() );
+
+    ///candidates are sorted: control points come first, then feather points
+    for (std::size_t c = 0; c < candidates.size(); ++c) {
+        bool isFeather = candidates[c] >= (int)polylines.controlPoints.size();
+        int i = isFeather ? candidates[c] - (int)polylines.controlPoints.size() : candidates[c];
+        if ( (i >= nbCps) || ( isFeather && (mode == 1) ) || ( !isFeather && (mode == 2) ) ) {
+            continue;
         }
-    }
-    i = 0;
-    if ( (mode == 0) || (mode == 2) ) {
-        for (BezierCPs::const_iterator it = _imp->featherPoints.begin(); it != _imp->featherPoints.end(); ++it,++i) {
-            double x,y;
-            (*it)->getPositionAtTime(time, &x, &y);
-            if ( ( x >= (l - acceptance) ) && ( x <= (r + acceptance) ) && ( y >= (b - acceptance) ) && ( y <= (t - acceptance) ) ) {
-                std::pair<boost::shared_ptr<BezierCP>,boost::shared_ptr<BezierCP> > p;
-                p.first = *it;
-                BezierCPs::const_iterator itF = _imp->points.begin();
-                std::advance(itF, i);
-                p.second = *itF;
+        const Point & pos = isFeather ? polylines.featherControlPoints[i] : polylines.controlPoints[i];
+        if ( ( pos.x >= (l - acceptance) ) && ( pos.x <= (r + acceptance) ) && ( pos.y >= (b - acceptance) ) && ( pos.y <= (t + acceptance) ) ) {
+            BezierCPs::const_iterator itCp = _imp->points.begin();
+            std::advance(itCp, i);
+            BezierCPs::const_iterator itF = _imp->featherPoints.begin();
+            std::advance(itF, i);
 
+            std::pair<boost::shared_ptr<BezierCP>,boost::shared_ptr<BezierCP> > p;
+            p.first = isFeather ? *itF : *itCp;
+            p.second = isFeather ? *itCp : *itF;
+
+            if (isFeather) {
                 ///avoid duplicates
                 bool found = false;
                 for (std::list< std::pair<boost::shared_ptr<BezierCP>,boost::shared_ptr<BezierCP> > >::iterator it2 = ret.begin();
                      it2 != ret.end(); ++it2) {
-                    if (it2->first == *itF) {
+                    if (it2->first == *itCp) {
                         found = true;
                         break;
                     }
                 }
-                if (!found) {
-                    ret.push_back(p);
+                if (found) {
+                    continue;
                 }
             }
+            ret.push_back(p);
         }
     }
 
@@ -3861,7 +4196,7 @@ point_line_intersection(const Point &p1,
  */
 bool
 Bezier::pointInPolygon(const Point & p,
-                       const std::list<Point> & polygon,
+                       const std::vector<Point> & polygon,
                        const RectD & featherPolyBBox,
                        FillRuleEnum rule)
 {
@@ -3872,9 +4207,9 @@ Bezier::pointInPolygon(const Point & p,
     }
 
     int winding_number = 0;
-    std::list<Point>::const_iterator last_pt = polygon.begin();
-    std::list<Point>::const_iterator last_start = last_pt;
-    std::list<Point>::const_iterator cur = last_pt;
+    std::vector<Point>::const_iterator last_pt = polygon.begin();
+    std::vector<Point>::const_iterator last_start = last_pt;
+    std::vector<Point>::const_iterator cur = last_pt;
     ++cur;
     for (; cur != polygon.end(); ++cur,++last_pt) {
         point_line_intersection(*last_pt, *cur, p, &winding_number);
@@ -3905,7 +4240,7 @@ Point
 Bezier::expandToFeatherDistance(const Point & cp, //< the point
                                 Point* fp, //< the feather point
                                 double featherDistance, //< feather distance
-                                const std::list<Point> & featherPolygon, //< the polygon of the bezier
+                                const std::vector<Point> & featherPolygon, //< the polygon of the bezier
                                 const RectD & featherPolyBBox, //< helper to speed-up pointInPolygon computations
                                 int time, //< time
                                 BezierCPs::const_iterator prevFp, //< iterator pointing to the feather before curFp
@@ -4408,24 +4743,34 @@ RotoContext::isNearbyBezier(double x,
     ///MT-safe: only called on the main-thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    QMutexLocker l(&_imp->rotoContextMutex);
-    for (std::list< boost::shared_ptr<RotoLayer> >::const_iterator it = _imp->layers.begin(); it != _imp->layers.end(); ++it) {
-        const RotoItems & items = (*it)->getItems();
-        for (RotoItems::const_iterator it2 = items.begin(); it2 != items.end(); ++it2) {
-            boost::shared_ptr<Bezier> b = boost::dynamic_pointer_cast<Bezier>(*it2);
-            if (b && !b->isLockedRecursive()) {
-                double param;
-                int i = b->isPointOnCurve(x, y, acceptance, &param,feather);
-                if (i != -1) {
-                    *index = i;
-                    *t = param;
-
-                    return b;
+    ///The hit-test validates the spatial index of each bezier against the age of the context: do not hold the context mutex
+    std::list< boost::shared_ptr<Bezier> > beziers;
+    {
+        QMutexLocker l(&_imp->rotoContextMutex);
+        for (std::list< boost::shared_ptr<RotoLayer> >::const_iterator it = _imp->layers.begin(); it != _imp->layers.end(); ++it) {
+            const RotoItems & items = (*it)->getItems();
+            for (RotoItems::const_iterator it2 = items.begin(); it2 != items.end(); ++it2) {
+                boost::shared_ptr<Bezier> b = boost::dynamic_pointer_cast<Bezier>(*it2);
+                if (b) {
+                    beziers.push_back(b);
                 }
             }
         }
     }
 
+    for (std::list< boost::shared_ptr<Bezier> >::const_iterator it = beziers.begin(); it != beziers.end(); ++it) {
+        if ( !(*it)->isLockedRecursive() ) {
+            double param;
+            int i = (*it)->isPointOnCurve(x, y, acceptance, &param,feather);
+            if (i != -1) {
+                *index = i;
+                *t = param;
+
+                return *it;
+            }
+        }
+    }
+
     return boost::shared_ptr<Bezier>();
 }
 
@@ -5458,51 +5803,60 @@ RotoContext::renderMask(bool useCache,
     RectI clippedRoI;
     roi.intersect(pixelRod, &clippedRoI);
 
-    cairo_format_t cairoImgFormat;
-    
-    if (components.getNumComponents() == 1) {
-        cairoImgFormat = CAIRO_FORMAT_A8;
-    } else if (components.getNumComponents() == 3) {
-        cairoImgFormat = CAIRO_FORMAT_RGB24;
-    } else if (components.getNumComponents() == 4) {
-        cairoImgFormat = CAIRO_FORMAT_ARGB32;
-    } else {
-        cairoImgFormat = CAIRO_FORMAT_A8;
-    }
+    ///Only render the part of the RoI that is not already in the cached mask
+    RectI renderWindow = image->getMinimalRect(clippedRoI);
+    if ( !renderWindow.isNull() ) {
+        cairo_format_t cairoImgFormat;
+
+        if (components.getNumComponents() == 1) {
+            cairoImgFormat = CAIRO_FORMAT_A8;
+        } else if (components.getNumComponents() == 3) {
+            cairoImgFormat = CAIRO_FORMAT_RGB24;
+        } else if (components.getNumComponents() == 4) {
+            cairoImgFormat = CAIRO_FORMAT_ARGB32;
+        } else {
+            cairoImgFormat = CAIRO_FORMAT_A8;
+        }
 
-    ////Allocate the cairo temporary buffer
-    cairo_surface_t* cairoImg = cairo_image_surface_create(cairoImgFormat, pixelRod.width(), pixelRod.height() );
-    cairo_surface_set_device_offset(cairoImg, -pixelRod.x1, -pixelRod.y1);
-    if (cairo_surface_status(cairoImg) != CAIRO_STATUS_SUCCESS) {
-        appPTR->removeFromNodeCache(image);
+        ////Allocate the cairo temporary buffer
+        cairo_surface_t* cairoImg = cairo_image_surface_create(cairoImgFormat, renderWindow.width(), renderWindow.height() );
+        cairo_surface_set_device_offset(cairoImg, -renderWindow.x1, -renderWindow.y1);
+        if (cairo_surface_status(cairoImg) != CAIRO_STATUS_SUCCESS) {
+            appPTR->removeFromNodeCache(image);
 
-        return image;
-    }
-    cairo_t* cr = cairo_create(cairoImg);
-    //cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD); // creates holes on self-overlapping shapes
-    cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+            return image;
+        }
+        cairo_t* cr = cairo_create(cairoImg);
+        //cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD); // creates holes on self-overlapping shapes
+        cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
 
-    ///We could also propose the user to render a mask to SVG
-    _imp->renderInternal(cr, cairoImg, splines,mipmapLevel,time);
+        ///Shapes are clipped to the RoD of the node rather than to the RoI so that their cached
+        ///rasterization does not depend on the RoI
+        RectI shapesRoD;
+        nodeRoD.toPixelEnclosing(mipmapLevel, 1., &shapesRoD);
 
-    switch (depth) {
-    case Natron::eImageBitDepthFloat:
-        convertCairoImageToNatronImage<float, 1>(cairoImg, image.get(), pixelRod);
-        break;
-    case Natron::eImageBitDepthByte:
-        convertCairoImageToNatronImage<unsigned char, 255>(cairoImg, image.get(), pixelRod);
-        break;
-    case Natron::eImageBitDepthShort:
-        convertCairoImageToNatronImage<unsigned short, 65535>(cairoImg, image.get(), pixelRod);
-        break;
-    case Natron::eImageBitDepthNone:
-        assert(false);
-        break;
-    }
+        ///We could also propose the user to render a mask to SVG
+        _imp->renderInternal(cr, cairoImg, splines, shapesRoD, renderWindow, mipmapLevel, time, view);
 
-    cairo_destroy(cr);
-    ////Free the buffer used by Cairo
-    cairo_surface_destroy(cairoImg);
+        switch (depth) {
+        case Natron::eImageBitDepthFloat:
+            convertCairoImageToNatronImage<float, 1>(cairoImg, image.get(), renderWindow);
+            break;
+        case Natron::eImageBitDepthByte:
+            convertCairoImageToNatronImage<unsigned char, 255>(cairoImg, image.get(), renderWindow);
+            break;
+        case Natron::eImageBitDepthShort:
+            convertCairoImageToNatronImage<unsigned short, 65535>(cairoImg, image.get(), renderWindow);
+            break;
+        case Natron::eImageBitDepthNone:
+            assert(false);
+            break;
+        }
+
+        cairo_destroy(cr);
+        ////Free the buffer used by Cairo
+        cairo_surface_destroy(cairoImg);
+    }
 
 
     ////////////////////////////////////
@@ -5526,284 +5880,434 @@ void
 RotoContextPrivate::renderInternal(cairo_t* cr,
                                    cairo_surface_t* cairoImg,
                                    const std::list< boost::shared_ptr<Bezier> > & splines,
+                                   const RectI & shapesRoD,
+                                   const RectI & renderWindow,
                                    unsigned int mipmapLevel,
-                                   int time)
+                                   int time,
+                                   int view)
 {
-    // these Roto shapes must be rendered WITHOUT antialias, or the junction between the inner
-    // polygon and the feather zone will have artifacts. This is partly due to the fact that cairo
-    // meshes are not antialiased.
-    // Use a default feather distance of 1 pixel instead!
-    // UPDATE: unfortunately, this produces less artifacts, but there are still some remaining (use opacity=0.5 to test)
-    // maybe the inner polygon should be made of mesh patterns too?
-    cairo_set_antialias(cr, CAIRO_ANTIALIAS_NONE);
+    ///Each shape is rasterized on its own image which is kept in the node cache. Editing one shape
+    ///only re-renders that shape, the others are just composited again.
+    ///A8 masks are made of A8 shapes, otherwise shapes need an alpha channel to be composited (even in RGB24).
+    cairo_format_t shapeFormat = cairo_image_surface_get_format(cairoImg) == CAIRO_FORMAT_A8 ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_ARGB32;
+
     for (std::list<boost::shared_ptr<Bezier> >::const_iterator it2 = splines.begin(); it2 != splines.end(); ++it2) {
         ///render the bezier only if finished (closed) and activated
         if ( !(*it2)->isCurveFinished() || !(*it2)->isActivated(time) || ( (*it2)->getControlPointsCount() <= 1 ) ) {
             continue;
         }
 
+        boost::shared_ptr<Natron::Image> shape = getOrRenderShape(*it2, shapeFormat, shapesRoD, renderWindow, mipmapLevel, time, view);
+        if (!shape) {
+            continue;
+        }
+
+        ///Only the part of the shape intersecting renderWindow is rendered, which is all cairoImg covers
+        Natron::Image::ReadAccess acc = shape->getReadRights();
+        cairo_surface_t* shapeSurface = createShapeSurface(shape.get(), shapeFormat, acc.pixelAt( shape->getBounds().x1, shape->getBounds().y1 ) );
+        if (!shapeSurface) {
+            continue;
+        }
+        cairo_set_operator(cr, (cairo_operator_t)(*it2)->getCompositingOperator());
+        cairo_set_source_surface(cr, shapeSurface, 0., 0.);
+        cairo_paint(cr);
+        ///The source holds a reference to the surface, release it before the image is unlocked
+        cairo_set_source_rgba(cr, 0., 0., 0., 0.);
+        cairo_surface_destroy(shapeSurface);
+    } // foreach(splines)
+    assert(cairo_surface_status(cairoImg) == CAIRO_STATUS_SUCCESS);
+
+    ///A call to cairo_surface_flush() is required before accessing the pixel data
+    ///to ensure that all pending drawing operations are finished.
+    cairo_surface_flush(cairoImg);
+} // renderInternal
+
+cairo_surface_t*
+RotoContextPrivate::createShapeSurface(const Natron::Image* shape,
+                                       cairo_format_t format,
+                                       const unsigned char* data)
+{
+    const RectI & bounds = shape->getBounds();
+    int stride = bounds.width() * (int)shape->getComponentsCount();
+
+    assert( stride == cairo_format_stride_for_width( format, bounds.width() ) );
+    cairo_surface_t* surface = cairo_image_surface_create_for_data(const_cast<unsigned char*>(data), format, bounds.width(), bounds.height(), stride);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+
+        return 0;
+    }
+    cairo_surface_set_device_offset(surface, -bounds.x1, -bounds.y1);
+
+    return surface;
+}
 
-        double fallOff = (*it2)->getFeatherFallOff(time);
-        double fallOffInverse = 1. / fallOff;
-        double featherDist = (*it2)->getFeatherDistance(time);
-        double opacity = (*it2)->getOpacity(time);
+boost::shared_ptr<Natron::Image>
+RotoContextPrivate::getOrRenderShape(const boost::shared_ptr<Bezier> & bezier,
+                                     cairo_format_t format,
+                                     const RectI & shapesRoD,
+                                     const RectI & renderWindow,
+                                     unsigned int mipmapLevel,
+                                     int time,
+                                     int view)
+{
+    RectI bounds;
 #ifdef NATRON_ROTO_INVERTIBLE
-        bool inverted = (*it2)->getInverted(time);
+    bool inverted = bezier->getInverted(time);
 #else
-        const bool inverted = false;
+    const bool inverted = false;
 #endif
-        int operatorIndex = (*it2)->getCompositingOperator();
-        double shapeColor[3];
-        (*it2)->getColor(time, shapeColor);
+    if (inverted) {
+        bounds = shapesRoD;
+    } else {
+        RectI shapeBounds;
+        bezier->getBoundingBox(time).toPixelEnclosing(mipmapLevel, 1., &shapeBounds);
+        ///the feather mesh is not antialiased but may still touch the pixels on the edges
+        shapeBounds.x1 -= 1;
+        shapeBounds.y1 -= 1;
+        shapeBounds.x2 += 1;
+        shapeBounds.y2 += 1;
+        if ( !shapeBounds.intersect(shapesRoD, &bounds) ) {
+            return boost::shared_ptr<Natron::Image>();
+        }
+    }
+    RectI shapeWindow;
+    if ( !bounds.intersect(renderWindow, &shapeWindow) ) {
+        return boost::shared_ptr<Natron::Image>();
+    }
+
+    ///The rows of the image are used as the rows of a cairo surface, which must be aligned on 4 bytes
+    if (format == CAIRO_FORMAT_A8) {
+        bounds.x2 = bounds.x1 + ( (bounds.width() + 3) & ~3 );
+    }
+
+    ///The hash already covers everything the rasterization depends on at this time and mipmap level. The time is only
+    ///part of the key for animated shapes, so that a shape that does not move is re-used across frames.
+    Natron::ImageKey key = Natron::Image::makeKey(bezier->computeRenderHash(time, mipmapLevel), bezier->getKeyframesCount() > 0, time, view);
+    RectD rod;
+    bounds.toCanonical_noClipping(mipmapLevel, 1., &rod);
+    boost::shared_ptr<Natron::ImageParams> params = Natron::Image::makeParams(0,
+                                                                              rod,
+                                                                              bounds,
+                                                                              1., // par
+                                                                              mipmapLevel,
+                                                                              false,
+                                                                              format == CAIRO_FORMAT_A8 ?
+                                                                              Natron::ImageComponents::getAlphaComponents() :
+                                                                              Natron::ImageComponents::getRGBAComponents(),
+                                                                              Natron::eImageBitDepthByte,
+                                                                              std::map<int,std::map<int, std::vector<RangeD> > >() );
+    boost::shared_ptr<Natron::Image> shape;
+    Natron::getImageFromCacheOrCreate(key, params, &shape);
+    if (!shape) {
+        return shape;
+    }
+    ///Does nothing if the image is already allocated
+    shape->allocateMemory();
+
+    ///Another tile may already have rendered a part of the window
+    std::list<RectI> rectsToRender;
+    shape->getRestToRender(shapeWindow, rectsToRender);
+    if ( rectsToRender.empty() ) {
+        return shape;
+    }
 
-        cairo_set_operator(cr, (cairo_operator_t)operatorIndex);
+    {
+        Natron::Image::WriteAccess acc = shape->getWriteRights();
+        cairo_surface_t* surface = createShapeSurface(shape.get(), format, acc.pixelAt(bounds.x1, bounds.y1) );
+        if (!surface) {
+            return boost::shared_ptr<Natron::Image>();
+        }
+        for (std::list<RectI>::iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
+            cairo_t* cr = cairo_create(surface);
+            //cairo_set_fill_rule(cr, CAIRO_FILL_RULE_EVEN_ODD); // creates holes on self-overlapping shapes
+            cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+            cairo_rectangle(cr, it->x1, it->y1, it->width(), it->height() );
+            cairo_clip(cr);
+            cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+            cairo_paint(cr);
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+            renderShape(cr, surface, bezier, mipmapLevel, time);
+            cairo_destroy(cr);
+        }
+        assert(cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS);
+        cairo_surface_flush(surface);
+        cairo_surface_destroy(surface);
+    }
+    for (std::list<RectI>::iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
+        shape->markForRendered(*it);
+    }
 
-        BezierCPs cps = (*it2)->getControlPoints_mt_safe();
-#pragma message WARN("Roto TODO: use featherPointsAtDistance")
-        // BUG https://github.com/MrKepzie/Natron/issues/145 : the feather Bezier must be moved by featherdistance before RoD computation!
-        BezierCPs fps = (*it2)->getFeatherPoints_mt_safe();
+    return shape;
+}
 
-        assert( cps.size() == fps.size() );
+void
+RotoContextPrivate::renderShape(cairo_t* cr,
+                                cairo_surface_t* cairoImg,
+                                const boost::shared_ptr<Bezier> & bezier,
+                                unsigned int mipmapLevel,
+                                int time)
+{
+    // these Roto shapes must be rendered WITHOUT antialias, or the junction between the inner
+    // polygon and the feather zone will have artifacts. This is partly due to the fact that cairo
+    // meshes are not antialiased.
+    // Use a default feather distance of 1 pixel instead!
+    // UPDATE: unfortunately, this produces less artifacts, but there are still some remaining (use opacity=0.5 to test)
+    // maybe the inner polygon should be made of mesh patterns too?
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_NONE);
 
-        if ( cps.empty() ) {
-            continue;
-        }
+    double fallOff = bezier->getFeatherFallOff(time);
+    double fallOffInverse = 1. / fallOff;
+    double featherDist = bezier->getFeatherDistance(time);
+    double opacity = bezier->getOpacity(time);
+#ifdef NATRON_ROTO_INVERTIBLE
+    bool inverted = bezier->getInverted(time);
+#else
+    const bool inverted = false;
+#endif
+    double shapeColor[3];
+    bezier->getColor(time, shapeColor);
 
-        cairo_new_path(cr);
+    ///The shape is drawn alone on its own surface, its compositing operator is applied when
+    ///compositing it with the other shapes
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
-        ////Define the feather edge pattern
-        cairo_pattern_t* mesh = cairo_pattern_create_mesh();
-        if (cairo_pattern_status(mesh) != CAIRO_STATUS_SUCCESS) {
-            cairo_pattern_destroy(mesh);
-            continue;
-        }
+    BezierCPs cps = bezier->getControlPoints_mt_safe();
+#pragma message WARN("Roto TODO: use featherPointsAtDistance")
+    // BUG https://github.com/MrKepzie/Natron/issues/145 : the feather Bezier must be moved by featherdistance before RoD computation!
+    BezierCPs fps = bezier->getFeatherPoints_mt_safe();
 
-        ///Adjust the feather distance so it takes the mipmap level into account
-        if (mipmapLevel != 0) {
-            featherDist /= (1 << mipmapLevel);
-        }
+    assert( cps.size() == fps.size() );
 
-#pragma message WARN("the following code very stange. Why evaluate 49 Bezier points when you only need to consider the end points?")
-        // PLEASE EXPLAIN THAT ``ALGORITHM''
+    if ( cps.empty() ) {
+        return;
+    }
 
-        ///here is the polygon of the feather bezier
-        ///This is used only if the feather distance is different of 0 and the feather points equal
-        ///the control points in order to still be able to apply the feather distance.
-        std::list<Point> featherPolygon;
-        std::list<Point> bezierPolygon;
-        RectD featherPolyBBox( std::numeric_limits<double>::infinity(),
-                               std::numeric_limits<double>::infinity(),
-                               -std::numeric_limits<double>::infinity(),
-                               -std::numeric_limits<double>::infinity() );
+    cairo_new_path(cr);
 
-        (*it2)->evaluateFeatherPointsAtTime_DeCasteljau(time, mipmapLevel, 50, true, &featherPolygon, &featherPolyBBox);
-        (*it2)->evaluateAtTime_DeCasteljau(time, mipmapLevel, 50, &bezierPolygon, NULL);
+    ////Define the feather edge pattern
+    cairo_pattern_t* mesh = cairo_pattern_create_mesh();
+    if (cairo_pattern_status(mesh) != CAIRO_STATUS_SUCCESS) {
+        cairo_pattern_destroy(mesh);
 
+        return;
+    }
 
-        assert( !featherPolygon.empty() );
+    ///Adjust the feather distance so it takes the mipmap level into account
+    if (mipmapLevel != 0) {
+        featherDist /= (1 << mipmapLevel);
+    }
 
-        std::list<Point> featherContour;
-        std::list<Point>::iterator cur = featherPolygon.begin();
-        std::list<Point>::iterator next = cur;
-        ++next;
-        std::list<Point>::iterator prev = featherPolygon.end();
-        --prev;
-        std::list<Point>::iterator bezIT = bezierPolygon.begin();
-        std::list<Point>::iterator prevBez = bezierPolygon.end();
-        --prevBez;
-        double absFeatherDist = std::abs(featherDist);
-        Point p1 = *cur;
-        double norm = sqrt( (next->x - prev->x) * (next->x - prev->x) + (next->y - prev->y) * (next->y - prev->y) );
-        assert(norm != 0);
-        double dx = -( (next->y - prev->y) / norm );
-        double dy = ( (next->x - prev->x) / norm );
-        p1.x = cur->x + dx;
-        p1.y = cur->y + dy;
+#pragma message WARN("the following code very stange. Why evaluate 49 Bezier points when you only need to consider the end points?")
+    // PLEASE EXPLAIN THAT ``ALGORITHM''
+
+    ///here is the polygon of the feather bezier
+    ///This is used only if the feather distance is different of 0 and the feather points equal
+    ///the control points in order to still be able to apply the feather distance.
+    ///Both polygons have the same number of points per segment.
+    boost::shared_ptr<BezierPolylines> polylines = bezier->getPolylinesAtTime(time, mipmapLevel);
+    const std::vector<Point> & featherPolygon = polylines->featherPoints;
+    const std::vector<Point> & bezierPolygon = polylines->points;
+    const RectD & featherPolyBBox = polylines->featherBBox;
+
+    assert( !featherPolygon.empty() && featherPolygon.size() == bezierPolygon.size() );
+
+    std::list<Point> featherContour;
+    std::vector<Point>::const_iterator cur = featherPolygon.begin();
+    std::vector<Point>::const_iterator next = cur;
+    ++next;
+    std::vector<Point>::const_iterator prev = featherPolygon.end();
+    --prev;
+    std::vector<Point>::const_iterator bezIT = bezierPolygon.begin();
+    std::vector<Point>::const_iterator prevBez = bezierPolygon.end();
+    --prevBez;
+    double absFeatherDist = std::abs(featherDist);
+    Point p1 = *cur;
+    double norm = sqrt( (next->x - prev->x) * (next->x - prev->x) + (next->y - prev->y) * (next->y - prev->y) );
+    assert(norm != 0);
+    double dx = -( (next->y - prev->y) / norm );
+    double dy = ( (next->x - prev->x) / norm );
+    p1.x = cur->x + dx;
+    p1.y = cur->y + dy;
 
 
 #pragma message WARN("pointInPolygon should not be used, see comment")
-        /*
-           The pointInPolygon function should not be used.
-           The algorithm to know which side is the outside of a polygon consists in computing the global polygon orientation.
-           To compute the orientation, compute its surface. If positive the polygon is clockwise, if negative it's counterclockwise.
-           to compute the surface, take the starting point of the polygon, and imagine a fan made of all the triangles
-           pointing at this point. The surface of a tringle is half the cross-product of two of its sides issued from
-           the same point (the starting point of the polygon, in this case.
-           The orientation of a polygon has to be computed only once for each modification of the polygon (whenever it's edited), and
-           should be stored with the polygon.
-           Of course an 8-shaped polygon doesn't have an outside, but it still has an orientation. The feather direction
-           should follow this orientation.
-         */
-        bool inside = Bezier::pointInPolygon(p1, featherPolygon,featherPolyBBox,Bezier::eFillRuleOddEven);
-        if ( ( !inside && (featherDist < 0) ) || ( inside && (featherDist > 0) ) ) {
-            p1.x = cur->x - dx * absFeatherDist;
-            p1.y = cur->y - dy * absFeatherDist;
-        } else {
-            p1.x = cur->x + dx * absFeatherDist;
-            p1.y = cur->y + dy * absFeatherDist;
-        }
+    /*
+       The pointInPolygon function should not be used.
+       The algorithm to know which side is the outside of a polygon consists in computing the global polygon orientation.
+       To compute the orientation, compute its surface. If positive the polygon is clockwise, if negative it's counterclockwise.
+       to compute the surface, take the starting point of the polygon, and imagine a fan made of all the triangles
+       pointing at this point. The surface of a tringle is half the cross-product of two of its sides issued from
+       the same point (the starting point of the polygon, in this case.
+       The orientation of a polygon has to be computed only once for each modification of the polygon (whenever it's edited), and
+       should be stored with the polygon.
+       Of course an 8-shaped polygon doesn't have an outside, but it still has an orientation. The feather direction
+       should follow this orientation.
+     */
+    bool inside = Bezier::pointInPolygon(p1, featherPolygon,featherPolyBBox,Bezier::eFillRuleOddEven);
+    if ( ( !inside && (featherDist < 0) ) || ( inside && (featherDist > 0) ) ) {
+        p1.x = cur->x - dx * absFeatherDist;
+        p1.y = cur->y - dy * absFeatherDist;
+    } else {
+        p1.x = cur->x + dx * absFeatherDist;
+        p1.y = cur->y + dy * absFeatherDist;
+    }
 
-        Point origin = p1;
-        featherContour.push_back(p1);
+    Point origin = p1;
+    featherContour.push_back(p1);
 
-        ++prev; ++next; ++cur; ++bezIT; ++prevBez;
+    ++prev; ++next; ++cur; ++bezIT; ++prevBez;
 
-        for (;; ++prev,++cur,++next,++bezIT,++prevBez) { // for each point in polygon
-            if ( next == featherPolygon.end() ) {
-                next = featherPolygon.begin();
-            }
-            if ( prev == featherPolygon.end() ) {
-                prev = featherPolygon.begin();
-            }
-            if ( bezIT == bezierPolygon.end() ) {
-                bezIT = bezierPolygon.begin();
-            }
-            if ( prevBez == bezierPolygon.end() ) {
-                prevBez = bezierPolygon.begin();
-            }
-            bool mustStop = false;
-            if ( cur == featherPolygon.end() ) {
-                mustStop = true;
-                cur = featherPolygon.begin();
-            }
+    for (;; ++prev,++cur,++next,++bezIT,++prevBez) { // for each point in polygon
+        if ( next == featherPolygon.end() ) {
+            next = featherPolygon.begin();
+        }
+        if ( prev == featherPolygon.end() ) {
+            prev = featherPolygon.begin();
+        }
+        if ( bezIT == bezierPolygon.end() ) {
+            bezIT = bezierPolygon.begin();
+        }
+        if ( prevBez == bezierPolygon.end() ) {
+            prevBez = bezierPolygon.begin();
+        }
+        bool mustStop = false;
+        if ( cur == featherPolygon.end() ) {
+            mustStop = true;
+            cur = featherPolygon.begin();
+        }
 
-            ///skip it
-            if ( (cur->x == prev->x) && (cur->y == prev->y) ) {
-                continue;
-            }
+        ///skip it
+        if ( (cur->x == prev->x) && (cur->y == prev->y) ) {
+            continue;
+        }
 
-            Point p0, p0p1, p1p0, p2, p2p3, p3p2, p3;
-            p0.x = prevBez->x;
-            p0.y = prevBez->y;
-            p3.x = bezIT->x;
-            p3.y = bezIT->y;
+        Point p0, p0p1, p1p0, p2, p2p3, p3p2, p3;
+        p0.x = prevBez->x;
+        p0.y = prevBez->y;
+        p3.x = bezIT->x;
+        p3.y = bezIT->y;
 
-            if (!mustStop) {
-                norm = sqrt( (next->x - prev->x) * (next->x - prev->x) + (next->y - prev->y) * (next->y - prev->y) );
-                assert(norm != 0);
-                dx = -( (next->y - prev->y) / norm );
-                dy = ( (next->x - prev->x) / norm );
-                p2.x = cur->x + dx;
-                p2.y = cur->y + dy;
+        if (!mustStop) {
+            norm = sqrt( (next->x - prev->x) * (next->x - prev->x) + (next->y - prev->y) * (next->y - prev->y) );
+            assert(norm != 0);
+            dx = -( (next->y - prev->y) / norm );
+            dy = ( (next->x - prev->x) / norm );
+            p2.x = cur->x + dx;
+            p2.y = cur->y + dy;
 
 #pragma message WARN("pointInPolygon should not be used, see comment")
-                /*
-                   The pointInPolygon function should not be used.
-                   The algorithm to know which side is the outside of a polygon consists in computing the global polygon orientation.
-                   To compute the orientation, compute its surface. If positive the polygon is clockwise, if negative it's counterclockwise.
-                   to compute the surface, take the starting point of the polygon, and imagine a fan made of all the triangles
-                   pointing at this point. The surface of a tringle is half the cross-product of two of its sides issued from
-                   the same point (the starting point of the polygon, in this case.
-                   The orientation of a polygon has to be computed only once for each modification of the polygon (whenever it's edited), and
-                   should be stored with the polygon.
-                   Of course an 8-shaped polygon doesn't have an outside, but it still has an orientation. The feather direction
-                   should follow this orientation.
-                 */
-                inside = Bezier::pointInPolygon(p2, featherPolygon, featherPolyBBox,Bezier::eFillRuleOddEven);
-                if ( ( !inside && (featherDist < 0) ) || ( inside && (featherDist > 0) ) ) {
-                    p2.x = cur->x - dx * absFeatherDist;
-                    p2.y = cur->y - dy * absFeatherDist;
-                } else {
-                    p2.x = cur->x + dx * absFeatherDist;
-                    p2.y = cur->y + dy * absFeatherDist;
-                }
+            /*
+               The pointInPolygon function should not be used.
+               The algorithm to know which side is the outside of a polygon consists in computing the global polygon orientation.
+               To compute the orientation, compute its surface. If positive the polygon is clockwise, if negative it's counterclockwise.
+               to compute the surface, take the starting point of the polygon, and imagine a fan made of all the triangles
+               pointing at this point. The surface of a tringle is half the cross-product of two of its sides issued from
+               the same point (the starting point of the polygon, in this case.
+               The orientation of a polygon has to be computed only once for each modification of the polygon (whenever it's edited), and
+               should be stored with the polygon.
+               Of course an 8-shaped polygon doesn't have an outside, but it still has an orientation. The feather direction
+               should follow this orientation.
+             */
+            inside = Bezier::pointInPolygon(p2, featherPolygon, featherPolyBBox,Bezier::eFillRuleOddEven);
+            if ( ( !inside && (featherDist < 0) ) || ( inside && (featherDist > 0) ) ) {
+                p2.x = cur->x - dx * absFeatherDist;
+                p2.y = cur->y - dy * absFeatherDist;
             } else {
-                p2 = origin;
-            }
-            featherContour.push_back(p2);
-
-            ///linear interpolation
-            p0p1.x = (p0.x * fallOff * 2. + fallOffInverse * p1.x) / (fallOff * 2. + fallOffInverse);
-            p0p1.y = (p0.y * fallOff * 2. + fallOffInverse * p1.y) / (fallOff * 2. + fallOffInverse);
-            p1p0.x = (p0.x * fallOff + 2. * fallOffInverse * p1.x) / (fallOff + 2. * fallOffInverse);
-            p1p0.y = (p0.y * fallOff + 2. * fallOffInverse * p1.y) / (fallOff + 2. * fallOffInverse);
-
-            p2p3.x = (p3.x * fallOff + 2. * fallOffInverse * p2.x) / (fallOff + 2. * fallOffInverse);
-            p2p3.y = (p3.y * fallOff + 2. * fallOffInverse * p2.y) / (fallOff + 2. * fallOffInverse);
-            p3p2.x = (p3.x * fallOff * 2. + fallOffInverse * p2.x) / (fallOff * 2. + fallOffInverse);
-            p3p2.y = (p3.y * fallOff * 2. + fallOffInverse * p2.y) / (fallOff * 2. + fallOffInverse);
-
-
-            ///move to the initial point
-            cairo_mesh_pattern_begin_patch(mesh);
-            cairo_mesh_pattern_move_to(mesh, p0.x, p0.y);
-            cairo_mesh_pattern_curve_to(mesh, p0p1.x, p0p1.y, p1p0.x, p1p0.y, p1.x, p1.y);
-            cairo_mesh_pattern_line_to(mesh, p2.x, p2.y);
-            cairo_mesh_pattern_curve_to(mesh, p2p3.x, p2p3.y, p3p2.x, p3p2.y, p3.x, p3.y);
-            cairo_mesh_pattern_line_to(mesh, p0.x, p0.y);
-            ///Set the 4 corners color
-            ///inner is full color
-
-            // IMPORTANT NOTE:
-            // The two sqrt below are due to a probable cairo bug.
-            // To check wether the bug is present is a given cairo version,
-            // make any shape with a very large feather and set
-            // opacity to 0.5. Then, zoom on the polygon border to check if the intensity is continuous
-            // and approximately equal to 0.5.
-            // If the bug if ixed in cairo, please use #if CAIRO_VERSION>xxx to keep compatibility with
-            // older Cairo versions.
-            cairo_mesh_pattern_set_corner_color_rgba( mesh, 0, shapeColor[0], shapeColor[1], shapeColor[2],
-                                                      std::sqrt(inverted ? 1. - opacity : opacity) );
-            ///outter is faded
-            cairo_mesh_pattern_set_corner_color_rgba(mesh, 1, shapeColor[0], shapeColor[1], shapeColor[2],
-                                                     inverted ? 1. : 0.);
-            cairo_mesh_pattern_set_corner_color_rgba(mesh, 2, shapeColor[0], shapeColor[1], shapeColor[2],
-                                                     inverted ? 1. : 0.);
-            ///inner is full color
-            cairo_mesh_pattern_set_corner_color_rgba( mesh, 3, shapeColor[0], shapeColor[1], shapeColor[2],
-                                                      std::sqrt(inverted ? 1. - opacity : opacity) );
-            assert(cairo_pattern_status(mesh) == CAIRO_STATUS_SUCCESS);
-
-            cairo_mesh_pattern_end_patch(mesh);
-
-            if (mustStop) {
-                break;
+                p2.x = cur->x + dx * absFeatherDist;
+                p2.y = cur->y + dy * absFeatherDist;
             }
+        } else {
+            p2 = origin;
+        }
+        featherContour.push_back(p2);
+
+        ///linear interpolation
+        p0p1.x = (p0.x * fallOff * 2. + fallOffInverse * p1.x) / (fallOff * 2. + fallOffInverse);
+        p0p1.y = (p0.y * fallOff * 2. + fallOffInverse * p1.y) / (fallOff * 2. + fallOffInverse);
+        p1p0.x = (p0.x * fallOff + 2. * fallOffInverse * p1.x) / (fallOff + 2. * fallOffInverse);
+        p1p0.y = (p0.y * fallOff + 2. * fallOffInverse * p1.y) / (fallOff + 2. * fallOffInverse);
+
+        p2p3.x = (p3.x * fallOff + 2. * fallOffInverse * p2.x) / (fallOff + 2. * fallOffInverse);
+        p2p3.y = (p3.y * fallOff + 2. * fallOffInverse * p2.y) / (fallOff + 2. * fallOffInverse);
+        p3p2.x = (p3.x * fallOff * 2. + fallOffInverse * p2.x) / (fallOff * 2. + fallOffInverse);
+        p3p2.y = (p3.y * fallOff * 2. + fallOffInverse * p2.y) / (fallOff * 2. + fallOffInverse);
+
+
+        ///move to the initial point
+        cairo_mesh_pattern_begin_patch(mesh);
+        cairo_mesh_pattern_move_to(mesh, p0.x, p0.y);
+        cairo_mesh_pattern_curve_to(mesh, p0p1.x, p0p1.y, p1p0.x, p1p0.y, p1.x, p1.y);
+        cairo_mesh_pattern_line_to(mesh, p2.x, p2.y);
+        cairo_mesh_pattern_curve_to(mesh, p2p3.x, p2p3.y, p3p2.x, p3p2.y, p3.x, p3.y);
+        cairo_mesh_pattern_line_to(mesh, p0.x, p0.y);
+        ///Set the 4 corners color
+        ///inner is full color
+
+        // IMPORTANT NOTE:
+        // The two sqrt below are due to a probable cairo bug.
+        // To check wether the bug is present is a given cairo version,
+        // make any shape with a very large feather and set
+        // opacity to 0.5. Then, zoom on the polygon border to check if the intensity is continuous
+        // and approximately equal to 0.5.
+        // If the bug if ixed in cairo, please use #if CAIRO_VERSION>xxx to keep compatibility with
+        // older Cairo versions.
+        cairo_mesh_pattern_set_corner_color_rgba( mesh, 0, shapeColor[0], shapeColor[1], shapeColor[2],
+                                                  std::sqrt(inverted ? 1. - opacity : opacity) );
+        ///outter is faded
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 1, shapeColor[0], shapeColor[1], shapeColor[2],
+                                                 inverted ? 1. : 0.);
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 2, shapeColor[0], shapeColor[1], shapeColor[2],
+                                                 inverted ? 1. : 0.);
+        ///inner is full color
+        cairo_mesh_pattern_set_corner_color_rgba( mesh, 3, shapeColor[0], shapeColor[1], shapeColor[2],
+                                                  std::sqrt(inverted ? 1. - opacity : opacity) );
+        assert(cairo_pattern_status(mesh) == CAIRO_STATUS_SUCCESS);
+
+        cairo_mesh_pattern_end_patch(mesh);
+
+        if (mustStop) {
+            break;
+        }
 
-            p1 = p2;
-        }  // for each point in polygon
+        p1 = p2;
+    }  // for each point in polygon
 
-        cairo_set_source_rgba(cr, shapeColor[0], shapeColor[1], shapeColor[2], opacity);
+    cairo_set_source_rgba(cr, shapeColor[0], shapeColor[1], shapeColor[2], opacity);
 
-        if (!inverted) {
-            // strangely, the above-mentioned cairo bug doesn't affect this function
-            renderInternalShape(time, mipmapLevel, cr, cps);
+    if (!inverted) {
+        // strangely, the above-mentioned cairo bug doesn't affect this function
+        renderInternalShape(time, mipmapLevel, cr, cps);
 #ifdef NATRON_ROTO_INVERTIBLE
-        } else {
+    } else {
 #pragma message WARN("doesn't work! the image should be infinite for this to work!")
-            // Doesn't work! the image should be infinite for this to work!
-            // Or at least it should contain the Union of the source RoDs.
-            // Here, it only contains the boinding box of the Bezier.
-            // If there's a transform after the roto node, a black border will appear.
-            // The only solution would be to have a color parameter which specifies how on image is outside of its RoD.
-            // Unfortunately, the OFX definition is: "it is black and transparent"
-
-            ///If inverted, draw an inverted rectangle on all the image first
-            // with a hole consisting of the feather polygon
-
-            double xOffset, yOffset;
-            cairo_surface_get_device_offset(cairoImg, &xOffset, &yOffset);
-            int width = cairo_image_surface_get_width(cairoImg);
-            int height = cairo_image_surface_get_height(cairoImg);
-
-            cairo_move_to(cr, -xOffset, -yOffset);
-            cairo_line_to(cr, -xOffset + width, -yOffset);
-            cairo_line_to(cr, -xOffset + width, -yOffset + height);
-            cairo_line_to(cr, -xOffset, -yOffset + height);
-            cairo_line_to(cr, -xOffset, -yOffset);
-            // strangely, the above-mentioned cairo bug doesn't affect this function
+        // Doesn't work! the image should be infinite for this to work!
+        // Or at least it should contain the Union of the source RoDs.
+        // Here, it only contains the boinding box of the Bezier.
+        // If there's a transform after the roto node, a black border will appear.
+        // The only solution would be to have a color parameter which specifies how on image is outside of its RoD.
+        // Unfortunately, the OFX definition is: "it is black and transparent"
+
+        ///If inverted, draw an inverted rectangle on all the image first
+        // with a hole consisting of the feather polygon
+
+        double xOffset, yOffset;
+        cairo_surface_get_device_offset(cairoImg, &xOffset, &yOffset);
+        int width = cairo_image_surface_get_width(cairoImg);
+        int height = cairo_image_surface_get_height(cairoImg);
+
+        cairo_move_to(cr, -xOffset, -yOffset);
+        cairo_line_to(cr, -xOffset + width, -yOffset);
+        cairo_line_to(cr, -xOffset + width, -yOffset + height);
+        cairo_line_to(cr, -xOffset, -yOffset + height);
+        cairo_line_to(cr, -xOffset, -yOffset);
+        // strangely, the above-mentioned cairo bug doesn't affect this function
 #pragma message WARN("WRONG! should use the outer feather contour, *displaced* by featherDistance, not fps")
-            renderInternalShape(time, mipmapLevel, cr, fps);
+        renderInternalShape(time, mipmapLevel, cr, fps);
 #endif
-        }
-        applyAndDestroyMask(cr, mesh);
-    } // foreach(splines)
-    assert(cairo_surface_status(cairoImg) == CAIRO_STATUS_SUCCESS);
-
-    ///A call to cairo_surface_flush() is required before accessing the pixel data
-    ///to ensure that all pending drawing operations are finished.
-    cairo_surface_flush(cairoImg);
-} // renderInternal
+    }
+    applyAndDestroyMask(cr, mesh);
+} // renderShape
 
 void
 RotoContextPrivate::renderInternalShape(int time,
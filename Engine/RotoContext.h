@@ -16,9 +16,11 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
+#include <limits>
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
@@ -517,7 +519,41 @@ private:
  **/
 
 
+/**
+ * @brief The polygons of a bezier and of its feather, flattened at a given time and mipmap level.
+ * The i-th segment of both polygons always has the same number of points so that they can be walked in parallel.
+ **/
+struct BezierPolylines
+{
+    std::vector<Natron::Point> points;
+    std::vector<Natron::Point> featherPoints;
+    std::vector<int> segmentStarts; //< index in points and featherPoints of the first point of each segment
+    std::vector<Natron::Point> controlPoints; //< the positions of the control points
+    std::vector<Natron::Point> featherControlPoints; //< the positions of the feather points
+    RectD bbox,featherBBox;
+    U64 pointsHash; //< the hash of the control points and feather points they were computed from
+
+    BezierPolylines()
+    : points()
+    , featherPoints()
+    , segmentStarts()
+    , controlPoints()
+    , featherControlPoints()
+    , bbox( std::numeric_limits<double>::infinity(),
+            std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity() )
+    , featherBBox( std::numeric_limits<double>::infinity(),
+                   std::numeric_limits<double>::infinity(),
+                   -std::numeric_limits<double>::infinity(),
+                   -std::numeric_limits<double>::infinity() )
+    , pointsHash(0)
+    {
+    }
+};
+
 struct BezierPrivate;
+struct BezierSpatialIndex;
 class Bezier
     : public RotoDrawableItem
 {
@@ -723,12 +759,27 @@ public:
                                                  std::list<Natron::Point >* points,
                                                  RectD* bbox) const;
 
+    /**
+     * @brief Evaluates the spline and its feather points at the given time. The number of points of each segment depends on
+     * its curvature so that the polyline does not deviate from the curve by more than kRotoFlatteningTolerance pixels
+     * at the given mipmap level.
+     * The result is cached and shared by the drawing, hit-testing and rendering code until the points change.
+     **/
+    boost::shared_ptr<BezierPolylines> getPolylinesAtTime(int time,unsigned int mipMapLevel) const;
+
     /**
      * @brief Returns the bounding box of the bezier. The last value computed by evaluateAtTime_DeCasteljau will be returned,
      * otherwise if it has never been called, evaluateAtTime_DeCasteljau will be called to compute the bounding box.
      **/
     RectD getBoundingBox(int time) const;
 
+    /**
+     * @brief Returns a hash of everything that affects the rasterization of this shape alone at the given time
+     * and mipmap level: the animated control points, feather points and the drawable item parameters.
+     * The time itself is not part of the hash so that a shape that does not move can be re-used across frames.
+     **/
+    U64 computeRenderHash(int time,unsigned int mipmapLevel) const;
+
     /**
      * @brief Returns a const ref to the control points of the bezier curve. This can only ever be called on the main thread.
      **/
@@ -808,7 +859,7 @@ public:
     static Natron::Point expandToFeatherDistance(const Natron::Point & cp, //< the point
                                                  Natron::Point* fp, //< the feather point
                                                  double featherDistance, //< feather distance
-                                                 const std::list<Natron::Point> & featherPolygon, //< the polygon of the bezier
+                                                 const std::vector<Natron::Point> & featherPolygon, //< the polygon of the bezier
                                                  const RectD & featherPolyBBox, //< helper to speed-up pointInPolygon computations
                                                  int time, //< time
                                                  std::list<boost::shared_ptr<BezierCP> >::const_iterator prevFp, //< iterator pointing to the feather before curFp
@@ -833,7 +884,7 @@ public:
        Of course an 8-shaped polygon doesn't have an outside, but it still has an orientation. The feather direction
        should follow this orientation.
      */
-    static bool pointInPolygon(const Natron::Point & p, const std::list<Natron::Point> & polygon,
+    static bool pointInPolygon(const Natron::Point & p, const std::vector<Natron::Point> & polygon,
                                const RectD & featherPolyBBox, FillRuleEnum rule);
 
     /**
@@ -889,6 +940,13 @@ Q_SIGNALS:
 
 private:
 
+    /**
+     * @brief Returns the spatial index of the control points and polygons at the given time, used by the hit-testing functions.
+     * The index is rebuilt only if the control points or feather points at that time changed since the last call,
+     * whatever made them change. This can only be called on the main-thread.
+     **/
+    boost::shared_ptr<BezierSpatialIndex> getSpatialIndex(int time) const;
+
     boost::scoped_ptr<BezierPrivate> _imp;
 };
 
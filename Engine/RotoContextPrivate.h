@@ -15,9 +15,11 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
+#include <algorithm>
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -37,6 +39,7 @@
 #include "Engine/Node.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/AppManager.h"
+#include "Engine/Rect.h"
 
 #include "Global/GlobalDefines.h"
 
@@ -47,6 +50,15 @@
 #define ROTO_DEFAULT_COLOR_G 1.
 #define ROTO_DEFAULT_COLOR_B 1.
 
+///The maximum distance (in pixels at the mipmap level of evaluation) between a bezier segment and its flattened polyline
+#define kRotoFlatteningTolerance 0.1
+///Bounds the number of points computed for a single bezier segment
+#define kRotoFlatteningMaxPointsPerSegment 200
+///How many flattened versions of a bezier (e.g: at different times or mipmap levels) are kept in its cache
+#define kRotoPolylinesCacheSize 4
+///Bounds the number of cells of the spatial index of a bezier in each dimension
+#define kRotoSpatialIndexMaxCells 256
+
 
 #define kRotoScriptNameHint "Script-name of the item for Python scripts. It cannot be edited."
 
@@ -148,6 +160,47 @@ struct BezierCPPrivate
 class BezierCP;
 typedef std::list< boost::shared_ptr<BezierCP> > BezierCPs;
 
+/**
+ * @brief A uniform grid over the control points and the flattened polygons of a bezier at a given time,
+ * used to speed-up hit-testing and rectangle selection. This is only used on the main-thread.
+ **/
+struct BezierSpatialIndex
+{
+    boost::shared_ptr<BezierPolylines> polylines; //< what the index was built from, at mipmap level 0
+    RectD bounds;
+    double cellSize;
+    int nbCellsX,nbCellsY;
+
+    ///For each cell, the indexes of the control points it contains.
+    ///Feather points are numbered after the control points.
+    std::vector<std::vector<int> > pointCells;
+
+    ///For each cell, the edges of the polygons crossing it. An edge is identified by the index of its first point.
+    ///Edges of the feather polygon are numbered after the points of the bezier polygon.
+    std::vector<std::vector<int> > edgeCells;
+
+    BezierSpatialIndex(const boost::shared_ptr<BezierPolylines> & polylines);
+
+    /**
+     * @brief Returns the sorted indexes of the control points (and feather points) which may lie in the given rectangle.
+     * The caller must still test each of them.
+     **/
+    void getPointsInRect(const RectD & rect,std::vector<int>* points) const;
+
+    /**
+     * @brief Returns the sorted indexes of the edges which may cross the given rectangle.
+     * The caller must still test each of them.
+     **/
+    void getEdgesInRect(const RectD & rect,std::vector<int>* edges) const;
+
+private:
+
+    void insert(const RectD & rect,int item,std::vector<std::vector<int> >* cells);
+
+    bool getCellRange(const RectD & rect,int* x1,int* y1,int* x2,int* y2) const;
+
+    void query(const RectD & rect,const std::vector<std::vector<int> > & cells,std::vector<int>* items) const;
+};
 
 struct BezierPrivate
 {
@@ -160,6 +213,14 @@ struct BezierPrivate
     double featherPointsAtDistanceVal; //< the distance value used to compute featherPointsAtDistance. if == 0., use featherPoints. if Bezier::getFeatherDistance() returns a different value, featherPointsAtDistance must be updated.
     bool finished; //< when finished is true, the last point of the list is connected to the first point of the list.
 
+    mutable QMutex polylinesCacheMutex; //< protects polylinesCache
+    ///The last flattened polygons, most recently used first. They are identified by the hash
+    ///of the control points they were computed from, see Bezier::getPolylinesAtTime
+    std::list<std::pair<U64, boost::shared_ptr<BezierPolylines> > > polylinesCache;
+
+    ///Only accessed on the main-thread, see Bezier::getSpatialIndex
+    boost::shared_ptr<BezierSpatialIndex> spatialIndex;
+
     BezierPrivate()
         : points()
           , featherPoints()
@@ -167,6 +228,9 @@ struct BezierPrivate
           , featherPointsAtDistance()
           , featherPointsAtDistanceVal(0.)
           , finished(false)
+          , polylinesCacheMutex()
+          , polylinesCache()
+          , spatialIndex()
     {
     }
 
@@ -221,20 +285,26 @@ struct BezierPrivate
         return it;
     }
 
-    BezierCPs::const_iterator findControlPointNearby(double x,
+    BezierCPs::const_iterator findControlPointNearby(const BezierSpatialIndex & spatialIndex,
+                                                     double x,
                                                      double y,
                                                      double acceptance,
-                                                     int time,
                                                      int* index) const
     {
         // PRIVATE - should not lock
-        int i = 0;
+        std::vector<int> candidates;
+
+        spatialIndex.getPointsInRect(RectD(x - acceptance, y - acceptance, x + acceptance, y + acceptance), &candidates);
 
-        for (BezierCPs::const_iterator it = points.begin(); it != points.end(); ++it,++i) {
-            double pX,pY;
-            (*it)->getPositionAtTime(time, &pX, &pY);
-            if ( ( pX >= (x - acceptance) ) && ( pX <= (x + acceptance) ) && ( pY >= (y - acceptance) ) && ( pY <= (y + acceptance) ) ) {
-                *index = i;
+        ///candidates are sorted and control points are numbered first
+        const std::vector<Natron::Point> & pos = spatialIndex.polylines->controlPoints;
+        int nbPoints = std::min( (int)pos.size(), (int)points.size() );
+        for (std::size_t i = 0; i < candidates.size() && candidates[i] < nbPoints; ++i) {
+            const Natron::Point & p = pos[candidates[i]];
+            if ( ( p.x >= (x - acceptance) ) && ( p.x <= (x + acceptance) ) && ( p.y >= (y - acceptance) ) && ( p.y <= (y + acceptance) ) ) {
+                *index = candidates[i];
+                BezierCPs::const_iterator it = points.begin();
+                std::advance(it, *index);
 
                 return it;
             }
@@ -243,20 +313,34 @@ struct BezierPrivate
         return points.end();
     }
 
-    BezierCPs::const_iterator findFeatherPointNearby(double x,
+    BezierCPs::const_iterator findFeatherPointNearby(const BezierSpatialIndex & spatialIndex,
+                                                     double x,
                                                      double y,
                                                      double acceptance,
-                                                     int time,
                                                      int* index) const
     {
         // PRIVATE - should not lock
-        int i = 0;
-
-        for (BezierCPs::const_iterator it = featherPoints.begin(); it != featherPoints.end(); ++it,++i) {
-            double pX,pY;
-            (*it)->getPositionAtTime(time, &pX, &pY);
-            if ( ( pX >= (x - acceptance) ) && ( pX <= (x + acceptance) ) && ( pY >= (y - acceptance) ) && ( pY <= (y + acceptance) ) ) {
-                *index = i;
+        std::vector<int> candidates;
+
+        spatialIndex.getPointsInRect(RectD(x - acceptance, y - acceptance, x + acceptance, y + acceptance), &candidates);
+
+        ///feather points are numbered after the control points
+        const std::vector<Natron::Point> & pos = spatialIndex.polylines->featherControlPoints;
+        int offset = (int)spatialIndex.polylines->controlPoints.size();
+        int nbPoints = std::min( (int)pos.size(), (int)featherPoints.size() );
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            int fpIndex = candidates[i] - offset;
+            if (fpIndex < 0) {
+                continue;
+            }
+            if (fpIndex >= nbPoints) {
+                break;
+            }
+            const Natron::Point & p = pos[fpIndex];
+            if ( ( p.x >= (x - acceptance) ) && ( p.x <= (x + acceptance) ) && ( p.y >= (y - acceptance) ) && ( p.y <= (y + acceptance) ) ) {
+                *index = fpIndex;
+                BezierCPs::const_iterator it = featherPoints.begin();
+                std::advance(it, *index);
 
                 return it;
             }
@@ -677,7 +761,25 @@ struct RotoContextPrivate
     }
 
     void renderInternal(cairo_t* cr,cairo_surface_t* cairoImg,const std::list< boost::shared_ptr<Bezier> > & splines,
-                        unsigned int mipmapLevel,int time);
+                        const RectI & shapesRoD,const RectI & renderWindow,unsigned int mipmapLevel,int time,int view);
+
+    /**
+     * @brief Returns the rasterization of the given shape alone, in an 8-bit image of the node cache laid out as a cairo
+     * surface of the given format. Only the part of the shape within renderWindow is guaranteed to be rendered: the rest
+     * is rendered by the tiles that need it. The returned image is NULL if the shape does not intersect renderWindow.
+     **/
+    boost::shared_ptr<Natron::Image> getOrRenderShape(const boost::shared_ptr<Bezier> & bezier,cairo_format_t format,
+                                                      const RectI & shapesRoD,const RectI & renderWindow,
+                                                      unsigned int mipmapLevel,int time,int view);
+
+    /**
+     * @brief Wraps the buffer of an image returned by getOrRenderShape in a cairo surface in pixel coordinates.
+     * The image must stay locked while the surface is used.
+     **/
+    static cairo_surface_t* createShapeSurface(const Natron::Image* shape,cairo_format_t format,const unsigned char* data);
+
+    void renderShape(cairo_t* cr,cairo_surface_t* cairoImg,const boost::shared_ptr<Bezier> & bezier,
+                     unsigned int mipmapLevel,int time);
 
     void renderInternalShape(int time,unsigned int mipmapLevel,cairo_t* cr,const BezierCPs & cps);
 
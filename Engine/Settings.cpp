@@ -108,9 +108,20 @@ Settings::initializeKnobs()
     _autoSaveDelay->setMinimum(0);
     _autoSaveDelay->setMaximum(60);
     _autoSaveDelay->setHintToolTip("The number of seconds after an event that " NATRON_APPLICATION_NAME " should wait before "
-                                   " auto-saving. Note that if a render is in progress, " NATRON_APPLICATION_NAME " will "
-                                   " wait until it is done to actually auto-save.");
+                                   " auto-saving. Renders in progress do not delay the auto-save: the project is serialized "
+                                   "on the main thread, which briefly blocks the interface for large projects, and then "
+                                   "written to disk in the background.");
     _generalTab->addKnob(_autoSaveDelay);
+    
+    _binaryProjectFormat = Natron::createKnob<Bool_Knob>(this, "Save projects in binary format");
+    _binaryProjectFormat->setName("binaryProjectFormat");
+    _binaryProjectFormat->setAnimationEnabled(false);
+    _binaryProjectFormat->setHintToolTip("When checked, projects and auto-saves are written in a compact binary format "
+                                         "which is much faster to load and save than the XML format. Both formats "
+                                         "can always be opened: to convert a project, open it and save it again. "
+                                         "Note that binary projects can only be shared with computers of the same "
+                                         "architecture, use the XML format to exchange projects.");
+    _generalTab->addKnob(_binaryProjectFormat);
 
 
     _linearPickers = Natron::createKnob<Bool_Knob>(this, "Linear color pickers");
@@ -547,6 +558,24 @@ Settings::initializeKnobs()
     _autoWipe->setAnimationEnabled(false);
     _viewersTab->addKnob(_autoWipe);
     
+    _viewerOrderedDither = Natron::createKnob<Bool_Knob>(this, "Ordered dithering");
+    _viewerOrderedDither->setName("viewerOrderedDither");
+    _viewerOrderedDither->setHintToolTip("When checked, 8-bit viewer textures are dithered with a fixed 4x4 pattern instead of "
+                                         "diffusing the quantization error along each line. This is faster to compute, "
+                                         "at the cost of a faint regular pattern in smooth gradients.");
+    _viewerOrderedDither->setAnimationEnabled(false);
+    _viewersTab->addKnob(_viewerOrderedDither);
+    
+    _viewerCompactPlaybackCache = Natron::createKnob<Bool_Knob>(this, "Compact playback cache");
+    _viewerCompactPlaybackCache->setName("viewerCompactPlaybackCache");
+    _viewerCompactPlaybackCache->setHintToolTip("When checked and the viewer textures are 32 bits floating point, the frames rendered "
+                                                "during playback are stored in the playback cache as 8-bit textures, with the gain and "
+                                                "color-space of the viewer applied. This uses 4 times less memory, so that more frames "
+                                                "fit in the cache, but changing the gain or the color-space of the viewer requires "
+                                                "rendering these frames again.");
+    _viewerCompactPlaybackCache->setAnimationEnabled(false);
+    _viewersTab->addKnob(_viewerCompactPlaybackCache);
+    
     /////////// Nodegraph tab
     _nodegraphTab = Natron::createKnob<Page_Knob>(this, "Nodegraph");
     
@@ -996,6 +1025,7 @@ Settings::setDefaultValues()
     _checkForUpdates->setDefaultValue(false);
     _notifyOnFileChange->setDefaultValue(true);
     _autoSaveDelay->setDefaultValue(5, 0);
+    _binaryProjectFormat->setDefaultValue(false);
     _maxUndoRedoNodeGraph->setDefaultValue(20, 0);
     _linearPickers->setDefaultValue(true,0);
     _snapNodesToConnections->setDefaultValue(true);
@@ -1029,6 +1059,8 @@ Settings::setDefaultValues()
     _checkerboardColor2->setDefaultValue(0.,2);
     _checkerboardColor2->setDefaultValue(0.,3);
     _autoWipe->setDefaultValue(false);
+    _viewerOrderedDither->setDefaultValue(false);
+    _viewerCompactPlaybackCache->setDefaultValue(false);
     
     _warnOcioConfigKnobChanged->setDefaultValue(true);
     _ocioStartupCheck->setDefaultValue(true);
@@ -1235,6 +1267,17 @@ Settings::warnChangedKnobs(const std::vector<KnobI*>& knobs)
                     
                 }
             }
+        } else if (knobs[i] == _viewerOrderedDither.get()) {
+            ///Textures in the playback cache were dithered with the previous method
+            appPTR->clearPlaybackCache();
+            std::map<int,AppInstanceRef> apps = appPTR->getAppInstances();
+            for (std::map<int,AppInstanceRef>::iterator it = apps.begin(); it != apps.end(); ++it) {
+                std::list<ViewerInstance*> allViewers;
+                it->second.app->getProject()->getViewers(&allViewers);
+                for (std::list<ViewerInstance*>::iterator it2 = allViewers.begin(); it2 != allViewers.end(); ++it2) {
+                    (*it2)->renderCurrentFrame(true);
+                }
+            }
         }
                    
     }
@@ -2119,6 +2162,18 @@ Settings::getAutoSaveDelayMS() const
     return _autoSaveDelay->getValue() * 1000;
 }
 
+bool
+Settings::isBinaryProjectFormatEnabled() const
+{
+    return _binaryProjectFormat->getValue();
+}
+
+void
+Settings::setBinaryProjectFormatEnabled(bool enabled)
+{
+    _binaryProjectFormat->setValue(enabled, 0);
+}
+
 bool
 Settings::isSnapToNodeEnabled() const
 {
@@ -2513,6 +2568,18 @@ Settings::isAutoWipeEnabled() const
     return _autoWipe->getValue();
 }
 
+bool
+Settings::isViewerOrderedDitheringEnabled() const
+{
+    return _viewerOrderedDither->getValue();
+}
+
+bool
+Settings::isViewerCompactPlaybackCacheEnabled() const
+{
+    return _viewerCompactPlaybackCache->getValue();
+}
+
 int
 Settings::getRenderScaleSupportPreference(const std::string& pluginID) const
 {
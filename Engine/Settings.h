@@ -146,6 +146,9 @@ public:
 
     int getAutoSaveDelayMS() const;
 
+    bool isBinaryProjectFormatEnabled() const;
+    void setBinaryProjectFormatEnabled(bool enabled);
+
     bool isSnapToNodeEnabled() const;
 
     bool isCheckForUpdatesEnabled() const;
@@ -222,6 +225,10 @@ public:
     
     bool isAutoWipeEnabled() const;
     
+    bool isViewerOrderedDitheringEnabled() const;
+    
+    bool isViewerCompactPlaybackCacheEnabled() const;
+    
     /**
      * @brief Return whether the render scale support is set to its default value (0)  or deactivated (1)
      * for the given plug-in.
@@ -295,6 +302,7 @@ private:
     boost::shared_ptr<Bool_Knob> _checkForUpdates;
     boost::shared_ptr<Bool_Knob> _notifyOnFileChange;
     boost::shared_ptr<Int_Knob> _autoSaveDelay;
+    boost::shared_ptr<Bool_Knob> _binaryProjectFormat;
     boost::shared_ptr<Bool_Knob> _linearPickers;
     boost::shared_ptr<Int_Knob> _numberOfThreads;
     boost::shared_ptr<Int_Knob> _numberOfParallelRenders;
@@ -348,6 +356,8 @@ private:
     boost::shared_ptr<Color_Knob> _checkerboardColor1;
     boost::shared_ptr<Color_Knob> _checkerboardColor2;
     boost::shared_ptr<Bool_Knob> _autoWipe;
+    boost::shared_ptr<Bool_Knob> _viewerOrderedDither;
+    boost::shared_ptr<Bool_Knob> _viewerCompactPlaybackCache;
     boost::shared_ptr<Page_Knob> _nodegraphTab;
     boost::shared_ptr<Bool_Knob> _autoTurbo;
     boost::shared_ptr<Bool_Knob> _useNodeGraphHints;
@@ -0,0 +1,407 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+CLANG_DIAG_ON(deprecated)
+
+#ifdef _WIN32
+#define NATRON_TRACE_OPEN(path) ::_open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define NATRON_TRACE_WRITE ::_write
+#define NATRON_TRACE_CLOSE ::_close
+#else
+#define NATRON_TRACE_OPEN(path) ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+#define NATRON_TRACE_WRITE ::write
+#define NATRON_TRACE_CLOSE ::close
+#endif
+
+///Maximum length of the path given to initialize(), which must be stored without allocation for the crash handler
+#define NATRON_TRACE_MAX_PATH 4096
+
+namespace Natron {
+namespace Trace {
+namespace {
+
+struct TraceRing
+{
+    ///1 while a thread records in this ring
+    QAtomicInt inUse;
+
+    ///Number of records written, modulo 2^32, published after each record is complete
+    QAtomicInt head;
+
+    ///1 once head went past NATRON_TRACE_RING_SIZE: all the records are valid
+    QAtomicInt wrapped;
+
+    ///The following members are only written by the thread owning the ring
+    quint32 written;
+    quint64 totalWritten;
+    quint32 threadIndex;
+    quint64 nativeThreadId;
+    char name[NATRON_TRACE_THREAD_NAME_SIZE];
+    TraceRecord records[NATRON_TRACE_RING_SIZE];
+
+    TraceRing()
+    : inUse()
+    , head()
+    , wrapped()
+    , written(0)
+    , totalWritten(0)
+    , threadIndex(0)
+    , nativeThreadId(0)
+    {
+        std::memset( name, 0, sizeof(name) );
+        std::memset( records, 0, sizeof(records) );
+    }
+};
+
+///Releases the ring of a thread when the thread finishes
+struct ThreadRingHandle
+{
+    TraceRing* ring;
+
+    ThreadRingHandle(TraceRing* ring)
+    : ring(ring)
+    {
+    }
+
+    ~ThreadRingHandle()
+    {
+        if (ring) {
+            ring->inUse.fetchAndStoreRelease(0);
+        }
+    }
+};
+
+struct TraceGlobals
+{
+    QElapsedTimer timer;
+    qint64 startTimeMs;
+    char crashFilePath[NATRON_TRACE_MAX_PATH];
+
+    ///Protects the acquisition of a ring by a thread, never taken when recording an event
+    QMutex ringsMutex;
+    TraceRing* rings[NATRON_TRACE_MAX_THREADS];
+
+    ///Number of valid entries of rings, published after the entry is set
+    QAtomicInt ringsCount;
+    quint32 threadsStarted;
+    QThreadStorage<ThreadRingHandle*> threadRing;
+
+    TraceGlobals()
+    : timer()
+    , startTimeMs(0)
+    , ringsMutex()
+    , ringsCount()
+    , threadsStarted(0)
+    , threadRing()
+    {
+        std::memset( crashFilePath, 0, sizeof(crashFilePath) );
+        std::memset( rings, 0, sizeof(rings) );
+    }
+};
+
+///Never destroyed: threads may still record events while the application exits
+TraceGlobals* globals = 0;
+
+TraceRing*
+acquireRing(TraceGlobals* g)
+{
+    QMutexLocker k(&g->ringsMutex);
+    TraceRing* ring = 0;
+    int count = g->ringsCount.fetchAndAddAcquire(0);
+
+    for (int i = 0; i < count; ++i) {
+        if ( g->rings[i]->inUse.testAndSetAcquire(0, 1) ) {
+            ring = g->rings[i];
+            break;
+        }
+    }
+    if (!ring) {
+        if (count >= NATRON_TRACE_MAX_THREADS) {
+            return 0;
+        }
+        ring = new TraceRing;
+        ring->inUse.fetchAndStoreRelaxed(1);
+        g->rings[count] = ring;
+        g->ringsCount.fetchAndAddRelease(1);
+    }
+
+    ///The previous records of a reused ring are kept, they still carry the index of their thread
+    ring->threadIndex = g->threadsStarted++;
+    QThread* thread = QThread::currentThread();
+    ring->nativeThreadId = (quint64)(quintptr)QThread::currentThreadId();
+    QByteArray name = thread ? thread->objectName().toUtf8() : QByteArray();
+    if ( name.isEmpty() && QCoreApplication::instance() && (thread == QCoreApplication::instance()->thread()) ) {
+        name = "Main";
+    }
+    std::memset( ring->name, 0, sizeof(ring->name) );
+    std::strncpy( ring->name, name.constData(), sizeof(ring->name) - 1 );
+
+    return ring;
+}
+
+inline TraceRing*
+getThreadRing(TraceGlobals* g)
+{
+    ThreadRingHandle* handle = g->threadRing.localData();
+
+    if (!handle) {
+        ///Threads beyond NATRON_TRACE_MAX_THREADS get a handle without ring so that they do not try again
+        handle = new ThreadRingHandle( acquireRing(g) );
+        g->threadRing.setLocalData(handle);
+    }
+
+    return handle->ring;
+}
+
+bool
+writeAll(int fd,
+         const void* data,
+         std::size_t size)
+{
+    const char* p = (const char*)data;
+
+    while (size > 0) {
+        int n = (int)NATRON_TRACE_WRITE(fd, p, (unsigned int)size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Writes the rings to fd. If scratch is NULL the records are written directly from the rings, which is what
+ * the crash handler must do since it cannot allocate. Otherwise they are copied to scratch first and the records that
+ * the owning thread overwrote during the copy are left out.
+ **/
+bool
+writeRings(TraceGlobals* g,
+           int fd,
+           std::vector<TraceRecord>* scratch)
+{
+    int count = g->ringsCount.fetchAndAddAcquire(0);
+    TraceFileHeader header;
+
+    std::memset( &header, 0, sizeof(header) );
+    std::memcpy( header.magic, NATRON_TRACE_FILE_MAGIC, sizeof(header.magic) );
+    header.version = NATRON_TRACE_FILE_VERSION;
+    header.byteOrderMark = NATRON_TRACE_BYTE_ORDER_MARK;
+    header.recordSize = sizeof(TraceRecord);
+    header.threadsCount = count;
+    header.startTimeMs = g->startTimeMs;
+    if ( !writeAll( fd, &header, sizeof(header) ) ) {
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        TraceRing* ring = g->rings[i];
+        quint32 head = (quint32)ring->head.fetchAndAddAcquire(0);
+        quint32 kept = ring->wrapped.fetchAndAddAcquire(0) ? NATRON_TRACE_RING_SIZE : std::min(head, (quint32)NATRON_TRACE_RING_SIZE);
+        quint32 first = head - kept;
+
+        if (scratch) {
+            scratch->resize(kept);
+            for (quint32 r = 0; r < kept; ++r) {
+                (*scratch)[r] = ring->records[(first + r) & (NATRON_TRACE_RING_SIZE - 1)];
+            }
+            ///The owning thread overwrote the slots of the records published since head was read, and it may be
+            ///writing the next slot, not published yet: when the ring is full these are the overwritten + 1 oldest records
+            quint32 overwritten = (quint32)ring->head.fetchAndAddAcquire(0) - head;
+            quint64 dropped = (quint64)overwritten + 1 + kept;
+            dropped = dropped > NATRON_TRACE_RING_SIZE ? dropped - NATRON_TRACE_RING_SIZE : 0;
+            if (dropped >= kept) {
+                kept = 0;
+            } else if (dropped > 0) {
+                scratch->erase( scratch->begin(), scratch->begin() + (std::size_t)dropped );
+                kept -= (quint32)dropped;
+            }
+        }
+
+        TraceThreadHeader thread;
+        std::memset( &thread, 0, sizeof(thread) );
+        thread.threadIndex = ring->threadIndex;
+        thread.recordsCount = kept;
+        thread.droppedCount = ring->totalWritten > kept ? ring->totalWritten - kept : 0;
+        thread.nativeThreadId = ring->nativeThreadId;
+        std::memcpy( thread.name, ring->name, sizeof(thread.name) );
+        thread.name[sizeof(thread.name) - 1] = 0;
+        if ( !writeAll( fd, &thread, sizeof(thread) ) ) {
+            return false;
+        }
+
+        if (scratch) {
+            if ( kept && !writeAll( fd, &scratch->front(), kept * sizeof(TraceRecord) ) ) {
+                return false;
+            }
+        } else {
+            ///The records are contiguous in the ring, except when they wrap around its end
+            quint32 start = first & (NATRON_TRACE_RING_SIZE - 1);
+            quint32 firstPart = std::min(kept, (quint32)NATRON_TRACE_RING_SIZE - start);
+            if ( !writeAll( fd, &ring->records[start], firstPart * sizeof(TraceRecord) ) ||
+                 !writeAll( fd, &ring->records[0], (kept - firstPart) * sizeof(TraceRecord) ) ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+} // anon namespace
+
+void
+initialize(const std::string & crashFilePath)
+{
+    TraceGlobals* g = globals;
+
+    if (!g) {
+        g = new TraceGlobals;
+        g->startTimeMs = QDateTime::currentMSecsSinceEpoch();
+        g->timer.start();
+    }
+    std::memset( g->crashFilePath, 0, sizeof(g->crashFilePath) );
+    std::strncpy( g->crashFilePath, crashFilePath.c_str(), sizeof(g->crashFilePath) - 1 );
+    globals = g;
+}
+
+void
+record(quint16 event,
+       const void* payload,
+       std::size_t payloadSize)
+{
+    TraceGlobals* g = globals;
+
+    if (!g) {
+        return;
+    }
+    TraceRing* ring = getThreadRing(g);
+    if (!ring) {
+        return;
+    }
+
+    TraceRecord & r = ring->records[ring->written & (NATRON_TRACE_RING_SIZE - 1)];
+    r.timestamp = (quint64)g->timer.nsecsElapsed();
+    r.threadIndex = ring->threadIndex;
+    r.event = event;
+    r.payloadSize = (quint16)std::min(payloadSize, (std::size_t)NATRON_TRACE_PAYLOAD_SIZE);
+    if (r.payloadSize) {
+        std::memcpy(r.payload, payload, r.payloadSize);
+    }
+
+    ++ring->written;
+    ++ring->totalWritten;
+    if (ring->written == NATRON_TRACE_RING_SIZE) {
+        ring->wrapped.fetchAndStoreRelease(1);
+    }
+    ring->head.fetchAndStoreRelease( (int)ring->written );
+}
+
+void
+recordMessage(const std::string & text)
+{
+    const std::size_t maxChunks = 16;
+    std::size_t size = std::min(text.size(), maxChunks * NATRON_TRACE_PAYLOAD_SIZE);
+
+    record( eTraceEventMessage, text.c_str(), std::min(size, (std::size_t)NATRON_TRACE_PAYLOAD_SIZE) );
+    for (std::size_t offset = NATRON_TRACE_PAYLOAD_SIZE; offset < size; offset += NATRON_TRACE_PAYLOAD_SIZE) {
+        record( eTraceEventMessageContinued, text.c_str() + offset, std::min(size - offset, (std::size_t)NATRON_TRACE_PAYLOAD_SIZE) );
+    }
+}
+
+bool
+writeToFile(const std::string & filePath)
+{
+    TraceGlobals* g = globals;
+
+    if (!g) {
+        return false;
+    }
+    int fd = NATRON_TRACE_OPEN( filePath.c_str() );
+    if (fd < 0) {
+        return false;
+    }
+    std::vector<TraceRecord> scratch;
+    scratch.reserve(NATRON_TRACE_RING_SIZE);
+    bool ok = writeRings(g, fd, &scratch);
+    if (NATRON_TRACE_CLOSE(fd) != 0) {
+        ok = false;
+    }
+
+    return ok;
+}
+
+void
+writeOnCrash()
+{
+    TraceGlobals* g = globals;
+
+    if ( !g || (g->crashFilePath[0] == 0) ) {
+        return;
+    }
+    int fd = NATRON_TRACE_OPEN(g->crashFilePath);
+    if (fd < 0) {
+        return;
+    }
+    writeRings(g, fd, NULL);
+    NATRON_TRACE_CLOSE(fd);
+}
+
+RenderScope::RenderScope(const std::string & nodeName,
+                         int time,
+                         int view,
+                         int x1,
+                         int y1,
+                         int x2,
+                         int y2)
+: _status(-1)
+{
+    TraceRenderPayload p;
+
+    p.time = time;
+    p.view = view;
+    p.x1 = x1;
+    p.y1 = y1;
+    p.x2 = x2;
+    p.y2 = y2;
+    std::strncpy( p.name, nodeName.c_str(), sizeof(p.name) );
+    record( eTraceEventRenderBegin, &p, sizeof(p) );
+}
+
+RenderScope::~RenderScope()
+{
+    record( eTraceEventRenderEnd, &_status, sizeof(_status) );
+}
+} // namespace Trace
+} // namespace Natron
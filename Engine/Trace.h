@@ -0,0 +1,91 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_TRACE_H_
+#define NATRON_ENGINE_TRACE_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstddef>
+#include <string>
+
+#include "Global/Macros.h"
+#include "Global/TraceFormat.h"
+
+/**
+ * An always-on trace of what the threads are doing, cheap enough to be left enabled in production.
+ *
+ * Each thread records fixed-size binary events (TraceRecord) in a ring buffer of its own: recording an event
+ * takes no lock and does no allocation, it only overwrites the oldest event of the thread once its ring is full.
+ * The rings are written to a file on demand with writeToFile() or by the crash handler with writeOnCrash(),
+ * and the file is decoded offline with NatronTraceDecoder.
+ **/
+
+///Number of events kept per thread, must be a power of 2
+#define NATRON_TRACE_RING_SIZE 2048
+
+///Threads recording at the same time beyond this number are not traced. Rings of finished threads are reused.
+#define NATRON_TRACE_MAX_THREADS 256
+
+namespace Natron {
+namespace Trace {
+
+/**
+ * @brief Starts the trace: the timestamps of the events are relative to this call and the events recorded
+ * before are ignored. crashFilePath is the file writeOnCrash() writes to.
+ * Must be called on the main thread, before any other thread records events. Calling it again only changes crashFilePath.
+ **/
+void initialize(const std::string & crashFilePath);
+
+/**
+ * @brief Records an event in the ring of the calling thread. The payload is truncated to NATRON_TRACE_PAYLOAD_SIZE bytes.
+ **/
+void record(quint16 event,const void* payload,std::size_t payloadSize);
+
+/**
+ * @brief Records a text, split in as many records as needed (with a limit of 16 records).
+ **/
+void recordMessage(const std::string & text);
+
+/**
+ * @brief Writes the events of all threads to filePath. Events recorded while writing may be missing from the file.
+ * Returns false if the file could not be written.
+ **/
+bool writeToFile(const std::string & filePath);
+
+/**
+ * @brief Writes the events of all threads to the file given to initialize(). This only uses async-signal-safe functions
+ * and may be called from a signal handler or from the crash handler, while the other threads are frozen.
+ **/
+void writeOnCrash();
+
+/**
+ * @brief Records eTraceEventRenderBegin when created and eTraceEventRenderEnd when destroyed,
+ * around the render action of an effect.
+ **/
+class RenderScope
+{
+    qint32 _status;
+
+public:
+
+    ///The status recorded is -1 unless setStatus() is called, which means that the render action threw an exception
+    RenderScope(const std::string & nodeName,int time,int view,int x1,int y1,int x2,int y2);
+
+    ~RenderScope();
+
+    void setStatus(int status)
+    {
+        _status = status;
+    }
+};
+
+} // namespace Trace
+} // namespace Natron
+
+#endif // NATRON_ENGINE_TRACE_H_
@@ -0,0 +1,363 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "TrackScheduler.h"
+
+#include <vector>
+#include <algorithm>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
+
+#include "Engine/KnobTypes.h"
+#include "Engine/TimeLine.h"
+
+struct TrackArgs
+{
+    int start,end;
+    bool forward;
+    std::list<Button_Knob*> instances;
+    boost::shared_ptr<TimeLine> timeline;
+};
+
+struct TrackSchedulerPrivate
+{
+    QMutex argsMutex;
+    TrackArgs curArgs,requestedArgs;
+
+    mutable QMutex mustQuitMutex;
+    bool mustQuit;
+    QWaitCondition mustQuitCond;
+
+    mutable QMutex abortRequestedMutex;
+    int abortRequested;
+    QWaitCondition abortRequestedCond;
+
+    QMutex startRequesstMutex;
+    int startRequests;
+    QWaitCondition startRequestsCond;
+
+    mutable QMutex isWorkingMutex;
+    bool isWorking;
+
+    mutable QMutex updateViewerMutex;
+    bool updateViewerOnTrackingEnabled;
+
+    ///The tracks which are done with their frame and wait for the scheduler to schedule their next frame
+    QMutex tracksMutex;
+    std::list<int> finishedTracks;
+    QWaitCondition finishedTracksCond;
+
+    TrackSchedulerPrivate()
+    : argsMutex()
+    , curArgs()
+    , requestedArgs()
+    , mustQuitMutex()
+    , mustQuit(false)
+    , mustQuitCond()
+    , abortRequestedMutex()
+    , abortRequested(0)
+    , abortRequestedCond()
+    , startRequesstMutex()
+    , startRequests(0)
+    , startRequestsCond()
+    , isWorkingMutex()
+    , isWorking(false)
+    , updateViewerMutex()
+    , updateViewerOnTrackingEnabled(true)
+    , tracksMutex()
+    , finishedTracks()
+    , finishedTracksCond()
+    {
+
+    }
+
+    bool checkForExit()
+    {
+        QMutexLocker k(&mustQuitMutex);
+        if (mustQuit) {
+            mustQuit = false;
+            mustQuitCond.wakeAll();
+            return true;
+        }
+        return false;
+    }
+
+    bool checkForAbort()
+    {
+        QMutexLocker k(&abortRequestedMutex);
+        if (abortRequested > 0) {
+            abortRequested = 0;
+            abortRequestedCond.wakeAll();
+            return true;
+        }
+        return false;
+    }
+
+    void onFrameTracked(int track)
+    {
+        QMutexLocker k(&tracksMutex);
+        finishedTracks.push_back(track);
+        finishedTracksCond.wakeOne();
+    }
+
+};
+
+///Runs in a thread of the global thread pool
+static void
+trackFrame(TrackSchedulerPrivate* imp,
+           int track,
+           Button_Knob* instance,
+           int frame)
+{
+    instance->getHolder()->onKnobValueChanged_public(instance,Natron::eValueChangedReasonNatronInternalEdited,frame,
+                                                     true);
+    imp->onFrameTracked(track);
+}
+
+TrackScheduler::TrackScheduler()
+: QThread()
+, _imp(new TrackSchedulerPrivate())
+{
+    setObjectName("TrackScheduler");
+}
+
+TrackScheduler::~TrackScheduler()
+{
+
+}
+
+bool
+TrackScheduler::isWorking() const
+{
+    QMutexLocker k(&_imp->isWorkingMutex);
+    return _imp->isWorking;
+}
+
+void
+TrackScheduler::setUpdateViewerOnTracking(bool update)
+{
+    QMutexLocker k(&_imp->updateViewerMutex);
+    _imp->updateViewerOnTrackingEnabled = update;
+}
+
+bool
+TrackScheduler::isUpdateViewerOnTrackingEnabled() const
+{
+    QMutexLocker k(&_imp->updateViewerMutex);
+    return _imp->updateViewerOnTrackingEnabled;
+}
+
+void
+TrackScheduler::run()
+{
+    for (;;) {
+
+        ///Check for exit of the thread
+        if (_imp->checkForExit()) {
+            return;
+        }
+
+        ///Flag that we're working
+        {
+            QMutexLocker k(&_imp->isWorkingMutex);
+            _imp->isWorking = true;
+        }
+
+        ///Copy the requested args to the args used for processing
+        {
+            QMutexLocker k(&_imp->argsMutex);
+            _imp->curArgs = _imp->requestedArgs;
+        }
+
+        const int end = _imp->curArgs.end;
+        const int start = _imp->curArgs.start;
+        const bool forward = _imp->curArgs.forward;
+        const std::vector<Button_Knob*> instances(_imp->curArgs.instances.begin(),_imp->curArgs.instances.end());
+
+        int framesCount = forward ? (end - start) : (start - end);
+
+        bool reportProgress = instances.size() > 1 || framesCount > 1;
+        if (reportProgress) {
+            Q_EMIT trackingStarted();
+        }
+
+        ///The next frame to track for each track
+        std::vector<int> nextFrames(instances.size(),start);
+
+        ///Launch the first frame of each track using the global thread pool
+        int runningTracks = 0;
+        for (std::size_t i = 0; i < instances.size(); ++i) {
+            QtConcurrent::run(trackFrame,_imp.get(),(int)i,instances[i],start);
+            ++runningTracks;
+        }
+
+        bool aborted = false;
+        int slowestFrame = start;
+        while (runningTracks > 0) {
+
+            std::list<int> finished;
+            {
+                QMutexLocker k(&_imp->tracksMutex);
+                while (_imp->finishedTracks.empty()) {
+                    _imp->finishedTracksCond.wait(&_imp->tracksMutex);
+                }
+                finished.swap(_imp->finishedTracks);
+            }
+
+            ///Check for abortion: the frames being tracked are left to finish but no other frame is scheduled
+            if (!aborted && _imp->checkForAbort()) {
+                aborted = true;
+            }
+
+            for (std::list<int>::iterator it = finished.begin(); it != finished.end(); ++it) {
+                --runningTracks;
+
+                int& cur = nextFrames[*it];
+                double progress;
+                if (forward) {
+                    ++cur;
+                    progress = (double)(cur - start) / framesCount;
+                } else {
+                    --cur;
+                    progress = (double)(start - cur) / framesCount;
+                }
+                if (reportProgress) {
+                    Q_EMIT trackProgressUpdate(*it, progress);
+                }
+
+                ///This track does not have to wait for the others to go on
+                if (!aborted && cur != end) {
+                    QtConcurrent::run(trackFrame,_imp.get(),*it,instances[*it],cur);
+                    ++runningTracks;
+                }
+            }
+
+            int slowest = forward ? *std::min_element(nextFrames.begin(), nextFrames.end()) :
+            *std::max_element(nextFrames.begin(), nextFrames.end());
+            if (slowest != slowestFrame) {
+                slowestFrame = slowest;
+
+                ///All tracks are finished for this frame, refresh viewer if needed
+                if (_imp->curArgs.timeline && isUpdateViewerOnTrackingEnabled()) {
+                    _imp->curArgs.timeline->seekFrame(slowestFrame, true, 0, Natron::eTimelineChangeReasonPlaybackSeek);
+                }
+
+                if (reportProgress) {
+                    Q_EMIT progressUpdate(forward ? (double)(slowestFrame - start) / framesCount :
+                                          (double)(start - slowestFrame) / framesCount);
+                }
+            }
+        }
+
+        ///Always emitted, even when trackingStarted() was not, so that a caller can wait for the request to be done
+        Q_EMIT trackingFinished();
+
+        ///Do not hold the knobs and the timeline once done
+        _imp->curArgs.instances.clear();
+        _imp->curArgs.timeline.reset();
+
+        ///Flag that we're no longer working
+        {
+            QMutexLocker k(&_imp->isWorkingMutex);
+            _imp->isWorking = false;
+        }
+
+        ///Make sure we really reset the abort flag
+        {
+            QMutexLocker k(&_imp->abortRequestedMutex);
+            if (_imp->abortRequested > 0) {
+                _imp->abortRequested = 0;
+
+            }
+        }
+
+        ///Sleep or restart if we've requests in the queue
+        {
+            QMutexLocker k(&_imp->startRequesstMutex);
+            while (_imp->startRequests <= 0) {
+                _imp->startRequestsCond.wait(&_imp->startRequesstMutex);
+            }
+            _imp->startRequests = 0;
+        }
+
+    }
+}
+
+void
+TrackScheduler::track(int startingFrame,int end,bool forward, const std::list<Button_Knob*> & selectedInstances,
+                      const boost::shared_ptr<TimeLine>& timeline)
+{
+    if ((forward && startingFrame >= end) || (!forward && startingFrame <= end)) {
+        Q_EMIT trackingFinished();
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->argsMutex);
+        _imp->requestedArgs.start = startingFrame;
+        _imp->requestedArgs.end = end;
+        _imp->requestedArgs.forward = forward;
+        _imp->requestedArgs.instances = selectedInstances;
+        _imp->requestedArgs.timeline = timeline;
+    }
+    if (isRunning()) {
+        QMutexLocker k(&_imp->startRequesstMutex);
+        ++_imp->startRequests;
+        _imp->startRequestsCond.wakeAll();
+    } else {
+        start();
+    }
+}
+
+
+void TrackScheduler::abortTracking()
+{
+    if (!isRunning() || !isWorking()) {
+        return;
+    }
+
+
+    {
+        QMutexLocker k(&_imp->abortRequestedMutex);
+        ++_imp->abortRequested;
+        _imp->abortRequestedCond.wakeAll();
+    }
+
+}
+
+void
+TrackScheduler::quitThread()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    abortTracking();
+
+    {
+        QMutexLocker k(&_imp->mustQuitMutex);
+        _imp->mustQuit = true;
+
+        {
+            QMutexLocker k(&_imp->startRequesstMutex);
+            ++_imp->startRequests;
+            _imp->startRequestsCond.wakeAll();
+        }
+
+        while (_imp->mustQuit) {
+            _imp->mustQuitCond.wait(&_imp->mustQuitMutex);
+        }
+
+    }
+
+
+    wait();
+
+}
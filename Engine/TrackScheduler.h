@@ -0,0 +1,88 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_TRACKSCHEDULER_H_
+#define NATRON_ENGINE_TRACKSCHEDULER_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QThread>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+class Button_Knob;
+class TimeLine;
+
+/**
+ * @brief Tracks a set of tracker instances over a frame range, without any dependency on the GUI.
+ * Each track is a pipeline of its own: the next frame of a track is scheduled on the global thread pool as soon
+ * as its previous frame is done, without waiting for the other tracks. The tracks all read the same source
+ * so the first one to reach a frame renders it in the cache for the others.
+ **/
+struct TrackSchedulerPrivate;
+class TrackScheduler : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    TrackScheduler();
+
+    virtual ~TrackScheduler();
+
+    /**
+     * @brief Track the selectedInstances, calling the instance change action on each button (either the previous or
+     * next button) in a separate thread.
+     * @param start the first frame to track, if forward is true then start < end
+     * @param end the next frame after the last frame to track (a la STL iterators), if forward is true then end > start
+     * @param timeline If set and updating the viewer is enabled, the timeline is moved to the last frame tracked by all tracks
+     **/
+    void track(int start,int end,bool forward,const std::list<Button_Knob*> & selectedInstances,
+               const boost::shared_ptr<TimeLine>& timeline = boost::shared_ptr<TimeLine>());
+
+    void abortTracking();
+
+    void quitThread();
+
+    bool isWorking() const;
+
+    void setUpdateViewerOnTracking(bool update);
+
+    bool isUpdateViewerOnTrackingEnabled() const;
+
+Q_SIGNALS:
+
+    ///Only emitted when there is more than one frame or track to track
+    void trackingStarted();
+
+    ///Emitted once tracking is done or aborted, or right away from track() if the frame range is empty
+    void trackingFinished();
+
+    ///The progress of the slowest track
+    void progressUpdate(double progress);
+
+    ///The progress of the track at the given index in the list passed to track()
+    void trackProgressUpdate(int track,double progress);
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+
+    boost::scoped_ptr<TrackSchedulerPrivate> _imp;
+
+};
+
+#endif // NATRON_ENGINE_TRACKSCHEDULER_H_
@@ -15,8 +15,14 @@
 
 #include "ViewerInstancePrivate.h"
 
+#include <algorithm>
+#include <cstring> // for memcpy
+#include <limits>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 
 CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QtGlobal>
@@ -43,6 +49,7 @@ CLANG_DIAG_ON(deprecated)
 #include "Engine/Project.h"
 #include "Engine/OpenGLViewerI.h"
 #include "Engine/Image.h"
+#include "Engine/HistogramCPU.h"
 #include "Engine/OutputSchedulerThread.h"
 
 #ifndef M_LN2
@@ -58,18 +65,14 @@ static void scaleToTexture8bits(std::pair<int,int> yRange,
                                 const RenderViewerArgs & args,
                                 ViewerInstance* viewer,
                                 U32* output);
-static void scaleToTexture32bits(std::pair<int,int> yRange,
-                                 const RenderViewerArgs & args,
-                                 ViewerInstance* viewer,
-                                 float *output);
 static std::pair<double, double>
-findAutoContrastVminVmax(boost::shared_ptr<const Natron::Image> inputImage,
-                         Natron::DisplayChannelsEnum channels,
+scaleToTexture32bits(std::pair<int,int> yRange,
+                     const RenderViewerArgs & args,
+                     ViewerInstance* viewer,
+                     float *output);
+static std::pair<double, double>
+findAutoContrastVminVmax(const RenderViewerArgs & args,
                          const RectI & rect);
-static void renderFunctor(std::pair<int,int> yRange,
-                          const RenderViewerArgs & args,
-                          ViewerInstance* viewer,
-                          void *buffer);
 
 /**
  *@brief Actually converting to ARGB... but it is called BGRA by
@@ -85,6 +88,42 @@ toBGRA(unsigned char r,
     return (a << 24) | (r << 16) | (g << 8) | b;
 }
 
+///Merges the (vmin, vmax) pairs computed on separate portions of the image
+static std::pair<double, double>
+mergeVminVmax(const QList<std::pair<double, double> > & results)
+{
+    std::pair<double, double> ret(std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity());
+    for (int i = 0; i < results.size(); ++i) {
+        ret.first = std::min(ret.first, results[i].first);
+        ret.second = std::max(ret.second, results[i].second);
+    }
+    return ret;
+}
+
+///Computes the gain and offset mapping [vmin, vmax] to [0, 1]
+static void
+autoContrastGainAndOffset(std::pair<double, double> vMinMax,
+                          double* gain,
+                          double* offset)
+{
+    double vmin = vMinMax.first;
+    double vmax = vMinMax.second;
+    
+    ///An empty image has an infinite range
+    if (vmin > vmax) {
+        vmin = 0.;
+        vmax = 1.;
+    }
+    
+    ///if vmax - vmin is greater than 1 the gain will be really small and we won't see
+    ///anything in the image
+    if (vmin == vmax) {
+        vmin = vmax - 1.;
+    }
+    *gain = 1 / (vmax - vmin);
+    *offset = -vmin / (vmax - vmin);
+}
+
 const Natron::Color::Lut*
 ViewerInstance::lutFromColorspace(Natron::ViewerColorSpaceEnum cs)
 {
@@ -360,6 +399,207 @@ static bool checkTreeCanRender(Node* node)
 
 
 
+/// the number of bytes of a pixel of a viewer texture: 8-bit BGRA or 32-bit float RGBA
+static std::size_t
+viewerTexturePixelSize(int bitDepth)
+{
+    return ( (bitDepth == OpenGLViewerI::eBitDepthFloat) || (bitDepth == OpenGLViewerI::eBitDepthHalf) ) ? 4 * sizeof(float) : 4;
+}
+
+/**
+ * @brief Copies the pixels of rect from src, the buffer of the texture srcRect, to dst, the buffer of the texture dstRect.
+ * Both textures must contain rect.
+ **/
+static void
+copyViewerTextureRect(const unsigned char* src,
+                      const RectI & srcRect,
+                      unsigned char* dst,
+                      const RectI & dstRect,
+                      const RectI & rect,
+                      std::size_t pixelSize)
+{
+    assert( srcRect.contains(rect) && dstRect.contains(rect) );
+    const std::size_t rowBytes = rect.width() * pixelSize;
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        const unsigned char* srcRow = src + ( (std::size_t)(y - srcRect.y1) * srcRect.width() + (rect.x1 - srcRect.x1) ) * pixelSize;
+        unsigned char* dstRow = dst + ( (std::size_t)(y - dstRect.y1) * dstRect.width() + (rect.x1 - dstRect.x1) ) * pixelSize;
+        std::memcpy(dstRow, srcRow, rowBytes);
+    }
+}
+
+/**
+ * @brief Splits the texture in tiles. The texture rectangle is made of the cells of the tile grid that intersect the
+ * visible portion of the image, clipped to the image bounds (@see getImageRectangleDisplayedRoundedToTileSize):
+ * the tile of a cell is then the same whatever the visible portion of the image is.
+ **/
+static void
+makeViewerTiles(const FrameKey & textureKey,
+                const TextureRect & texRect,
+                std::vector<ViewerTile>* tiles)
+{
+    const int tileSize = 1 << appPTR->getCurrentSettings()->getViewerTilesPowerOf2();
+    const int gridX1 = (int)std::floor( (double)texRect.x1 / tileSize ) * tileSize;
+    const int gridY1 = (int)std::floor( (double)texRect.y1 / tileSize ) * tileSize;
+    
+    tiles->clear();
+    for (int y = gridY1; y < texRect.y2; y += tileSize) {
+        for (int x = gridX1; x < texRect.x2; x += tileSize) {
+            ViewerTile tile;
+            tile.rect.set( std::max(x, texRect.x1), std::max(y, texRect.y1),
+                           std::min(x + tileSize, texRect.x2), std::min(y + tileSize, texRect.y2) );
+            TextureRect tileTexRect(tile.rect.x1, tile.rect.y1, tile.rect.x2, tile.rect.y2,
+                                    tile.rect.width(), tile.rect.height(), texRect.closestPo2, texRect.par);
+            tile.key.reset( new FrameKey(textureKey, tileTexRect) );
+            tiles->push_back(tile);
+        }
+    }
+}
+
+/**
+ * @brief Copies the tiles of params that were found in the cache to its texture buffer. The tiles that cannot be
+ * copied, because another thread is rendering them or because their render was aborted, are removed from the tiles
+ * found in the cache, so that they get rendered.
+ * @returns True if all the tiles were copied.
+ **/
+static bool
+copyCachedViewerTiles(LockManagerI<Natron::FrameEntry>* lockManager,
+                      UpdateViewerParams* params)
+{
+    const RectI texRect(params->textureRect.x1, params->textureRect.y1, params->textureRect.x2, params->textureRect.y2);
+    bool allCopied = true;
+    
+    for (std::size_t i = 0; i < params->tiles.size(); ++i) {
+        ViewerTile & tile = params->tiles[i];
+        if (!tile.cachedFrame || tile.isRendered) {
+            allCopied = false;
+            continue;
+        }
+        
+        /// make sure we have the lock on the tile because it may be in the cache already
+        ///but not yet rendered.
+        FrameEntryLocker entryLocker(lockManager);
+        if ( !entryLocker.tryLock(tile.cachedFrame) || tile.cachedFrame->getAborted() ) {
+            tile.cachedFrame.reset();
+            allCopied = false;
+            continue;
+        }
+        
+        copyViewerTextureRect(tile.cachedFrame->data(), tile.rect, params->ramBuffer, texRect, tile.rect,
+                              viewerTexturePixelSize( tile.key->getBitDepth() ) );
+    }
+    
+    return allCopied;
+}
+
+/**
+ * @brief Removes the texture or the tiles rendered by an aborted render from the cache, since they contain only garbage.
+ * Another thread might successfully have found them in the cache: they are flagged as aborted for it.
+ **/
+static void
+abortRenderedViewerTextures(UpdateViewerParams* params)
+{
+    if (params->cachedFrame) {
+        params->cachedFrame->setAborted(true);
+        appPTR->removeFromViewerCache(params->cachedFrame);
+        params->cachedFrame.reset();
+    }
+    for (std::size_t i = 0; i < params->tiles.size(); ++i) {
+        ViewerTile & tile = params->tiles[i];
+        if (tile.isRendered) {
+            tile.cachedFrame->setAborted(true);
+            appPTR->removeFromViewerCache(tile.cachedFrame);
+            tile.cachedFrame.reset();
+            tile.isRendered = false;
+        }
+    }
+}
+
+///The maximum number of bins of histograms kept for the textures and tiles of the viewer cache, for each input
+#define kViewerCachedHistogramsMaxCount 256
+
+void
+ViewerInstance::ViewerInstancePrivate::storeCachedHistogram(int textureIndex,
+                                                             U64 entryHash,
+                                                             const boost::shared_ptr<HistogramBins> & bins)
+{
+    QMutexLocker l(&histogramMutex);
+    const ViewerHistogramRequest & request = histogramRequest[textureIndex];
+    if ( !bins->isValidFor(request.mode, request.binsCount, request.vmin, request.vmax, bins->rect) ) {
+        ///The request changed during the render
+        return;
+    }
+    std::map<U64, boost::shared_ptr<HistogramBins> > & histograms = cachedHistograms[textureIndex];
+    ///The entries evicted from the viewer cache are not notified: just start over when there are too many
+    if (histograms.size() >= kViewerCachedHistogramsMaxCount) {
+        histograms.clear();
+    }
+    histograms[entryHash] = bins;
+}
+
+void
+ViewerInstance::ViewerInstancePrivate::setLastHistogramFromTiles(int textureIndex,
+                                                                  const Natron::FrameKey & key,
+                                                                  const RectI & imageBounds,
+                                                                  const std::vector<ViewerTile> & tiles)
+{
+    const TextureRect & texRect = key.getTextureRect();
+    const RectI rect(texRect.x1, texRect.y1, texRect.x2, texRect.y2);
+
+    QMutexLocker l(&histogramMutex);
+    lastHistogram[textureIndex].reset();
+    const ViewerHistogramRequest & request = histogramRequest[textureIndex];
+    if ( (request.binsCount <= 0) || (request.fullImage && rect != imageBounds) ) {
+        return;
+    }
+    const std::map<U64, boost::shared_ptr<HistogramBins> > & histograms = cachedHistograms[textureIndex];
+    std::map<U64, boost::shared_ptr<HistogramBins> >::const_iterator found = histograms.find( key.getHash() );
+    if ( (found != histograms.end()) && found->second->isValidFor(request.mode, request.binsCount, request.vmin, request.vmax, rect) ) {
+        lastHistogram[textureIndex] = found->second;
+
+        return;
+    }
+    if ( tiles.empty() ) {
+        return;
+    }
+    boost::shared_ptr<HistogramBins> bins( new HistogramBins(request.mode, request.binsCount, request.vmin, request.vmax, rect) );
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+        boost::shared_ptr<HistogramBins> tileBins = tiles[i].histogram;
+        if (!tileBins) {
+            found = histograms.find( tiles[i].key->getHash() );
+            if ( found != histograms.end() ) {
+                tileBins = found->second;
+            }
+        }
+        ///the request may have changed since the tile was converted
+        if ( !tileBins || !tileBins->isValidFor(request.mode, request.binsCount, request.vmin, request.vmax, tiles[i].rect) ) {
+            return;
+        }
+        bins->merge(*tileBins);
+    }
+    lastHistogram[textureIndex] = bins;
+}
+
+/// a tile of the viewer texture converted on its own, to the buffer of its cache entry or to a temporary buffer
+struct ViewerTileConversion
+{
+    ViewerTileConversion(const RenderViewerArgs & args_,
+                         unsigned char* buffer_)
+    : args(args_)
+    , buffer(buffer_)
+    {
+    }
+
+    RenderViewerArgs args;
+    unsigned char* buffer;
+};
+
+static void
+renderViewerTileFunctor(const ViewerTileConversion & tile,
+                        ViewerInstance* viewer)
+{
+    renderFunctor(std::make_pair(tile.args.texRect.y1, tile.args.texRect.y2), tile.args, viewer, tile.buffer);
+}
+
 Natron::StatusEnum
 ViewerInstance::getRenderViewerArgsAndCheckCache(SequenceTime time,
                                                  bool isSequential,
@@ -538,6 +778,13 @@ ViewerInstance::getRenderViewerArgsAndCheckCache(SequenceTime time,
     assert(_imp->uiContext);
     OpenGLViewerI::BitDepthEnum bitDepth = _imp->uiContext->getBitDepth();
     
+    ///With the compact playback cache, the frames rendered for playback are 8-bit textures
+    if ( isSequential && (bitDepth != OpenGLViewerI::eBitDepthByte) &&
+         appPTR->getCurrentSettings()->isViewerCompactPlaybackCacheEnabled() ) {
+        bitDepth = OpenGLViewerI::eBitDepthByte;
+    }
+    outArgs->params->bitDepth = (int)bitDepth;
+    
     //half float is not supported yet so it is the same as float
     if ( (bitDepth == OpenGLViewerI::eBitDepthFloat) || (bitDepth == OpenGLViewerI::eBitDepthHalf) ) {
         outArgs->params->bytesCount *= sizeof(float);
@@ -558,10 +805,13 @@ ViewerInstance::getRenderViewerArgsAndCheckCache(SequenceTime time,
     }
     std::string inputToRenderName = outArgs->activeInputToRender->getNode()->getScriptName_mt_safe();
     
+    ///The gain and the color-space are applied by the OpenGL shader to float textures: changing them
+    ///does not require to render these again.
+    const bool gainInTexture = (bitDepth == OpenGLViewerI::eBitDepthByte);
     outArgs->key.reset(new FrameKey(time,
                                     viewerHash,
-                                    outArgs->params->gain,
-                                    outArgs->params->lut,
+                                    gainInTexture ? outArgs->params->gain : 1.,
+                                    gainInTexture ? (int)outArgs->params->lut : (int)Natron::eViewerColorSpaceLinear,
                                     (int)bitDepth,
                                     channels,
                                     view,
@@ -571,15 +821,13 @@ ViewerInstance::getRenderViewerArgsAndCheckCache(SequenceTime time,
                                     outArgs->params->layer,
                                     outArgs->params->alphaLayer.getLayerName() + outArgs->params->alphaChannelName));
     
-    bool isCached = false;
-    
     ///we never use the texture cache when the user RoI is enabled, otherwise we would have
     ///zillions of textures in the cache, each a few pixels different.
     assert(_imp->uiContext);
-    boost::shared_ptr<Natron::FrameParams> cachedFrameParams;
     
     if (!_imp->uiContext->isUserRegionOfInterestEnabled() && !autoContrast) {
-        isCached = Natron::getTextureFromCache(*(outArgs->key), &outArgs->params->cachedFrame);
+        
+        bool isCached = Natron::getTextureFromCache(*(outArgs->key), &outArgs->params->cachedFrame);
         
         ///if we want to force a refresh, we by-pass the cache
         if (outArgs->forceRender && outArgs->params->cachedFrame) {
@@ -587,10 +835,27 @@ ViewerInstance::getRenderViewerArgsAndCheckCache(SequenceTime time,
             isCached = false;
             outArgs->params->cachedFrame.reset();
         }
-
-        if (isCached) {
-            assert(outArgs->params->cachedFrame);
-            cachedFrameParams = outArgs->params->cachedFrame->getParams();
+        
+        ///Playback caches whole textures, which are then displayed without any copy. Interactive renders cache
+        ///the texture by tiles, so that panning and zooming only render the tiles that are not cached yet.
+        ///A texture made of a single tile is the same entry in both cases.
+        bool areTilesCached = false;
+        if (!isCached && !isSequential) {
+            makeViewerTiles(*outArgs->key, outArgs->params->textureRect, &outArgs->params->tiles);
+            
+            areTilesCached = true;
+            for (std::size_t i = 0; i < outArgs->params->tiles.size(); ++i) {
+                ViewerTile & tile = outArgs->params->tiles[i];
+                if ( !Natron::getTextureFromCache(*tile.key, &tile.cachedFrame) ) {
+                    areTilesCached = false;
+                }
+                
+                if (outArgs->forceRender && tile.cachedFrame) {
+                    appPTR->removeFromViewerCache(tile.cachedFrame);
+                    tile.cachedFrame.reset();
+                    areTilesCached = false;
+                }
+            }
         }
         
         ///The user changed a parameter or the tree, just clear the cache
@@ -608,55 +873,90 @@ ViewerInstance::getRenderViewerArgsAndCheckCache(SequenceTime time,
                 QMutexLocker l(&_imp->lastRenderedHashMutex);
                 _imp->lastRenderedHashValid = false;
             }
+            {
+                QMutexLocker l(&_imp->histogramMutex);
+                _imp->cachedHistograms[0].clear();
+                _imp->cachedHistograms[1].clear();
+            }
         }
-    }
-    
-    if (isCached) {
-        
-        /// make sure we have the lock on the texture because it may be in the cache already
-        ///but not yet allocated.
-        FrameEntryLocker entryLocker(_imp.get());
-        if (!entryLocker.tryLock(outArgs->params->cachedFrame)) {
-            outArgs->params->cachedFrame.reset();
-            ///Another thread is rendering it, just return it is not useful to keep this thread waiting.
-            //return eStatusReplyDefault;
-            return eStatusOK;
-        }
-        
-        if (outArgs->params->cachedFrame->getAborted()) {
-            ///The thread rendering the frame entry might have been aborted and the entry removed from the cache
-            ///but another thread might successfully have found it in the cache. This flag is to notify it the frame
-            ///is invalid.
-            outArgs->params->cachedFrame.reset();
-            return eStatusOK;
-        }
-        
-        // how do you make sure cachedFrame->data() is not freed after this line?
-        ///It is not freed as long as the cachedFrame shared_ptr has a used_count greater than 1.
-        ///Since it is used during the whole function scope it is guaranteed not to be freed before
-        ///The viewer is actually done with it.
-        /// @see Cache::clearInMemoryPortion and Cache::clearDiskPortion and LRUHashTable::evict
-        ///
         
+        RectI bounds;
+        rod.toPixelEnclosing(mipMapLevel, par, &bounds);
         
-        outArgs->params->ramBuffer = outArgs->params->cachedFrame->data();
-        
-        {
-            QMutexLocker l(&_imp->lastRenderedHashMutex);
-            _imp->lastRenderedHash = viewerHash;
-            _imp->lastRenderedHashValid = true;
+        if (isCached) {
+            
+            /// make sure we have the lock on the texture because it may be in the cache already
+            ///but not yet allocated.
+            FrameEntryLocker entryLocker(_imp.get());
+            if (!entryLocker.tryLock(outArgs->params->cachedFrame)) {
+                outArgs->params->cachedFrame.reset();
+                ///Another thread is rendering it, just return it is not useful to keep this thread waiting.
+                //return eStatusReplyDefault;
+                return eStatusOK;
+            }
+            
+            if (outArgs->params->cachedFrame->getAborted()) {
+                ///The thread rendering the frame entry might have been aborted and the entry removed from the cache
+                ///but another thread might successfully have found it in the cache. This flag is to notify it the frame
+                ///is invalid.
+                outArgs->params->cachedFrame.reset();
+                return eStatusOK;
+            }
+            
+            // how do you make sure cachedFrame->data() is not freed after this line?
+            ///It is not freed as long as the cachedFrame shared_ptr has a used_count greater than 1.
+            ///Since it is used during the whole function scope it is guaranteed not to be freed before
+            ///The viewer is actually done with it.
+            /// @see Cache::clearInMemoryPortion and Cache::clearDiskPortion and LRUHashTable::evict
+            ///
+            
+            
+            outArgs->params->ramBuffer = outArgs->params->cachedFrame->data();
+            
+            if (!isSequential) {
+                ///The texture may have been rendered by tiles before being rendered as a whole
+                makeViewerTiles(*outArgs->key, outArgs->params->textureRect, &outArgs->params->tiles);
+            }
+            _imp->setLastHistogramFromTiles(textureIndex, *outArgs->key, bounds, outArgs->params->tiles);
+            outArgs->params->tiles.clear();
+            
+            {
+                QMutexLocker l(&_imp->lastRenderedHashMutex);
+                _imp->lastRenderedHash = viewerHash;
+                _imp->lastRenderedHashValid = true;
+            }
+            
+        } else if (areTilesCached) {
+            ///Assemble the texture from the tiles. If one of them is being rendered by another thread or was aborted,
+            ///the texture is rendered instead, which only renders the tiles that could not be copied.
+            outArgs->params->mustFreeRamBuffer = true;
+            outArgs->params->ramBuffer = (unsigned char*)malloc(outArgs->params->bytesCount);
+            if ( !copyCachedViewerTiles(_imp.get(), outArgs->params.get()) ) {
+                free(outArgs->params->ramBuffer);
+                outArgs->params->ramBuffer = NULL;
+                outArgs->params->mustFreeRamBuffer = false;
+                
+                return eStatusOK;
+            }
+            
+            _imp->setLastHistogramFromTiles(textureIndex, *outArgs->key, bounds, outArgs->params->tiles);
+            
+            ///The tiles are not needed anymore, do not keep them out of the cache's reach
+            outArgs->params->tiles.clear();
+            
+            {
+                QMutexLocker l(&_imp->lastRenderedHashMutex);
+                _imp->lastRenderedHash = viewerHash;
+                _imp->lastRenderedHashValid = true;
+            }
         }
-        
     }
     return eStatusOK;
 }
 
-//if render was aborted, remove the frame from the cache as it contains only garbage
+//if render was aborted, remove the tiles from the cache as they contain only garbage
 #define abortCheck(input) if ( input->aborted() ) { \
-                                if (inArgs.params->cachedFrame) { \
-                                    inArgs.params->cachedFrame->setAborted(true); \
-                                    appPTR->removeFromViewerCache(inArgs.params->cachedFrame); \
-                                } \
+                                abortRenderedViewerTextures( inArgs.params.get() ); \
                                 /*_imp->checkAndUpdateDisplayAge(inArgs.params->textureIndex,inArgs.params->renderAge);*/ \
                                 if (!isSequentialRender && canAbort) { \
                                     _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge); \
@@ -728,6 +1028,9 @@ ViewerInstance::renderViewer_internal(int view,
     ///Don't allow different threads to write the texture entry
     FrameEntryLocker entryLocker(_imp.get());
     
+    ///Don't allow different threads to write the same tile
+    std::vector<boost::shared_ptr<FrameEntryLocker> > tileLockers;
+    
     ///If the user RoI is enabled, the odds that we find a texture containing exactly the same portion
     ///is very low, we better render again (and let the NodeCache do the work) rather than just
     ///overload the ViewerCache which may become slowe
@@ -735,10 +1038,11 @@ ViewerInstance::renderViewer_internal(int view,
     if (inArgs.forceRender || _imp->uiContext->isUserRegionOfInterestEnabled() || autoContrast) {
         
         assert(!inArgs.params->cachedFrame);
+        inArgs.params->tiles.clear();
         inArgs.params->mustFreeRamBuffer = true;
         inArgs.params->ramBuffer =  (unsigned char*)malloc(inArgs.params->bytesCount);
         
-    } else {
+    } else if (isSequentialRender) {
         
         // For the viewer, we need the enclosing rectangle to avoid black borders.
         // Do this here to avoid infinity values.
@@ -755,20 +1059,11 @@ ViewerInstance::renderViewer_internal(int view,
             ss << "Failed to allocate a texture of ";
             ss << printAsRAM( cachedFrameParams->getElementsCount() * sizeof(FrameEntry::data_t) ).toStdString();
             Natron::errorDialog( QObject::tr("Out of memory").toStdString(),ss.str() );
-            if (!isSequentialRender) {
-                _imp->checkAndUpdateDisplayAge(inArgs.params->textureIndex,inArgs.params->renderAge);
-            }
-            if (!isSequentialRender && canAbort) {
-                _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
-            }
             return eStatusFailed;
         }
         
         if (!entryLocker.tryLock(inArgs.params->cachedFrame)) {
             ///Another thread is rendering it, just return it is not useful to keep this thread waiting.
-            if (!isSequentialRender && canAbort) {
-                _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
-            }
             inArgs.params.reset();
             return eStatusReplyDefault;
         }
@@ -776,8 +1071,6 @@ ViewerInstance::renderViewer_internal(int view,
         ///The entry has already been locked by the cache
         inArgs.params->cachedFrame->allocateMemory();
         
-    
-        
         assert(inArgs.params->cachedFrame);
         // how do you make sure cachedFrame->data() is not freed after this line?
         ///It is not freed as long as the cachedFrame shared_ptr has a used_count greater than 1.
@@ -791,6 +1084,85 @@ ViewerInstance::renderViewer_internal(int view,
             _imp->lastRenderedHashValid = true;
             _imp->lastRenderedHash = viewerHash;
         }
+        
+    } else {
+        
+        ///The texture is assembled from its tiles: those found in the cache are copied, only the others are rendered
+        assert(!inArgs.params->cachedFrame);
+        inArgs.params->mustFreeRamBuffer = true;
+        inArgs.params->ramBuffer =  (unsigned char*)malloc(inArgs.params->bytesCount);
+        if ( inArgs.params->tiles.empty() ) {
+            makeViewerTiles(*inArgs.key, inArgs.params->textureRect, &inArgs.params->tiles);
+        }
+        copyCachedViewerTiles(_imp.get(), inArgs.params.get());
+        
+        // For the viewer, we need the enclosing rectangle to avoid black borders.
+        // Do this here to avoid infinity values.
+        RectI bounds;
+        inArgs.params->rod.toPixelEnclosing(inArgs.params->mipMapLevel, inArgs.params->textureRect.par, &bounds);
+        
+        for (std::size_t i = 0; i < inArgs.params->tiles.size(); ++i) {
+            ViewerTile & tile = inArgs.params->tiles[i];
+            if (tile.cachedFrame) {
+                continue;
+            }
+            boost::shared_ptr<Natron::FrameParams> cachedFrameParams =
+            FrameEntry::makeParams(bounds,inArgs.key->getBitDepth(), tile.rect.width(), tile.rect.height());
+            Natron::getTextureFromCacheOrCreate(*tile.key, cachedFrameParams, &tile.cachedFrame);
+            if (!tile.cachedFrame) {
+                std::stringstream ss;
+                ss << "Failed to allocate a texture of ";
+                ss << printAsRAM( cachedFrameParams->getElementsCount() * sizeof(FrameEntry::data_t) ).toStdString();
+                Natron::errorDialog( QObject::tr("Out of memory").toStdString(),ss.str() );
+                abortRenderedViewerTextures( inArgs.params.get() );
+                _imp->checkAndUpdateDisplayAge(inArgs.params->textureIndex,inArgs.params->renderAge);
+                if (canAbort) {
+                    _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
+                }
+                return eStatusFailed;
+            }
+            
+            boost::shared_ptr<FrameEntryLocker> tileLocker( new FrameEntryLocker( _imp.get() ) );
+            if ( !tileLocker->tryLock(tile.cachedFrame) ) {
+                ///Another thread is rendering it: render it anyway, but leave it to the other thread to fill the cache
+                tile.cachedFrame.reset();
+                continue;
+            }
+            tileLockers.push_back(tileLocker);
+            
+            ///The entry has already been locked by the cache
+            tile.cachedFrame->allocateMemory();
+            tile.isRendered = true;
+        }
+        
+        {
+            QMutexLocker l(&_imp->lastRenderedHashMutex);
+            _imp->lastRenderedHashValid = true;
+            _imp->lastRenderedHash = viewerHash;
+        }
+        
+        ///Only render the bounding box of the tiles that were not copied
+        RectI tilesRoI;
+        for (std::size_t i = 0; i < inArgs.params->tiles.size(); ++i) {
+            const ViewerTile & tile = inArgs.params->tiles[i];
+            if (!tile.cachedFrame || tile.isRendered) {
+                if ( tilesRoI.isNull() ) {
+                    tilesRoI = tile.rect;
+                } else {
+                    tilesRoI.merge(tile.rect);
+                }
+            }
+        }
+        if ( tilesRoI.isNull() ) {
+            ///All the tiles were rendered by other threads in the meantime
+            _imp->setLastHistogramFromTiles(inArgs.params->textureIndex, *inArgs.key, bounds, inArgs.params->tiles);
+            inArgs.params->tiles.clear();
+            if (canAbort) {
+                _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
+            }
+            return eStatusOK;
+        }
+        roi = tilesRoI;
     }
     assert(inArgs.params->ramBuffer);
     
@@ -825,12 +1197,11 @@ ViewerInstance::renderViewer_internal(int view,
     }
     
     if (requestedComponents.empty()) {
-        if (inArgs.params->cachedFrame) {
-            inArgs.params->cachedFrame->setAborted(true);
+        if ( inArgs.params->cachedFrame || !inArgs.params->tiles.empty() ) {
+            abortRenderedViewerTextures( inArgs.params.get() );
             if (!isSequentialRender) {
                 _imp->checkAndUpdateDisplayAge(inArgs.params->textureIndex,inArgs.params->renderAge);
             }
-            appPTR->removeFromViewerCache(inArgs.params->cachedFrame);
         }
         if (!isSequentialRender && canAbort) {
             _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
@@ -887,12 +1258,11 @@ ViewerInstance::renderViewer_internal(int view,
                 inArgs.params->image = planes.front();
             }
             if (!inArgs.params->image) {
-                if (inArgs.params->cachedFrame) {
-                    inArgs.params->cachedFrame->setAborted(true);
+                if ( inArgs.params->cachedFrame || !inArgs.params->tiles.empty() ) {
+                    abortRenderedViewerTextures( inArgs.params.get() );
                     if (!isSequentialRender) {
                         _imp->checkAndUpdateDisplayAge(inArgs.params->textureIndex,inArgs.params->renderAge);
                     }
-                    appPTR->removeFromViewerCache(inArgs.params->cachedFrame);
                 }
                 if (!isSequentialRender && canAbort) {
                     _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
@@ -919,11 +1289,7 @@ ViewerInstance::renderViewer_internal(int view,
     ///We check that the render age is still OK and that no other renders were triggered, in which case we should not need to
     ///refresh the viewer.
     if (!_imp->checkAgeNoUpdate(inArgs.params->textureIndex,inArgs.params->renderAge)) {
-        if (inArgs.params->cachedFrame) {
-            inArgs.params->cachedFrame->setAborted(true);
-            appPTR->removeFromViewerCache(inArgs.params->cachedFrame);
-            inArgs.params->cachedFrame.reset();
-        }
+        abortRenderedViewerTextures( inArgs.params.get() );
         if (!isSequentialRender && canAbort) {
             _imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge);
         }
@@ -933,11 +1299,7 @@ ViewerInstance::renderViewer_internal(int view,
     abortCheck(inArgs.activeInputToRender);
     
     if (!isSequentialRender && canAbort && !_imp->removeOngoingRender(inArgs.params->textureIndex, inArgs.params->renderAge)) {
-        if (inArgs.params->cachedFrame) {
-            inArgs.params->cachedFrame->setAborted(true);
-            appPTR->removeFromViewerCache(inArgs.params->cachedFrame);
-            inArgs.params->cachedFrame.reset();
-        }
+        abortRenderedViewerTextures( inArgs.params.get() );
         return eStatusReplyDefault;
     }
 
@@ -946,127 +1308,191 @@ ViewerInstance::renderViewer_internal(int view,
     
     assert(alphaChannelIndex < (int)inArgs.params->image->getComponentsCount());
     
-    if (singleThreaded) {
-        if (autoContrast) {
-            double vmin, vmax;
-            std::pair<double,double> vMinMax = findAutoContrastVminVmax(inArgs.params->image, channels, roi);
-            vmin = vMinMax.first;
-            vmax = vMinMax.second;
-            
-            ///if vmax - vmin is greater than 1 the gain will be really small and we won't see
-            ///anything in the image
-            if (vmin == vmax) {
-                vmin = vmax - 1.;
+    const bool orderedDither = appPTR->getCurrentSettings()->isViewerOrderedDitheringEnabled();
+    
+    ///With float textures the gain and offset are applied by the OpenGL shader: the auto-contrast range can then
+    ///be computed while converting the image instead of in a separate pass over it.
+    const int textureBitDepth = inArgs.key->getBitDepth();
+    const bool fuseAutoContrast = autoContrast && (textureBitDepth == OpenGLViewerI::eBitDepthFloat ||
+                                                   textureBitDepth == OpenGLViewerI::eBitDepthHalf);
+    
+    ///If a histogram of this input was requested, its bins are accumulated while converting the image. This is only
+    ///possible when the conversion sees the values of the image itself: a linear float image displayed in RGB or Y,
+    ///and when the histogram is the one of the texture, which is the displayed portion of the image rounded to the
+    ///tiles (@see getImageRectangleDisplayedRoundedToTileSize), or the whole image when all of it is displayed.
+    const RectI texRect(inArgs.params->textureRect.x1, inArgs.params->textureRect.y1,
+                        inArgs.params->textureRect.x2, inArgs.params->textureRect.y2);
+    RectI bounds;
+    inArgs.params->rod.toPixelEnclosing(inArgs.params->mipMapLevel, inArgs.params->textureRect.par, &bounds);
+    ViewerHistogramRequest request;
+    {
+        QMutexLocker l(&_imp->histogramMutex);
+        request = _imp->histogramRequest[inArgs.params->textureIndex];
+    }
+    const boost::shared_ptr<Natron::Image> & image = inArgs.params->image;
+    const bool computeHistogram = request.binsCount > 0 &&
+    image->getBitDepth() == Natron::eImageBitDepthFloat &&
+    !lutFromColorspace(srcColorSpace) &&
+    (channels == Natron::eDisplayChannelsRGB || channels == Natron::eDisplayChannelsY) &&
+    ( request.mode != 1 || ( image->getComponentsCount() == 4 && inArgs.params->srcPremult != Natron::eImagePremultiplicationOpaque ) ) &&
+    ( !request.fullImage || texRect == bounds );
+    
+    bool runInCurrentThread = singleThreaded ||
+    QThreadPool::globalInstance()->activeThreadCount() >= QThreadPool::globalInstance()->maxThreadCount();
+    
+    if ( !inArgs.params->tiles.empty() ) {
+        
+        ///Each tile that was not copied from the cache is converted on its own, to the buffer of its cache entry if
+        ///this render stores it, with its own histogram bins. There is no auto-contrast here.
+        const std::size_t pixelSize = viewerTexturePixelSize(textureBitDepth);
+        std::vector<ViewerTileConversion> conversions;
+        std::list<std::vector<unsigned char> > tileBuffers;
+        for (std::size_t i = 0; i < inArgs.params->tiles.size(); ++i) {
+            ViewerTile & tile = inArgs.params->tiles[i];
+            if (tile.cachedFrame && !tile.isRendered) {
+                continue;
+            }
+            if (computeHistogram) {
+                tile.histogram.reset( new HistogramBins(request.mode, request.binsCount, request.vmin, request.vmax, tile.rect) );
             }
-            inArgs.params->gain = 1 / (vmax - vmin);
-            inArgs.params->offset = -vmin / ( vmax - vmin);
+            unsigned char* buffer;
+            if (tile.isRendered) {
+                buffer = tile.cachedFrame->data();
+            } else {
+                tileBuffers.push_back( std::vector<unsigned char>( (std::size_t)tile.rect.area() * pixelSize ) );
+                buffer = &tileBuffers.back()[0];
+            }
+            TextureRect tileTexRect(tile.rect.x1, tile.rect.y1, tile.rect.x2, tile.rect.y2,
+                                    tile.rect.width(), tile.rect.height(),
+                                    inArgs.params->textureRect.closestPo2, inArgs.params->textureRect.par);
+            conversions.push_back( ViewerTileConversion(RenderViewerArgs(image,
+                                                                         tileTexRect,
+                                                                         channels,
+                                                                         inArgs.params->srcPremult,
+                                                                         textureBitDepth,
+                                                                         inArgs.params->gain,
+                                                                         inArgs.params->offset,
+                                                                         lutFromColorspace(srcColorSpace),
+                                                                         lutFromColorspace(inArgs.params->lut),
+                                                                         alphaChannelIndex,
+                                                                         orderedDither,
+                                                                         false,
+                                                                         tile.histogram),
+                                                        buffer) );
         }
         
-        const RenderViewerArgs args(inArgs.params->image,
-                                    inArgs.params->textureRect,
-                                    channels,
-                                    inArgs.params->srcPremult,
-                                    inArgs.key->getBitDepth(),
-                                    inArgs.params->gain,
-                                    inArgs.params->offset,
-                                    lutFromColorspace(srcColorSpace),
-                                    lutFromColorspace(inArgs.params->lut),
-                                    alphaChannelIndex);
-        
-        renderFunctor(std::make_pair(roi.y1,roi.y2),
-                      args,
-                      this,
-                      inArgs.params->ramBuffer);
-    } else {
-        
-        int rowsPerThread = std::ceil( (double)(roi.x2 - roi.x1) / appPTR->getHardwareIdealThreadCount() );
-        // group of group of rows where first is image coordinate, second is texture coordinate
-        QList< std::pair<int, int> > splitRows;
-        
-        bool runInCurrentThread = QThreadPool::globalInstance()->activeThreadCount() >= QThreadPool::globalInstance()->maxThreadCount();
-        
-        if (!runInCurrentThread) {
-            int k = roi.y1;
-            while (k < roi.y2) {
-                int top = k + rowsPerThread;
-                int realTop = top > roi.y2 ? roi.y2 : top;
-                splitRows.push_back( std::make_pair(k,realTop) );
-                k += rowsPerThread;
+        if ( runInCurrentThread || (conversions.size() == 1) ) {
+            for (std::size_t i = 0; i < conversions.size(); ++i) {
+                renderViewerTileFunctor(conversions[i], this);
             }
+        } else {
+            QtConcurrent::map( conversions, boost::bind(&renderViewerTileFunctor, _1, this) ).waitForFinished();
         }
         
-        ///if autoContrast is enabled, find out the vmin/vmax before rendering and mapping against new values
-        if (autoContrast) {
-            rowsPerThread = std::ceil( (double)( roi.width() ) / (double)appPTR->getHardwareIdealThreadCount() );
-            
-            std::vector<RectI> splitRects;
-            
-            double vmin = std::numeric_limits<double>::infinity();
-            double vmax = -std::numeric_limits<double>::infinity();
-            
-            if (!runInCurrentThread) {
-                int k = roi.y1;
-                while (k < roi.y2) {
-                    int top = k + rowsPerThread;
-                    int realTop = top > roi.top() ? roi.top() : top;
-                    splitRects.push_back( RectI(roi.left(), k, roi.right(), realTop) );
-                    k += rowsPerThread;
+        if ( aborted() ) {
+            ///The conversion was interrupted
+            abortRenderedViewerTextures( inArgs.params.get() );
+        } else {
+            for (std::size_t i = 0, c = 0; i < inArgs.params->tiles.size(); ++i) {
+                ViewerTile & tile = inArgs.params->tiles[i];
+                if (tile.cachedFrame && !tile.isRendered) {
+                    continue;
                 }
-                
-                
-                QFuture<std::pair<double,double> > future = QtConcurrent::mapped( splitRects,
-                                                                                 boost::bind(findAutoContrastVminVmax,
-                                                                                             inArgs.params->image,
-                                                                                             channels,
-                                                                                             _1) );
-                future.waitForFinished();
-                
-                std::pair<double,double> vMinMax;
-                Q_FOREACH ( vMinMax, future.results() ) {
-                    if (vMinMax.first < vmin) {
-                        vmin = vMinMax.first;
-                    }
-                    if (vMinMax.second > vmax) {
-                        vmax = vMinMax.second;
-                    }
+                copyViewerTextureRect(conversions[c].buffer, tile.rect, inArgs.params->ramBuffer, texRect, tile.rect, pixelSize);
+                ++c;
+                if (tile.isRendered && tile.histogram) {
+                    _imp->storeCachedHistogram(inArgs.params->textureIndex, tile.key->getHash(), tile.histogram);
                 }
-            } else { //!runInCurrentThread
-                std::pair<double,double> vMinMax = findAutoContrastVminVmax(inArgs.params->image, channels, roi);
-                vmin = vMinMax.first;
-                vmax = vMinMax.second;
-            }
-            
-            if (vmax == vmin) {
-                vmin = vmax - 1.;
             }
-            
-            inArgs.params->gain = 1 / (vmax - vmin);
-            inArgs.params->offset =  -vmin / (vmax - vmin);
+            _imp->setLastHistogramFromTiles(inArgs.params->textureIndex, *inArgs.key, bounds, inArgs.params->tiles);
         }
+        ///The tiles are not needed anymore, do not keep them out of the cache's reach
+        inArgs.params->tiles.clear();
         
-        const RenderViewerArgs args(inArgs.params->image,
-                                    inArgs.params->textureRect,
-                                    channels,
-                                    inArgs.params->srcPremult,
-                                    inArgs.key->getBitDepth(),
-                                    inArgs.params->gain,
-                                    inArgs.params->offset,
-                                    lutFromColorspace(srcColorSpace),
-                                    lutFromColorspace(inArgs.params->lut),
-                                    alphaChannelIndex);
+        return eStatusOK;
+    }
+    
+    boost::shared_ptr<HistogramBins> histogram;
+    if (computeHistogram) {
+        histogram.reset( new HistogramBins(request.mode, request.binsCount, request.vmin, request.vmax, texRect) );
+    }
+    
+    RenderViewerArgs args(inArgs.params->image,
+                          inArgs.params->textureRect,
+                          channels,
+                          inArgs.params->srcPremult,
+                          textureBitDepth,
+                          inArgs.params->gain,
+                          inArgs.params->offset,
+                          lutFromColorspace(srcColorSpace),
+                          lutFromColorspace(inArgs.params->lut),
+                          alphaChannelIndex,
+                          orderedDither,
+                          fuseAutoContrast,
+                          histogram);
+    
+    // group of rows, in image coordinates
+    QList< std::pair<int, int> > splitRows;
+    if (!runInCurrentThread) {
+        int rowsPerThread = std::ceil( (double)( roi.height() ) / appPTR->getHardwareIdealThreadCount() );
+        int k = roi.y1;
+        while (k < roi.y2) {
+            int top = k + rowsPerThread;
+            int realTop = top > roi.y2 ? roi.y2 : top;
+            splitRows.push_back( std::make_pair(k,realTop) );
+            k += rowsPerThread;
+        }
+    }
+    
+    ///if autoContrast is enabled with 8-bit textures, find out the vmin/vmax before rendering and mapping against new values
+    if (autoContrast && !fuseAutoContrast) {
+        std::pair<double,double> vMinMax;
         if (runInCurrentThread) {
-            renderFunctor(std::make_pair(inArgs.params->textureRect.y1,inArgs.params->textureRect.y2),
-                          args, this, inArgs.params->ramBuffer);
+            vMinMax = findAutoContrastVminVmax(args, roi);
         } else {
-            QtConcurrent::map( splitRows,
-                              boost::bind(&renderFunctor,
-                                          _1,
-                                          args,
-                                          this,
-                                          inArgs.params->ramBuffer) ).waitForFinished();
+            std::vector<RectI> splitRects;
+            for (int i = 0; i < splitRows.size(); ++i) {
+                splitRects.push_back( RectI(roi.left(), splitRows[i].first, roi.right(), splitRows[i].second) );
+            }
+            QFuture<std::pair<double,double> > future = QtConcurrent::mapped( splitRects,
+                                                                             boost::bind(findAutoContrastVminVmax,
+                                                                                         args,
+                                                                                         _1) );
+            future.waitForFinished();
+            vMinMax = mergeVminVmax( future.results() );
         }
-        
-        
+        autoContrastGainAndOffset(vMinMax, &args.gain, &args.offset);
+        inArgs.params->gain = args.gain;
+        inArgs.params->offset = args.offset;
+    }
+    
+    std::pair<double,double> vMinMax;
+    if (runInCurrentThread) {
+        vMinMax = renderFunctor(std::make_pair(roi.y1,roi.y2),
+                                args,
+                                this,
+                                inArgs.params->ramBuffer);
+    } else {
+        QFuture<std::pair<double,double> > future = QtConcurrent::mapped( splitRows,
+                                                                         boost::bind(&renderFunctor,
+                                                                                     _1,
+                                                                                     args,
+                                                                                     this,
+                                                                                     inArgs.params->ramBuffer) );
+        future.waitForFinished();
+        vMinMax = mergeVminVmax( future.results() );
+    }
+    
+    if (fuseAutoContrast) {
+        autoContrastGainAndOffset(vMinMax, &inArgs.params->gain, &inArgs.params->offset);
+    }
+    
+    if ( !aborted() ) {
+        if (histogram && inArgs.params->cachedFrame) {
+            _imp->storeCachedHistogram(inArgs.params->textureIndex, inArgs.key->getHash(), histogram);
+        }
+        QMutexLocker l(&_imp->histogramMutex);
+        _imp->lastHistogram[inArgs.params->textureIndex] = histogram;
     }
 
     return eStatusOK;
@@ -1079,7 +1505,7 @@ ViewerInstance::updateViewer(boost::shared_ptr<UpdateViewerParams> & frame)
     _imp->updateViewer(boost::dynamic_pointer_cast<UpdateViewerParams>(frame));
 }
 
-void
+std::pair<double, double>
 renderFunctor(std::pair<int,int> yRange,
               const RenderViewerArgs & args,
               ViewerInstance* viewer,
@@ -1089,283 +1515,430 @@ renderFunctor(std::pair<int,int> yRange,
 
     if ( (args.bitDepth == OpenGLViewerI::eBitDepthFloat) || (args.bitDepth == OpenGLViewerI::eBitDepthHalf) ) {
         // image is stored as linear, the OpenGL shader with do gamma/sRGB/Rec709 decompression, as well as gain and offset
-        scaleToTexture32bits(yRange, args,viewer, (float*)buffer);
+        return scaleToTexture32bits(yRange, args,viewer, (float*)buffer);
     } else {
         // texture is stored as sRGB/Rec709 compressed 8-bit RGBA
+        assert(!args.computeVminVmax);
         scaleToTexture8bits(yRange, args,viewer, (U32*)buffer);
+        return std::make_pair(std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity());
     }
 }
 
-inline
-std::pair<double, double>
-findAutoContrastVminVmax_generic(boost::shared_ptr<const Natron::Image> inputImage,
-                                 int nComps,
-                                 Natron::DisplayChannelsEnum channels,
-                                 const RectI & rect)
+///Number of pixels of a scan-line converted at once: the planar buffers of a chunk stay in the L1 cache
+#define kViewerScanLineChunkSize 256
+
+/**
+ * @brief Scratch scan-line used by the viewer conversion kernels. The pixels of a row of the input image are
+ * de-interleaved, one chunk at a time, into planar float buffers so that every following step (colour-space,
+ * gain/offset, luminance, quantization) is a straight loop over contiguous memory that the compiler can vectorize.
+ * The quantized values of the whole row are kept for the error diffusion, which walks the row from a start column
+ * computed from the row index: it is not random, so that converting the same frame twice gives the same texture.
+ **/
+struct ViewerScanLine
+{
+    float r[kViewerScanLineChunkSize];
+    float g[kViewerScanLineChunkSize];
+    float b[kViewerScanLineChunkSize];
+    float a[kViewerScanLineChunkSize];
+    std::vector<unsigned short> r8xx,g8xx,b8xx;
+    std::vector<U8> a8;
+
+    ViewerScanLine(int width,
+                   bool needs8xx)
+    : r8xx(needs8xx ? width : 0)
+    , g8xx(needs8xx ? width : 0)
+    , b8xx(needs8xx ? width : 0)
+    , a8(needs8xx ? width : 0)
+    {
+    }
+};
+
+///4x4 Bayer matrix used by the ordered dithering, scaled to the 8 fractional bits of the uint8xx values
+static const unsigned short kViewerBayerMatrix[4][4] = {
+    {   8, 136,  40, 168 },
+    { 200,  72, 232, 104 },
+    {  56, 184,  24, 152 },
+    { 248, 120, 216,  88 }
+};
+
+template <typename PIX,int nComps,int offset>
+float
+viewerChannelValue(const PIX* pix)
 {
-    double localVmin = std::numeric_limits<double>::infinity();
-    double localVmax = -std::numeric_limits<double>::infinity();
-    
-    Natron::Image::ReadAccess acc = inputImage->getReadRights();
-    
-    for (int y = rect.bottom(); y < rect.top(); ++y) {
-        const float* src_pixels = (const float*)acc.pixelAt(rect.left(),y);
-        ///we fill the scan-line with all the pixels of the input image
-        for (int x = rect.left(); x < rect.right(); ++x) {
-            
-            double r,g,b,a;
-            switch (nComps) {
-                case 4:
-                    r = src_pixels[0];
-                    g = src_pixels[1];
-                    b = src_pixels[2];
-                    a = src_pixels[3];
-                    break;
-                case 3:
-                    r = src_pixels[0];
-                    g = src_pixels[1];
-                    b = src_pixels[2];
-                    a = 1.;
-                    break;
-                case 1:
-                    a = src_pixels[0];
-                    r = g = b = 0.;
-                    break;
-                default:
-                    r = g = b = 0.;
-            }
-            
-            double mini, maxi;
-            switch (channels) {
-                case Natron::eDisplayChannelsRGB:
-                    mini = std::min(std::min(r,g),b);
-                    maxi = std::max(std::max(r,g),b);
-                    break;
-                case Natron::eDisplayChannelsY:
-                    mini = r = 0.299 * r + 0.587 * g + 0.114 * b;
-                    maxi = mini;
-                    break;
-                case Natron::eDisplayChannelsR:
-                    mini = r;
-                    maxi = mini;
-                    break;
-                case Natron::eDisplayChannelsG:
-                    mini = g;
-                    maxi = mini;
-                    break;
-                case Natron::eDisplayChannelsB:
-                    mini = b;
-                    maxi = mini;
-                    break;
-                case Natron::eDisplayChannelsA:
-                    mini = a;
-                    maxi = mini;
-                    break;
-                default:
-                    mini = 0.;
-                    maxi = 0.;
-                    break;
-            }
-            if (mini < localVmin) {
-                localVmin = mini;
-            }
-            if (maxi > localVmax) {
-                localVmax = maxi;
-            }
-            
-            src_pixels += nComps;
+    if (nComps == 1) {
+        return (float)pix[0];
+    }
+    return offset < nComps ? (float)pix[offset] : 0.f;
+}
+
+template <typename PIX>
+struct ViewerSrcColorSpace;
+
+template <>
+struct ViewerSrcColorSpace<float>
+{
+    static void toLinear(const Natron::Color::Lut* lut,
+                         float* p,
+                         int n)
+    {
+        lut->fromColorSpaceFloatToLinearFloatFast(p, n);
+    }
+};
+
+template <>
+struct ViewerSrcColorSpace<unsigned char>
+{
+    static void toLinear(const Natron::Color::Lut* lut,
+                         float* p,
+                         int n)
+    {
+        for (int i = 0; i < n; ++i) {
+            p[i] = lut->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)p[i] );
+        }
+    }
+};
+
+template <>
+struct ViewerSrcColorSpace<unsigned short>
+{
+    static void toLinear(const Natron::Color::Lut* lut,
+                         float* p,
+                         int n)
+    {
+        for (int i = 0; i < n; ++i) {
+            p[i] = lut->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)p[i] );
+        }
+    }
+};
+
+/**
+ * @brief Fills the scan-line buffers with the linear values of the n pixels starting at src.
+ * nComps, the channel offsets and the depth are compile-time constants: the only branches left
+ * are hoisted out of the per-pixel loops. stride is the number of elements between 2 pixels,
+ * which is nComps except for layers with more than 4 components.
+ **/
+template <typename PIX,int maxValue,int nComps,bool opaque,int rOffset,int gOffset,int bOffset>
+void
+unpackToLinear(const PIX* src,
+               int stride,
+               int n,
+               const Natron::Color::Lut* srcColorSpace,
+               ViewerScanLine & line)
+{
+    float* r = line.r;
+    float* g = line.g;
+    float* b = line.b;
+    float* a = line.a;
+    
+    ///when displaying a single channel, r, g and b are the same: convert it only once
+    const bool singleChannel = nComps == 1 || (rOffset == gOffset && gOffset == bOffset);
+    
+    if (singleChannel) {
+        for (int x = 0; x < n; ++x, src += stride) {
+            r[x] = viewerChannelValue<PIX, nComps, rOffset>(src);
+            a[x] = (nComps >= 4 && !opaque) ? (float)src[3] : (float)maxValue;
+        }
+    } else {
+        for (int x = 0; x < n; ++x, src += stride) {
+            r[x] = viewerChannelValue<PIX, nComps, rOffset>(src);
+            g[x] = viewerChannelValue<PIX, nComps, gOffset>(src);
+            b[x] = viewerChannelValue<PIX, nComps, bOffset>(src);
+            a[x] = (nComps >= 4 && !opaque) ? (float)src[3] : (float)maxValue;
         }
     }
     
-    return std::make_pair(localVmin, localVmax);
+    const int nChannels = singleChannel ? 1 : 3;
+    float* channels[3] = { r, g, b };
+    if (srcColorSpace) {
+        for (int c = 0; c < nChannels; ++c) {
+            ViewerSrcColorSpace<PIX>::toLinear(srcColorSpace, channels[c], n);
+        }
+    } else if (maxValue != 1) {
+        const float scale = 1.f / maxValue;
+        for (int c = 0; c < nChannels; ++c) {
+            float* p = channels[c];
+            for (int x = 0; x < n; ++x) {
+                p[x] *= scale;
+            }
+        }
+    }
+    if (maxValue != 1) {
+        const float scale = 1.f / maxValue;
+        for (int x = 0; x < n; ++x) {
+            a[x] *= scale;
+        }
+    }
+    if (singleChannel) {
+        std::copy(r, r + n, g);
+        std::copy(r, r + n, b);
+    }
 }
 
-template <int nComps>
-std::pair<double, double>
-findAutoContrastVminVmax_internal(boost::shared_ptr<const Natron::Image> inputImage,
-                                  Natron::DisplayChannelsEnum channels,
-                                  const RectI & rect)
+static void
+applyGainAndOffset(float gain,
+                   float offset,
+                   int n,
+                   ViewerScanLine & line)
 {
-    return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
+    float* r = line.r;
+    float* g = line.g;
+    float* b = line.b;
+    for (int x = 0; x < n; ++x) {
+        r[x] = r[x] * gain + offset;
+        g[x] = g[x] * gain + offset;
+        b[x] = b[x] * gain + offset;
+    }
 }
 
-std::pair<double, double>
-findAutoContrastVminVmax(boost::shared_ptr<const Natron::Image> inputImage,
-                         Natron::DisplayChannelsEnum channels,
-                         const RectI & rect)
+static void
+applyLuminance(int n,
+               ViewerScanLine & line)
 {
-    int nComps = inputImage->getComponents().getNumComponents();
-    if (nComps == 4) {
-        return findAutoContrastVminVmax_internal<4>(inputImage, channels, rect);
-    } else if (nComps == 3) {
-        return findAutoContrastVminVmax_internal<3>(inputImage, channels, rect);
-    } else if (nComps == 1) {
-        return findAutoContrastVminVmax_internal<1>(inputImage, channels, rect);
-    } else {
-        return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
+    float* r = line.r;
+    float* g = line.g;
+    float* b = line.b;
+    for (int x = 0; x < n; ++x) {
+        float l = 0.299f * r[x] + 0.587f * g[x] + 0.114f * b[x];
+        r[x] = l;
+        g[x] = l;
+        b[x] = l;
+    }
+}
+
+/**
+ * @brief Updates vmin and vmax with the n values of p. The values are reduced in 4 independent lanes
+ * so that the loop is not serialized on a single comparison chain. NaNs are ignored.
+ **/
+static void
+reduceVminVmax(const float* p,
+               int n,
+               float* vmin,
+               float* vmax)
+{
+    float lo[4] = { *vmin, *vmin, *vmin, *vmin };
+    float hi[4] = { *vmax, *vmax, *vmax, *vmax };
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        ///written so that the comparison maps to a packed min/max instruction
+        for (int k = 0; k < 4; ++k) {
+            lo[k] = p[x + k] < lo[k] ? p[x + k] : lo[k];
+            hi[k] = p[x + k] > hi[k] ? p[x + k] : hi[k];
+        }
     }
+    for (; x < n; ++x) {
+        lo[0] = std::min(lo[0], p[x]);
+        hi[0] = std::max(hi[0], p[x]);
+    }
+    *vmin = std::min( std::min(lo[0], lo[1]), std::min(lo[2], lo[3]) );
+    *vmax = std::max( std::max(hi[0], hi[1]), std::max(hi[2], hi[3]) );
+}
+
+/**
+ * @brief Accumulates into bins the pixels of the chunk [x0, x0 + n[ of the row y that lie inside bins->rect.
+ * x0 is relative to texX1, the left edge of the texture. Must be called right after unpackToLinear,
+ * before the gain and the luminance modify the values.
+ **/
+static void
+accumulateHistogram(int texX1,
+                    int y,
+                    int x0,
+                    int n,
+                    const ViewerScanLine & line,
+                    HistogramBins* bins)
+{
+    const RectI & rect = bins->rect;
+    if ( (y < rect.y1) || (y >= rect.y2) ) {
+        return;
+    }
+    const int first = std::max(x0, rect.x1 - texX1);
+    const int last = std::min(x0 + n, rect.x2 - texX1);
+    if (first >= last) {
+        return;
+    }
+    const int i = first - x0;
+    bins->accumulate(line.r + i, line.g + i, line.b + i, line.a + i, last - first);
+}
+
+///Same as Color::floatToInt<256> but written so that the loops using it vectorize
+static inline U8
+viewerFloatToByte(float v)
+{
+    return (U8)(int)std::max( 0.f, std::min(255.f, v * 255.f + 0.5f) );
+}
+
+static void
+packToBGRA(int n,
+           const ViewerScanLine & line,
+           U32* dst_pixels)
+{
+    for (int x = 0; x < n; ++x) {
+        dst_pixels[x] = toBGRA(viewerFloatToByte(line.r[x]),
+                               viewerFloatToByte(line.g[x]),
+                               viewerFloatToByte(line.b[x]),
+                               viewerFloatToByte(line.a[x]));
+    }
+}
+
+/**
+ * @brief Quantizes the uint8xx values of the scan-line with an ordered dither. The threshold only
+ * depends on the pixel position in image coordinates, so the loop has no dependency between pixels
+ * and 2 conversions of the same frame (or of adjacent portions of it) produce the same texels.
+ **/
+static void
+ditherOrdered(int width,
+              int x1,
+              int y,
+              const ViewerScanLine & line,
+              U32* dst_pixels)
+{
+    const unsigned short* r = &line.r8xx[0];
+    const unsigned short* g = &line.g8xx[0];
+    const unsigned short* b = &line.b8xx[0];
+    const U8* a = &line.a8[0];
+    const unsigned short* threshold = kViewerBayerMatrix[y & 3];
+    for (int x = 0; x < width; ++x) {
+        unsigned int t = threshold[(x1 + x) & 3];
+        dst_pixels[x] = toBGRA((U8)((r[x] + t) >> 8),
+                               (U8)((g[x] + t) >> 8),
+                               (U8)((b[x] + t) >> 8),
+                               a[x]);
+    }
+}
+
+/**
+ * @brief Quantizes the uint8xx values of the scan-line by diffusing the quantization error along the row,
+ * forward then backward from a start column that is a hash of the row index. Varying the start from one row to
+ * the next avoids vertical patterns, and since it is not random the result only depends on the frame.
+ **/
+static void
+ditherErrorDiffusion(int width,
+                     int y,
+                     const ViewerScanLine & line,
+                     U32* dst_pixels)
+{
+    const unsigned short* r = &line.r8xx[0];
+    const unsigned short* g = &line.g8xx[0];
+    const unsigned short* b = &line.b8xx[0];
+    const U8* a = &line.a8[0];
     
-} // findAutoContrastVminVmax
+    ///the start only depends on the row so that converting the same frame twice gives the same result
+    int start = (int)( ( (unsigned int)y * 2654435761U ) % (unsigned int)width );
+    
+    for (int backward = 0; backward < 2; ++backward) {
+        
+        int index = backward ? start - 1 : start;
+        
+        assert( backward == 1 || ( index >= 0 && index < width ) );
+        
+        unsigned error_r = 0x80;
+        unsigned error_g = 0x80;
+        unsigned error_b = 0x80;
+        
+        while (index < width && index >= 0) {
+            error_r = (error_r & 0xff) + r[index];
+            error_g = (error_g & 0xff) + g[index];
+            error_b = (error_b & 0xff) + b[index];
+            assert(error_r < 0x10000 && error_g < 0x10000 && error_b < 0x10000);
+            dst_pixels[index] = toBGRA((U8)(error_r >> 8),
+                                       (U8)(error_g >> 8),
+                                       (U8)(error_b >> 8),
+                                       a[index]);
+            if (backward) {
+                --index;
+            } else {
+                ++index;
+            }
+        }
+    }
+}
 
-template <typename PIX,int maxValue,bool opaque,int rOffset,int gOffset,int bOffset>
+template <typename PIX,int maxValue,int nComps,bool opaque,int rOffset,int gOffset,int bOffset>
 void
-scaleToTexture8bits_generic(const std::pair<int,int> & yRange,
+scaleToTexture8bits_internal(const std::pair<int,int> & yRange,
                              const RenderViewerArgs & args,
-                             int nComps,
-                             ViewerInstance* /*viewer*/,
+                             int stride,
+                             ViewerInstance* viewer,
                              U32* output)
 {
-    size_t pixelSize = sizeof(PIX);
+    const int width = args.texRect.w;
+    
+    ///Cannot be an empty rect
+    assert(width > 0 && width == args.texRect.x2 - args.texRect.x1);
     
     const bool luminance = (args.channels == Natron::eDisplayChannelsY);
+    const bool applyGain = args.gain != 1. || args.offset != 0.;
+    const Natron::Color::Lut* colorSpace = args.colorSpace;
     
     Natron::Image::ReadAccess acc = Natron::Image::ReadAccess(args.inputImage.get());
     
-    ///offset the output buffer at the starting point
-    U32* dst_pixels = output + (yRange.first - args.texRect.y1) * args.texRect.w;
-
-    ///Cannot be an empty rect
-    assert(args.texRect.x2 > args.texRect.x1);
+    ViewerScanLine line(width, colorSpace != 0);
     
-    const PIX* src_pixels = (const PIX*)acc.pixelAt(args.texRect.x1, yRange.first);
-    const int srcRowElements = (int)args.inputImage->getRowElements();
+    ///the bins of this group of rows, merged into args.histogram once they are all converted
+    boost::scoped_ptr<HistogramBins> histogram;
+    if (args.histogram) {
+        histogram.reset( new HistogramBins(args.histogram->mode, args.histogram->binsCount, args.histogram->vmin, args.histogram->vmax,
+                                           args.histogram->rect) );
+    }
     
-    for (int y = yRange.first; y < yRange.second;
-         ++y,
-         dst_pixels += args.texRect.w,
-         src_pixels += srcRowElements) {
+    ///offset the output buffer at the starting point
+    U32* dst_pixels = output + (yRange.first - args.texRect.y1) * width;
+    
+    for (int y = yRange.first; y < yRange.second; ++y, dst_pixels += width) {
         
+        if (viewer && viewer->aborted()) {
+            return;
+        }
         
-        // coverity[dont_call]
-        int start = (int)(rand() % (args.texRect.x2 - args.texRect.x1));
+        const PIX* src_pixels = (const PIX*)acc.pixelAt(args.texRect.x1, y);
+        if (!src_pixels) {
+            std::fill(dst_pixels, dst_pixels + width, 0);
+            continue;
+        }
         
-
-        for (int backward = 0; backward < 2; ++backward) {
+        for (int x0 = 0; x0 < width; x0 += kViewerScanLineChunkSize) {
+            const int n = std::min(kViewerScanLineChunkSize, width - x0);
             
-            int index = backward ? start - 1 : start;
-            
-            assert( backward == 1 || ( index >= 0 && index < (args.texRect.x2 - args.texRect.x1) ) );
-
-            unsigned error_r = 0x80;
-            unsigned error_g = 0x80;
-            unsigned error_b = 0x80;
+            unpackToLinear<PIX, maxValue, nComps, opaque, rOffset, gOffset, bOffset>(src_pixels + x0 * stride, stride, n,
+                                                                                     args.srcColorSpace, line);
+            if (histogram) {
+                accumulateHistogram(args.texRect.x1, y, x0, n, line, histogram.get());
+            }
+            if (applyGain) {
+                applyGainAndOffset((float)args.gain, (float)args.offset, n, line);
+            }
+            if (luminance) {
+                applyLuminance(n, line);
+            }
             
-            while (index < args.texRect.w && index >= 0) {
-                
-                double r,g,b;
-                int a;
-                
-                if (nComps >= 4) {
-                        r = (src_pixels ? src_pixels[index * nComps + rOffset] : 0.);
-                        g = (src_pixels ? src_pixels[index * nComps + gOffset] : 0.);
-                        b = (src_pixels ? src_pixels[index * nComps + bOffset] : 0.);
-                        if (opaque) {
-                            a = 255;
-                        } else {
-                            a = (src_pixels ? Color::floatToInt<256>(src_pixels[index * nComps + 3]) : 0);
-                        }
-                } else if (nComps == 3) {
-                        r = (src_pixels && rOffset < nComps) ? src_pixels[index * nComps + rOffset] : 0.;
-                        g = (src_pixels && gOffset < nComps) ? src_pixels[index * nComps + gOffset] : 0.;
-                        b = (src_pixels && bOffset < nComps) ? src_pixels[index * nComps + bOffset] : 0.;
-                        a = (src_pixels ? 255 : 0);
-                } else if (nComps == 2) {
-                    r = (src_pixels && rOffset < nComps) ? src_pixels[index * nComps + rOffset] : 0.;
-                    g = (src_pixels && gOffset < nComps) ? src_pixels[index * nComps + gOffset] : 0.;
-                    b = 0;
-                    a = (src_pixels ? 255 : 0);
-                } else if (nComps == 1) {
-                    r = src_pixels ? src_pixels[index] : 0.;
-                    g = b = r;
-                    a = src_pixels ? 255 : 0;
-                } else {
-                    assert(false);
-                }
-                
-                
-                
-                switch ( pixelSize ) {
-                    case sizeof(unsigned char): //byte
-                        if (args.srcColorSpace) {
-                            r = args.srcColorSpace->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)r );
-                            g = args.srcColorSpace->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)g );
-                            b = args.srcColorSpace->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)b );
-                        } else {
-                            r = (double)convertPixelDepth<unsigned char, float>( (unsigned char)r );
-                            g = (double)convertPixelDepth<unsigned char, float>( (unsigned char)g );
-                            b = (double)convertPixelDepth<unsigned char, float>( (unsigned char)b );
-                        }
-                        break;
-                    case sizeof(unsigned short): //short
-                        if (args.srcColorSpace) {
-                            r = args.srcColorSpace->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)r );
-                            g = args.srcColorSpace->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)g );
-                            b = args.srcColorSpace->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)b );
-                        } else {
-                            r = (double)convertPixelDepth<unsigned short, float>( (unsigned char)r );
-                            g = (double)convertPixelDepth<unsigned short, float>( (unsigned char)g );
-                            b = (double)convertPixelDepth<unsigned short, float>( (unsigned char)b );
-                        }
-                        break;
-                    case sizeof(float): //float
-                        if (args.srcColorSpace) {
-                            r = args.srcColorSpace->fromColorSpaceFloatToLinearFloat(r);
-                            g = args.srcColorSpace->fromColorSpaceFloatToLinearFloat(g);
-                            b = args.srcColorSpace->fromColorSpaceFloatToLinearFloat(b);
-                        }
-                        break;
-                    default:
-                        break;
-                }
-                
-                r =  r * args.gain + args.offset;
-                g =  g * args.gain + args.offset;
-                b =  b * args.gain + args.offset;
-                
-                if (luminance) {
-                    r = 0.299 * r + 0.587 * g + 0.114 * b;
-                    g = r;
-                    b = r;
-                }
-                
-                if (!args.colorSpace) {
-                    dst_pixels[index] = toBGRA(Color::floatToInt<256>(r),
-                                               Color::floatToInt<256>(g),
-                                               Color::floatToInt<256>(b),
-                                               a);
-                } else {
-                    error_r = (error_r & 0xff) + args.colorSpace->toColorSpaceUint8xxFromLinearFloatFast(r);
-                    error_g = (error_g & 0xff) + args.colorSpace->toColorSpaceUint8xxFromLinearFloatFast(g);
-                    error_b = (error_b & 0xff) + args.colorSpace->toColorSpaceUint8xxFromLinearFloatFast(b);
-                    assert(error_r < 0x10000 && error_g < 0x10000 && error_b < 0x10000);
-                    dst_pixels[index] = toBGRA((U8)(error_r >> 8),
-                                               (U8)(error_g >> 8),
-                                               (U8)(error_b >> 8),
-                                               a);
-                }
-                
-                if (backward) {
-                    --index;
-                } else {
-                    ++index;
+            if (!colorSpace) {
+                packToBGRA(n, line, dst_pixels + x0);
+            } else {
+                unsigned short* r8xx = &line.r8xx[x0];
+                unsigned short* g8xx = &line.g8xx[x0];
+                unsigned short* b8xx = &line.b8xx[x0];
+                U8* a8 = &line.a8[x0];
+                for (int x = 0; x < n; ++x) {
+                    r8xx[x] = colorSpace->toColorSpaceUint8xxFromLinearFloatFast(line.r[x]);
+                    g8xx[x] = colorSpace->toColorSpaceUint8xxFromLinearFloatFast(line.g[x]);
+                    b8xx[x] = colorSpace->toColorSpaceUint8xxFromLinearFloatFast(line.b[x]);
+                    a8[x] = viewerFloatToByte(line.a[x]);
                 }
-                
-            } // while (index < args.texRect.w && index >= 0) {
-            
-        } // for (int backward = 0; backward < 2; ++backward) {
-    } // for (int y = yRange.first; y < yRange.second;
-} // scaleToTexture8bits_generic
-
-
-template <typename PIX,int maxValue,int nComps,bool opaque,int rOffset,int gOffset,int bOffset>
-void
-scaleToTexture8bits_internal(const std::pair<int,int> & yRange,
-                             const RenderViewerArgs & args,
-                             ViewerInstance* viewer,
-                             U32* output)
-{
-    scaleToTexture8bits_generic<PIX, maxValue, opaque, rOffset, gOffset, bOffset>(yRange, args, nComps, viewer, output);
-}
+            }
+        }
+        
+        if (colorSpace) {
+            if (args.orderedDither) {
+                ditherOrdered(width, args.texRect.x1, y, line, dst_pixels);
+            } else {
+                ditherErrorDiffusion(width, y, line, dst_pixels);
+            }
+        }
+    } // for (int y = yRange.first; y < yRange.second; ++y, dst_pixels += width) {
+    
+    if (histogram) {
+        args.histogram->merge(*histogram);
+    }
+} // scaleToTexture8bits_internal
 
 template <typename PIX,int maxValue, bool opaque, int rOffset, int gOffset, int bOffset>
 void
@@ -1377,19 +1950,21 @@ scaleToTexture8bitsForDepthForComponents(const std::pair<int,int> & yRange,
     int nComps = args.inputImage->getComponents().getNumComponents();
     switch (nComps) {
         case 4:
-            scaleToTexture8bits_internal<PIX,maxValue,4 , opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
+            scaleToTexture8bits_internal<PIX,maxValue,4, opaque, rOffset,gOffset,bOffset>(yRange,args,4,viewer,output);
             break;
         case 3:
-            scaleToTexture8bits_internal<PIX,maxValue,3, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
+            scaleToTexture8bits_internal<PIX,maxValue,3, opaque, rOffset,gOffset,bOffset>(yRange,args,3,viewer,output);
             break;
         case 2:
-            scaleToTexture8bits_internal<PIX,maxValue,2, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
+            scaleToTexture8bits_internal<PIX,maxValue,2, opaque, rOffset,gOffset,bOffset>(yRange,args,2,viewer,output);
             break;
         case 1:
-            scaleToTexture8bits_internal<PIX,maxValue,1, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
+            scaleToTexture8bits_internal<PIX,maxValue,1, opaque, rOffset,gOffset,bOffset>(yRange,args,1,viewer,output);
             break;
         default:
-            scaleToTexture8bits_generic<PIX, maxValue, opaque, rOffset, gOffset, bOffset>(yRange, args, nComps, viewer, output);
+            ///layers with more than 4 components: only the first 4 are displayed
+            assert(nComps > 4);
+            scaleToTexture8bits_internal<PIX,maxValue,4, opaque, rOffset,gOffset,bOffset>(yRange,args,nComps,viewer,output);
             break;
     }
 }
@@ -1490,160 +2065,116 @@ scaleToTexture8bits(std::pair<int,int> yRange,
     }
 } // scaleToTexture8bits
 
-template <typename PIX,int maxValue,bool opaque,int rOffset,int gOffset,int bOffset>
-void
-scaleToTexture32bitsGeneric(const std::pair<int,int> & yRange,
-                            const RenderViewerArgs & args,
-                            int nComps,
-                            ViewerInstance* viewer,
-                            float *output)
+template <typename PIX,int maxValue,int nComps,bool opaque,int rOffset,int gOffset,int bOffset>
+std::pair<double, double>
+scaleToTexture32bitsInternal(const std::pair<int,int> & yRange,
+                             const RenderViewerArgs & args,
+                             int stride,
+                             ViewerInstance* viewer,
+                             float *output)
 {
-    size_t pixelSize = sizeof(PIX);
+    const int width = args.texRect.w;
+    
+    assert(width > 0 && width == args.texRect.x2 - args.texRect.x1);
+    
     const bool luminance = (args.channels == Natron::eDisplayChannelsY);
-
+    
     ///the width of the output buffer multiplied by the channels count
-    int dst_width = args.texRect.w * 4;
-
+    const int dst_width = width * 4;
     
     Natron::Image::ReadAccess acc = Natron::Image::ReadAccess(args.inputImage.get());
-
-    float* dst_pixels =  output + (yRange.first - args.texRect.y1) * dst_width;
-    const float* src_pixels = (const float*)acc.pixelAt(args.texRect.x1, yRange.first);
-
-    assert(args.texRect.w == args.texRect.x2 - args.texRect.x1);
     
-    const int srcRowElements = (const int)args.inputImage->getRowElements();
+    ViewerScanLine line(width, false);
+    
+    ///when displaying a single channel or the luminance, r, g and b are the same
+    const bool singleChannel = luminance || nComps == 1 || (rOffset == gOffset && gOffset == bOffset);
+    float vmin = std::numeric_limits<float>::infinity();
+    float vmax = -std::numeric_limits<float>::infinity();
     
-    for (int y = yRange.first; y < yRange.second;
-         ++y,
-         src_pixels += srcRowElements) {
+    ///the bins of this group of rows, merged into args.histogram once they are all converted
+    boost::scoped_ptr<HistogramBins> histogram;
+    if (args.histogram) {
+        histogram.reset( new HistogramBins(args.histogram->mode, args.histogram->binsCount, args.histogram->vmin, args.histogram->vmax,
+                                           args.histogram->rect) );
+    }
+    
+    float* dst_pixels =  output + (yRange.first - args.texRect.y1) * dst_width;
+    
+    for (int y = yRange.first; y < yRange.second; ++y, dst_pixels += dst_width) {
         
-        if (viewer->aborted()) {
-            return;
+        if (viewer && viewer->aborted()) {
+            break;
         }
         
-
-        for (int x = 0; x < args.texRect.w;
-             ++x,
-             dst_pixels += 4) {
-            
-            double r,g,b,a;
+        const PIX* src_pixels = (const PIX*)acc.pixelAt(args.texRect.x1, y);
+        if (!src_pixels) {
+            std::fill(dst_pixels, dst_pixels + dst_width, 0.f);
+            continue;
+        }
+        
+        for (int x0 = 0; x0 < width; x0 += kViewerScanLineChunkSize) {
+            const int n = std::min(kViewerScanLineChunkSize, width - x0);
             
-            if (nComps >= 4) {
-                r = (double)(src_pixels[x * nComps + rOffset]);
-                g = (double)src_pixels[x * nComps + gOffset];
-                b = (double)src_pixels[x * nComps + bOffset];
-                if (opaque) {
-                    a = 1.;
-                } else {
-                    a = (nComps < 4) ? 1. : src_pixels[x * nComps + 3];
-                }
-            } else if (nComps == 3) {
-                r = (double)(src_pixels[x * nComps + rOffset]);
-                g = (double)src_pixels[x * nComps + gOffset];
-                b = (double)src_pixels[x * nComps + bOffset];
-                a = 1.;
-            } else if (nComps == 2) {
-                r = (double)(src_pixels[x * nComps + rOffset]);
-                g = (double)src_pixels[x * nComps + gOffset];
-                b = 0.;
-                a = 1.;
-            } else if (nComps == 1) {
-                a = (nComps < 4) ? 1. : src_pixels[x];
-                r = g = b = a;
-                a = 1.;
-            } else {
-                assert(false);
+            ///gain and offset are applied by the OpenGL shader
+            unpackToLinear<PIX, maxValue, nComps, opaque, rOffset, gOffset, bOffset>(src_pixels + x0 * stride, stride, n,
+                                                                                     args.srcColorSpace, line);
+            if (histogram) {
+                accumulateHistogram(args.texRect.x1, y, x0, n, line, histogram.get());
             }
-            
-            
-            switch ( pixelSize ) {
-            case sizeof(unsigned char):
-                if (args.srcColorSpace) {
-                    r = args.srcColorSpace->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)r );
-                    g = args.srcColorSpace->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)g );
-                    b = args.srcColorSpace->fromColorSpaceUint8ToLinearFloatFast( (unsigned char)b );
-                } else {
-                    r = (double)convertPixelDepth<unsigned char, float>( (unsigned char)r );
-                    g = (double)convertPixelDepth<unsigned char, float>( (unsigned char)g );
-                    b = (double)convertPixelDepth<unsigned char, float>( (unsigned char)b );
-                }
-                break;
-            case sizeof(unsigned short):
-                if (args.srcColorSpace) {
-                    r = args.srcColorSpace->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)r );
-                    g = args.srcColorSpace->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)g );
-                    b = args.srcColorSpace->fromColorSpaceUint16ToLinearFloatFast( (unsigned short)b );
-                } else {
-                    r = (double)convertPixelDepth<unsigned short, float>( (unsigned char)r );
-                    g = (double)convertPixelDepth<unsigned short, float>( (unsigned char)g );
-                    b = (double)convertPixelDepth<unsigned short, float>( (unsigned char)b );
-                }
-                break;
-            case sizeof(float):
-                if (args.srcColorSpace) {
-                    r = args.srcColorSpace->fromColorSpaceFloatToLinearFloat(r);
-                    g = args.srcColorSpace->fromColorSpaceFloatToLinearFloat(g);
-                    b = args.srcColorSpace->fromColorSpaceFloatToLinearFloat(b);
+            if (luminance) {
+                applyLuminance(n, line);
+            }
+            if (args.computeVminVmax) {
+                reduceVminVmax(line.r, n, &vmin, &vmax);
+                if (!singleChannel) {
+                    reduceVminVmax(line.g, n, &vmin, &vmax);
+                    reduceVminVmax(line.b, n, &vmin, &vmax);
                 }
-                break;
-            default:
-                break;
             }
-
-
-            if (luminance) {
-                r = 0.299 * r + 0.587 * g + 0.114 * b;
-                g = r;
-                b = r;
+            
+            float* dst = dst_pixels + x0 * 4;
+            for (int x = 0; x < n; ++x) {
+                dst[x * 4] = line.r[x];
+                dst[x * 4 + 1] = line.g[x];
+                dst[x * 4 + 2] = line.b[x];
+                dst[x * 4 + 3] = line.a[x];
             }
-            *dst_pixels = r;
-            *(dst_pixels + 1) = g;
-            *(dst_pixels + 2) = b;
-            *(dst_pixels + 3) = a;
-
         }
     }
-} // scaleToTexture32bitsGeneric
-
-template <typename PIX,int maxValue,int nComps,bool opaque,int rOffset,int gOffset,int bOffset>
-void
-scaleToTexture32bitsInternal(const std::pair<int,int> & yRange,
-                             const RenderViewerArgs & args,
-                             ViewerInstance* viewer,
-                             float *output) {
-    scaleToTexture32bitsGeneric<PIX, maxValue, opaque, rOffset, gOffset, bOffset>(yRange, args, nComps, viewer, output);
-}
+    
+    if (histogram) {
+        args.histogram->merge(*histogram);
+    }
+    
+    return std::make_pair( (double)vmin, (double)vmax );
+} // scaleToTexture32bitsInternal
 
 template <typename PIX,int maxValue,bool opaque,int rOffset,int gOffset,int bOffset>
-void
+std::pair<double, double>
 scaleToTexture32bitsForDepthForComponents(const std::pair<int,int> & yRange,
                              const RenderViewerArgs & args,
-                            ViewerInstance* viewer,
+                             ViewerInstance* viewer,
                              float *output)
 {
-    int  nComps = args.inputImage->getComponents().getNumComponents();
+    int nComps = args.inputImage->getComponents().getNumComponents();
     switch (nComps) {
         case 4:
-            scaleToTexture32bitsInternal<PIX,maxValue,4, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
-            break;
+            return scaleToTexture32bitsInternal<PIX,maxValue,4, opaque, rOffset,gOffset,bOffset>(yRange,args,4,viewer,output);
         case 3:
-            scaleToTexture32bitsInternal<PIX,maxValue,3, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
-            break;
+            return scaleToTexture32bitsInternal<PIX,maxValue,3, opaque, rOffset,gOffset,bOffset>(yRange,args,3,viewer,output);
         case 2:
-            scaleToTexture32bitsInternal<PIX,maxValue,2, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
-            break;
+            return scaleToTexture32bitsInternal<PIX,maxValue,2, opaque, rOffset,gOffset,bOffset>(yRange,args,2,viewer,output);
         case 1:
-            scaleToTexture32bitsInternal<PIX,maxValue,1, opaque, rOffset,gOffset,bOffset>(yRange,args,viewer,output);
-            break;
+            return scaleToTexture32bitsInternal<PIX,maxValue,1, opaque, rOffset,gOffset,bOffset>(yRange,args,1,viewer,output);
         default:
-            scaleToTexture32bitsGeneric<PIX,maxValue, opaque, rOffset,gOffset,bOffset>(yRange,args,nComps,viewer,output);
-            break;
+            ///layers with more than 4 components: only the first 4 are displayed
+            assert(nComps > 4);
+            return scaleToTexture32bitsInternal<PIX,maxValue,4, opaque, rOffset,gOffset,bOffset>(yRange,args,nComps,viewer,output);
     }
 }
 
 template <typename PIX,int maxValue,bool opaque>
-void
+std::pair<double, double>
 scaleToTexture32bitsForPremultForComponents(const std::pair<int,int> & yRange,
                              const RenderViewerArgs & args,
                             ViewerInstance* viewer,
@@ -1655,47 +2186,37 @@ scaleToTexture32bitsForPremultForComponents(const std::pair<int,int> & yRange,
     switch (args.channels) {
         case Natron::eDisplayChannelsRGB:
         case Natron::eDisplayChannelsY:
-            scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 0, 1, 2>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 0, 1, 2>(yRange, args,viewer, output);
         case Natron::eDisplayChannelsG:
-            scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 1, 1, 1>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 1, 1, 1>(yRange, args,viewer, output);
         case Natron::eDisplayChannelsB:
-            scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 2, 2, 2>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 2, 2, 2>(yRange, args,viewer, output);
         case Natron::eDisplayChannelsA:
             switch (args.alphaChannelIndex) {
                 case -1:
-                    scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 3, 3, 3>(yRange, args,viewer, output);
-                    break;
+                    return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 3, 3, 3>(yRange, args,viewer, output);
                 case 0:
-                    scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 0, 0, 0>(yRange, args,viewer, output);
-                    break;
+                    return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 0, 0, 0>(yRange, args,viewer, output);
                 case 1:
-                    scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 1, 1, 1>(yRange, args,viewer, output);
-                    break;
+                    return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 1, 1, 1>(yRange, args,viewer, output);
                 case 2:
-                    scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 2, 2, 2>(yRange, args,viewer, output);
-                    break;
+                    return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 2, 2, 2>(yRange, args,viewer, output);
                 case 3:
-                    scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 3, 3, 3>(yRange, args,viewer, output);
-                    break;
+                    return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 3, 3, 3>(yRange, args,viewer, output);
                 default:
-                    scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 3, 3, 3>(yRange, args,viewer, output);
-                    break;
+                    return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 3, 3, 3>(yRange, args,viewer, output);
             }
             
             break;
         case Natron::eDisplayChannelsR:
         default:
-            scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 0, 0, 0>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForDepthForComponents<PIX, maxValue, opaque, 0, 0, 0>(yRange, args,viewer, output);
     }
 
 }
 
 template <typename PIX,int maxValue>
-void
+std::pair<double, double>
 scaleToTexture32bitsForPremult(const std::pair<int,int> & yRange,
                              const RenderViewerArgs & args,
                              ViewerInstance* viewer,
@@ -1703,20 +2224,18 @@ scaleToTexture32bitsForPremult(const std::pair<int,int> & yRange,
 {
     switch (args.srcPremult) {
         case Natron::eImagePremultiplicationOpaque:
-            scaleToTexture32bitsForPremultForComponents<PIX, maxValue, true>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForPremultForComponents<PIX, maxValue, true>(yRange, args,viewer, output);
         case Natron::eImagePremultiplicationPremultiplied:
         case Natron::eImagePremultiplicationUnPremultiplied:
         default:
-            scaleToTexture32bitsForPremultForComponents<PIX, maxValue, false>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForPremultForComponents<PIX, maxValue, false>(yRange, args,viewer, output);
             
     }
     
     
 }
 
-void
+std::pair<double, double>
 scaleToTexture32bits(std::pair<int,int> yRange,
                      const RenderViewerArgs & args,
                      ViewerInstance* viewer,
@@ -1726,19 +2245,132 @@ scaleToTexture32bits(std::pair<int,int> yRange,
 
     switch ( args.inputImage->getBitDepth() ) {
         case Natron::eImageBitDepthFloat:
-            scaleToTexture32bitsForPremult<float, 1>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForPremult<float, 1>(yRange, args,viewer, output);
         case Natron::eImageBitDepthByte:
-            scaleToTexture32bitsForPremult<unsigned char, 255>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForPremult<unsigned char, 255>(yRange, args,viewer, output);
         case Natron::eImageBitDepthShort:
-            scaleToTexture32bitsForPremult<unsigned short, 65535>(yRange, args,viewer, output);
-            break;
+            return scaleToTexture32bitsForPremult<unsigned short, 65535>(yRange, args,viewer, output);
         case Natron::eImageBitDepthNone:
             break;
     }
+    return std::make_pair(std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity());
 } // scaleToTexture32bits
 
+/**
+ * @brief Computes the range of the values displayed for the given rectangle of the image, with the same
+ * channel selection and colour-space conversion as the 8-bit kernel, before gain and offset.
+ **/
+template <typename PIX,int maxValue,int nComps,int rOffset,int gOffset,int bOffset>
+std::pair<double, double>
+findAutoContrastVminVmax_internal(const RenderViewerArgs & args,
+                                  int stride,
+                                  const RectI & rect)
+{
+    const bool luminance = (args.channels == Natron::eDisplayChannelsY);
+    const bool singleChannel = luminance || nComps == 1 || (rOffset == gOffset && gOffset == bOffset);
+    const int width = rect.width();
+    
+    float vmin = std::numeric_limits<float>::infinity();
+    float vmax = -std::numeric_limits<float>::infinity();
+    
+    Natron::Image::ReadAccess acc = Natron::Image::ReadAccess(args.inputImage.get());
+    
+    ViewerScanLine line(width, false);
+    
+    for (int y = rect.bottom(); y < rect.top(); ++y) {
+        const PIX* src_pixels = (const PIX*)acc.pixelAt(rect.left(), y);
+        if (!src_pixels) {
+            continue;
+        }
+        for (int x0 = 0; x0 < width; x0 += kViewerScanLineChunkSize) {
+            const int n = std::min(kViewerScanLineChunkSize, width - x0);
+            
+            unpackToLinear<PIX, maxValue, nComps, true, rOffset, gOffset, bOffset>(src_pixels + x0 * stride, stride, n,
+                                                                                   args.srcColorSpace, line);
+            if (luminance) {
+                applyLuminance(n, line);
+            }
+            reduceVminVmax(line.r, n, &vmin, &vmax);
+            if (!singleChannel) {
+                reduceVminVmax(line.g, n, &vmin, &vmax);
+                reduceVminVmax(line.b, n, &vmin, &vmax);
+            }
+        }
+    }
+    
+    return std::make_pair( (double)vmin, (double)vmax );
+}
+
+template <typename PIX,int maxValue,int rOffset,int gOffset,int bOffset>
+std::pair<double, double>
+findAutoContrastVminVmaxForComponents(const RenderViewerArgs & args,
+                                      const RectI & rect)
+{
+    int nComps = args.inputImage->getComponents().getNumComponents();
+    switch (nComps) {
+        case 4:
+            return findAutoContrastVminVmax_internal<PIX, maxValue, 4, rOffset, gOffset, bOffset>(args, 4, rect);
+        case 3:
+            return findAutoContrastVminVmax_internal<PIX, maxValue, 3, rOffset, gOffset, bOffset>(args, 3, rect);
+        case 2:
+            return findAutoContrastVminVmax_internal<PIX, maxValue, 2, rOffset, gOffset, bOffset>(args, 2, rect);
+        case 1:
+            return findAutoContrastVminVmax_internal<PIX, maxValue, 1, rOffset, gOffset, bOffset>(args, 1, rect);
+        default:
+            assert(nComps > 4);
+            return findAutoContrastVminVmax_internal<PIX, maxValue, 4, rOffset, gOffset, bOffset>(args, nComps, rect);
+    }
+}
+
+template <typename PIX,int maxValue>
+std::pair<double, double>
+findAutoContrastVminVmaxForDepth(const RenderViewerArgs & args,
+                                 const RectI & rect)
+{
+    switch (args.channels) {
+        case Natron::eDisplayChannelsRGB:
+        case Natron::eDisplayChannelsY:
+            return findAutoContrastVminVmaxForComponents<PIX, maxValue, 0, 1, 2>(args, rect);
+        case Natron::eDisplayChannelsG:
+            return findAutoContrastVminVmaxForComponents<PIX, maxValue, 1, 1, 1>(args, rect);
+        case Natron::eDisplayChannelsB:
+            return findAutoContrastVminVmaxForComponents<PIX, maxValue, 2, 2, 2>(args, rect);
+        case Natron::eDisplayChannelsA:
+            switch (args.alphaChannelIndex) {
+                case 0:
+                    return findAutoContrastVminVmaxForComponents<PIX, maxValue, 0, 0, 0>(args, rect);
+                case 1:
+                    return findAutoContrastVminVmaxForComponents<PIX, maxValue, 1, 1, 1>(args, rect);
+                case 2:
+                    return findAutoContrastVminVmaxForComponents<PIX, maxValue, 2, 2, 2>(args, rect);
+                case -1:
+                case 3:
+                default:
+                    return findAutoContrastVminVmaxForComponents<PIX, maxValue, 3, 3, 3>(args, rect);
+            }
+        case Natron::eDisplayChannelsR:
+        default:
+            return findAutoContrastVminVmaxForComponents<PIX, maxValue, 0, 0, 0>(args, rect);
+    }
+}
+
+std::pair<double, double>
+findAutoContrastVminVmax(const RenderViewerArgs & args,
+                         const RectI & rect)
+{
+    switch ( args.inputImage->getBitDepth() ) {
+        case Natron::eImageBitDepthFloat:
+            return findAutoContrastVminVmaxForDepth<float, 1>(args, rect);
+        case Natron::eImageBitDepthByte:
+            return findAutoContrastVminVmaxForDepth<unsigned char, 255>(args, rect);
+        case Natron::eImageBitDepthShort:
+            return findAutoContrastVminVmaxForDepth<unsigned short, 65535>(args, rect);
+        case Natron::eImageBitDepthNone:
+            break;
+    }
+    return std::make_pair(std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity());
+} // findAutoContrastVminVmax
+
 
 void
 ViewerInstance::ViewerInstancePrivate::updateViewer(boost::shared_ptr<UpdateViewerParams> params)
@@ -1756,6 +2388,7 @@ ViewerInstance::ViewerInstancePrivate::updateViewer(boost::shared_ptr<UpdateView
     /// Since updateViewer() is in the scope of cachedFrame, and renderViewer waits for the completion
     /// of updateViewer(), it is guaranteed not to be freed before the viewer is actually done with it.
     /// @see Cache::clearInMemoryPortion and Cache::clearDiskPortion and LRUHashTable::evict
+    /// A texture assembled from tiles is in a buffer owned by params, which is only freed with params.
     
     assert(params->ramBuffer);
     
@@ -1769,6 +2402,7 @@ ViewerInstance::ViewerInstancePrivate::updateViewer(boost::shared_ptr<UpdateView
                                               params->time,
                                               params->rod,
                                               params->bytesCount,
+                                              params->bitDepth,
                                               params->textureRect,
                                               params->gain,
                                               params->offset,
@@ -1778,6 +2412,7 @@ ViewerInstance::ViewerInstancePrivate::updateViewer(boost::shared_ptr<UpdateView
                                               params->srcPremult,
                                               params->textureIndex);
         updateViewerPboIndex = (updateViewerPboIndex + 1) % 2;
+        displayedTextureBitDepth[params->textureIndex] = params->bitDepth;
         
         
         uiContext->updateColorPicker(params->textureIndex);
@@ -1814,7 +2449,8 @@ ViewerInstance::onGainChanged(double exp)
         _imp->viewerParamsGain = exp;
     }
     assert(_imp->uiContext);
-    if ( ( (_imp->uiContext->getBitDepth() == OpenGLViewerI::eBitDepthByte) || !_imp->uiContext->supportsGLSL() )
+    if ( ( (_imp->uiContext->getBitDepth() == OpenGLViewerI::eBitDepthByte) || !_imp->uiContext->supportsGLSL() ||
+           _imp->isDisplayingByteTexture() )
          && !getApp()->getProject()->isLoadingProject() ) {
         renderCurrentFrame(true);
     } else {
@@ -1876,7 +2512,8 @@ ViewerInstance::onColorSpaceChanged(Natron::ViewerColorSpaceEnum colorspace)
         _imp->viewerParamsLut = colorspace;
     }
     assert(_imp->uiContext);
-    if ( ( (_imp->uiContext->getBitDepth() == OpenGLViewerI::eBitDepthByte) || !_imp->uiContext->supportsGLSL() )
+    if ( ( (_imp->uiContext->getBitDepth() == OpenGLViewerI::eBitDepthByte) || !_imp->uiContext->supportsGLSL() ||
+           _imp->isDisplayingByteTexture() )
         && !getApp()->getProject()->isLoadingProject() ) {
         renderCurrentFrame(true);
     } else {
@@ -2127,6 +2764,38 @@ ViewerInstance::getTimelineBounds(int* first,int* last) const
     }
 }
 
+void
+ViewerInstance::setHistogramRequest(int textureIndex,
+                                    int mode,
+                                    int binsCount,
+                                    double vmin,
+                                    double vmax,
+                                    bool fullImage)
+{
+    assert(textureIndex == 0 || textureIndex == 1);
+    QMutexLocker l(&_imp->histogramMutex);
+    ViewerHistogramRequest & request = _imp->histogramRequest[textureIndex];
+    if ( (request.binsCount != binsCount) || (request.mode != mode) || (request.vmin != vmin) || (request.vmax != vmax) ) {
+        _imp->cachedHistograms[textureIndex].clear();
+    }
+    request.binsCount = binsCount;
+    request.mode = mode;
+    request.vmin = vmin;
+    request.vmax = vmax;
+    request.fullImage = fullImage;
+    if (binsCount <= 0) {
+        _imp->lastHistogram[textureIndex].reset();
+    }
+}
+
+boost::shared_ptr<HistogramBins>
+ViewerInstance::getLastHistogram(int textureIndex) const
+{
+    assert(textureIndex == 0 || textureIndex == 1);
+    QMutexLocker l(&_imp->histogramMutex);
+    return _imp->lastHistogram[textureIndex];
+}
+
 
 int
 ViewerInstance::getMipMapLevelFromZoomFactor() const
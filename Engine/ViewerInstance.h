@@ -35,6 +35,7 @@ class UpdateViewerParams;
 class TimeLine;
 class OpenGLViewerI;
 struct TextureRect;
+class HistogramBins;
 
 class ViewerInstance
 : public Natron::OutputEffectInstance
@@ -173,6 +174,27 @@ public:
     void getTimelineBounds(int* first,int* last) const;
     
     static const Natron::Color::Lut* lutFromColorspace(Natron::ViewerColorSpaceEnum cs) WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Asks the viewer to accumulate the bins of a histogram of the images of the given input while converting them
+     * to a texture, so that the histogram does not have to read the image again. The parameters are the ones of the
+     * HistogramBins constructor. If fullImage is false, the bins are computed over the portion of the image displayed,
+     * rounded to the viewer tiles (@see OpenGLViewerI::getImageRectangleDisplayedRoundedToTileSize), i.e. over the
+     * texture. A negative binsCount stops the accumulation. MT-safe.
+     **/
+    void setHistogramRequest(int textureIndex,
+                             int mode,
+                             int binsCount,
+                             double vmin,
+                             double vmax,
+                             bool fullImage);
+
+    /**
+     * @brief Returns the bins of the last texture of the given input, if any: accumulated while converting it, or
+     * rebuilt from the bins of its tiles when it was found in the cache. The caller must check that they were computed
+     * with the expected parameters. MT-safe.
+     **/
+    boost::shared_ptr<HistogramBins> getLastHistogram(int textureIndex) const WARN_UNUSED_RETURN;
     
     virtual void checkOFXClipPreferences(double time,
                                          const RenderScale & scale,
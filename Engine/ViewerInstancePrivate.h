@@ -18,6 +18,7 @@
 #include "ViewerInstance.h"
 
 #include <map>
+#include <vector>
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
 #include <QtCore/QThread>
@@ -25,6 +26,7 @@
 
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/ImageComponents.h"
+#include "Engine/OpenGLViewerI.h"
 #include "Engine/FrameEntry.h"
 #include "Engine/Settings.h"
 #include "Engine/TextureRect.h"
@@ -47,7 +49,10 @@ struct RenderViewerArgs
                      double offset_,
                      const Natron::Color::Lut* srcColorSpace_,
                      const Natron::Color::Lut* colorSpace_,
-                     int alphaChannelIndex_)
+                     int alphaChannelIndex_,
+                     bool orderedDither_,
+                     bool computeVminVmax_,
+                     const boost::shared_ptr<HistogramBins> & histogram_)
     : inputImage(inputImage_)
     , texRect(texRect_)
     , channels(channels_)
@@ -58,6 +63,9 @@ struct RenderViewerArgs
     , srcColorSpace(srcColorSpace_)
     , colorSpace(colorSpace_)
     , alphaChannelIndex(alphaChannelIndex_)
+    , orderedDither(orderedDither_)
+    , computeVminVmax(computeVminVmax_)
+    , histogram(histogram_)
     {
     }
 
@@ -71,6 +79,72 @@ struct RenderViewerArgs
     const Natron::Color::Lut* srcColorSpace;
     const Natron::Color::Lut* colorSpace;
     int alphaChannelIndex;
+    bool orderedDither;
+    
+    ///When true, the 32-bit conversion also returns the range of the displayed values for the auto-contrast
+    bool computeVminVmax;
+    
+    ///If not NULL, the bins of the histogram requested by ViewerInstance::setHistogramRequest() are accumulated
+    ///over histogram->rect while converting the image
+    boost::shared_ptr<HistogramBins> histogram;
+};
+
+/**
+ * @brief Converts the rows [yRange.first, yRange.second[ of args.inputImage to the viewer texture in buffer,
+ * which is either 8-bit BGRA or 32-bit float RGBA depending on args.bitDepth.
+ * viewer may be NULL, in which case the conversion cannot be aborted.
+ * @returns The (vmin, vmax) range of the converted values if args.computeVminVmax is true, (+inf, -inf) otherwise.
+ **/
+std::pair<double, double> renderFunctor(std::pair<int,int> yRange,
+                                        const RenderViewerArgs & args,
+                                        ViewerInstance* viewer,
+                                        void *buffer);
+
+/// the histogram the viewer accumulates while converting the images, @see ViewerInstance::setHistogramRequest()
+struct ViewerHistogramRequest
+{
+    ViewerHistogramRequest()
+    : binsCount(-1)
+    , mode(0)
+    , vmin(0.)
+    , vmax(0.)
+    , fullImage(false)
+    {
+    }
+    
+    int binsCount; //< negative when there is no request
+    int mode;
+    double vmin, vmax;
+    bool fullImage;
+};
+
+/**
+ * @brief A tile of the viewer texture. The tiles are aligned to a grid of getViewerTilesPowerOf2() pixels at the
+ * mipmap level of the texture (and clipped to the image bounds), and each one is cached as a FrameEntry:
+ * a texture that is panned or zoomed only renders the tiles that are not cached yet.
+ **/
+struct ViewerTile
+{
+    ViewerTile()
+    : rect()
+    , key()
+    , cachedFrame()
+    , isRendered(false)
+    , histogram()
+    {
+    }
+
+    RectI rect;
+    boost::shared_ptr<Natron::FrameKey> key;
+    
+    ///The entry of the tile in the viewer cache. NULL if the tile is not cached
+    boost::shared_ptr<Natron::FrameEntry> cachedFrame;
+    
+    ///True if the tile is rendered into cachedFrame by this render (it is removed from the cache if the render is aborted)
+    bool isRendered;
+    
+    ///The bins of the requested histogram accumulated while converting the tile, NULL if they were not
+    boost::shared_ptr<HistogramBins> histogram;
 };
 
 /// parameters send from the scheduler thread to updateViewer() (which runs in the main thread)
@@ -87,6 +161,7 @@ public:
     , textureRect()
     , srcPremult(Natron::eImagePremultiplicationOpaque)
     , bytesCount(0)
+    , bitDepth(0)
     , gain(1.)
     , offset(0.)
     , mipMapLevel(0)
@@ -96,6 +171,7 @@ public:
     , alphaLayer()
     , alphaChannelName()
     , cachedFrame()
+    , tiles()
     , image()
     , rod()
     , renderAge(0)
@@ -121,6 +197,7 @@ public:
     TextureRect textureRect;
     Natron::ImagePremultiplicationEnum srcPremult;
     size_t bytesCount;
+    int bitDepth; //< the OpenGLViewerI::BitDepthEnum of the texture, which may be 8-bit with float viewers
     double gain;
     double offset;
     unsigned int mipMapLevel;
@@ -131,7 +208,11 @@ public:
     std::string alphaChannelName;
     
     // put a shared_ptr here, so that the cache entry is never released before the end of updateViewer()
+    ///The entry of the whole texture, used by playback and when the texture is found in the cache as a whole
     boost::shared_ptr<Natron::FrameEntry> cachedFrame;
+    
+    ///The tiles of interactive renders, empty if the texture is not cached by tiles (@see cachedFrame)
+    std::vector<ViewerTile> tiles;
     boost::shared_ptr<Natron::Image> image;
     RectD rod;
     U64 renderAge;
@@ -151,6 +232,7 @@ public:
     , forceRenderMutex()
     , forceRender(false)
     , updateViewerPboIndex(0)
+    , displayedTextureBitDepth()
     , viewerParamsMutex()
     , viewerParamsGain(1.)
     , viewerParamsLut(Natron::eViewerColorSpaceSRGB)
@@ -165,12 +247,17 @@ public:
     , lastRenderedHashMutex()
     , lastRenderedHash(0)
     , lastRenderedHashValid(false)
+    , histogramMutex()
+    , histogramRequest()
+    , lastHistogram()
+    , cachedHistograms()
     , renderAgeMutex()
     , renderAge()
     , displayAge()
     {
 
         for (int i = 0;i < 2; ++i) {
+            displayedTextureBitDepth[i] = -1;
             activeInputs[i] = -1;
             renderAge[i] = 1;
             displayAge[i] = 0;
@@ -184,6 +271,13 @@ public:
         Q_EMIT mustRedrawViewer();
     }
     
+    /// True if one of the displayed textures has the gain and color-space applied, i.e. it is an 8-bit texture
+    bool isDisplayingByteTexture() const
+    {
+        // always running in the main thread
+        return displayedTextureBitDepth[0] == OpenGLViewerI::eBitDepthByte || displayedTextureBitDepth[1] == OpenGLViewerI::eBitDepthByte;
+    }
+    
 public:
     
     virtual void lock(const boost::shared_ptr<Natron::FrameEntry>& entry) OVERRIDE FINAL
@@ -344,6 +438,7 @@ public:
     //wait the entire time. This flag is here to make the renderViewer() thread wait
     //until the texture upload is finished by the main thread.
     int updateViewerPboIndex;                // always accessed in the main thread: initialized in the constructor, then always accessed and modified by updateViewer()
+    int displayedTextureBitDepth[2];         // always accessed in the main thread: the bit depth of the last textures given to the OpenGL viewer, -1 if none
 
 
     // viewerParams: The viewer parameters that may be accessed from the GUI
@@ -369,6 +464,32 @@ public:
     QWaitCondition textureBeingRenderedCond;
     std::list<boost::shared_ptr<Natron::FrameEntry> > textureBeingRendered; ///< a list of all the texture being rendered simultaneously
     
+    mutable QMutex histogramMutex; //< protects histogramRequest, lastHistogram and cachedHistograms
+    ViewerHistogramRequest histogramRequest[2];
+    boost::shared_ptr<HistogramBins> lastHistogram[2];
+    
+    ///The bins of the requested histogram accumulated while converting the textures and tiles stored in the viewer
+    ///cache, by hash of their FrameKey: the histogram of a texture found in the cache is rebuilt from them.
+    std::map<U64, boost::shared_ptr<HistogramBins> > cachedHistograms[2];
+    
+    /**
+     * @brief Stores the bins of the texture or tile of the viewer cache whose key hash is entryHash
+     **/
+    void storeCachedHistogram(int textureIndex,
+                              U64 entryHash,
+                              const boost::shared_ptr<HistogramBins> & bins);
+    
+    /**
+     * @brief Sets the last histogram of the texture key (of the image bounds imageBounds) from the bins accumulated
+     * when it was converted as a whole, or else from the bins of its tiles: those of tiles, or the ones stored
+     * with storeCachedHistogram(). The last histogram is reset if they are not all found, so that the histogram
+     * is computed from the image instead.
+     **/
+    void setLastHistogramFromTiles(int textureIndex,
+                                   const Natron::FrameKey & key,
+                                   const RectI & imageBounds,
+                                   const std::vector<ViewerTile> & tiles);
+    
 private:
     
     mutable QMutex renderAgeMutex; // protects renderAge lastRenderAge currentRenderAges
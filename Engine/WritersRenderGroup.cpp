@@ -0,0 +1,397 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "WritersRenderGroup.h"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <QDebug>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
+#include "Engine/Project.h"
+#include "Engine/Settings.h"
+#include "Engine/TimeLine.h"
+
+using namespace Natron;
+
+namespace {
+
+struct WriterData
+{
+    int firstFrame,lastFrame;
+
+    ///All frames before this one were released, or INT_MAX once the writer left the group
+    int firstFrameNotReleased;
+
+    ///Frames released after firstFrameNotReleased
+    std::set<int> released;
+
+    ///Nodes upstream of the writer
+    std::set<Natron::Node*> upstream;
+
+    bool hasReleased(int time) const
+    {
+        return time < firstFrameNotReleased || released.find(time) != released.end();
+    }
+};
+
+struct FrameData
+{
+    ///Writers which have to render this frame and did not release it yet
+    std::set<OutputEffectInstance*> pendingWriters;
+
+    ///Views for which the shared nodes were rendered, or are being rendered
+    std::set<int> renderedViews,viewsBeingRendered;
+
+    ///The images of the shared nodes, kept alive so that they are not evicted from the cache
+    ImageList images;
+};
+
+///Renders the whole region of definition of the node at scale 1, the same way the writers render their input
+void
+renderSharedNode(const NodePtr& node,
+                 int time,
+                 int view,
+                 ImageList* images)
+{
+    EffectInstance* effect = node->getLiveInstance();
+    RenderScale scale;
+
+    scale.x = scale.y = 1.;
+
+    RectD rod;
+    bool isProjectFormat;
+    StatusEnum stat = effect->getRegionOfDefinition_public(effect->getHash(), time, scale, view, &rod, &isProjectFormat);
+    if (stat == eStatusFailed) {
+        return;
+    }
+    std::list<ImageComponents> components;
+    ImageBitDepthEnum imageDepth;
+    effect->getPreferredDepthAndComponents(-1, &components, &imageDepth);
+    RectI renderWindow;
+    rod.toPixelEnclosing(scale, effect->getPreferredAspectRatio(), &renderWindow);
+
+    ParallelRenderArgsSetter frameRenderArgs(effect->getApp()->getProject().get(),
+                                             time,
+                                             view,
+                                             false, // is this render due to user interaction ?
+                                             false, // is this sequential ?
+                                             true, // canAbort ?
+                                             0, //renderAge
+                                             0, // viewer requester
+                                             0, //texture index
+                                             effect->getApp()->getTimeLine().get());
+    RenderingFlagSetter flagIsRendering(node.get());
+
+    ImageList planes;
+    try {
+        EffectInstance::RenderRoIRetCode retCode = effect->renderRoI(EffectInstance::RenderRoIArgs(time,
+                                                                                                    scale,
+                                                                                                    0,
+                                                                                                    view,
+                                                                                                    false,
+                                                                                                    renderWindow,
+                                                                                                    rod,
+                                                                                                    components,
+                                                                                                    imageDepth), &planes);
+        if (retCode != EffectInstance::eRenderRoIRetCodeOk) {
+            ///The writers will render it themselves and report the failure
+            return;
+        }
+    } catch (const std::exception& e) {
+        qDebug() << "Error while rendering" << node->getScriptName_mt_safe().c_str() << "for several writers:" << e.what();
+        return;
+    }
+    images->insert(images->end(), planes.begin(), planes.end());
+}
+
+void
+getUpstreamNodes(const NodePtr& node,
+                 std::set<Natron::Node*>* upstream,
+                 std::set<Natron::Node*>* visited,
+                 std::vector<NodePtr>* nodesInOrder)
+{
+    int maxInputs = node->getMaxInputCount();
+    for (int i = 0; i < maxInputs; ++i) {
+        NodePtr input = node->getInput(i);
+        if (!input || !upstream->insert(input.get()).second) {
+            continue;
+        }
+        getUpstreamNodes(input, upstream, visited, nodesInOrder);
+        ///Post-order: the inputs of a node are before it
+        if (visited->insert(input.get()).second) {
+            nodesInOrder->push_back(input);
+        }
+    }
+}
+} // anon namespace
+
+struct WritersRenderGroupPrivate
+{
+    mutable QMutex lock;
+
+    ///Signaled when a frame is released, a writer leaves the group, or the shared nodes of a frame are rendered
+    QWaitCondition cond;
+
+    std::map<OutputEffectInstance*,WriterData> writers;
+    std::map<int,FrameData> frames;
+
+    ///The nodes upstream of any writer, each one after its inputs
+    std::vector<NodePtr> nodesInOrder;
+
+    ///How many frames a writer may render ahead of the slowest one, to bound the memory held by the shared images
+    int maxFramesAhead;
+
+    WritersRenderGroupPrivate()
+    : lock()
+    , cond()
+    , writers()
+    , frames()
+    , nodesInOrder()
+    , maxFramesAhead(1)
+    {
+    }
+
+    ///Returns the first frame not released yet by the writers which have to render the given frame
+    int getSlowestFrame(int time) const
+    {
+        int ret = INT_MAX;
+        for (std::map<OutputEffectInstance*,WriterData>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+            if (time >= it->second.firstFrame && time <= it->second.lastFrame) {
+                ret = std::min(ret, it->second.firstFrameNotReleased);
+            }
+        }
+        return ret;
+    }
+
+    FrameData& getFrame(int time)
+    {
+        std::map<int,FrameData>::iterator found = frames.find(time);
+        if (found != frames.end()) {
+            return found->second;
+        }
+        FrameData& frame = frames[time];
+        for (std::map<OutputEffectInstance*,WriterData>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+            if (time >= it->second.firstFrame && time <= it->second.lastFrame && !it->second.hasReleased(time)) {
+                frame.pendingWriters.insert(it->first);
+            }
+        }
+        return frame;
+    }
+
+    /**
+     * @brief Returns the nodes upstream of several of the given writers and feeding a node which is not: rendering
+     * these is enough for the writers to find all the shared part of the graph in the cache.
+     **/
+    void getSharedNodesToRender(const std::set<OutputEffectInstance*>& pendingWriters,
+                                std::list<NodePtr>* nodes) const
+    {
+        std::map<Natron::Node*,int> writersCount;
+        std::set<Natron::Node*> writerNodes;
+        for (std::set<OutputEffectInstance*>::const_iterator it = pendingWriters.begin(); it != pendingWriters.end(); ++it) {
+            writerNodes.insert( (*it)->getNode().get() );
+            std::map<OutputEffectInstance*,WriterData>::const_iterator found = writers.find(*it);
+            assert( found != writers.end() );
+            for (std::set<Natron::Node*>::const_iterator it2 = found->second.upstream.begin(); it2 != found->second.upstream.end(); ++it2) {
+                ++writersCount[*it2];
+            }
+        }
+
+        for (std::vector<NodePtr>::const_iterator it = nodesInOrder.begin(); it != nodesInOrder.end(); ++it) {
+            std::map<Natron::Node*,int>::const_iterator found = writersCount.find( it->get() );
+            if ( found == writersCount.end() || found->second < 2 || (*it)->isOutputNode() || (*it)->isNodeDisabled() ) {
+                continue;
+            }
+            std::list<Natron::Node*> outputs;
+            (*it)->getOutputs_mt_safe(outputs);
+            bool feedsNonSharedNode = false;
+            for (std::list<Natron::Node*>::iterator it2 = outputs.begin(); it2 != outputs.end(); ++it2) {
+                if ( writerNodes.find(*it2) != writerNodes.end() ) {
+                    feedsNonSharedNode = true;
+                    break;
+                }
+                std::map<Natron::Node*,int>::const_iterator foundOutput = writersCount.find(*it2);
+                if (foundOutput != writersCount.end() && foundOutput->second < 2) {
+                    feedsNonSharedNode = true;
+                    break;
+                }
+            }
+            ///An image which is not cached could not be found by the writers anyway
+            if ( feedsNonSharedNode && (*it)->getLiveInstance()->shouldCacheOutput() ) {
+                nodes->push_back(*it);
+            }
+        }
+    }
+
+    ///Must be called under lock. The images of the frame are moved to imagesToRelease so that they are freed outside of the lock.
+    void removePendingWriter(int time,
+                             OutputEffectInstance* writer,
+                             ImageList* imagesToRelease)
+    {
+        std::map<int,FrameData>::iterator found = frames.find(time);
+        if ( found == frames.end() ) {
+            return;
+        }
+        found->second.pendingWriters.erase(writer);
+        if ( found->second.pendingWriters.empty() && found->second.viewsBeingRendered.empty() ) {
+            imagesToRelease->splice(imagesToRelease->end(), found->second.images);
+            frames.erase(found);
+        }
+    }
+};
+
+WritersRenderGroup::WritersRenderGroup(const std::list<WriterRange>& writers)
+: _imp(new WritersRenderGroupPrivate)
+{
+    std::set<Natron::Node*> visited;
+    for (std::list<WriterRange>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+        WriterData& data = _imp->writers[it->writer];
+        data.firstFrame = it->firstFrame;
+        data.lastFrame = it->lastFrame;
+        data.firstFrameNotReleased = it->firstFrame;
+        getUpstreamNodes(it->writer->getNode(), &data.upstream, &visited, &_imp->nodesInOrder);
+    }
+
+    int parallelRenders = appPTR->getCurrentSettings()->getNumberOfParallelRenders();
+    if (parallelRenders == 0) {
+        parallelRenders = appPTR->getHardwareIdealThreadCount();
+    }
+    _imp->maxFramesAhead = std::max(1, parallelRenders);
+}
+
+WritersRenderGroup::~WritersRenderGroup()
+{
+}
+
+void
+WritersRenderGroup::acquireFrame(OutputEffectInstance* writer,
+                                 int time,
+                                 int view)
+{
+    std::list<NodePtr> nodesToRender;
+    {
+        QMutexLocker k(&_imp->lock);
+        assert( _imp->writers.find(writer) != _imp->writers.end() );
+
+        ///The slowest writer can always render its next frame, so this cannot dead-lock
+        while ( time >= (qint64)_imp->getSlowestFrame(time) + _imp->maxFramesAhead ) {
+            _imp->cond.wait(&_imp->lock);
+        }
+
+        _imp->getFrame(time);
+
+        ///The frame is looked up again after each wait: releaseFrame() and removeWriter() may have erased it meanwhile
+        std::map<int,FrameData>::iterator found;
+        for (;;) {
+            found = _imp->frames.find(time);
+            if ( found == _imp->frames.end() ) {
+                return;
+            }
+            if (found->second.pendingWriters.size() < 2) {
+                ///No other writer needs this frame anymore
+                if ( found->second.pendingWriters.empty() && found->second.viewsBeingRendered.empty() ) {
+                    _imp->frames.erase(found);
+                }
+                return;
+            }
+            if ( found->second.viewsBeingRendered.find(view) == found->second.viewsBeingRendered.end() ) {
+                break;
+            }
+            _imp->cond.wait(&_imp->lock);
+        }
+        FrameData& frame = found->second;
+        if ( frame.renderedViews.find(view) != frame.renderedViews.end() ) {
+            return;
+        }
+        _imp->getSharedNodesToRender(frame.pendingWriters, &nodesToRender);
+        frame.viewsBeingRendered.insert(view);
+    }
+
+    ImageList images;
+    for (std::list<NodePtr>::iterator it = nodesToRender.begin(); it != nodesToRender.end(); ++it) {
+        if ( writer->aborted() ) {
+            break;
+        }
+        renderSharedNode(*it, time, view, &images);
+    }
+
+    QMutexLocker k(&_imp->lock);
+    ///The frame cannot be removed while a view is being rendered
+    std::map<int,FrameData>::iterator found = _imp->frames.find(time);
+    assert( found != _imp->frames.end() );
+    FrameData& frame = found->second;
+    frame.viewsBeingRendered.erase(view);
+    frame.renderedViews.insert(view);
+    if ( frame.pendingWriters.empty() && frame.viewsBeingRendered.empty() ) {
+        ///All the writers left the group meanwhile
+        _imp->frames.erase(time);
+    } else {
+        frame.images.splice(frame.images.end(), images);
+    }
+    _imp->cond.wakeAll();
+}
+
+void
+WritersRenderGroup::releaseFrame(OutputEffectInstance* writer,
+                                 int time)
+{
+    ImageList imagesToRelease;
+    {
+        QMutexLocker k(&_imp->lock);
+        std::map<OutputEffectInstance*,WriterData>::iterator found = _imp->writers.find(writer);
+        assert( found != _imp->writers.end() );
+        WriterData& data = found->second;
+        if ( data.hasReleased(time) ) {
+            return;
+        }
+        data.released.insert(time);
+        while ( !data.released.empty() && *data.released.begin() == data.firstFrameNotReleased ) {
+            data.released.erase( data.released.begin() );
+            ++data.firstFrameNotReleased;
+        }
+        _imp->removePendingWriter(time, writer, &imagesToRelease);
+        _imp->cond.wakeAll();
+    }
+}
+
+void
+WritersRenderGroup::removeWriter(OutputEffectInstance* writer)
+{
+    ImageList imagesToRelease;
+    {
+        QMutexLocker k(&_imp->lock);
+        std::map<OutputEffectInstance*,WriterData>::iterator found = _imp->writers.find(writer);
+        if ( found == _imp->writers.end() ) {
+            return;
+        }
+        found->second.firstFrameNotReleased = INT_MAX;
+        found->second.released.clear();
+
+        std::list<int> times;
+        for (std::map<int,FrameData>::iterator it = _imp->frames.begin(); it != _imp->frames.end(); ++it) {
+            times.push_back(it->first);
+        }
+        for (std::list<int>::iterator it = times.begin(); it != times.end(); ++it) {
+            _imp->removePendingWriter(*it, writer, &imagesToRelease);
+        }
+        _imp->cond.wakeAll();
+    }
+}
@@ -0,0 +1,77 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_WRITERSRENDERGROUP_H_
+#define NATRON_ENGINE_WRITERSRENDERGROUP_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+
+#include "Global/Macros.h"
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+namespace Natron {
+class OutputEffectInstance;
+}
+
+/**
+ * @brief Makes several writers rendering at the same time advance frame by frame together, so that the nodes
+ * upstream of more than one writer are rendered once per frame instead of once per writer.
+ *
+ * Each writer keeps its own scheduler and render threads. Before rendering a frame, a render thread calls acquireFrame():
+ * it waits until the frame is not too far ahead of the slowest writer, and the first thread to get there renders
+ * the shared nodes feeding the non-shared part of the graph. Their images are kept alive (hence in the cache) until
+ * every writer rendering that frame called releaseFrame(), so the writers all find them in the cache.
+ **/
+struct WritersRenderGroupPrivate;
+class WritersRenderGroup
+{
+public:
+
+    struct WriterRange
+    {
+        Natron::OutputEffectInstance* writer;
+        int firstFrame,lastFrame;
+    };
+
+    /**
+     * @brief The graph upstream of the writers is analysed here and must not change during the render.
+     * Must be called on the main thread.
+     **/
+    WritersRenderGroup(const std::list<WriterRange>& writers);
+
+    ~WritersRenderGroup();
+
+    /**
+     * @brief Called by a render thread of the writer before it renders the given view of the frame.
+     * Blocks while the frame is too far ahead of the slowest writer, then makes sure the nodes shared by the writers
+     * rendering this frame are rendered for this view.
+     **/
+    void acquireFrame(Natron::OutputEffectInstance* writer,int time,int view);
+
+    /**
+     * @brief Called by a render thread of the writer when it does not need the images of the upstream nodes
+     * at the given frame anymore, whether the frame was rendered or not.
+     **/
+    void releaseFrame(Natron::OutputEffectInstance* writer,int time);
+
+    /**
+     * @brief Called when the writer stops rendering, because it is done or because it failed or was aborted:
+     * the other writers do not wait for it anymore.
+     **/
+    void removeWriter(Natron::OutputEffectInstance* writer);
+
+private:
+
+    boost::scoped_ptr<WritersRenderGroupPrivate> _imp;
+};
+
+#endif // NATRON_ENGINE_WRITERSRENDERGROUP_H_
@@ -68,23 +68,16 @@ typedef OfxPointD Point;
 typedef OfxRGBAColourF RGBAColourF;
 typedef OfxRangeD RangeD;
 
-///these are used between process to communicate via the pipes
+///these are printed by background processes that do not communicate with a main process via the pipes, @see ProcessMessage.h
 #define kRenderingStartedLong "Rendering started"
-#define kRenderingStartedShort "-b"
 
 #define kFrameRenderedStringLong "Frame rendered: "
-#define kFrameRenderedStringShort "-r"
 
 #define kProgressChangedStringLong "Progress changed: "
-#define kProgressChangedStringShort "-p"
 
 #define kRenderingFinishedStringLong "Rendering finished"
-#define kRenderingFinishedStringShort "-e"
 
 #define kAbortRenderingStringLong "Abort rendering"
-#define kAbortRenderingStringShort "-a"
-
-#define kBgProcessServerCreatedShort "--bg_server_created"
 
 
 #define kNodeGraphObjectName "nodeGraph"
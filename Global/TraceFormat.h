@@ -0,0 +1,117 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_GLOBAL_TRACEFORMAT_H_
+#define NATRON_GLOBAL_TRACEFORMAT_H_
+
+// Layout of the trace files written by Natron::Trace (Engine/Trace.h) and read by NatronTraceDecoder.
+// This header must not depend on anything else than QtCore so that the decoder can be built on its own.
+//
+// A trace file is made of:
+// - a TraceFileHeader
+// - for each thread that recorded events: a TraceThreadHeader followed by recordsCount TraceRecord,
+//   from the oldest to the most recent one.
+// All values are written in the byte order of the machine that recorded them: TraceFileHeader::byteOrderMark
+// lets the decoder detect a file written with another byte order.
+
+#include <QtCore/qglobal.h>
+
+#define NATRON_TRACE_FILE_MAGIC "NTRACE01"
+#define NATRON_TRACE_FILE_VERSION 1
+#define NATRON_TRACE_BYTE_ORDER_MARK 0x01020304
+
+///Bytes of payload of a record, so that a record is 64 bytes long
+#define NATRON_TRACE_PAYLOAD_SIZE 48
+
+///Bytes of the name of a thread in a TraceThreadHeader
+#define NATRON_TRACE_THREAD_NAME_SIZE 48
+
+namespace Natron {
+namespace Trace {
+
+enum TraceEventEnum
+{
+    eTraceEventNone = 0,
+
+    ///Payload: the text given to Log::beginFunction()
+    eTraceEventBeginFunction,
+
+    ///Payload: the text given to Log::endFunction()
+    eTraceEventEndFunction,
+
+    ///Payload: the first NATRON_TRACE_PAYLOAD_SIZE bytes of a text, the rest of the text follows
+    ///in eTraceEventMessageContinued records
+    eTraceEventMessage,
+    eTraceEventMessageContinued,
+
+    ///Payload: TraceRenderPayload, recorded when an effect starts rendering a tile
+    eTraceEventRenderBegin,
+
+    ///Payload: the Natron::StatusEnum returned by the render action as a qint32, or -1 if it threw an exception
+    eTraceEventRenderEnd,
+
+    ///Event ids greater or equal to this one are free for ad-hoc traces and are shown as hexadecimal payloads
+    eTraceEventUser = 1024
+};
+
+struct TraceFileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrderMark;
+
+    ///sizeof(TraceRecord)
+    quint32 recordSize;
+    quint32 threadsCount;
+
+    ///Milliseconds since the epoch at the time the timestamps of the records are relative to
+    qint64 startTimeMs;
+};
+
+struct TraceThreadHeader
+{
+    ///Index of the thread in the order threads started recording, also stored in each record
+    quint32 threadIndex;
+    quint32 recordsCount;
+
+    ///Records lost because the ring buffer of the thread was full
+    quint64 droppedCount;
+
+    ///Native id of the thread as returned by QThread::currentThreadId()
+    quint64 nativeThreadId;
+
+    ///Null terminated
+    char name[NATRON_TRACE_THREAD_NAME_SIZE];
+};
+
+struct TraceRecord
+{
+    ///Nanoseconds since TraceFileHeader::startTimeMs
+    quint64 timestamp;
+    quint32 threadIndex;
+
+    ///A TraceEventEnum
+    quint16 event;
+    quint16 payloadSize;
+    unsigned char payload[NATRON_TRACE_PAYLOAD_SIZE];
+};
+
+///Size of the name of the effect in a TraceRenderPayload
+#define NATRON_TRACE_RENDER_NAME_SIZE (NATRON_TRACE_PAYLOAD_SIZE - 6 * 4)
+
+struct TraceRenderPayload
+{
+    qint32 time;
+    qint32 view;
+    qint32 x1, y1, x2, y2;
+
+    ///Script name of the node, truncated and not necessarily null terminated
+    char name[NATRON_TRACE_RENDER_NAME_SIZE];
+};
+
+} // namespace Trace
+} // namespace Natron
+
+#endif // NATRON_GLOBAL_TRACEFORMAT_H_
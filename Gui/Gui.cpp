@@ -107,6 +107,7 @@ CLANG_DIAG_ON(unused-parameter)
 #include "Gui/MultiInstancePanel.h"
 #include "Gui/ScriptEditor.h"
 #include "Gui/PythonPanels.h"
+#include "Gui/PreviewThread.h"
 
 #define kPropertiesBinName "properties"
 
@@ -300,6 +301,9 @@ struct GuiPrivate
     NodeGraph* _lastFocusedGraph;
     std::list<NodeGraph*> _groups;
 
+    ///Computes the previews of the nodes
+    boost::scoped_ptr<PreviewThread> _previewThread;
+
     ///The curve editor.
     CurveEditor *_curveEditor;
 
@@ -447,6 +451,7 @@ struct GuiPrivate
         , _nodeGraphArea(0)
         , _lastFocusedGraph(0)
         , _groups()
+        , _previewThread(new PreviewThread)
         , _curveEditor(0)
         , _toolBox(0)
         , _propertiesBin(0)
@@ -685,11 +690,13 @@ Gui::abortProject(bool quitApp)
 
         assert(_imp->_appInstance);
 
+        _imp->_previewThread->quitThread();
         _imp->_appInstance->getProject()->closeProject();
         _imp->notifyGuiClosing();
         _imp->_appInstance->quit();
     } else {
         _imp->_appInstance->resetPreviewProvider();
+        _imp->_previewThread->abortPendingPreviews();
         _imp->_appInstance->getProject()->closeProject();
         centerAllNodeGraphsWithTimer();
         restoreDefaultLayout();
@@ -4265,6 +4272,12 @@ Gui::getCurveEditor() const
     return _imp->_curveEditor;
 }
 
+PreviewThread*
+Gui::getPreviewThread() const
+{
+    return _imp->_previewThread.get();
+}
+
 ScriptEditor*
 Gui::getScriptEditor() const
 {
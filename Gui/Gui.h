@@ -69,6 +69,7 @@ class FloatingWidget;
 class BoundAction;
 class ScriptEditor;
 class PyPanel;
+class PreviewThread;
 
 //Natron engine
 class ViewerInstance;
@@ -375,6 +376,8 @@ public:
 
     NodeGraph* getNodeGraph() const;
     CurveEditor* getCurveEditor() const;
+    
+    PreviewThread* getPreviewThread() const;
     ScriptEditor* getScriptEditor() const;
     
     QVBoxLayout* getPropertiesLayout() const;
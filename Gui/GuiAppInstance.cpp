@@ -746,7 +746,8 @@ GuiAppInstance::endProgress(KnobHolder* effect)
 
 bool
 GuiAppInstance::progressUpdate(KnobHolder* effect,
-                               double t)
+                               double t,
+                               int /*time*/)
 {
     bool ret =  _imp->_gui->progressUpdate(effect, t);
 
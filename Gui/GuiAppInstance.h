@@ -118,7 +118,7 @@ public:
     virtual bool isShowingDialog() const OVERRIDE FINAL;
     virtual void startProgress(KnobHolder* effect,const std::string & message,bool canCancel = true) OVERRIDE FINAL;
     virtual void endProgress(KnobHolder* effect) OVERRIDE FINAL;
-    virtual bool progressUpdate(KnobHolder* effect,double t) OVERRIDE FINAL;
+    virtual bool progressUpdate(KnobHolder* effect,double t,int time) OVERRIDE FINAL;
     virtual void onMaxPanelsOpenedChanged(int maxPanels) OVERRIDE FINAL;
     virtual void connectViewersToViewerCache() OVERRIDE FINAL;
     virtual void disconnectViewersFromViewerCache() OVERRIDE FINAL;
@@ -106,12 +106,26 @@ struct HistogramPrivate
           , binsCount(0)
           , mipMapLevel(0)
           , hasImage(false)
+          , requestViewer()
+          , requestTextureIndex(0)
 #endif
          , sizeH()
     {
     }
 
-    boost::shared_ptr<Natron::Image> getHistogramImage(RectI* imagePortion) const;
+    boost::shared_ptr<Natron::Image> getHistogramImage(RectI* imagePortion,
+                                                       ViewerInstance** viewerNode = 0,
+                                                       int* textureIndex = 0) const;
+
+#ifndef NATRON_HISTOGRAM_USING_OPENGL
+    ///Asks the viewer node to accumulate the bins of this histogram while it renders, and stops the previous request
+    ///if it was made to another viewer. viewerNode may be NULL to just stop the request.
+    void updateViewerHistogramRequest(ViewerInstance* viewerNode,
+                                      int textureIndex,
+                                      int binsCount,
+                                      double vmin,
+                                      double vmax);
+#endif
 
 
     void showMenu(const QPoint & globalPos);
@@ -245,6 +259,10 @@ struct HistogramPrivate
     unsigned int binsCount;
     unsigned int mipMapLevel;
     bool hasImage;
+    
+    ///The viewer node to which the bins of the histogram were requested, see ViewerInstance::setHistogramRequest()
+    boost::weak_ptr<Natron::Node> requestViewer;
+    int requestTextureIndex;
 #endif // !NATRON_HISTOGRAM_USING_OPENGL
     
     QSize sizeH;
@@ -407,10 +425,14 @@ Histogram::~Histogram()
     glDeleteBuffers(1,&_imp->vboID);
     glDeleteBuffers(1,&_imp->vboHistogramRendering);
 
+#else
+    _imp->updateViewerHistogramRequest(NULL, 0, -1, 0., 0.);
 #endif
 }
 
-boost::shared_ptr<Natron::Image> HistogramPrivate::getHistogramImage(RectI* imagePortion) const
+boost::shared_ptr<Natron::Image> HistogramPrivate::getHistogramImage(RectI* imagePortion,
+                                                                     ViewerInstance** viewerNode,
+                                                                     int* textureIndexOut) const
 {
     // always running in the main thread
     assert( qApp && qApp->thread() == QThread::currentThread() );
@@ -429,6 +451,9 @@ boost::shared_ptr<Natron::Image> HistogramPrivate::getHistogramImage(RectI* imag
     if (selectedInputAction) {
         textureIndex = selectedInputAction->data().toInt();
     } 
+    if (textureIndexOut) {
+        *textureIndexOut = textureIndex;
+    }
     if (index == 0) {
         //no viewer selected
         imagePortion->clear();
@@ -439,15 +464,19 @@ boost::shared_ptr<Natron::Image> HistogramPrivate::getHistogramImage(RectI* imag
         ViewerTab* lastSelectedViewer = gui->getNodeGraph()->getLastSelectedViewer();
         boost::shared_ptr<Natron::Image> ret;
         if (lastSelectedViewer) {
+            if (viewerNode) {
+                *viewerNode = lastSelectedViewer->getInternalNode();
+            }
             ret = lastSelectedViewer->getViewer()->getLastRenderedImageByMipMapLevel(textureIndex,lastSelectedViewer->getInternalNode()->getMipMapLevelFromZoomFactor());
         }
         if (ret) {
+            ///The portions of the image the viewer accumulates the bins on, @see ViewerInstance::setHistogramRequest
             if (!useImageRoD) {
                 if (lastSelectedViewer) {
-                    *imagePortion = lastSelectedViewer->getViewer()->getImageRectangleDisplayed(ret->getBounds(), ret->getPixelAspectRatio(), ret->getMipMapLevel());
+                    *imagePortion = lastSelectedViewer->getViewer()->getImageRectangleDisplayedRoundedToTileSize(ret->getRoD(), ret->getPixelAspectRatio(), ret->getMipMapLevel());
                 }
             } else {
-                *imagePortion = ret->getBounds();
+                ret->getRoD().toPixelEnclosing(ret->getMipMapLevel(), ret->getPixelAspectRatio(), imagePortion);
             }
         }
 
@@ -457,12 +486,15 @@ boost::shared_ptr<Natron::Image> HistogramPrivate::getHistogramImage(RectI* imag
         const std::list<ViewerTab*> & viewerTabs = gui->getViewersList();
         for (std::list<ViewerTab*>::const_iterator it = viewerTabs.begin(); it != viewerTabs.end(); ++it) {
             if ( (*it)->getInternalNode()->getScriptName_mt_safe() == viewerName ) {
+                if (viewerNode) {
+                    *viewerNode = (*it)->getInternalNode();
+                }
                 ret = (*it)->getViewer()->getLastRenderedImage(textureIndex);
                 if (ret) {
                     if (!useImageRoD) {
-                        *imagePortion = (*it)->getViewer()->getImageRectangleDisplayed(ret->getBounds(), ret->getPixelAspectRatio(), ret->getMipMapLevel());
+                        *imagePortion = (*it)->getViewer()->getImageRectangleDisplayedRoundedToTileSize(ret->getRoD(), ret->getPixelAspectRatio(), ret->getMipMapLevel());
                     } else {
-                        *imagePortion = ret->getBounds();
+                        ret->getRoD().toPixelEnclosing(ret->getMipMapLevel(), ret->getPixelAspectRatio(), imagePortion);
                     }
                 }
 
@@ -474,6 +506,35 @@ boost::shared_ptr<Natron::Image> HistogramPrivate::getHistogramImage(RectI* imag
     }
 } // getHistogramImage
 
+#ifndef NATRON_HISTOGRAM_USING_OPENGL
+void
+HistogramPrivate::updateViewerHistogramRequest(ViewerInstance* viewerNode,
+                                               int textureIndex,
+                                               int binsCount,
+                                               double vmin,
+                                               double vmax)
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+
+    boost::shared_ptr<Natron::Node> previous = requestViewer.lock();
+    if (previous) {
+        ViewerInstance* previousNode = dynamic_cast<ViewerInstance*>( previous->getLiveInstance() );
+        if ( previousNode && ( (previousNode != viewerNode) || (requestTextureIndex != textureIndex) ) ) {
+            previousNode->setHistogramRequest(requestTextureIndex, 0, -1, 0., 0., false);
+        }
+    }
+    if (!viewerNode || binsCount <= 0) {
+        requestViewer.reset();
+
+        return;
+    }
+    viewerNode->setHistogramRequest(textureIndex, (int)mode, binsCount, vmin, vmax, fullImage->isChecked());
+    requestViewer = viewerNode->getNode();
+    requestTextureIndex = textureIndex;
+}
+#endif
+
 void
 HistogramPrivate::showMenu(const QPoint & globalPos)
 {
@@ -1436,6 +1497,9 @@ Histogram::computeHistogramAndRefresh(bool forceEvenIfNotVisible)
     assert( qApp && qApp->thread() == QThread::currentThread() );
 
     if (!isVisible() && !forceEvenIfNotVisible) {
+#ifndef NATRON_HISTOGRAM_USING_OPENGL
+        _imp->updateViewerHistogramRequest(NULL, 0, -1, 0., 0.);
+#endif
         return;
     }
 
@@ -1447,9 +1511,23 @@ Histogram::computeHistogramAndRefresh(bool forceEvenIfNotVisible)
 #ifndef NATRON_HISTOGRAM_USING_OPENGL
 
     RectI rect;
-    boost::shared_ptr<Natron::Image> image = _imp->getHistogramImage(&rect);
+    ViewerInstance* viewerNode = 0;
+    int textureIndex = 0;
+    boost::shared_ptr<Natron::Image> image = _imp->getHistogramImage(&rect, &viewerNode, &textureIndex);
+    
+    ///The viewer accumulates the bins of the next images it renders, so that they are not read again here
+    _imp->updateViewerHistogramRequest(viewerNode, textureIndex, width(), vmin, vmax);
+    
     if (image) {
-        _imp->histogramThread.computeHistogram(_imp->mode, image, rect, width(),vmin,vmax,_imp->filterSize);
+        boost::shared_ptr<HistogramBins> bins;
+        if (viewerNode) {
+            bins = viewerNode->getLastHistogram(textureIndex);
+        }
+        if ( bins && bins->isValidFor(_imp->mode, width(), vmin, vmax, rect) ) {
+            _imp->histogramThread.computeHistogram(bins, image->getMipMapLevel(), _imp->filterSize);
+        } else {
+            _imp->histogramThread.computeHistogram(_imp->mode, image, rect, width(),vmin,vmax,_imp->filterSize);
+        }
     } else {
         _imp->hasImage = false;
     }
@@ -27,13 +27,10 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QUndoCommand>
 #include <QPainter>
 #include <QCheckBox>
-#include <QWaitCondition>
-#include <QtConcurrentMap>
 #include <QMenu>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
-#include <boost/bind.hpp>
 #include <boost/weak_ptr.hpp>
 
 #include "Engine/Node.h"
@@ -42,6 +39,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/EffectInstance.h"
 #include "Engine/Curve.h"
 #include "Engine/TimeLine.h"
+#include "Engine/TrackScheduler.h"
 
 #include <ofxNatron.h>
 
@@ -1583,9 +1581,6 @@ struct TrackerPanelPrivate
     TrackerPanel* publicInterface;
     Button* averageTracksButton;
     
-    mutable QMutex updateViewerMutex;
-    bool updateViewerOnTrackingEnabled;
-    
     Natron::Label* exportLabel;
     QWidget* exportContainer;
     QHBoxLayout* exportLayout;
@@ -1602,8 +1597,6 @@ struct TrackerPanelPrivate
     TrackerPanelPrivate(TrackerPanel* publicInterface)
         : publicInterface(publicInterface)
           , averageTracksButton(0)
-          , updateViewerMutex()
-          , updateViewerOnTrackingEnabled(true)
           , exportLabel(0)
           , exportContainer(0)
           , exportLayout(0)
@@ -1611,7 +1604,7 @@ struct TrackerPanelPrivate
           , exportButton(0)
           , transformPage()
           , referenceFrame()
-          , scheduler(publicInterface)
+          , scheduler()
     {
     }
 
@@ -1855,22 +1848,6 @@ TrackerPanel::onButtonTriggered(Button_Knob* button)
     }
 }
 
-static void
-handleTrackNextAndPrevious(Button_Knob* selectedInstance,
-                           SequenceTime currentFrame)
-{
-//        ///When a reason of eValueChangedReasonUserEdited is given, the tracker plug-in will move the timeline so just send it
-//        ///upon the last track if we want to update the viewer
-//        Natron::ValueChangedReasonEnum reason;
-//        if (updateViewer) {
-//            reason = next == selectedInstances.end() ? eValueChangedReasonNatronGuiEdited : eValueChangedReasonNatronInternalEdited;
-//        } else {
-//            reason = eValueChangedReasonNatronInternalEdited;
-//        }
-        selectedInstance->getHolder()->onKnobValueChanged_public(selectedInstance,eValueChangedReasonNatronInternalEdited,currentFrame,
-                                                                 true);
-}
-
 void
 TrackerPanel::onTrackingStarted()
 {
@@ -1947,7 +1924,7 @@ TrackerPanel::trackBackward()
     int end = leftBound - 1;
     int start = getApp()->getTimeLine()->currentFrame();
     
-    _imp->scheduler.track(start, end, false, instanceButtons);
+    _imp->scheduler.track(start, end, false, instanceButtons, getApp()->getTimeLine());
     
     return true;
 } // trackBackward
@@ -1969,7 +1946,7 @@ TrackerPanel::trackForward()
     int end = rightBound + 1;
     int start = timeline->currentFrame();
     
-    _imp->scheduler.track(start, end, true, instanceButtons);
+    _imp->scheduler.track(start, end, true, instanceButtons, getApp()->getTimeLine());
     
     return true;
 
@@ -2002,7 +1979,7 @@ TrackerPanel::trackPrevious()
     int start = timeline->currentFrame();
     int end = start - 1;
     
-    _imp->scheduler.track(start, end, false, instanceButtons);
+    _imp->scheduler.track(start, end, false, instanceButtons, getApp()->getTimeLine());
 
     return true;
 }
@@ -2028,7 +2005,7 @@ TrackerPanel::trackNext()
     int start = timeline->currentFrame();
     int end = start + 1;
     
-    _imp->scheduler.track(start, end, true, instanceButtons);
+    _imp->scheduler.track(start, end, true, instanceButtons, getApp()->getTimeLine());
     
     return true;
 }
@@ -2086,15 +2063,13 @@ TrackerPanel::clearForwardAnimationForSelection()
 void
 TrackerPanel::setUpdateViewerOnTracking(bool update)
 {
-    QMutexLocker k(&_imp->updateViewerMutex);
-    _imp->updateViewerOnTrackingEnabled = update;
+    _imp->scheduler.setUpdateViewerOnTracking(update);
 }
 
 bool
 TrackerPanel::isUpdateViewerOnTrackingEnabled() const
 {
-    QMutexLocker k(&_imp->updateViewerMutex);
-    return _imp->updateViewerOnTrackingEnabled;
+    return _imp->scheduler.isUpdateViewerOnTrackingEnabled();
 }
 
 void
@@ -2295,263 +2270,3 @@ TrackerPanel::showMenuForInstance(Natron::Node* instance)
     }
 }
 
-
-struct TrackArgs
-{
-    int start,end;
-    bool forward;
-    std::list<Button_Knob*> instances;
-};
-
-struct TrackSchedulerPrivate
-{
-    const TrackerPanel* panel;
-    
-    QMutex argsMutex;
-    TrackArgs curArgs,requestedArgs;
-    
-    mutable QMutex mustQuitMutex;
-    bool mustQuit;
-    QWaitCondition mustQuitCond;
-    
-    mutable QMutex abortRequestedMutex;
-    int abortRequested;
-    QWaitCondition abortRequestedCond;
-    
-    QMutex startRequesstMutex;
-    int startRequests;
-    QWaitCondition startRequestsCond;
-    
-    mutable QMutex isWorkingMutex;
-    bool isWorking;
-    
-    
-    TrackSchedulerPrivate(const TrackerPanel* panel)
-    : panel(panel)
-    , argsMutex()
-    , curArgs()
-    , requestedArgs()
-    , mustQuitMutex()
-    , mustQuit(false)
-    , mustQuitCond()
-    , abortRequestedMutex()
-    , abortRequested(0)
-    , abortRequestedCond()
-    , startRequesstMutex()
-    , startRequests(0)
-    , startRequestsCond()
-    , isWorkingMutex()
-    , isWorking(false)
-    {
-        
-    }
-    
-    bool checkForExit()
-    {
-        QMutexLocker k(&mustQuitMutex);
-        if (mustQuit) {
-            mustQuit = false;
-            mustQuitCond.wakeAll();
-            return true;
-        }
-        return false;
-    }
-    
-};
-
-
-TrackScheduler::TrackScheduler(const TrackerPanel* panel)
-: QThread()
-, _imp(new TrackSchedulerPrivate(panel))
-{
-    setObjectName("TrackScheduler");
-}
-
-TrackScheduler::~TrackScheduler()
-{
-    
-}
-
-bool
-TrackScheduler::isWorking() const
-{
-    QMutexLocker k(&_imp->isWorkingMutex);
-    return _imp->isWorking;
-}
-
-void
-TrackScheduler::run()
-{
-    for (;;) {
-        
-        ///Check for exit of the thread
-        if (_imp->checkForExit()) {
-            return;
-        }
-        
-        ///Flag that we're working
-        {
-            QMutexLocker k(&_imp->isWorkingMutex);
-            _imp->isWorking = true;
-        }
-        
-        ///Copy the requested args to the args used for processing
-        {
-            QMutexLocker k(&_imp->argsMutex);
-            _imp->curArgs = _imp->requestedArgs;
-        }
-        
-        boost::shared_ptr<TimeLine> timeline = _imp->panel->getApp()->getTimeLine();
-
-        int end = _imp->curArgs.end;
-        int start = _imp->curArgs.start;
-        int cur = start;
-        
-        int framesCount = _imp->curArgs.forward ? (end - start) : (start - end);
-        
-        bool reportProgress = _imp->curArgs.instances.size() > 1 || framesCount > 1;
-        if (reportProgress) {
-            Q_EMIT trackingStarted();
-        }
-        
-        while (cur != end) {
-            
-            
-            ///Launch parallel thread for each track using the global thread pool
-            QtConcurrent::map(_imp->curArgs.instances,
-                              boost::bind(&handleTrackNextAndPrevious,
-                                          _1,
-                                          cur)).waitForFinished();
-            
-            
-            double progress;
-            if (_imp->curArgs.forward) {
-                ++cur;
-                progress = (double)(cur - start) / framesCount;
-            } else {
-                --cur;
-                progress = (double)(start - cur) / framesCount;
-            }
-            
-            ///Ok all tracks are finished now for this frame, refresh viewer if needed
-            bool updateViewer = _imp->panel->isUpdateViewerOnTrackingEnabled();
-            if (updateViewer) {
-                timeline->seekFrame(cur, true, 0, Natron::eTimelineChangeReasonPlaybackSeek);
-            }
-
-            if (reportProgress) {
-                ///Notify we progressed of 1 frame
-                Q_EMIT progressUpdate(progress);
-            }
-            
-            ///Check for abortion
-            {
-                QMutexLocker k(&_imp->abortRequestedMutex);
-                if (_imp->abortRequested > 0) {
-                    _imp->abortRequested = 0;
-                    _imp->abortRequestedCond.wakeAll();
-                    break;
-                }
-            }
-
-        }
-        
-        if (reportProgress) {
-            Q_EMIT trackingFinished();
-        }
-        
-        ///Flag that we're no longer working
-        {
-            QMutexLocker k(&_imp->isWorkingMutex);
-            _imp->isWorking = false;
-        }
-        
-        ///Make sure we really reset the abort flag
-        {
-            QMutexLocker k(&_imp->abortRequestedMutex);
-            if (_imp->abortRequested > 0) {
-                _imp->abortRequested = 0;
-                
-            }
-        }
-        
-        ///Sleep or restart if we've requests in the queue
-        {
-            QMutexLocker k(&_imp->startRequesstMutex);
-            while (_imp->startRequests <= 0) {
-                _imp->startRequestsCond.wait(&_imp->startRequesstMutex);
-            }
-            _imp->startRequests = 0;
-        }
-        
-    }
-}
-
-void
-TrackScheduler::track(int startingFrame,int end,bool forward, const std::list<Button_Knob*> & selectedInstances)
-{
-    if ((forward && startingFrame >= end) || (!forward && startingFrame <= end)) {
-        Q_EMIT trackingFinished();
-        return;
-    }
-    {
-        QMutexLocker k(&_imp->argsMutex);
-        _imp->requestedArgs.start = startingFrame;
-        _imp->requestedArgs.end = end;
-        _imp->requestedArgs.forward = forward;
-        _imp->requestedArgs.instances = selectedInstances;
-    }
-    if (isRunning()) {
-        QMutexLocker k(&_imp->startRequesstMutex);
-        ++_imp->startRequests;
-        _imp->startRequestsCond.wakeAll();
-    } else {
-        start();
-    }
-}
-
-
-void TrackScheduler::abortTracking()
-{
-    if (!isRunning() || !isWorking()) {
-        return;
-    }
-    
-    
-    {
-        QMutexLocker k(&_imp->abortRequestedMutex);
-        ++_imp->abortRequested;
-        _imp->abortRequestedCond.wakeAll();
-    }
-    
-}
-
-void
-TrackScheduler::quitThread()
-{
-    if (!isRunning()) {
-        return;
-    }
-    
-    abortTracking();
-    
-    {
-        QMutexLocker k(&_imp->mustQuitMutex);
-        _imp->mustQuit = true;
-
-        {
-            QMutexLocker k(&_imp->startRequesstMutex);
-            ++_imp->startRequests;
-            _imp->startRequestsCond.wakeAll();
-        }
-        
-        while (_imp->mustQuit) {
-            _imp->mustQuitCond.wait(&_imp->mustQuitMutex);
-        }
-
-    }
-
-    
-    wait();
-    
-}
@@ -40,6 +40,7 @@ CLANG_DIAG_ON(uninitialized)
 class DefaultOverlay;
 class Edge;
 class QPainterPath;
+class QImage;
 class QScrollArea;
 class NodeSettingsPanel;
 class QVBoxLayout;
@@ -428,6 +429,9 @@ public Q_SLOTS:
 
     /*Updates the preview image no matter what*/
     void forceComputePreview(int time);
+    
+    /*Called by the PreviewThread in the main thread once the preview of the node is computed*/
+    void setPreviewImage(const QImage& image);
 
     void setName(const QString & _nameItem);
 
@@ -524,7 +528,7 @@ private:
     
     void setAboveItem(QGraphicsItem* item);
 
-    void computePreviewImage(int time);
+    void appendToPreviewQueue(int time);
 
     void populateMenu();
 
@@ -0,0 +1,222 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "PreviewThread.h"
+
+#include <list>
+#include <cstdlib>
+#include <cassert>
+#ifdef __NATRON_LINUX__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#endif
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/weak_ptr.hpp>
+#endif
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QCoreApplication>
+#include <QtGui/QImage>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+
+#include "Engine/Node.h"
+#include "Gui/NodeGui.h"
+
+struct PreviewRequest
+{
+    boost::weak_ptr<NodeGui> gui;
+    boost::shared_ptr<Natron::Node> node;
+    int time;
+};
+
+struct PreviewResult
+{
+    boost::weak_ptr<NodeGui> gui;
+    QImage image;
+};
+
+struct PreviewThreadPrivate
+{
+    ///Protects queue, mustQuit and computingNode
+    QMutex queueMutex;
+    std::list<PreviewRequest> queue;
+    QWaitCondition queueCond;
+    bool mustQuit;
+    boost::shared_ptr<Natron::Node> computingNode; //< the node whose preview is being computed, if any
+
+    QMutex resultsMutex;
+    std::list<PreviewResult> results;
+
+    PreviewThreadPrivate()
+    : queueMutex()
+    , queue()
+    , queueCond()
+    , mustQuit(false)
+    , computingNode()
+    , resultsMutex()
+    , results()
+    {
+    }
+};
+
+PreviewThread::PreviewThread()
+: QThread()
+, _imp(new PreviewThreadPrivate())
+{
+    setObjectName("PreviewThread");
+    QObject::connect( this, SIGNAL( previewsComputed() ), this, SLOT( onPreviewsComputed() ) );
+}
+
+PreviewThread::~PreviewThread()
+{
+    quitThread();
+}
+
+void
+PreviewThread::appendToQueue(const boost::shared_ptr<NodeGui>& node,
+                             int time)
+{
+    assert(QThread::currentThread() == qApp->thread());
+
+    boost::shared_ptr<Natron::Node> internalNode = node->getNode();
+    {
+        QMutexLocker k(&_imp->queueMutex);
+
+        ///If the node is already waiting for its preview, just render the last time requested
+        for (std::list<PreviewRequest>::iterator it = _imp->queue.begin(); it != _imp->queue.end(); ++it) {
+            if (it->node == internalNode) {
+                it->time = time;
+                return;
+            }
+        }
+
+        ///The preview being computed for this node is out of date, it will be computed again
+        if (_imp->computingNode == internalNode) {
+            internalNode->abortPreviewRendering();
+        }
+
+        PreviewRequest r;
+        r.gui = node;
+        r.node = internalNode;
+        r.time = time;
+        _imp->queue.push_back(r);
+        _imp->queueCond.wakeOne();
+    }
+    if ( !isRunning() ) {
+        start(QThread::IdlePriority);
+    }
+}
+
+void
+PreviewThread::abortPendingPreviews()
+{
+    QMutexLocker k(&_imp->queueMutex);
+    _imp->queue.clear();
+    if (_imp->computingNode) {
+        _imp->computingNode->abortPreviewRendering();
+    }
+}
+
+void
+PreviewThread::quitThread()
+{
+    if ( !isRunning() ) {
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->queueMutex);
+        _imp->queue.clear();
+        if (_imp->computingNode) {
+            _imp->computingNode->abortPreviewRendering();
+        }
+        _imp->mustQuit = true;
+        _imp->queueCond.wakeOne();
+    }
+    wait();
+}
+
+void
+PreviewThread::run()
+{
+#ifdef __NATRON_LINUX__
+    ///The priority given to QThread::start() is ignored by the default Linux scheduler: lower the nice value of this thread
+    ///instead. The previews are rendered entirely by this thread, @see ParallelRenderArgs::previewRequester
+    setpriority( PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19 );
+#endif
+    for (;;) {
+        PreviewRequest request;
+        {
+            QMutexLocker k(&_imp->queueMutex);
+            _imp->computingNode.reset();
+            while (_imp->queue.empty() && !_imp->mustQuit) {
+                _imp->queueCond.wait(&_imp->queueMutex);
+            }
+            if (_imp->mustQuit) {
+                _imp->mustQuit = false;
+                return;
+            }
+            request = _imp->queue.front();
+            _imp->queue.pop_front();
+            _imp->computingNode = request.node;
+        }
+
+        if ( request.node->isRenderingPreview() ) {
+            continue;
+        }
+
+        int w = NATRON_PREVIEW_WIDTH;
+        int h = NATRON_PREVIEW_HEIGHT;
+        size_t dataSize = 4 * w * h;
+#ifndef __NATRON_WIN32__
+        unsigned int* buf = (unsigned int*)calloc(dataSize,1);
+#else
+        unsigned int* buf = (unsigned int*)malloc(dataSize);
+        for (int i = 0; i < w * h; ++i) {
+            buf[i] = qRgba(0,0,0,255);
+        }
+#endif
+        bool success = request.node->makePreviewImage(request.time, &w, &h, buf);
+        if (success) {
+            PreviewResult result;
+            result.gui = request.gui;
+            ///Deep copy since the buffer is freed below
+            result.image = QImage(reinterpret_cast<const uchar*>(buf), w, h, QImage::Format_ARGB32_Premultiplied).copy();
+            {
+                QMutexLocker k(&_imp->resultsMutex);
+                _imp->results.push_back(result);
+            }
+            Q_EMIT previewsComputed();
+        }
+        free(buf);
+    }
+}
+
+void
+PreviewThread::onPreviewsComputed()
+{
+    assert(QThread::currentThread() == qApp->thread());
+
+    std::list<PreviewResult> results;
+    {
+        QMutexLocker k(&_imp->resultsMutex);
+        results.swap(_imp->results);
+    }
+    for (std::list<PreviewResult>::iterator it = results.begin(); it != results.end(); ++it) {
+        boost::shared_ptr<NodeGui> gui = it->gui.lock();
+        if (gui) {
+            gui->setPreviewImage(it->image);
+        }
+    }
+}
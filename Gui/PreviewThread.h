@@ -0,0 +1,75 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_GUI_PREVIEWTHREAD_H_
+#define NATRON_GUI_PREVIEWTHREAD_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#endif
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QThread>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+
+class NodeGui;
+
+/**
+ * @brief Computes the previews of the nodes of the node graphs, one at a time and at idle priority so that they
+ * do not delay the viewers. Requests are queued and a node which already has a pending preview is not queued twice:
+ * only the most recent time requested for it is rendered. A new request for the node whose preview is being
+ * computed aborts it.
+ **/
+struct PreviewThreadPrivate;
+class PreviewThread
+    : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    PreviewThread();
+
+    virtual ~PreviewThread();
+
+    /**
+     * @brief Queues a preview of the given node at the given time, on the main thread
+     **/
+    void appendToQueue(const boost::shared_ptr<NodeGui>& node,int time);
+
+    /**
+     * @brief Drops all pending requests and aborts the preview being computed, if any, without waiting for it.
+     **/
+    void abortPendingPreviews();
+
+    void quitThread();
+
+Q_SIGNALS:
+
+    void previewsComputed();
+
+public Q_SLOTS:
+
+    /**
+     * @brief Sets the computed previews on their nodes, in the main thread
+     **/
+    void onPreviewsComputed();
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+
+    boost::scoped_ptr<PreviewThreadPrivate> _imp;
+};
+
+#endif // NATRON_GUI_PREVIEWTHREAD_H_
@@ -867,8 +867,8 @@ RotoGui::drawOverlays(double /*scaleX*/,
             // It should first compute the bbox (this is cheap)
             // then check if the bbox is visible
             // if the bbox is visible, compute the polygon and draw it.
-            std::list< Point > points;
-            (*it)->evaluateAtTime_DeCasteljau(time,0, 100, &points, NULL);
+            boost::shared_ptr<BezierPolylines> polylines = (*it)->getPolylinesAtTime(time, 0);
+            const std::vector<Point> & points = polylines->points;
             
             bool locked = (*it)->isLockedRecursive();
             double curveColor[4];
@@ -880,33 +880,22 @@ RotoGui::drawOverlays(double /*scaleX*/,
             glColor4dv(curveColor);
             
             glBegin(GL_LINE_STRIP);
-            for (std::list<Point >::const_iterator it2 = points.begin(); it2 != points.end(); ++it2) {
+            for (std::vector<Point>::const_iterator it2 = points.begin(); it2 != points.end(); ++it2) {
                 glVertex2f(it2->x, it2->y);
             }
             glEnd();
             
             ///draw the feather points
-            std::list< Point > featherPoints;
-            RectD featherBBox( std::numeric_limits<double>::infinity(),
-                              std::numeric_limits<double>::infinity(),
-                              -std::numeric_limits<double>::infinity(),
-                              -std::numeric_limits<double>::infinity() );
+            const std::vector<Point> & featherPoints = polylines->featherPoints;
+            const RectD & featherBBox = polylines->featherBBox;
             
             if ( isFeatherVisible() ) {
                 ///Draw feather only if visible (button is toggled in the user interface)
-#pragma message WARN("Roto drawing: please update this algorithm")
-
-                // Plese update this algorithm:
-                // It should first compute the bbox (this is cheap)
-                // then check if the bbox is visible
-                // if the bbox is visible, compute the polygon and draw it.
-                (*it)->evaluateFeatherPointsAtTime_DeCasteljau(time,0, 100, true, &featherPoints, &featherBBox);
-                
                 if ( !featherPoints.empty() ) {
                     glLineStipple(2, 0xAAAA);
                     glEnable(GL_LINE_STIPPLE);
                     glBegin(GL_LINE_STRIP);
-                    for (std::list<Point >::const_iterator it2 = featherPoints.begin(); it2 != featherPoints.end(); ++it2) {
+                    for (std::vector<Point>::const_iterator it2 = featherPoints.begin(); it2 != featherPoints.end(); ++it2) {
                         glVertex2f(it2->x, it2->y);
                     }
                     glEnd();
@@ -2906,12 +2895,9 @@ RotoGui::RotoGuiPrivate::isNearbyFeatherBar(int time,
         if (cpCount <= 1) {
             continue;
         }
-        std::list<Point> polygon;
-        RectD polygonBBox( std::numeric_limits<double>::infinity(),
-                           std::numeric_limits<double>::infinity(),
-                           -std::numeric_limits<double>::infinity(),
-                           -std::numeric_limits<double>::infinity() );
-        (*it)->evaluateFeatherPointsAtTime_DeCasteljau(time, 0, 50, true, &polygon, &polygonBBox);
+        boost::shared_ptr<BezierPolylines> polylines = (*it)->getPolylinesAtTime(time, 0);
+        const std::vector<Point> & polygon = polylines->featherPoints;
+        const RectD & polygonBBox = polylines->featherBBox;
 
         std::list<boost::shared_ptr<BezierCP> >::const_iterator itF = fps.begin();
         std::list<boost::shared_ptr<BezierCP> >::const_iterator nextF = itF;
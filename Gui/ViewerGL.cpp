@@ -472,7 +472,8 @@ ViewerGL::drawRenderingVAO(unsigned int mipMapLevel,
     assert( qApp && qApp->thread() == QThread::currentThread() );
     assert( QGLContext::currentContext() == context() );
 
-    bool useShader = getBitDepth() != OpenGLViewerI::eBitDepthByte && _imp->supportsGLSL;
+    ///8-bit textures already have the gain and color-space applied, even with a float viewer (@see transferBufferFromRAMtoGPU)
+    bool useShader = _imp->activeTextures[textureIndex]->type() != Texture::eDataTypeByte && _imp->supportsGLSL;
 
     
     ///the texture rectangle in image coordinates. The values in it are multiples of tile size.
@@ -2383,6 +2384,7 @@ ViewerGL::transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
                                      int time,
                                      const RectD& rod,
                                      size_t bytesCount,
+                                     int bitDepth,
                                      const TextureRect & region,
                                      double gain,
                                      double offset,
@@ -2414,7 +2416,7 @@ ViewerGL::transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
     glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
     glCheckError();
 
-    OpenGLViewerI::BitDepthEnum bd = getBitDepth();
+    OpenGLViewerI::BitDepthEnum bd = (OpenGLViewerI::BitDepthEnum)bitDepth;
     assert(textureIndex == 0 || textureIndex == 1);
     if (bd == OpenGLViewerI::eBitDepthByte) {
         _imp->displayTextures[textureIndex]->fillOrAllocateTexture(region, Texture::eDataTypeByte);
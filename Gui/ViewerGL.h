@@ -169,7 +169,7 @@ public:
                                             const boost::shared_ptr<Natron::Image>& image,
                                             int time,
                                             const RectD& rod,
-                                            size_t bytesCount, const TextureRect & region,
+                                            size_t bytesCount, int bitDepth, const TextureRect & region,
                                             double gain, double offset, int lut, int pboIndex,
                                             unsigned int mipMapLevel,Natron::ImagePremultiplicationEnum premult,
                                             int textureIndex) OVERRIDE FINAL;
@@ -14,8 +14,11 @@ SUBDIRS += \
     Gui \
     Renderer \
     Tests \
+    Benchmarks \
+    RenderBenchmark \
     App \
-    CrashReporter
+    CrashReporter \
+    TraceDecoder
 
 OTHER_FILES += \
     Global/Enums.h \
@@ -25,6 +28,7 @@ OTHER_FILES += \
     Global/Macros.h \
     Global/MemoryInfo.h \
     Global/QtCompat.h \
+    Global/TraceFormat.h \
     global.pri \
     config.pri
 
@@ -0,0 +1,435 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "BenchmarkEffects.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+CLANG_DIAG_ON(deprecated)
+
+#include "Engine/AppManager.h"
+#include "Engine/Image.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/LibraryBinary.h"
+#include "Engine/Node.h"
+
+using namespace Natron;
+
+namespace {
+
+///Adds the time spent in its scope to the render statistics of an effect
+class RenderTimer
+{
+    BenchmarkRenderStats* _stats;
+    QElapsedTimer _timer;
+
+public:
+
+    RenderTimer(BenchmarkRenderStats* stats)
+    : _stats(stats)
+    , _timer()
+    {
+        _timer.start();
+    }
+
+    ~RenderTimer()
+    {
+        _stats->addRenderTime( _timer.nsecsElapsed() );
+    }
+};
+
+template <class EFFECT>
+void
+registerBenchmarkPlugin()
+{
+    boost::shared_ptr<EffectInstance> node( EFFECT::BuildEffect( boost::shared_ptr<Natron::Node>() ) );
+    std::map<std::string,void*> functions;
+    functions.insert( std::make_pair("BuildEffect", (void*)&EFFECT::BuildEffect) );
+    LibraryBinary *binary = new LibraryBinary(functions);
+    assert(binary);
+
+    std::list<std::string> grouping;
+    node->getPluginGrouping(&grouping);
+    QStringList qgrouping;
+    for (std::list<std::string>::iterator it = grouping.begin(); it != grouping.end(); ++it) {
+        qgrouping.push_back( it->c_str() );
+    }
+    appPTR->registerPlugin(qgrouping, node->getPluginID().c_str(), node->getPluginLabel().c_str(), "", "", false, false, binary, false,
+                           node->getMajorVersion(), node->getMinorVersion());
+}
+
+///Fetches the RGBA float image of the given input over the render window, throws if it could not be rendered
+ImagePtr
+getInputImage(EffectInstance* effect,
+              int inputNb,
+              SequenceTime time,
+              const RenderScale& originalScale,
+              int view,
+              const ImagePtr& output)
+{
+    RectI roiPixel;
+    ImagePtr src = effect->getImage(inputNb, time, originalScale, view, NULL, ImageComponents::getRGBAComponents(),
+                                    eImageBitDepthFloat, 1., false, &roiPixel);
+
+    if ( src && (src->getMipMapLevel() != output->getMipMapLevel()) ) {
+        throw std::runtime_error("Host gave image with wrong scale");
+    }
+
+    return src;
+}
+
+///A pixel of the image, or NULL if the image does not exist or does not contain it
+inline const float*
+getPixel(const Image::ReadAccess* acc,
+         int x,
+         int y)
+{
+    return acc ? (const float*)acc->pixelAt(x, y) : NULL;
+}
+
+} // anon namespace
+
+void
+registerBenchmarkPlugins()
+{
+    registerBenchmarkPlugin<BenchmarkGenerator>();
+    registerBenchmarkPlugin<BenchmarkProcess>();
+    registerBenchmarkPlugin<BenchmarkMerge>();
+    registerBenchmarkPlugin<BenchmarkSink>();
+}
+
+BenchmarkEffectBase::BenchmarkEffectBase(boost::shared_ptr<Natron::Node> node)
+: EffectInstance(node)
+, BenchmarkRenderStats()
+{
+    setSupportsRenderScaleMaybe(eSupportsYes);
+}
+
+void
+BenchmarkEffectBase::addAcceptedComponents(int /*inputNb*/,std::list<Natron::ImageComponents>* comps)
+{
+    comps->push_back( ImageComponents::getRGBAComponents() );
+}
+
+void
+BenchmarkEffectBase::addSupportedBitDepth(std::list<Natron::ImageBitDepthEnum>* depths) const
+{
+    depths->push_back(Natron::eImageBitDepthFloat);
+}
+
+void
+BenchmarkEffectBase::getPreferredDepthAndComponents(int /*inputNb*/,std::list<Natron::ImageComponents>* comp,Natron::ImageBitDepthEnum* depth) const
+{
+    comp->push_back( ImageComponents::getRGBAComponents() );
+    *depth = eImageBitDepthFloat;
+}
+
+////////////////////////////////////////BenchmarkGenerator
+
+BenchmarkGenerator::BenchmarkGenerator(boost::shared_ptr<Natron::Node> node)
+: BenchmarkEffectBase(node)
+{
+}
+
+void
+BenchmarkGenerator::initializeKnobs()
+{
+    boost::shared_ptr<Page_Knob> page = Natron::createKnob<Page_Knob>(this, "Controls");
+
+    _width = Natron::createKnob<Int_Knob>(this, "Width");
+    _width->setName("width");
+    _width->setAnimationEnabled(false);
+    _width->disableSlider();
+    _width->setDefaultValue(1920);
+    page->addKnob(_width);
+
+    _height = Natron::createKnob<Int_Knob>(this, "Height");
+    _height->setName("height");
+    _height->setAnimationEnabled(false);
+    _height->disableSlider();
+    _height->setDefaultValue(1080);
+    page->addKnob(_height);
+}
+
+void
+BenchmarkGenerator::setSize(int width,
+                            int height)
+{
+    _width->setValue(width, 0);
+    _height->setValue(height, 0);
+}
+
+Natron::StatusEnum
+BenchmarkGenerator::getRegionOfDefinition(U64 /*hash*/,
+                                          SequenceTime /*time*/,
+                                          const RenderScale & /*scale*/,
+                                          int /*view*/,
+                                          RectD* rod)
+{
+    rod->x1 = 0;
+    rod->y1 = 0;
+    rod->x2 = _width->getValue();
+    rod->y2 = _height->getValue();
+
+    return eStatusOK;
+}
+
+void
+BenchmarkGenerator::getFrameRange(SequenceTime *first,
+                                  SequenceTime *last)
+{
+    *first = 1;
+    *last = 100000;
+}
+
+Natron::StatusEnum
+BenchmarkGenerator::render(SequenceTime time,
+                           const RenderScale& /*originalScale*/,
+                           const RenderScale & mappedScale,
+                           const RectI & roi,
+                           int /*view*/,
+                           bool /*isSequentialRender*/,
+                           bool /*isRenderResponseToUserInteraction*/,
+                           const ImageList& outputPlanes)
+{
+    RenderTimer timer(this);
+
+    assert(outputPlanes.size() == 1);
+    const ImagePtr& output = outputPlanes.front();
+    const double width = _width->getValue();
+    const double height = _height->getValue();
+    ///The checkerboard moves with the time so that each frame is different
+    const int square = 64;
+    const int offset = (int)time * 8;
+    Image::WriteAccess acc = output->getWriteRights();
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        float* pix = (float*)acc.pixelAt(roi.x1, y);
+        if (!pix) {
+            continue;
+        }
+        const double canonicalY = y / mappedScale.y;
+        for (int x = roi.x1; x < roi.x2; ++x, pix += 4) {
+            const double canonicalX = x / mappedScale.x;
+            const bool odd = ( ( ( (int)canonicalX + offset ) / square ) + ( (int)canonicalY / square ) ) & 1;
+            const float checker = odd ? 0.75f : 0.25f;
+            pix[0] = checker * (float)(canonicalX / width);
+            pix[1] = checker * (float)(canonicalY / height);
+            pix[2] = checker;
+            pix[3] = 1.f;
+        }
+    }
+
+    return eStatusOK;
+}
+
+////////////////////////////////////////BenchmarkProcess
+
+BenchmarkProcess::BenchmarkProcess(boost::shared_ptr<Natron::Node> node)
+: BenchmarkEffectBase(node)
+{
+}
+
+void
+BenchmarkProcess::addAcceptedComponents(int inputNb,
+                                        std::list<Natron::ImageComponents>* comps)
+{
+    if (inputNb == 1) {
+        comps->push_back( ImageComponents::getAlphaComponents() );
+    }
+    comps->push_back( ImageComponents::getRGBAComponents() );
+}
+
+void
+BenchmarkProcess::initializeKnobs()
+{
+    boost::shared_ptr<Page_Knob> page = Natron::createKnob<Page_Knob>(this, "Controls");
+
+    _gain = Natron::createKnob<Double_Knob>(this, "Gain");
+    _gain->setName("gain");
+    _gain->setDefaultValue(0.9);
+    page->addKnob(_gain);
+
+    _cost = Natron::createKnob<Int_Knob>(this, "Cost");
+    _cost->setName("cost");
+    _cost->setHintToolTip("Number of operations per pixel and per channel.");
+    _cost->setAnimationEnabled(false);
+    _cost->disableSlider();
+    _cost->setDefaultValue(4);
+    page->addKnob(_cost);
+}
+
+void
+BenchmarkProcess::setCost(int cost)
+{
+    _cost->setValue(cost, 0);
+}
+
+Natron::StatusEnum
+BenchmarkProcess::render(SequenceTime time,
+                         const RenderScale& originalScale,
+                         const RenderScale & /*mappedScale*/,
+                         const RectI & roi,
+                         int view,
+                         bool /*isSequentialRender*/,
+                         bool /*isRenderResponseToUserInteraction*/,
+                         const ImageList& outputPlanes)
+{
+    assert(outputPlanes.size() == 1);
+    const ImagePtr& output = outputPlanes.front();
+
+    ///Fetching the inputs renders them: do not count it in the time of this node
+    ImagePtr src = getInputImage(this, 0, time, originalScale, view, output);
+    ImagePtr mask;
+    if ( getInput(1) ) {
+        mask = getInputImage(this, 1, time, originalScale, view, output);
+    }
+
+    RenderTimer timer(this);
+
+    const float gain = (float)_gain->getValueAtTime(time);
+    const int cost = std::max(1, _cost->getValue());
+    Image::WriteAccess acc = output->getWriteRights();
+    boost::scoped_ptr<Image::ReadAccess> srcAcc( src ? new Image::ReadAccess( src.get() ) : 0 );
+    boost::scoped_ptr<Image::ReadAccess> maskAcc( mask ? new Image::ReadAccess( mask.get() ) : 0 );
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        float* dst = (float*)acc.pixelAt(roi.x1, y);
+        if (!dst) {
+            continue;
+        }
+        for (int x = roi.x1; x < roi.x2; ++x, dst += 4) {
+            const float* srcPix = getPixel(srcAcc.get(), x, y);
+            if (!srcPix) {
+                dst[0] = dst[1] = dst[2] = dst[3] = 0.f;
+                continue;
+            }
+            const float* maskPix = getPixel(maskAcc.get(), x, y);
+            ///The alpha of the mask: a RGBA image has 4 components
+            const float m = mask ? ( maskPix ? maskPix[mask->getComponentsCount() - 1] : 0.f ) : 1.f;
+            for (int c = 0; c < 4; ++c) {
+                float v = srcPix[c];
+                for (int i = 0; i < cost; ++i) {
+                    v = v * gain + (1.f - gain) * 0.5f;
+                }
+                dst[c] = srcPix[c] + (v - srcPix[c]) * m;
+            }
+        }
+    }
+
+    return eStatusOK;
+}
+
+////////////////////////////////////////BenchmarkMerge
+
+BenchmarkMerge::BenchmarkMerge(boost::shared_ptr<Natron::Node> node)
+: BenchmarkEffectBase(node)
+{
+}
+
+Natron::StatusEnum
+BenchmarkMerge::render(SequenceTime time,
+                       const RenderScale& originalScale,
+                       const RenderScale & /*mappedScale*/,
+                       const RectI & roi,
+                       int view,
+                       bool /*isSequentialRender*/,
+                       bool /*isRenderResponseToUserInteraction*/,
+                       const ImageList& outputPlanes)
+{
+    assert(outputPlanes.size() == 1);
+    const ImagePtr& output = outputPlanes.front();
+
+    ImagePtr a = getInputImage(this, 0, time, originalScale, view, output);
+    ImagePtr b = getInputImage(this, 1, time, originalScale, view, output);
+
+    RenderTimer timer(this);
+
+    Image::WriteAccess acc = output->getWriteRights();
+    boost::scoped_ptr<Image::ReadAccess> aAcc( a ? new Image::ReadAccess( a.get() ) : 0 );
+    boost::scoped_ptr<Image::ReadAccess> bAcc( b ? new Image::ReadAccess( b.get() ) : 0 );
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        float* dst = (float*)acc.pixelAt(roi.x1, y);
+        if (!dst) {
+            continue;
+        }
+        for (int x = roi.x1; x < roi.x2; ++x, dst += 4) {
+            const float* aPix = getPixel(aAcc.get(), x, y);
+            const float* bPix = getPixel(bAcc.get(), x, y);
+            for (int c = 0; c < 4; ++c) {
+                dst[c] = ( (aPix ? aPix[c] : 0.f) + (bPix ? bPix[c] : 0.f) ) * 0.5f;
+            }
+        }
+    }
+
+    return eStatusOK;
+}
+
+////////////////////////////////////////BenchmarkSink
+
+BenchmarkSink::BenchmarkSink(boost::shared_ptr<Natron::Node> node)
+: OutputEffectInstance(node)
+, BenchmarkRenderStats()
+{
+    setSupportsRenderScaleMaybe(eSupportsYes);
+}
+
+void
+BenchmarkSink::addAcceptedComponents(int /*inputNb*/,std::list<Natron::ImageComponents>* comps)
+{
+    comps->push_back( ImageComponents::getRGBAComponents() );
+}
+
+void
+BenchmarkSink::addSupportedBitDepth(std::list<Natron::ImageBitDepthEnum>* depths) const
+{
+    depths->push_back(Natron::eImageBitDepthFloat);
+}
+
+void
+BenchmarkSink::getPreferredDepthAndComponents(int /*inputNb*/,std::list<Natron::ImageComponents>* comp,Natron::ImageBitDepthEnum* depth) const
+{
+    comp->push_back( ImageComponents::getRGBAComponents() );
+    *depth = eImageBitDepthFloat;
+}
+
+Natron::StatusEnum
+BenchmarkSink::render(SequenceTime time,
+                      const RenderScale& originalScale,
+                      const RenderScale & /*mappedScale*/,
+                      const RectI & roi,
+                      int view,
+                      bool /*isSequentialRender*/,
+                      bool /*isRenderResponseToUserInteraction*/,
+                      const ImageList& outputPlanes)
+{
+    assert(outputPlanes.size() == 1);
+    const ImagePtr& output = outputPlanes.front();
+
+    ImagePtr src = getInputImage(this, 0, time, originalScale, view, output);
+    if (!src) {
+        return eStatusFailed;
+    }
+
+    RenderTimer timer(this);
+    output->pasteFrom(*src, roi, output->usesBitMap() && src->usesBitMap());
+
+    return eStatusOK;
+}
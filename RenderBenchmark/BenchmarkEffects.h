@@ -0,0 +1,439 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_RENDERBENCHMARK_BENCHMARKEFFECTS_H_
+#define NATRON_RENDERBENCHMARK_BENCHMARKEFFECTS_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QMutex>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+
+#include "Engine/EffectInstance.h"
+
+/**
+ * The effects of the synthetic graphs rendered by the benchmark. They do not depend on any OpenFX plug-in so that
+ * the benchmark runs the same way on every machine. They are registered as plug-ins by registerBenchmarkPlugins()
+ * and are not visible in the application.
+ **/
+#define PLUGINID_NATRON_BENCHMARK_GENERATOR (NATRON_ORGANIZATION_DOMAIN_TOPLEVEL "." NATRON_ORGANIZATION_DOMAIN_SUB ".benchmark.Generator")
+#define PLUGINID_NATRON_BENCHMARK_PROCESS   (NATRON_ORGANIZATION_DOMAIN_TOPLEVEL "." NATRON_ORGANIZATION_DOMAIN_SUB ".benchmark.Process")
+#define PLUGINID_NATRON_BENCHMARK_MERGE     (NATRON_ORGANIZATION_DOMAIN_TOPLEVEL "." NATRON_ORGANIZATION_DOMAIN_SUB ".benchmark.Merge")
+#define PLUGINID_NATRON_BENCHMARK_SINK      (NATRON_ORGANIZATION_DOMAIN_TOPLEVEL "." NATRON_ORGANIZATION_DOMAIN_SUB ".benchmark.Sink")
+
+class Int_Knob;
+class Double_Knob;
+
+void registerBenchmarkPlugins();
+
+/**
+ * @brief The time spent in the render action of an effect, summed over all the threads rendering it
+ **/
+class BenchmarkRenderStats
+{
+    mutable QMutex _lock;
+    qint64 _renderNs;
+    qint64 _renderCalls;
+
+public:
+
+    BenchmarkRenderStats()
+    : _lock()
+    , _renderNs(0)
+    , _renderCalls(0)
+    {
+    }
+
+    virtual ~BenchmarkRenderStats()
+    {
+    }
+
+    void addRenderTime(qint64 ns)
+    {
+        QMutexLocker k(&_lock);
+        _renderNs += ns;
+        ++_renderCalls;
+    }
+
+    void getRenderStats(qint64* renderNs,qint64* renderCalls) const
+    {
+        QMutexLocker k(&_lock);
+        *renderNs = _renderNs;
+        *renderCalls = _renderCalls;
+    }
+
+    void resetRenderStats()
+    {
+        QMutexLocker k(&_lock);
+        _renderNs = 0;
+        _renderCalls = 0;
+    }
+};
+
+/**
+ * @brief Base of the benchmark effects: RGBA float only, thread-safe, tiled and multi-resolution
+ **/
+class BenchmarkEffectBase
+    : public Natron::EffectInstance
+    , public BenchmarkRenderStats
+{
+public:
+
+    BenchmarkEffectBase(boost::shared_ptr<Natron::Node> node);
+
+    virtual ~BenchmarkEffectBase()
+    {
+    }
+
+    virtual int getMajorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 1;
+    }
+
+    virtual int getMinorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 0;
+    }
+
+    virtual void getPluginGrouping(std::list<std::string>* grouping) const OVERRIDE FINAL
+    {
+        grouping->push_back(PLUGIN_GROUP_OTHER);
+    }
+
+    virtual void addAcceptedComponents(int inputNb,std::list<Natron::ImageComponents>* comps) OVERRIDE;
+
+    virtual void addSupportedBitDepth(std::list<Natron::ImageBitDepthEnum>* depths) const OVERRIDE FINAL;
+
+    virtual void getPreferredDepthAndComponents(int inputNb,std::list<Natron::ImageComponents>* comp,Natron::ImageBitDepthEnum* depth) const OVERRIDE FINAL;
+
+    virtual EffectInstance::RenderSafetyEnum renderThreadSafety() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return EffectInstance::eRenderSafetyFullySafeFrame;
+    }
+
+    virtual bool supportsTiles() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+
+    virtual bool supportsMultiResolution() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+};
+
+/**
+ * @brief Generates a moving checkerboard over a ramp, of the given size
+ **/
+class BenchmarkGenerator
+    : public BenchmarkEffectBase
+{
+public:
+
+    static Natron::EffectInstance* BuildEffect(boost::shared_ptr<Natron::Node> n)
+    {
+        return new BenchmarkGenerator(n);
+    }
+
+    BenchmarkGenerator(boost::shared_ptr<Natron::Node> node);
+
+    void setSize(int width,int height);
+
+    virtual std::string getPluginID() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return PLUGINID_NATRON_BENCHMARK_GENERATOR;
+    }
+
+    virtual std::string getPluginLabel() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "BenchmarkGenerator";
+    }
+
+    virtual std::string getDescription() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "Generates a synthetic image for the render benchmark.";
+    }
+
+    virtual int getMaxInputCount() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 0;
+    }
+
+    virtual bool isInputOptional(int /*inputNb*/) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+
+    virtual bool isGenerator() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+
+    virtual bool isFrameVarying() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+
+    virtual void initializeKnobs() OVERRIDE FINAL;
+
+private:
+
+    virtual Natron::StatusEnum getRegionOfDefinition(U64 hash,SequenceTime time, const RenderScale & scale, int view, RectD* rod) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    virtual void getFrameRange(SequenceTime *first,SequenceTime *last) OVERRIDE FINAL;
+
+    virtual Natron::StatusEnum render(SequenceTime time,
+                                      const RenderScale& originalScale,
+                                      const RenderScale & mappedScale,
+                                      const RectI & roi,
+                                      int view,
+                                      bool isSequentialRender,
+                                      bool isRenderResponseToUserInteraction,
+                                      const std::list<boost::shared_ptr<Natron::Image> >& outputPlanes) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    boost::shared_ptr<Int_Knob> _width;
+    boost::shared_ptr<Int_Knob> _height;
+};
+
+/**
+ * @brief A per-pixel operation whose cost is a parameter, optionally masked by the alpha of its second input
+ **/
+class BenchmarkProcess
+    : public BenchmarkEffectBase
+{
+public:
+
+    static Natron::EffectInstance* BuildEffect(boost::shared_ptr<Natron::Node> n)
+    {
+        return new BenchmarkProcess(n);
+    }
+
+    BenchmarkProcess(boost::shared_ptr<Natron::Node> node);
+
+    ///Number of arithmetic operations per pixel and per channel
+    void setCost(int cost);
+
+    virtual std::string getPluginID() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return PLUGINID_NATRON_BENCHMARK_PROCESS;
+    }
+
+    virtual std::string getPluginLabel() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "BenchmarkProcess";
+    }
+
+    virtual std::string getDescription() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "A per-pixel operation of configurable cost for the render benchmark.";
+    }
+
+    virtual int getMaxInputCount() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 2;
+    }
+
+    virtual std::string getInputLabel(int inputNb) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return inputNb == 0 ? "Source" : "Mask";
+    }
+
+    virtual bool isInputOptional(int inputNb) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return inputNb == 1;
+    }
+
+    virtual bool isInputMask(int inputNb) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return inputNb == 1;
+    }
+
+    virtual void addAcceptedComponents(int inputNb,std::list<Natron::ImageComponents>* comps) OVERRIDE FINAL;
+
+    virtual void initializeKnobs() OVERRIDE FINAL;
+
+private:
+
+    virtual Natron::StatusEnum render(SequenceTime time,
+                                      const RenderScale& originalScale,
+                                      const RenderScale & mappedScale,
+                                      const RectI & roi,
+                                      int view,
+                                      bool isSequentialRender,
+                                      bool isRenderResponseToUserInteraction,
+                                      const std::list<boost::shared_ptr<Natron::Image> >& outputPlanes) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    boost::shared_ptr<Int_Knob> _cost;
+    boost::shared_ptr<Double_Knob> _gain;
+};
+
+/**
+ * @brief The average of its 2 inputs
+ **/
+class BenchmarkMerge
+    : public BenchmarkEffectBase
+{
+public:
+
+    static Natron::EffectInstance* BuildEffect(boost::shared_ptr<Natron::Node> n)
+    {
+        return new BenchmarkMerge(n);
+    }
+
+    BenchmarkMerge(boost::shared_ptr<Natron::Node> node);
+
+    virtual std::string getPluginID() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return PLUGINID_NATRON_BENCHMARK_MERGE;
+    }
+
+    virtual std::string getPluginLabel() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "BenchmarkMerge";
+    }
+
+    virtual std::string getDescription() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "Averages 2 images for the render benchmark.";
+    }
+
+    virtual int getMaxInputCount() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 2;
+    }
+
+    virtual std::string getInputLabel(int inputNb) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return inputNb == 0 ? "A" : "B";
+    }
+
+    virtual bool isInputOptional(int /*inputNb*/) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return false;
+    }
+
+private:
+
+    virtual Natron::StatusEnum render(SequenceTime time,
+                                      const RenderScale& originalScale,
+                                      const RenderScale & mappedScale,
+                                      const RectI & roi,
+                                      int view,
+                                      bool isSequentialRender,
+                                      bool isRenderResponseToUserInteraction,
+                                      const std::list<boost::shared_ptr<Natron::Image> >& outputPlanes) OVERRIDE FINAL WARN_UNUSED_RETURN;
+};
+
+/**
+ * @brief The output of the benchmark graphs: it pulls its input like a writer would, but does not write anything
+ * nor cache its output, so that only the rendering of the graph is measured.
+ **/
+class BenchmarkSink
+    : public Natron::OutputEffectInstance
+    , public BenchmarkRenderStats
+{
+public:
+
+    static Natron::EffectInstance* BuildEffect(boost::shared_ptr<Natron::Node> n)
+    {
+        return new BenchmarkSink(n);
+    }
+
+    BenchmarkSink(boost::shared_ptr<Natron::Node> node);
+
+    virtual int getMajorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 1;
+    }
+
+    virtual int getMinorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 0;
+    }
+
+    virtual int getMaxInputCount() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return 1;
+    }
+
+    virtual std::string getPluginID() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return PLUGINID_NATRON_BENCHMARK_SINK;
+    }
+
+    virtual std::string getPluginLabel() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "BenchmarkSink";
+    }
+
+    virtual std::string getDescription() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return "Pulls the images of its input for the render benchmark.";
+    }
+
+    virtual void getPluginGrouping(std::list<std::string>* grouping) const OVERRIDE FINAL
+    {
+        grouping->push_back(PLUGIN_GROUP_OTHER);
+    }
+
+    virtual bool isInputOptional(int /*inputNb*/) const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return false;
+    }
+
+    virtual void addAcceptedComponents(int inputNb,std::list<Natron::ImageComponents>* comps) OVERRIDE FINAL;
+
+    virtual void addSupportedBitDepth(std::list<Natron::ImageBitDepthEnum>* depths) const OVERRIDE FINAL;
+
+    virtual void getPreferredDepthAndComponents(int inputNb,std::list<Natron::ImageComponents>* comp,Natron::ImageBitDepthEnum* depth) const OVERRIDE FINAL;
+
+    virtual EffectInstance::RenderSafetyEnum renderThreadSafety() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return EffectInstance::eRenderSafetyFullySafeFrame;
+    }
+
+    virtual bool supportsTiles() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+
+    virtual bool supportsMultiResolution() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
+    }
+
+    virtual bool isOutput() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return false;
+    }
+
+private:
+
+    virtual bool shouldCacheOutput() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return false;
+    }
+
+    virtual Natron::StatusEnum render(SequenceTime time,
+                                      const RenderScale& originalScale,
+                                      const RenderScale & mappedScale,
+                                      const RectI & roi,
+                                      int view,
+                                      bool isSequentialRender,
+                                      bool isRenderResponseToUserInteraction,
+                                      const std::list<boost::shared_ptr<Natron::Image> >& outputPlanes) OVERRIDE FINAL WARN_UNUSED_RETURN;
+};
+
+#endif // NATRON_RENDERBENCHMARK_BENCHMARKEFFECTS_H_
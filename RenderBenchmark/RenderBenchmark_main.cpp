@@ -0,0 +1,551 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QProcess>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QThread>
+CLANG_DIAG_ON(deprecated)
+
+#include "Global/MemoryInfo.h"
+#include "Engine/AppManager.h"
+#include "Engine/AppInstance.h"
+#include "Engine/BlockingBackgroundRender.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/Settings.h"
+
+#include "BenchmarkEffects.h"
+#include "SyntheticGraphs.h"
+
+/**
+ * Renders synthetic graphs made of built-in nodes and of the benchmark effects through
+ * OutputEffectInstance::renderFullSequence, the way a background render does, and reports for each graph and each
+ * thread count the frames per second, the memory used, the hit rate of the image caches and the time spent in each node.
+ * It does not need any OpenFX plug-in (except for the roto graph) nor a GPU.
+ *
+ * Usage: RenderBenchmark [--graph=<all|name,...>] [--width=1920] [--height=1080] [--depth=8] [--cost=4] [--frames=50]
+ *                        [--threads=0[,n...]] [--parallel-renders=0] [--passes=1] [--out=<file.json>]
+ * --threads is the number of threads per frame as in the preferences: 0 picks the number of cores, -1 renders on the
+ * main thread. Each pass after the first one renders the same frames again and measures the render with warm caches.
+ * Each graph and thread count is rendered by a new process running this program with --child-out=<file>, so that the peak
+ * memory reported is the one of that configuration only (up to the pass reported) and not of the whole benchmark.
+ **/
+
+namespace {
+
+struct Options
+{
+    std::vector<std::string> graphs;
+    SyntheticGraphParams params;
+    int frames;
+    std::vector<int> threads;
+    int parallelRenders;
+    int passes;
+    std::string out;
+    std::string childOut; //< set when rendering a single configuration for the parent process
+
+    Options()
+    : graphs()
+    , params()
+    , frames(50)
+    , threads()
+    , parallelRenders(0)
+    , passes(1)
+    , out()
+    , childOut()
+    {
+    }
+};
+
+struct NodeTiming
+{
+    std::string name;
+    double ms;
+    long long calls;
+};
+
+struct PassResult
+{
+    std::string graph;
+    int threads;
+    int pass;
+    bool ok;
+    std::string error;
+    double seconds;
+    double fps;
+    U64 nodeCacheLookups, nodeCacheHits, diskCacheLookups, diskCacheHits;
+    size_t peakRSS, currentRSS;
+    std::vector<NodeTiming> nodes;
+};
+
+std::vector<std::string>
+split(const std::string& str)
+{
+    std::vector<std::string> ret;
+    std::stringstream ss(str);
+    std::string item;
+
+    while ( std::getline(ss, item, ',') ) {
+        if ( !item.empty() ) {
+            ret.push_back(item);
+        }
+    }
+
+    return ret;
+}
+
+bool
+parseOption(const char* arg,
+            const char* name,
+            std::string* value)
+{
+    std::size_t len = std::strlen(name);
+
+    if ( (std::strncmp(arg, name, len) == 0) && (arg[len] == '=') ) {
+        *value = arg + len + 1;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool
+parseOptions(int argc,
+             char* argv[],
+             Options* options)
+{
+    std::string graphs = "all";
+    std::string threads = "0";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string value;
+        if ( parseOption(argv[i], "--graph", &value) ) {
+            graphs = value;
+        } else if ( parseOption(argv[i], "--width", &value) ) {
+            options->params.width = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--height", &value) ) {
+            options->params.height = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--depth", &value) ) {
+            options->params.depth = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--cost", &value) ) {
+            options->params.cost = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--frames", &value) ) {
+            options->frames = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--threads", &value) ) {
+            threads = value;
+        } else if ( parseOption(argv[i], "--parallel-renders", &value) ) {
+            options->parallelRenders = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--passes", &value) ) {
+            options->passes = std::atoi( value.c_str() );
+        } else if ( parseOption(argv[i], "--out", &value) ) {
+            options->out = value;
+        } else if ( parseOption(argv[i], "--child-out", &value) ) {
+            options->childOut = value;
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+
+            return false;
+        }
+    }
+
+    options->graphs = graphs == "all" ? getSyntheticGraphNames() : split(graphs);
+    std::vector<std::string> threadsList = split(threads);
+    for (std::size_t i = 0; i < threadsList.size(); ++i) {
+        options->threads.push_back( std::atoi( threadsList[i].c_str() ) );
+    }
+    if ( (options->params.width <= 0) || (options->params.height <= 0) || (options->frames <= 0) || (options->passes <= 0) ||
+         options->threads.empty() ) {
+        std::cerr << "Invalid options" << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+void
+resetNodeTimings(const SyntheticGraph& graph)
+{
+    for (std::list<boost::shared_ptr<Natron::Node> >::const_iterator it = graph.nodes.begin(); it != graph.nodes.end(); ++it) {
+        BenchmarkRenderStats* stats = dynamic_cast<BenchmarkRenderStats*>( (*it)->getLiveInstance() );
+        if (stats) {
+            stats->resetRenderStats();
+        }
+    }
+}
+
+///Only the benchmark effects measure their render time: the built-in nodes of the graphs are pass-through
+void
+getNodeTimings(const SyntheticGraph& graph,
+               std::vector<NodeTiming>* timings)
+{
+    for (std::list<boost::shared_ptr<Natron::Node> >::const_iterator it = graph.nodes.begin(); it != graph.nodes.end(); ++it) {
+        BenchmarkRenderStats* stats = dynamic_cast<BenchmarkRenderStats*>( (*it)->getLiveInstance() );
+        if (!stats) {
+            continue;
+        }
+        qint64 ns, calls;
+        stats->getRenderStats(&ns, &calls);
+        NodeTiming t;
+        t.name = (*it)->getFullyQualifiedName();
+        t.ms = ns / 1e6;
+        t.calls = calls;
+        timings->push_back(t);
+    }
+}
+
+double
+hitRate(U64 lookups,
+        U64 hits)
+{
+    return lookups ? 100. * hits / lookups : 0.;
+}
+
+void
+runGraph(AppInstance* app,
+         const std::string& name,
+         const Options& options,
+         int threads,
+         std::vector<PassResult>* results)
+{
+    ///Start from an empty project and cold caches so that each configuration is measured the same way
+    app->getProject()->closeProject();
+    appPTR->clearNodeCache();
+    appPTR->clearDiskCache();
+
+    PassResult result;
+    result.graph = name;
+    result.threads = threads;
+    result.pass = 0;
+    result.ok = false;
+    result.seconds = result.fps = 0.;
+    result.nodeCacheLookups = result.nodeCacheHits = result.diskCacheLookups = result.diskCacheHits = 0;
+    result.peakRSS = result.currentRSS = 0;
+
+    SyntheticGraph graph;
+    std::string error;
+    if ( !buildSyntheticGraph(name, app, options.params, &graph, &error) ) {
+        result.error = error;
+        results->push_back(result);
+
+        return;
+    }
+
+    appPTR->setNumberOfThreads(threads);
+    appPTR->getCurrentSettings()->setNumberOfParallelRenders(options.parallelRenders);
+
+    Natron::OutputEffectInstance* sink = dynamic_cast<Natron::OutputEffectInstance*>( graph.sink->getLiveInstance() );
+    assert(sink);
+
+    for (int pass = 0; pass < options.passes; ++pass) {
+        resetNodeTimings(graph);
+        appPTR->resetImageCachesLookupStats();
+
+        QElapsedTimer timer;
+        timer.start();
+        BlockingBackgroundRender render(sink);
+        render.blockingRender(1, options.frames);
+        qint64 ns = timer.nsecsElapsed();
+
+        PassResult passResult = result;
+        passResult.pass = pass;
+        passResult.ok = true;
+        passResult.seconds = ns / 1e9;
+        passResult.fps = ns > 0 ? options.frames / passResult.seconds : 0.;
+        appPTR->getImageCachesLookupStats(&passResult.nodeCacheLookups, &passResult.nodeCacheHits,
+                                          &passResult.diskCacheLookups, &passResult.diskCacheHits);
+        passResult.peakRSS = getPeakRSS();
+        passResult.currentRSS = getCurrentRSS();
+        getNodeTimings(graph, &passResult.nodes);
+        results->push_back(passResult);
+    }
+}
+
+///Results are passed from the child process to the parent one line per pass, followed by one line per node.
+///Graph and node names do not contain spaces, the error message is the end of its line.
+void
+writeChildResults(std::ostream& os,
+                  const std::vector<PassResult>& results)
+{
+    os.precision(15);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const PassResult& r = results[i];
+        std::string error = r.error;
+        for (std::size_t c = 0; c < error.size(); ++c) {
+            if ( (error[c] == '\n') || (error[c] == '\r') ) {
+                error[c] = ' ';
+            }
+        }
+        os << "pass " << r.graph << ' ' << r.threads << ' ' << r.pass << ' ' << r.ok << ' ' << r.seconds << ' ' << r.fps << ' '
+           << r.nodeCacheLookups << ' ' << r.nodeCacheHits << ' ' << r.diskCacheLookups << ' ' << r.diskCacheHits << ' '
+           << r.peakRSS << ' ' << r.currentRSS << ' ' << error << '\n';
+        for (std::size_t j = 0; j < r.nodes.size(); ++j) {
+            os << "node " << r.nodes[j].ms << ' ' << r.nodes[j].calls << ' ' << r.nodes[j].name << '\n';
+        }
+    }
+}
+
+void
+readChildResults(std::istream& is,
+                 std::vector<PassResult>* results)
+{
+    std::string line;
+
+    while ( std::getline(is, line) ) {
+        std::istringstream ss(line);
+        std::string type;
+        ss >> type;
+        if (type == "pass") {
+            PassResult r;
+            ss >> r.graph >> r.threads >> r.pass >> r.ok >> r.seconds >> r.fps >> r.nodeCacheLookups >> r.nodeCacheHits
+               >> r.diskCacheLookups >> r.diskCacheHits >> r.peakRSS >> r.currentRSS;
+            std::getline(ss, r.error);
+            if ( !r.error.empty() && (r.error[0] == ' ') ) {
+                r.error.erase(0, 1);
+            }
+            results->push_back(r);
+        } else if ( (type == "node") && !results->empty() ) {
+            NodeTiming t;
+            ss >> t.ms >> t.calls >> t.name;
+            results->back().nodes.push_back(t);
+        }
+    }
+}
+
+///Renders a single configuration in a new process running this program, and appends its results
+void
+runGraphInChildProcess(const char* program,
+                       const std::string& name,
+                       const Options& options,
+                       int threads,
+                       std::vector<PassResult>* results)
+{
+    PassResult failure;
+    failure.graph = name;
+    failure.threads = threads;
+    failure.pass = 0;
+    failure.ok = false;
+    failure.seconds = failure.fps = 0.;
+    failure.nodeCacheLookups = failure.nodeCacheHits = failure.diskCacheLookups = failure.diskCacheHits = 0;
+    failure.peakRSS = failure.currentRSS = 0;
+
+    QTemporaryFile childOut;
+    if ( !childOut.open() ) {
+        failure.error = "Could not create a temporary file for the results";
+        results->push_back(failure);
+
+        return;
+    }
+    childOut.close();
+
+    QStringList args;
+    args << QString("--graph=%1").arg( name.c_str() )
+         << QString("--width=%1").arg(options.params.width)
+         << QString("--height=%1").arg(options.params.height)
+         << QString("--depth=%1").arg(options.params.depth)
+         << QString("--cost=%1").arg(options.params.cost)
+         << QString("--frames=%1").arg(options.frames)
+         << QString("--threads=%1").arg(threads)
+         << QString("--parallel-renders=%1").arg(options.parallelRenders)
+         << QString("--passes=%1").arg(options.passes)
+         << QString("--child-out=%1").arg( childOut.fileName() );
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedChannels);
+    process.start(program, args);
+    if ( !process.waitForFinished(-1) || (process.exitStatus() != QProcess::NormalExit) || (process.exitCode() != 0) ) {
+        failure.error = "The benchmark process failed: " + process.errorString().toStdString();
+        results->push_back(failure);
+
+        return;
+    }
+
+    std::ifstream ifile( childOut.fileName().toStdString().c_str() );
+    std::size_t first = results->size();
+    readChildResults(ifile, results);
+    if (results->size() == first) {
+        failure.error = "The benchmark process did not report any result";
+        results->push_back(failure);
+    }
+}
+
+void
+printResult(const PassResult& r)
+{
+    if (!r.ok) {
+        std::printf( "%-10s %8d %5s  ERROR: %s\n", r.graph.c_str(), r.threads, "-", r.error.c_str() );
+
+        return;
+    }
+    std::printf( "%-10s %8d %5d %10.3f %9.2f %9.1f%% %9.1f%% %10.1f %10.1f\n", r.graph.c_str(), r.threads, r.pass, r.seconds, r.fps,
+                 hitRate(r.nodeCacheLookups, r.nodeCacheHits), hitRate(r.diskCacheLookups, r.diskCacheHits),
+                 r.peakRSS / (1024. * 1024.), r.currentRSS / (1024. * 1024.) );
+    for (std::size_t i = 0; i < r.nodes.size(); ++i) {
+        std::printf( "    %-40s %12.3f ms %8lld calls\n", r.nodes[i].name.c_str(), r.nodes[i].ms, r.nodes[i].calls );
+    }
+}
+
+std::string
+escapeJSON(const std::string& str)
+{
+    std::string ret;
+
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        if ( (str[i] == '"') || (str[i] == '\\') ) {
+            ret.push_back('\\');
+        }
+        ret.push_back(str[i]);
+    }
+
+    return ret;
+}
+
+void
+writeJSON(std::ostream& os,
+          const Options& options,
+          const std::vector<PassResult>& results)
+{
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << "    \"width\": " << options.params.width << ",\n";
+    os << "    \"height\": " << options.params.height << ",\n";
+    os << "    \"depth\": " << options.params.depth << ",\n";
+    os << "    \"cost\": " << options.params.cost << ",\n";
+    os << "    \"frames\": " << options.frames << ",\n";
+    os << "    \"parallel_renders\": " << options.parallelRenders << ",\n";
+    os << "    \"hardware_threads\": " << QThread::idealThreadCount() << "\n";
+    os << "  },\n";
+    os << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const PassResult& r = results[i];
+        os << "    {\n";
+        os << "      \"graph\": \"" << escapeJSON(r.graph) << "\",\n";
+        os << "      \"threads\": " << r.threads << ",\n";
+        os << "      \"pass\": " << r.pass << ",\n";
+        if (!r.ok) {
+            os << "      \"error\": \"" << escapeJSON(r.error) << "\"\n";
+        } else {
+            os << "      \"seconds\": " << r.seconds << ",\n";
+            os << "      \"frames_per_second\": " << r.fps << ",\n";
+            os << "      \"node_cache_lookups\": " << r.nodeCacheLookups << ",\n";
+            os << "      \"node_cache_hits\": " << r.nodeCacheHits << ",\n";
+            os << "      \"disk_cache_lookups\": " << r.diskCacheLookups << ",\n";
+            os << "      \"disk_cache_hits\": " << r.diskCacheHits << ",\n";
+            os << "      \"peak_rss\": " << r.peakRSS << ",\n";
+            os << "      \"current_rss\": " << r.currentRSS << ",\n";
+            os << "      \"nodes\": [";
+            for (std::size_t j = 0; j < r.nodes.size(); ++j) {
+                os << (j ? ",\n" : "\n");
+                os << "        { \"name\": \"" << escapeJSON(r.nodes[j].name) << "\", \"render_ms\": " << r.nodes[j].ms
+                   << ", \"render_calls\": " << r.nodes[j].calls << " }";
+            }
+            os << "\n      ]\n";
+        }
+        os << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+} // anon namespace
+
+int
+main(int argc,
+     char *argv[])
+{
+    Options options;
+
+    if ( !parseOptions(argc, argv, &options) ) {
+        return 1;
+    }
+
+    if ( !options.childOut.empty() ) {
+        ///Render a single configuration for the parent process
+        if ( (options.graphs.size() != 1) || (options.threads.size() != 1) ) {
+            std::cerr << "--child-out needs a single graph and a single thread count" << std::endl;
+
+            return 1;
+        }
+
+        ///A background application, as for the unit tests
+        AppManager* manager = new AppManager;
+        int appArgc = 0;
+        CLArgs cl;
+        manager->load(appArgc, 0, cl);
+        registerBenchmarkPlugins();
+
+        AppInstance* app = manager->getTopLevelInstance();
+        int ret = 0;
+        if (!app) {
+            std::cerr << "Could not create the application" << std::endl;
+            ret = 1;
+        } else {
+            std::vector<PassResult> results;
+            runGraph(app, options.graphs[0], options, options.threads[0], &results);
+            app->getProject()->closeProject();
+
+            std::ofstream ofile( options.childOut.c_str() );
+            if (!ofile) {
+                std::cerr << "Could not open " << options.childOut << std::endl;
+                ret = 1;
+            } else {
+                writeChildResults(ofile, results);
+            }
+            app->quit();
+        }
+
+        appPTR->setNumberOfThreads(0);
+        delete appPTR;
+
+        return ret;
+    }
+
+    std::vector<PassResult> results;
+    std::printf("%-10s %8s %5s %10s %9s %10s %10s %10s %10s\n", "graph", "threads", "pass", "seconds", "fps",
+                "node hits", "disk hits", "peak MB", "RSS MB");
+    for (std::size_t i = 0; i < options.graphs.size(); ++i) {
+        for (std::size_t t = 0; t < options.threads.size(); ++t) {
+            std::size_t first = results.size();
+            runGraphInChildProcess(argv[0], options.graphs[i], options, options.threads[t], &results);
+            for (std::size_t r = first; r < results.size(); ++r) {
+                printResult(results[r]);
+            }
+            std::fflush(stdout);
+        }
+    }
+
+    int ret = 0;
+    if ( !options.out.empty() ) {
+        std::ofstream ofile( options.out.c_str() );
+        if (!ofile) {
+            std::cerr << "Could not open " << options.out << std::endl;
+            ret = 1;
+        } else {
+            writeJSON(ofile, options, results);
+        }
+    }
+
+    return ret;
+}
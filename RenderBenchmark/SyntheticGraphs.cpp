@@ -0,0 +1,286 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "SyntheticGraphs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <stdexcept>
+
+#include "Engine/AppInstance.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
+#include "Engine/Project.h"
+#include "Engine/RotoContext.h"
+
+#include "BenchmarkEffects.h"
+
+namespace {
+
+typedef boost::shared_ptr<Natron::Node> NodePtr;
+typedef boost::shared_ptr<NodeCollection> CollectionPtr;
+
+///Builds the graph with the given name, throws a std::runtime_error on failure
+class GraphBuilder
+{
+    AppInstance* _app;
+    const SyntheticGraphParams& _params;
+    SyntheticGraph* _graph;
+
+public:
+
+    GraphBuilder(AppInstance* app,
+                 const SyntheticGraphParams& params,
+                 SyntheticGraph* graph)
+    : _app(app)
+    , _params(params)
+    , _graph(graph)
+    {
+    }
+
+    CollectionPtr project() const
+    {
+        return _app->getProject();
+    }
+
+    NodePtr createNode(const QString& pluginID,
+                       const CollectionPtr& group)
+    {
+        NodePtr node = _app->createNode( CreateNodeArgs(pluginID,
+                                                        "",
+                                                        -1,-1,false,INT_MIN,INT_MIN,false,true,false,
+                                                        QString(),CreateNodeArgs::DefaultValuesList(),
+                                                        group) );
+        if (!node) {
+            throw std::runtime_error("Could not create a node of the " + pluginID.toStdString() + " plug-in");
+        }
+        _graph->nodes.push_back(node);
+
+        return node;
+    }
+
+    void connect(const CollectionPtr& group,
+                 int inputNb,
+                 const NodePtr& input,
+                 const NodePtr& output)
+    {
+        if ( !group->connectNodes( inputNb, input, output.get() ) ) {
+            throw std::runtime_error("Could not connect " + input->getScriptName() + " to " + output->getScriptName());
+        }
+    }
+
+    NodePtr generator()
+    {
+        NodePtr node = createNode(PLUGINID_NATRON_BENCHMARK_GENERATOR, project());
+        BenchmarkGenerator* effect = dynamic_cast<BenchmarkGenerator*>( node->getLiveInstance() );
+        assert(effect);
+        effect->setSize(_params.width, _params.height);
+
+        return node;
+    }
+
+    NodePtr process(const CollectionPtr& group,
+                    const NodePtr& input)
+    {
+        NodePtr node = createNode(PLUGINID_NATRON_BENCHMARK_PROCESS, group);
+        BenchmarkProcess* effect = dynamic_cast<BenchmarkProcess*>( node->getLiveInstance() );
+        assert(effect);
+        effect->setCost(_params.cost);
+        connect(group, 0, input, node);
+
+        return node;
+    }
+
+    NodePtr merge(const NodePtr& a,
+                  const NodePtr& b)
+    {
+        NodePtr node = createNode(PLUGINID_NATRON_BENCHMARK_MERGE, project());
+        connect(project(), 0, a, node);
+        connect(project(), 1, b, node);
+
+        return node;
+    }
+
+    void sink(const NodePtr& input)
+    {
+        _graph->sink = createNode(PLUGINID_NATRON_BENCHMARK_SINK, project());
+        connect(project(), 0, input, _graph->sink);
+    }
+
+    ///A Roto node with a closed shape covering the center of the image
+    NodePtr roto()
+    {
+        NodePtr node = createNode(PLUGINID_OFX_ROTO, project());
+        boost::shared_ptr<RotoContext> context = node->getRotoContext();
+        if (!context) {
+            throw std::runtime_error("The " PLUGINID_OFX_ROTO " node has no roto context");
+        }
+        const int points = 16;
+        const double radius = std::min(_params.width, _params.height) / 3.;
+        boost::shared_ptr<Bezier> bezier;
+        for (int i = 0; i < points; ++i) {
+            double angle = 2. * M_PI * i / points;
+            double x = _params.width / 2. + radius * std::cos(angle);
+            double y = _params.height / 2. + radius * std::sin(angle);
+            if (i == 0) {
+                bezier = context->makeBezier(x, y, "Bezier", 0);
+            } else {
+                bezier->addControlPoint(x, y, 0);
+            }
+        }
+        bezier->setCurveFinished(true);
+
+        return node;
+    }
+
+    void build(const std::string& name)
+    {
+        const int depth = std::max(1, _params.depth);
+
+        if (name == "noop") {
+            NodePtr last = generator();
+            for (int i = 0; i < depth; ++i) {
+                NodePtr dot = createNode(PLUGINID_NATRON_DOT, project());
+                connect(project(), 0, last, dot);
+                last = dot;
+            }
+            sink(last);
+        } else if (name == "process") {
+            NodePtr last = generator();
+            for (int i = 0; i < depth; ++i) {
+                last = process(project(), last);
+            }
+            sink(last);
+        } else if (name == "group") {
+            NodePtr group = createNode(PLUGINID_NATRON_GROUP, project());
+            CollectionPtr collection = boost::dynamic_pointer_cast<NodeCollection>( group->getLiveInstance()->shared_from_this() );
+            assert(collection);
+            ///The Input and Output nodes created with the group
+            NodePtr groupInput, groupOutput;
+            NodeList groupNodes = collection->getNodes();
+            for (NodeList::iterator it = groupNodes.begin(); it != groupNodes.end(); ++it) {
+                if ( (*it)->getPluginID() == PLUGINID_NATRON_INPUT ) {
+                    groupInput = *it;
+                } else if ( (*it)->getPluginID() == PLUGINID_NATRON_OUTPUT ) {
+                    groupOutput = *it;
+                }
+            }
+            if (!groupInput || !groupOutput) {
+                throw std::runtime_error("The group has no Input or Output node");
+            }
+            NodePtr existing = groupOutput->getRealInput(0);
+            if (existing) {
+                collection->disconnectNodes( existing.get(), groupOutput.get() );
+            }
+            NodePtr last = groupInput;
+            for (int i = 0; i < depth; ++i) {
+                last = process(collection, last);
+            }
+            connect(collection, 0, last, groupOutput);
+            connect(project(), 0, generator(), group);
+            sink(group);
+        } else if (name == "roto") {
+            NodePtr mask = roto();
+            NodePtr last = generator();
+            for (int i = 0; i < depth; ++i) {
+                last = process(project(), last);
+                connect(project(), 1, mask, last);
+            }
+            sink(last);
+        } else if (name == "diskcache") {
+            NodePtr last = generator();
+            for (int i = 0; i < depth; ++i) {
+                last = process(project(), last);
+            }
+            NodePtr diskCache = createNode(PLUGINID_NATRON_DISKCACHE, project());
+            connect(project(), 0, last, diskCache);
+            sink(diskCache);
+        } else if (name == "diamond") {
+            NodePtr last = generator();
+            for (int i = 0; i < depth; ++i) {
+                NodePtr left = process(project(), last);
+                NodePtr right = process(project(), last);
+                last = merge(left, right);
+            }
+            sink(last);
+        } else if (name == "deep") {
+            NodePtr last = generator();
+            for (int i = 0; i < depth; ++i) {
+                last = merge( last, generator() );
+            }
+            sink(last);
+        } else if (name == "wide") {
+            std::list<NodePtr> level;
+            for (int i = 0; i < depth; ++i) {
+                level.push_back( generator() );
+            }
+            while (level.size() > 1) {
+                std::list<NodePtr> next;
+                while (level.size() > 1) {
+                    NodePtr a = level.front();
+                    level.pop_front();
+                    NodePtr b = level.front();
+                    level.pop_front();
+                    next.push_back( merge(a, b) );
+                }
+                if ( !level.empty() ) {
+                    next.push_back( level.front() );
+                }
+                level.swap(next);
+            }
+            sink( level.front() );
+        } else {
+            throw std::runtime_error("Unknown graph " + name);
+        }
+    }
+};
+
+} // anon namespace
+
+std::vector<std::string>
+getSyntheticGraphNames()
+{
+    std::vector<std::string> ret;
+
+    ret.push_back("noop");
+    ret.push_back("process");
+    ret.push_back("group");
+    ret.push_back("roto");
+    ret.push_back("diskcache");
+    ret.push_back("diamond");
+    ret.push_back("deep");
+    ret.push_back("wide");
+
+    return ret;
+}
+
+bool
+buildSyntheticGraph(const std::string& name,
+                    AppInstance* app,
+                    const SyntheticGraphParams& params,
+                    SyntheticGraph* graph,
+                    std::string* error)
+{
+    graph->sink.reset();
+    graph->nodes.clear();
+
+    try {
+        GraphBuilder builder(app, params, graph);
+        builder.build(name);
+    } catch (const std::exception& e) {
+        *error = e.what();
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,85 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_RENDERBENCHMARK_SYNTHETICGRAPHS_H_
+#define NATRON_RENDERBENCHMARK_SYNTHETICGRAPHS_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+class AppInstance;
+namespace Natron {
+class Node;
+}
+
+/**
+ * @brief The shape and the cost of a synthetic graph
+ **/
+struct SyntheticGraphParams
+{
+    ///Size of the images produced by the generators
+    int width, height;
+
+    ///Number of levels of the graph: length of the chains, number of diamonds or of merges...
+    int depth;
+
+    ///Number of operations per pixel and per channel of the processing nodes
+    int cost;
+
+    SyntheticGraphParams()
+    : width(1920)
+    , height(1080)
+    , depth(8)
+    , cost(4)
+    {
+    }
+};
+
+/**
+ * @brief A graph built in the project of an AppInstance, ending with a BenchmarkSink
+ **/
+struct SyntheticGraph
+{
+    ///The output to render
+    boost::shared_ptr<Natron::Node> sink;
+
+    ///All the nodes created, including those inside groups, in creation order
+    std::list<boost::shared_ptr<Natron::Node> > nodes;
+};
+
+/**
+ * @brief The names of the graphs that buildSyntheticGraph() can build:
+ * - noop: a generator followed by a chain of depth Dots
+ * - process: a chain of depth processing nodes
+ * - group: the same chain inside a Group
+ * - roto: a chain of depth processing nodes all masked by a Roto node (requires the Roto plug-in)
+ * - diskcache: a chain of depth processing nodes followed by a DiskCache node
+ * - diamond: depth diamonds, each one splitting the image in 2 branches merged afterwards
+ * - deep: a chain of depth merges, each merging a new generator
+ * - wide: a balanced tree of merges over depth generators
+ **/
+std::vector<std::string> getSyntheticGraphNames();
+
+/**
+ * @brief Builds the graph with the given name in the project of app. Must be called on the main thread.
+ * Returns false and sets error if the graph could not be built, e.g. if a required plug-in is missing.
+ **/
+bool buildSyntheticGraph(const std::string& name,
+                         AppInstance* app,
+                         const SyntheticGraphParams& params,
+                         SyntheticGraph* graph,
+                         std::string* error);
+
+#endif // NATRON_RENDERBENCHMARK_SYNTHETICGRAPHS_H_
@@ -17,6 +17,10 @@
 #include "BaseTest.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include "Engine/Node.h"
 #include "Engine/Project.h"
 #include "Engine/AppManager.h"
@@ -25,6 +29,7 @@
 #include "Engine/EffectInstance.h"
 #include "Engine/Plugin.h"
 #include "Engine/Curve.h"
+#include "Engine/Settings.h"
 using namespace Natron;
 
 
@@ -272,3 +277,83 @@ TEST_F(BaseTest,SimpleNodeConnections) {
     disconnectNodes(generator, writer, false);
     connectNodes(generator, writer, 0, true);
 }
+
+///Saves the same project in the XML and binary formats, checks that both can be loaded back
+///and records their load times as test properties.
+TEST_F(BaseTest,BinaryProjectFormat)
+{
+    const int nodesCount = 50;
+    for (int i = 0; i < nodesCount; ++i) {
+        boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+        assert(generator);
+        Double_Knob* radius = dynamic_cast<Double_Knob*>(generator->getKnobByName("radius").get());
+        assert(radius);
+        for (int t = 0; t < 100; ++t) {
+            radius->setValueAtTime(t, t + i, 0);
+        }
+    }
+
+    ///Save in a directory of the test in the temporary directory, removed at the end
+    const QString path = QDir::tempPath() + "/NatronBinaryProjectFormat" + QString::number( QCoreApplication::applicationPid() ) + '/';
+    ASSERT_TRUE( QDir().mkpath(path) );
+    const QString xmlName("test_project_xml." NATRON_PROJECT_FILE_EXT);
+    const QString binaryName("test_project_binary." NATRON_PROJECT_FILE_EXT);
+    boost::shared_ptr<Project> project = _app->getProject();
+    
+    ///The format is a user preference: restore it once saved
+    boost::shared_ptr<Settings> settings = appPTR->getCurrentSettings();
+    const bool binaryProjectFormat = settings->isBinaryProjectFormatEnabled();
+    settings->setBinaryProjectFormatEnabled(false);
+    QString xmlFile = project->saveProject(path, xmlName, false);
+    settings->setBinaryProjectFormatEnabled(true);
+    QString binaryFile = project->saveProject(path, binaryName, false);
+    settings->setBinaryProjectFormatEnabled(binaryProjectFormat);
+    
+    EXPECT_TRUE(QFile::exists(xmlFile));
+    EXPECT_TRUE(QFile::exists(binaryFile));
+    EXPECT_TRUE(QFileInfo(binaryFile).size() < QFileInfo(xmlFile).size());
+
+    QElapsedTimer timer;
+    timer.start();
+    EXPECT_TRUE(project->loadProject(path, xmlName));
+    qint64 xmlLoadTime = timer.restart();
+    EXPECT_EQ(nodesCount, (int)project->getNodes().size());
+    
+    timer.restart();
+    EXPECT_TRUE(project->loadProject(path, binaryName));
+    qint64 binaryLoadTime = timer.elapsed();
+    EXPECT_EQ(nodesCount, (int)project->getNodes().size());
+    
+    ///Written to the XML output of the tests (--gtest_output=xml)
+    RecordProperty( "xmlLoadTimeMs", (int)xmlLoadTime );
+    RecordProperty( "xmlFileSize", (int)QFileInfo(xmlFile).size() );
+    RecordProperty( "binaryLoadTimeMs", (int)binaryLoadTime );
+    RecordProperty( "binaryFileSize", (int)QFileInfo(binaryFile).size() );
+    
+    QFile::remove(xmlFile);
+    QFile::remove(binaryFile);
+    QDir().rmdir(path);
+}
+
+///Checks that the topological order of the project is updated when nodes are connected
+TEST_F(BaseTest,TopologicalOrder)
+{
+    boost::shared_ptr<Node> writer = createNode(_writeOIIOPluginID);
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    boost::shared_ptr<Project> project = _app->getProject();
+    
+    EXPECT_NE(-1, project->getTopologicalIndex(writer.get()));
+    EXPECT_NE(-1, project->getTopologicalIndex(generator.get()));
+    
+    connectNodes(generator, writer, 0, true);
+    EXPECT_LT(project->getTopologicalIndex(generator.get()), project->getTopologicalIndex(writer.get()));
+    EXPECT_FALSE(generator->checkIfConnectingInputIsOk(writer.get()));
+    
+    NodeList ordered;
+    project->getNodesInTopologicalOrder(&ordered);
+    EXPECT_EQ(project->getNodes().size(), ordered.size());
+    
+    disconnectNodes(generator, writer, true);
+    connectNodes(generator, writer, 0, true);
+    EXPECT_LT(project->getTopologicalIndex(generator.get()), project->getTopologicalIndex(writer.get()));
+}
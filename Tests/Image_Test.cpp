@@ -68,6 +68,35 @@ TEST(BitmapTest,SimpleRect) {
     ASSERT_TRUE( !memchr( map,0,rod.area() ) );
 }
 
+#if NATRON_ENABLE_TRIMAP
+TEST(ImageTest,RenderClaims) {
+    RectI bounds(0,0,100,100);
+    Natron::Image img(Natron::ImageComponents::getRGBAComponents(),RectD(0,0,100,100),bounds,0,1.,Natron::eImageBitDepthFloat,true);
+
+    RectI bottomHalf(0,0,100,50);
+    RectI topHalf(0,50,100,100);
+
+    ///a claimed portion can not be claimed again by another render, even partially
+    ASSERT_TRUE( img.claimForRendering(bottomHalf) );
+    EXPECT_FALSE( img.claimForRendering( RectI(0,40,100,60) ) );
+    ASSERT_TRUE( img.claimForRendering(topHalf) );
+
+    ///a rendered portion stays rendered, a failed render can be claimed again
+    img.releaseRenderClaim(bottomHalf, true);
+    img.releaseRenderClaim(topHalf, false);
+    EXPECT_TRUE( img.getMinimalRect(bounds) == topHalf );
+    EXPECT_FALSE( img.claimForRendering(bottomHalf) );
+    ASSERT_TRUE( img.claimForRendering(topHalf) );
+    img.releaseRenderClaim(topHalf, true);
+    EXPECT_TRUE( img.getMinimalRect(bounds).isNull() );
+
+    ///the image can be resized once no thread renders in it anymore
+    img.ensureBounds( RectI(0,0,200,100) );
+    EXPECT_TRUE( img.getBounds() == RectI(0,0,200,100) );
+    EXPECT_TRUE( img.getMinimalRect( RectI(0,0,200,100) ) == RectI(100,0,200,100) );
+}
+#endif
+
 TEST(ImageKeyTest,Equality) {
     srand(2000);
     // coverity[dont_call]
@@ -8,9 +8,13 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
+#include <cmath>
 #include <cstdlib>
+#include <limits>
+#include <vector>
 #include <gtest/gtest.h>
 #include "Engine/Lut.h"
+#include "Engine/Rect.h"
 
 using namespace Natron::Color;
 
@@ -34,3 +38,155 @@ TEST(Lut,IntConversions) {
         EXPECT_EQ( i, uint8xxToChar( charToUint8xx(i) ) );
     }
 }
+
+TEST(Lut,Uint16Conversions) {
+    const Natron::Color::Lut* luts[2] = { Natron::Color::LutManager::sRGBLut(), Natron::Color::LutManager::Rec709Lut() };
+    for (int l = 0; l < 2; ++l) {
+        const Natron::Color::Lut* lut = luts[l];
+        lut->validate();
+        for (int i = 0; i < 0x10000; ++i) {
+            // the 16-bit table is exact
+            EXPECT_EQ( lut->fromColorSpaceUint16ToLinearFloatFast(i), lut->fromColorSpaceFloatToLinearFloat( intToFloat<65536>(i) ) );
+            // converting back is accurate to 1 unit, except where the transfer function is not continuous
+            // (the two parts of the Rec709 function do not join exactly at 0.018)
+            float f = lut->fromColorSpaceUint16ToLinearFloatFast(i);
+            if ( (l == 1) && (std::abs(f - 0.018f) < 0.0002f) ) {
+                continue;
+            }
+            int back = lut->toColorSpaceUint16FromLinearFloatFast(f);
+            EXPECT_LE(std::abs(back - i), 1);
+        }
+        for (int i = 0; i <= 1000; ++i) {
+            float v = i / 1000.f;
+            if ( (l == 1) && (i == 18) ) {
+                continue;
+            }
+            int expected = floatToInt<65536>( lut->toColorSpaceFloatFromLinearFloat(v) );
+            EXPECT_LE(std::abs(lut->toColorSpaceUint16FromLinearFloatFast(v) - expected), 1);
+        }
+        EXPECT_EQ(0, lut->toColorSpaceUint16FromLinearFloatFast(-1.f));
+        EXPECT_EQ(65535, lut->toColorSpaceUint16FromLinearFloatFast(2.f));
+    }
+}
+
+TEST(Lut,Uint16Buffers) {
+    const Natron::Color::Lut* lut = Natron::Color::LutManager::sRGBLut();
+    lut->validate();
+
+    // RGBA float buffer, 3x2 pixels
+    const int w = 3, h = 2;
+    float rgba[w * h * 4];
+    for (int i = 0; i < w * h; ++i) {
+        rgba[i * 4] = i / 6.f;
+        rgba[i * 4 + 1] = 0.5f;
+        rgba[i * 4 + 2] = 1.f - i / 6.f;
+        rgba[i * 4 + 3] = 0.5f;
+    }
+
+    // planar with strides, premultiplied by alpha
+    unsigned short planar[w * h];
+    lut->to_short_planar(planar, rgba, w * h, rgba + 3, 4, 1);
+    for (int i = 0; i < w * h; ++i) {
+        EXPECT_EQ( planar[i], lut->toColorSpaceUint16FromLinearFloatFast(rgba[i * 4] * 0.5f) );
+    }
+    float back[w * h];
+    lut->from_short_planar(back, planar, w * h);
+    for (int i = 0; i < w * h; ++i) {
+        EXPECT_EQ( back[i], lut->fromColorSpaceUint16ToLinearFloatFast(planar[i]) );
+    }
+
+    // packed RGBA -> BGRA
+    RectI bounds(0, 0, w, h);
+    unsigned short bgra[w * h * 4];
+    lut->to_short_packed(bgra, rgba, bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingBGRA, false, false);
+    for (int i = 0; i < w * h; ++i) {
+        const float* src = rgba + i * 4;
+        const unsigned short* dst = bgra + i * 4;
+        EXPECT_EQ( dst[2], lut->toColorSpaceUint16FromLinearFloatFast(src[0]) );
+        EXPECT_EQ( dst[1], lut->toColorSpaceUint16FromLinearFloatFast(src[1]) );
+        EXPECT_EQ( dst[0], lut->toColorSpaceUint16FromLinearFloatFast(src[2]) );
+        EXPECT_EQ( dst[3], floatToInt<65536>(src[3]) );
+    }
+
+    // and back to RGBA
+    float rgba2[w * h * 4];
+    lut->from_short_packed(rgba2, bgra, bounds, bounds, bounds, ePixelPackingBGRA, ePixelPackingRGBA, false, false);
+    for (int i = 0; i < w * h * 4; ++i) {
+        EXPECT_NEAR(rgba2[i], rgba[i], 1e-4);
+    }
+
+    // the rows are laid out the same way as the 8-bit conversion, with or without invertY
+    for (int invertY = 0; invertY < 2; ++invertY) {
+        unsigned char bgra8[w * h * 4];
+        lut->to_byte_packed(bgra8, rgba, bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingBGRA, invertY, false);
+        lut->to_short_packed(bgra, rgba, bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingBGRA, invertY, false);
+        for (int i = 0; i < w * h; ++i) {
+            // the 8-bit conversion is dithered
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_NEAR(bgra8[i * 4 + c], bgra[i * 4 + c] / 257., 1.);
+            }
+        }
+    }
+}
+
+TEST(Lut,FloatConversions) {
+    const Natron::Color::Lut* luts[2] = { Natron::Color::LutManager::sRGBLut(), Natron::Color::LutManager::Rec709Lut() };
+    for (int l = 0; l < 2; ++l) {
+        const Natron::Color::Lut* lut = luts[l];
+        lut->validate();
+        // within the error bound over the whole range of the tables, and beyond
+        const int n = 100000;
+        std::vector<float> buf(n);
+        for (int i = 0; i < n; ++i) {
+            buf[i] = -1.f + 300.f * i / n;
+        }
+        std::vector<float> to(buf), from(buf);
+        lut->toColorSpaceFloatFromLinearFloatFast(&to[0], n);
+        lut->fromColorSpaceFloatToLinearFloatFast(&from[0], n);
+        for (int i = 0; i < n; ++i) {
+            float exact = lut->toColorSpaceFloatFromLinearFloat(buf[i]);
+            EXPECT_NEAR( to[i], exact, kLutFloatMaxError * std::max(std::abs(exact), 1e-2f) );
+            EXPECT_EQ( to[i], lut->toColorSpaceFloatFromLinearFloatFast(buf[i]) );
+            exact = lut->fromColorSpaceFloatToLinearFloat(buf[i]);
+            EXPECT_NEAR( from[i], exact, kLutFloatMaxError * std::max(std::abs(exact), 1e-2f) );
+            EXPECT_EQ( from[i], lut->fromColorSpaceFloatToLinearFloatFast(buf[i]) );
+        }
+        // small values, including the interval below the range of the tables
+        for (int i = 0; i <= 1000; ++i) {
+            float v = std::ldexp(i / 1000.f, -12);
+            float exact = lut->fromColorSpaceFloatToLinearFloat(v);
+            EXPECT_NEAR( lut->fromColorSpaceFloatToLinearFloatFast(v), exact, kLutFloatMaxError * std::max(std::abs(exact), 1e-2f) );
+        }
+        // values that are not in the tables are converted exactly
+        EXPECT_EQ( lut->toColorSpaceFloatFromLinearFloatFast(1000.f), lut->toColorSpaceFloatFromLinearFloat(1000.f) );
+        EXPECT_EQ( lut->toColorSpaceFloatFromLinearFloatFast(-0.5f), lut->toColorSpaceFloatFromLinearFloat(-0.5f) );
+        float nan = lut->toColorSpaceFloatFromLinearFloatFast( std::numeric_limits<float>::quiet_NaN() );
+        EXPECT_TRUE(nan != nan);
+
+        // packed rows are converted one channel at a time, and premultiplied by alpha
+        const int w = 5, h = 2;
+        RectI bounds(0, 0, w, h);
+        float rgba[w * h * 4];
+        for (int i = 0; i < w * h * 4; ++i) {
+            rgba[i] = (i % 4 == 3) ? 0.25f * (i / 4 % 4) : 0.1f * (i % 11);
+        }
+        float packed[w * h * 4];
+        lut->to_float_packed(packed, rgba, bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGBA, true, true);
+        for (int i = 0; i < w * h; ++i) {
+            const float* src = rgba + i * 4;
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_EQ( packed[i * 4 + c], lut->toColorSpaceFloatFromLinearFloatFast(src[c] * src[3]) );
+            }
+            EXPECT_EQ( packed[i * 4 + 3], src[3] );
+        }
+        float back[w * h * 4];
+        lut->from_float_packed(back, packed, bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGBA, false, true);
+        for (int i = 0; i < w * h; ++i) {
+            const float* src = packed + i * 4;
+            for (int c = 0; c < 3; ++c) {
+                float expected = src[3] > 0.f ? lut->fromColorSpaceFloatToLinearFloatFast(src[c] / src[3]) * src[3] : 0.f;
+                EXPECT_EQ( back[i * 4 + c], expected );
+            }
+        }
+    }
+}
@@ -0,0 +1,125 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QDataStream>
+
+#include "Engine/ProcessMessage.h"
+
+using namespace Natron;
+
+TEST(ProcessMessageTest,RoundTrip) {
+    ProcessMessage rendered(eProcessMessageTypeFrameRendered);
+    rendered.time = 12;
+    rendered.view = 1;
+    rendered.value = 0.5;
+
+    ProcessMessage stats(eProcessMessageTypeCacheStats);
+    stats.cacheMemory = 1ULL << 40;
+    stats.cacheLookups = 100;
+    stats.cacheHits = 60;
+    stats.diskCacheLookups = 40;
+    stats.diskCacheHits = 10;
+
+    ProcessMessage error(eProcessMessageTypeError);
+    error.context = "Write1";
+    error.text = QString::fromUtf8("Could not open file \xc3\xa9");
+
+    QByteArray buffer;
+    encodeProcessMessage(rendered, &buffer);
+    encodeProcessMessage(stats, &buffer);
+    encodeProcessMessage(error, &buffer);
+
+    ProcessMessageList messages;
+    ASSERT_TRUE( decodeProcessMessages(&buffer, &messages) );
+    EXPECT_TRUE( buffer.isEmpty() );
+    ASSERT_EQ(3u, messages.size());
+
+    ProcessMessageList::iterator it = messages.begin();
+    EXPECT_EQ(eProcessMessageTypeFrameRendered, it->type);
+    EXPECT_EQ(12, it->time);
+    EXPECT_EQ(1, it->view);
+    EXPECT_EQ(0.5, it->value);
+    ++it;
+    EXPECT_EQ(eProcessMessageTypeCacheStats, it->type);
+    EXPECT_EQ(1ULL << 40, it->cacheMemory);
+    EXPECT_EQ(60u, it->cacheHits);
+    EXPECT_EQ(10u, it->diskCacheHits);
+    ++it;
+    EXPECT_EQ(eProcessMessageTypeError, it->type);
+    EXPECT_TRUE(it->context == error.context);
+    EXPECT_TRUE(it->text == error.text);
+}
+
+TEST(ProcessMessageTest,PartialMessages) {
+    ProcessMessage serverCreated(eProcessMessageTypeBgServerCreated);
+    serverCreated.text = "/tmp/Natron_INPUT_SOCKET1234";
+    QByteArray data;
+    encodeProcessMessage(serverCreated, &data);
+    encodeProcessMessage(ProcessMessage(eProcessMessageTypeRenderingStarted), &data);
+
+    ///feed the data byte by byte, as it may be received from the socket
+    QByteArray buffer;
+    ProcessMessageList messages;
+    for (int i = 0; i < data.size(); ++i) {
+        buffer.append(data[i]);
+        ASSERT_TRUE( decodeProcessMessages(&buffer, &messages) );
+    }
+    ASSERT_EQ(2u, messages.size());
+    EXPECT_TRUE(messages.front().text == serverCreated.text);
+    EXPECT_EQ(eProcessMessageTypeRenderingStarted, messages.back().type);
+    EXPECT_TRUE( buffer.isEmpty() );
+}
+
+TEST(ProcessMessageTest,UnknownAndInvalidMessages) {
+    QByteArray buffer;
+    {
+        ///a message of a type unknown to this version, with a payload
+        QDataStream stream(&buffer,QIODevice::WriteOnly);
+        stream << (quint32)(sizeof(quint16) + sizeof(qint32)) << (quint16)1000 << (qint32)42;
+    }
+    encodeProcessMessage(ProcessMessage(eProcessMessageTypeRenderingFinished), &buffer);
+
+    ProcessMessageList messages;
+    ASSERT_TRUE( decodeProcessMessages(&buffer, &messages) );
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ(eProcessMessageTypeRenderingFinished, messages.front().type);
+
+    QByteArray garbage("this is not a message");
+    EXPECT_FALSE( decodeProcessMessages(&garbage, &messages) );
+    EXPECT_TRUE( garbage.isEmpty() );
+}
+
+TEST(ProcessMessageTest,Coalesce) {
+    ProcessMessageList messages;
+    for (int i = 1; i <= 4; ++i) {
+        ProcessMessage progress(eProcessMessageTypeFrameProgress);
+        progress.time = 1;
+        progress.value = i / 4.;
+        messages.push_back(progress);
+    }
+    ProcessMessage otherFrame(eProcessMessageTypeFrameProgress);
+    otherFrame.time = 2;
+    otherFrame.value = 0.25;
+    messages.push_back(otherFrame);
+    ProcessMessage rendered(eProcessMessageTypeFrameRendered);
+    rendered.time = 2;
+    messages.push_back(rendered);
+
+    coalesceProcessMessages(&messages);
+
+    ///only the last progress of frame 1 is kept, the progress of frame 2 is superseded by the frame being rendered
+    ASSERT_EQ(2u, messages.size());
+    EXPECT_EQ(eProcessMessageTypeFrameProgress, messages.front().type);
+    EXPECT_EQ(1, messages.front().time);
+    EXPECT_EQ(1., messages.front().value);
+    EXPECT_EQ(eProcessMessageTypeFrameRendered, messages.back().type);
+}
@@ -0,0 +1,119 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
+
+#include "Engine/RenderCheckpoint.h"
+
+namespace {
+
+QString
+makeCheckpointPath()
+{
+    QTemporaryFile tmpf;
+    tmpf.open();
+    QString path = tmpf.fileName();
+    tmpf.remove();
+
+    return path;
+}
+} // anon namespace
+
+TEST(RenderCheckpointTest,ResumeFromGaps) {
+    QString path = makeCheckpointPath();
+    {
+        RenderCheckpoint checkpoint(path);
+        QString error;
+        ASSERT_TRUE( checkpoint.open(&error) );
+        for (int i = 1; i <= 10; ++i) {
+            checkpoint.markFrameCompleted(i);
+        }
+        ///frames rendered in parallel complete out of order
+        checkpoint.markFrameCompleted(13);
+        checkpoint.markFrameCompleted(12);
+        checkpoint.markFrameIncomplete(5);
+    }
+
+    RenderCheckpoint checkpoint(path);
+    QString error;
+    ASSERT_TRUE( checkpoint.open(&error) );
+    EXPECT_TRUE( checkpoint.isFrameCompleted(1) );
+    EXPECT_FALSE( checkpoint.isFrameCompleted(5) );
+
+    std::list<std::pair<int,int> > ranges;
+    checkpoint.getFrameRangesToRender(1, 20, &ranges);
+    ASSERT_EQ(3u, ranges.size());
+    std::list<std::pair<int,int> >::iterator it = ranges.begin();
+    EXPECT_EQ(std::make_pair(5, 5), *it);
+    ++it;
+    EXPECT_EQ(std::make_pair(11, 11), *it);
+    ++it;
+    EXPECT_EQ(std::make_pair(14, 20), *it);
+
+    checkpoint.remove();
+    EXPECT_FALSE( QFile::exists(path) );
+}
+
+TEST(RenderCheckpointTest,TornRecord) {
+    QString path = makeCheckpointPath();
+    {
+        RenderCheckpoint checkpoint(path);
+        QString error;
+        ASSERT_TRUE( checkpoint.open(&error) );
+        checkpoint.markFrameCompleted(1);
+        checkpoint.markFrameCompleted(2);
+    }
+    {
+        ///the process died while writing the record of frame 3
+        QFile file(path);
+        ASSERT_TRUE( file.open(QIODevice::WriteOnly | QIODevice::Append) );
+        const char partialRecord[5] = { 3, 0, 0, 0, 0x50 };
+        file.write(partialRecord, sizeof(partialRecord));
+    }
+    {
+        RenderCheckpoint checkpoint(path);
+        QString error;
+        ASSERT_TRUE( checkpoint.open(&error) );
+        EXPECT_TRUE( checkpoint.isFrameCompleted(2) );
+        EXPECT_FALSE( checkpoint.isFrameCompleted(3) );
+        ///the records written after the torn one must be read back
+        checkpoint.markFrameCompleted(3);
+    }
+
+    RenderCheckpoint checkpoint(path);
+    QString error;
+    ASSERT_TRUE( checkpoint.open(&error) );
+    EXPECT_TRUE( checkpoint.isFrameCompleted(3) );
+    checkpoint.remove();
+}
+
+TEST(RenderCheckpointTest,NotACheckpoint) {
+    QString path = makeCheckpointPath();
+    {
+        QFile file(path);
+        ASSERT_TRUE( file.open(QIODevice::WriteOnly) );
+        file.write("garbage that is not a checkpoint");
+    }
+
+    RenderCheckpoint checkpoint(path);
+    QString error;
+    ASSERT_TRUE( checkpoint.open(&error) );
+    std::list<std::pair<int,int> > ranges;
+    checkpoint.getFrameRangesToRender(1, 3, &ranges);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(std::make_pair(1, 3), ranges.front());
+    checkpoint.remove();
+}
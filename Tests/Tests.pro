@@ -157,7 +157,10 @@ SOURCES += \
     Image_Test.cpp \
     Lut_Test.cpp \
     File_Knob_Test.cpp \
-    Curve_Test.cpp
+    Curve_Test.cpp \
+    ProcessMessage_Test.cpp \
+    RenderCheckpoint_Test.cpp \
+    Trace_Test.cpp
 
 HEADERS += \
     BaseTest.h
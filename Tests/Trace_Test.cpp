@@ -0,0 +1,129 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
+
+#include "Engine/Trace.h"
+
+using namespace Natron::Trace;
+
+namespace {
+
+///Reads back a trace file, returns the records of all threads
+bool
+readTraceFile(const QString & filePath,
+              std::vector<TraceRecord>* records)
+{
+    QFile file(filePath);
+
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+    TraceFileHeader header;
+    if ( (file.read( (char*)&header, sizeof(header) ) != sizeof(header)) ||
+         (std::memcmp( header.magic, NATRON_TRACE_FILE_MAGIC, sizeof(header.magic) ) != 0) ||
+         (header.recordSize != sizeof(TraceRecord)) ) {
+        return false;
+    }
+    for (quint32 i = 0; i < header.threadsCount; ++i) {
+        TraceThreadHeader thread;
+        if ( file.read( (char*)&thread, sizeof(thread) ) != sizeof(thread) ) {
+            return false;
+        }
+        std::size_t first = records->size();
+        records->resize(first + thread.recordsCount);
+        qint64 size = (qint64)thread.recordsCount * sizeof(TraceRecord);
+        if ( size && (file.read( (char*)&(*records)[first], size ) != size) ) {
+            return false;
+        }
+    }
+
+    return file.atEnd();
+}
+
+QString
+getTemporaryFilePath()
+{
+    QTemporaryFile tmp;
+
+    tmp.open();
+
+    return tmp.fileName() + ".ntrace";
+}
+} // anon namespace
+
+TEST(Trace,RingKeepsTheMostRecentEvents) {
+    initialize( std::string() );
+
+    const quint16 event = eTraceEventUser + 1;
+    const int count = 2 * NATRON_TRACE_RING_SIZE + 10;
+    for (int i = 0; i < count; ++i) {
+        record( event, &i, sizeof(i) );
+    }
+
+    QString filePath = getTemporaryFilePath();
+    ASSERT_TRUE( writeToFile( filePath.toStdString() ) );
+    std::vector<TraceRecord> records;
+    ASSERT_TRUE( readTraceFile(filePath, &records) );
+    QFile::remove(filePath);
+
+    std::vector<int> values;
+    quint64 lastTimestamp = 0;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        if (records[i].event != event) {
+            continue;
+        }
+        EXPECT_EQ( sizeof(int), (std::size_t)records[i].payloadSize );
+        EXPECT_GE(records[i].timestamp, lastTimestamp);
+        lastTimestamp = records[i].timestamp;
+        int v;
+        std::memcpy( &v, records[i].payload, sizeof(v) );
+        values.push_back(v);
+    }
+    ///The ring of this thread only contains the last NATRON_TRACE_RING_SIZE events, in order
+    ASSERT_EQ( (std::size_t)NATRON_TRACE_RING_SIZE, values.size() );
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ( (int)(count - NATRON_TRACE_RING_SIZE + i), values[i] );
+    }
+}
+
+TEST(Trace,LongMessagesAreSplit) {
+    initialize( std::string() );
+
+    std::string text;
+    for (int i = 0; i < 3 * NATRON_TRACE_PAYLOAD_SIZE - 5; ++i) {
+        text.push_back( 'a' + (i % 26) );
+    }
+    recordMessage(text);
+
+    QString filePath = getTemporaryFilePath();
+    ASSERT_TRUE( writeToFile( filePath.toStdString() ) );
+    std::vector<TraceRecord> records;
+    ASSERT_TRUE( readTraceFile(filePath, &records) );
+    QFile::remove(filePath);
+
+    ///The message is the last event of this thread
+    std::string decoded;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        if (records[i].event == eTraceEventMessage) {
+            decoded = std::string( (const char*)records[i].payload, records[i].payloadSize );
+        } else if (records[i].event == eTraceEventMessageContinued) {
+            decoded += std::string( (const char*)records[i].payload, records[i].payloadSize );
+        }
+    }
+    EXPECT_EQ(text, decoded);
+}
@@ -0,0 +1,30 @@
+#This Source Code Form is subject to the terms of the Mozilla Public
+#License, v. 2.0. If a copy of the MPL was not distributed with this
+#file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+# Offline decoder of the trace files written by Natron (see Engine/Trace.h).
+# It only depends on QtCore so that it can be built and run on any machine.
+
+TARGET = NatronTraceDecoder
+QT       += core
+QT       -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += qt
+
+TEMPLATE = app
+
+CONFIG(debug, debug|release){
+    DEFINES *= DEBUG
+} else {
+    DEFINES *= NDEBUG
+}
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../Global/TraceFormat.h
@@ -0,0 +1,321 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/**
+ * Decodes the trace files written by Natron (see Engine/Trace.h), on demand by Natron::Log::flush() or when it crashes.
+ *
+ * Usage: NatronTraceDecoder [--format=text|chrome] <file.ntrace>
+ * - text prints the events of all threads sorted by time, one per line.
+ * - chrome writes JSON that can be loaded in chrome://tracing or in the Perfetto UI, the renders of the effects
+ *   appearing as slices on the timeline of their thread.
+ **/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QtCore/QFile>
+
+#include "Global/TraceFormat.h"
+
+using namespace Natron::Trace;
+
+namespace {
+
+struct ThreadInfo
+{
+    quint64 nativeThreadId;
+    quint64 droppedCount;
+    std::string name;
+};
+
+bool
+recordLess(const TraceRecord & a,
+           const TraceRecord & b)
+{
+    return a.timestamp < b.timestamp;
+}
+
+const char*
+getEventName(quint16 event)
+{
+    switch (event) {
+    case eTraceEventBeginFunction:
+        return "BeginFunction";
+    case eTraceEventEndFunction:
+        return "EndFunction";
+    case eTraceEventMessage:
+    case eTraceEventMessageContinued:
+        return "Message";
+    case eTraceEventRenderBegin:
+        return "RenderBegin";
+    case eTraceEventRenderEnd:
+        return "RenderEnd";
+    default:
+        return "User";
+    }
+}
+
+///The text stored in a buffer which is not necessarily null terminated
+std::string
+getText(const char* buffer,
+        std::size_t size)
+{
+    return std::string( buffer, std::find(buffer, buffer + size, 0) );
+}
+
+std::string
+getPayloadText(const TraceRecord & r)
+{
+    return getText( (const char*)r.payload, std::min( (std::size_t)r.payloadSize, sizeof(r.payload) ) );
+}
+
+std::string
+escapeJSON(const std::string & str)
+{
+    std::string ret;
+
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = str[i];
+        if ( (c == '"') || (c == '\\') ) {
+            ret.push_back('\\');
+            ret.push_back(c);
+        } else if (c < 0x20) {
+            char buf[8];
+            std::sprintf(buf, "\\u%04x", c);
+            ret += buf;
+        } else {
+            ret.push_back(c);
+        }
+    }
+
+    return ret;
+}
+
+bool
+readTrace(const char* filePath,
+          TraceFileHeader* header,
+          std::map<quint32, ThreadInfo>* threads,
+          std::vector<TraceRecord>* records)
+{
+    QFile file(filePath);
+
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        std::fprintf(stderr, "Could not open %s\n", filePath);
+
+        return false;
+    }
+    if ( (file.read( (char*)header, sizeof(*header) ) != sizeof(*header)) ||
+         (std::memcmp( header->magic, NATRON_TRACE_FILE_MAGIC, sizeof(header->magic) ) != 0) ) {
+        std::fprintf(stderr, "%s is not a Natron trace file\n", filePath);
+
+        return false;
+    }
+    if ( (header->byteOrderMark != NATRON_TRACE_BYTE_ORDER_MARK) || (header->version != NATRON_TRACE_FILE_VERSION) ||
+         (header->recordSize != sizeof(TraceRecord)) ) {
+        std::fprintf(stderr, "%s was written by another version of Natron or on a machine with another byte order\n", filePath);
+
+        return false;
+    }
+
+    for (quint32 i = 0; i < header->threadsCount; ++i) {
+        TraceThreadHeader thread;
+        if ( file.read( (char*)&thread, sizeof(thread) ) != sizeof(thread) ) {
+            std::fprintf(stderr, "%s is truncated\n", filePath);
+
+            return false;
+        }
+        thread.name[sizeof(thread.name) - 1] = 0;
+        ThreadInfo & info = (*threads)[thread.threadIndex];
+        info.nativeThreadId = thread.nativeThreadId;
+        info.droppedCount = thread.droppedCount;
+        info.name = thread.name;
+
+        std::size_t first = records->size();
+        records->resize(first + thread.recordsCount);
+        qint64 size = (qint64)thread.recordsCount * sizeof(TraceRecord);
+        if ( size && (file.read( (char*)&(*records)[first], size ) != size) ) {
+            std::fprintf(stderr, "%s is truncated\n", filePath);
+
+            return false;
+        }
+    }
+
+    ///Records of a thread that reused the ring of a finished thread are not listed in a thread header
+    for (std::size_t i = 0; i < records->size(); ++i) {
+        if ( threads->find( (*records)[i].threadIndex ) == threads->end() ) {
+            ThreadInfo & info = (*threads)[(*records)[i].threadIndex];
+            info.nativeThreadId = 0;
+            info.droppedCount = 0;
+        }
+    }
+
+    std::stable_sort(records->begin(), records->end(), recordLess);
+
+    return true;
+}
+
+void
+printText(const TraceFileHeader & header,
+          const std::map<quint32, ThreadInfo> & threads,
+          const std::vector<TraceRecord> & records)
+{
+    std::printf("Trace started at %lld ms since the epoch\n", (long long)header.startTimeMs);
+    for (std::map<quint32, ThreadInfo>::const_iterator it = threads.begin(); it != threads.end(); ++it) {
+        std::printf( "Thread %u: %s id 0x%llx, %llu events overwritten\n", it->first, it->second.name.empty() ? "(unnamed)" : it->second.name.c_str(),
+                     (unsigned long long)it->second.nativeThreadId, (unsigned long long)it->second.droppedCount );
+    }
+
+    ///The nesting of the renders of each thread, to indent them
+    std::map<quint32, int> depth;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const TraceRecord & r = records[i];
+        if ( (r.event == eTraceEventMessageContinued) && (i > 0) ) {
+            ///Printed with the message it continues
+            continue;
+        }
+        int & d = depth[r.threadIndex];
+        if ( ( (r.event == eTraceEventRenderEnd) || (r.event == eTraceEventEndFunction) ) && (d > 0) ) {
+            --d;
+        }
+        std::printf( "%14.6f ms  thread %-3u %*s%-14s ", r.timestamp / 1e6, r.threadIndex, d * 2, "", getEventName(r.event) );
+        switch (r.event) {
+        case eTraceEventBeginFunction:
+        case eTraceEventEndFunction:
+            std::printf( "%s", getPayloadText(r).c_str() );
+            break;
+        case eTraceEventMessage:
+        case eTraceEventMessageContinued: {
+            std::string text = getPayloadText(r);
+            for (std::size_t j = i + 1; j < records.size(); ++j) {
+                if ( (records[j].threadIndex == r.threadIndex) && (records[j].event == eTraceEventMessageContinued) ) {
+                    text += getPayloadText(records[j]);
+                } else if (records[j].threadIndex == r.threadIndex) {
+                    break;
+                }
+            }
+            std::printf( "%s", text.c_str() );
+            break;
+        }
+        case eTraceEventRenderBegin: {
+            TraceRenderPayload p;
+            std::memset( &p, 0, sizeof(p) );
+            std::memcpy( &p, r.payload, std::min( (std::size_t)r.payloadSize, sizeof(p) ) );
+            std::string name = getText( p.name, sizeof(p.name) );
+            std::printf("%s time %d view %d roi (%d,%d)-(%d,%d)", name.c_str(), p.time, p.view, p.x1, p.y1, p.x2, p.y2);
+            break;
+        }
+        case eTraceEventRenderEnd: {
+            qint32 status = 0;
+            std::memcpy( &status, r.payload, std::min( (std::size_t)r.payloadSize, sizeof(status) ) );
+            std::printf("%s", status == 0 ? "ok" : status == -1 ? "exception" : "failed");
+            break;
+        }
+        default:
+            std::printf("event %u", r.event);
+            for (quint16 j = 0; j < r.payloadSize; ++j) {
+                std::printf(" %02x", r.payload[j]);
+            }
+            break;
+        }
+        std::printf("\n");
+        if ( (r.event == eTraceEventRenderBegin) || (r.event == eTraceEventBeginFunction) ) {
+            ++d;
+        }
+    }
+}
+
+void
+printChrome(const std::map<quint32, ThreadInfo> & threads,
+            const std::vector<TraceRecord> & records)
+{
+    std::printf("{ \"traceEvents\": [\n");
+    bool first = true;
+    for (std::map<quint32, ThreadInfo>::const_iterator it = threads.begin(); it != threads.end(); ++it) {
+        std::printf( "%s  { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": { \"name\": \"%s\" } }",
+                     first ? "" : ",\n", it->first, escapeJSON( it->second.name.empty() ? "Thread" : it->second.name ).c_str() );
+        first = false;
+    }
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const TraceRecord & r = records[i];
+        double us = r.timestamp / 1e3;
+        switch (r.event) {
+        case eTraceEventRenderBegin: {
+            TraceRenderPayload p;
+            std::memset( &p, 0, sizeof(p) );
+            std::memcpy( &p, r.payload, std::min( (std::size_t)r.payloadSize, sizeof(p) ) );
+            std::string name = getText( p.name, sizeof(p.name) );
+            std::printf( ",\n  { \"name\": \"%s\", \"ph\": \"B\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, "
+                         "\"args\": { \"time\": %d, \"view\": %d, \"roi\": [%d, %d, %d, %d] } }",
+                         escapeJSON(name).c_str(), r.threadIndex, us, p.time, p.view, p.x1, p.y1, p.x2, p.y2 );
+            break;
+        }
+        case eTraceEventBeginFunction:
+            std::printf( ",\n  { \"name\": \"%s\", \"ph\": \"B\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f }",
+                         escapeJSON( getPayloadText(r) ).c_str(), r.threadIndex, us );
+            break;
+        case eTraceEventRenderEnd:
+        case eTraceEventEndFunction:
+            std::printf(",\n  { \"ph\": \"E\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f }", r.threadIndex, us);
+            break;
+        case eTraceEventMessage:
+            std::printf( ",\n  { \"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f }",
+                         escapeJSON( getPayloadText(r) ).c_str(), r.threadIndex, us );
+            break;
+        case eTraceEventMessageContinued:
+            break;
+        default:
+            std::printf(",\n  { \"name\": \"event %u\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f }",
+                        r.event, r.threadIndex, us);
+            break;
+        }
+    }
+    std::printf("\n] }\n");
+}
+} // anon namespace
+
+int
+main(int argc,
+     char *argv[])
+{
+    bool chrome = false;
+    const char* filePath = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--format=chrome") == 0) {
+            chrome = true;
+        } else if (std::strcmp(argv[i], "--format=text") == 0) {
+            chrome = false;
+        } else if (argv[i][0] != '-') {
+            filePath = argv[i];
+        } else {
+            filePath = 0;
+            break;
+        }
+    }
+    if (!filePath) {
+        std::fprintf(stderr, "Usage: %s [--format=text|chrome] <file.ntrace>\n", argv[0]);
+
+        return 1;
+    }
+
+    TraceFileHeader header;
+    std::map<quint32, ThreadInfo> threads;
+    std::vector<TraceRecord> records;
+    if ( !readTrace(filePath, &header, &threads, &records) ) {
+        return 1;
+    }
+    if (chrome) {
+        printChrome(threads, records);
+    } else {
+        printText(header, threads, records);
+    }
+
+    return 0;
+}
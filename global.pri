@@ -18,10 +18,6 @@ trace_ofx_properties{
     DEFINES += OFX_DEBUG_PROPERTIES
 }
 
-log{
-    DEFINES += NATRON_LOG
-}
-
 CONFIG(debug, debug|release){
     DEFINES *= DEBUG
 } else {